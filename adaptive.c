@@ -0,0 +1,484 @@
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// ============================================================ * * * * * adaptive.c * * * * * ======================================================================== //
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/*
+
+### USAGE OF adaptive.c FILE IN STEGANOGRAPHY PROJECT ?
+--> THIS FILE IMPLEMENTS THE CONTENT-ADAPTIVE EMBEDDING MODE. THE COST OF A COLOUR SAMPLE IS |LEFT - RIGHT| + |UP - DOWN| OVER THE SAME CHANNEL OF THE NEIGHBOUR
+    PIXELS, TAKEN ON THE SAMPLES SHIFTED RIGHT BY ONE (LSB DROPPED). ROW BANDS OF THE IMAGE ARE COSTED BY WORKER THREADS WITH SSE2 / AVX2 ROW KERNELS, EACH BAND ALSO
+    FILLS A COST HISTOGRAM. THE ENCODER PICKS THE HIGHEST THRESHOLD THAT STILL LEAVES ENOUGH SAMPLES FOR THE PAYLOAD, STORES IT AFTER THE MODE WORD AND EMBEDS THE
+    PAYLOAD BITS, IN FILE ORDER, INTO THE SAMPLES WHOSE COST REACHES IT. BOTH SIDES WORK ON A MEMORY MAP OF THE IMAGE.
+
+*/
+
+/* ====================================================================== INCLUDES ==================================================================================== */
+
+#include <stdio.h>       // Std inbuilt functions
+#include <stdlib.h>      // malloc, free
+#include <string.h>      // Inbuilt string functions
+#include <stdint.h>      // Fixed width BMP header fields
+#include <pthread.h>     // Cost map bands
+#include <time.h>        // clock_gettime
+#include <unistd.h>      // sysconf
+#include <sys/mman.h>    // munmap
+#include "types.h"       // Status
+#include "common.h"      // MAGIC_STRING_EXT and MODE_* flags
+#include "encode.h"      // EncodeInfo and encoding steps
+#include "decode.h"      // DecodeInfo, PayloadParser
+#include "fastcopy.h"    // map_image_file
+#include "adaptive.h"    // Prototypes
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>   // SSE2 / AVX2 row kernels
+#define ADAPTIVE_HAVE_X86 1
+#endif
+
+/* ======================================================================= MACROS ===================================================================================== */
+
+#define BMP_HEADER 54                                       // Pixel data offset the rest of the project assumes
+#define ADAPTIVE_HEADER_BYTES (BMP_HEADER + 16 + 32 + 32)   // Image bytes holding magic, mode word and threshold in file order
+
+/* ======================================================================= STRUCTURE ================================================================================== */
+
+/* Cost of the samples of one row: cost[x] for x in [0, n), n = width * 3 */
+typedef void (*CostRowFn)(unsigned char *cost, const unsigned char *up, const unsigned char *row, const unsigned char *down, size_t n);
+
+/* Cost map of a mapped BMP */
+typedef struct
+{
+    const unsigned char *pixels;    // First pixel byte
+    unsigned char *cost;            // One cost per pixel byte (padding and borders 0)
+    size_t width3;                  // Sample bytes per row
+    size_t stride;                  // Row size with padding
+    size_t height;
+    unsigned long long hist[256];   // Samples per cost value
+} CostMap;
+
+/* One band of rows costed by a worker */
+typedef struct
+{
+    CostMap *map;
+    size_t y0, y1;
+    unsigned long long hist[256];
+} CostBand;
+
+static CostRowFn cost_row;
+static const char *cost_row_name;
+
+/* ================================================================= FUNCTION DEFINITIONS ============================================================================= */
+
+/* |a - b| of two samples with their LSB dropped */
+static inline unsigned char absdiff7(unsigned char a, unsigned char b)
+{
+    a >>= 1;
+    b >>= 1;
+    return a > b ? a - b : b - a;
+}
+
+/* Border samples (first / last pixel of the row) have no left / right neighbour and cost 0 */
+static void cost_row_scalar(unsigned char *cost, const unsigned char *up, const unsigned char *row, const unsigned char *down, size_t n)
+{
+    memset(cost, 0, n < 3 ? n : 3);
+    for (size_t x = 3; x + 3 < n; x++)
+    {
+        cost[x] = absdiff7(row[x - 3], row[x + 3]) + absdiff7(up[x], down[x]);
+    }
+    if (n > 3)
+    {
+        memset(cost + n - 3, 0, 3);
+    }
+}
+
+#ifdef ADAPTIVE_HAVE_X86
+__attribute__((target("sse2")))
+static void cost_row_sse2(unsigned char *cost, const unsigned char *up, const unsigned char *row, const unsigned char *down, size_t n)
+{
+    const __m128i m7f = _mm_set1_epi8(0x7F);
+    size_t x = 3;
+
+    memset(cost, 0, n < 3 ? n : 3);
+    for (; x + 16 + 3 <= n; x += 16)
+    {
+        __m128i l = _mm_and_si128(_mm_srli_epi16(_mm_loadu_si128((const __m128i *)(row + x - 3)), 1), m7f);
+        __m128i r = _mm_and_si128(_mm_srli_epi16(_mm_loadu_si128((const __m128i *)(row + x + 3)), 1), m7f);
+        __m128i u = _mm_and_si128(_mm_srli_epi16(_mm_loadu_si128((const __m128i *)(up + x)), 1), m7f);
+        __m128i d = _mm_and_si128(_mm_srli_epi16(_mm_loadu_si128((const __m128i *)(down + x)), 1), m7f);
+        __m128i h = _mm_or_si128(_mm_subs_epu8(l, r), _mm_subs_epu8(r, l));
+        __m128i v = _mm_or_si128(_mm_subs_epu8(u, d), _mm_subs_epu8(d, u));
+        _mm_storeu_si128((__m128i *)(cost + x), _mm_add_epi8(h, v));
+    }
+    for (; x + 3 < n; x++)
+    {
+        cost[x] = absdiff7(row[x - 3], row[x + 3]) + absdiff7(up[x], down[x]);
+    }
+    if (n > 3)
+    {
+        memset(cost + n - 3, 0, 3);
+    }
+}
+
+__attribute__((target("avx2")))
+static void cost_row_avx2(unsigned char *cost, const unsigned char *up, const unsigned char *row, const unsigned char *down, size_t n)
+{
+    const __m256i m7f = _mm256_set1_epi8(0x7F);
+    size_t x = 3;
+
+    memset(cost, 0, n < 3 ? n : 3);
+    for (; x + 32 + 3 <= n; x += 32)
+    {
+        __m256i l = _mm256_and_si256(_mm256_srli_epi16(_mm256_loadu_si256((const __m256i *)(row + x - 3)), 1), m7f);
+        __m256i r = _mm256_and_si256(_mm256_srli_epi16(_mm256_loadu_si256((const __m256i *)(row + x + 3)), 1), m7f);
+        __m256i u = _mm256_and_si256(_mm256_srli_epi16(_mm256_loadu_si256((const __m256i *)(up + x)), 1), m7f);
+        __m256i d = _mm256_and_si256(_mm256_srli_epi16(_mm256_loadu_si256((const __m256i *)(down + x)), 1), m7f);
+        __m256i h = _mm256_or_si256(_mm256_subs_epu8(l, r), _mm256_subs_epu8(r, l));
+        __m256i v = _mm256_or_si256(_mm256_subs_epu8(u, d), _mm256_subs_epu8(d, u));
+        _mm256_storeu_si256((__m256i *)(cost + x), _mm256_add_epi8(h, v));
+    }
+    for (; x + 3 < n; x++)
+    {
+        cost[x] = absdiff7(row[x - 3], row[x + 3]) + absdiff7(up[x], down[x]);
+    }
+    if (n > 3)
+    {
+        memset(cost + n - 3, 0, 3);
+    }
+}
+#endif
+
+/* Pick the widest row kernel once */
+static void cost_init(void)
+{
+    cost_row = cost_row_scalar;
+    cost_row_name = "scalar";
+#ifdef ADAPTIVE_HAVE_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2"))
+    {
+        cost_row = cost_row_avx2;
+        cost_row_name = "avx2";
+    }
+    else if (__builtin_cpu_supports("sse2"))
+    {
+        cost_row = cost_row_sse2;
+        cost_row_name = "sse2";
+    }
+#endif
+}
+
+/* Row kernel chosen once, daemon workers may race to be first */
+static void cost_setup(void)
+{
+    static pthread_once_t once = PTHREAD_ONCE_INIT;
+    pthread_once(&once, cost_init);
+}
+
+/* Worker: cost every row of a band and count the costs */
+static void *cost_band(void *arg)
+{
+    CostBand *band = arg;
+    CostMap *map = band->map;
+    size_t skip = ADAPTIVE_HEADER_BYTES - BMP_HEADER;
+    unsigned long long part[4][256];
+
+    memset(part, 0, sizeof(part));
+
+    for (size_t y = band->y0; y < band->y1; y++)
+    {
+        unsigned char *c = map->cost + y * map->stride;
+        const unsigned char *row = map->pixels + y * map->stride;
+
+        // STEP 1 : Top and bottom rows have no vertical neighbour, padding never carries data
+        if (y == 0 || y + 1 == map->height)
+        {
+            memset(c, 0, map->stride);
+        }
+        else
+        {
+            cost_row(c, row - map->stride, row, row + map->stride, map->width3);
+            memset(c + map->width3, 0, map->stride - map->width3);
+        }
+
+        // STEP 2 : Bytes holding magic, mode word and threshold are not part of the adaptive region
+        if (y * map->stride < skip)
+        {
+            size_t n = skip - y * map->stride;
+            memset(c, 0, n < map->stride ? n : map->stride);
+        }
+
+        // STEP 3 : Histogram for the threshold choice (four partial tables so repeated costs do not serialize)
+        size_t x = 0;
+        for (; x + 4 <= map->width3; x += 4)
+        {
+            part[0][c[x]]++;
+            part[1][c[x + 1]]++;
+            part[2][c[x + 2]]++;
+            part[3][c[x + 3]]++;
+        }
+        for (; x < map->width3; x++)
+        {
+            part[0][c[x]]++;
+        }
+    }
+    for (int v = 0; v < 256; v++)
+    {
+        band->hist[v] = part[0][v] + part[1][v] + part[2][v] + part[3][v];
+    }
+    return NULL;
+}
+
+/* Geometry of the mapped BMP and its cost map, built by one band of rows per CPU */
+static Status build_cost_map(const unsigned char *image, size_t image_size, CostMap *map)
+{
+    struct timespec t0, t1;
+
+    memset(map, 0, sizeof(*map));
+    if (image_size < ADAPTIVE_HEADER_BYTES)
+    {
+        printf("Error: Image too small for adaptive embedding.\n");
+        return e_failure;
+    }
+
+    // STEP 1 : Rows from the BMP header (little endian width at 18, height at 22), 4 byte aligned
+    int32_t width = image[18] | image[19] << 8 | image[20] << 16 | (uint32_t)image[21] << 24;
+    int32_t height = image[22] | image[23] << 8 | image[24] << 16 | (uint32_t)image[25] << 24;
+    map->width3 = (size_t)(width < 0 ? -(int64_t)width : width) * 3;
+    map->stride = (map->width3 + 3) & ~(size_t)3;
+    map->height = height < 0 ? -(int64_t)height : height;
+    if (map->stride == 0 || map->height < 3 || map->stride * map->height > image_size - BMP_HEADER)
+    {
+        printf("Error: BMP dimensions do not match the file size.\n");
+        return e_failure;
+    }
+    map->pixels = image + BMP_HEADER;
+    map->cost = malloc(map->stride * map->height);
+    if (map->cost == NULL)
+    {
+        printf("Error: Unable to allocate the cost map.\n");
+        return e_failure;
+    }
+
+    // STEP 2 : One band per CPU
+    cost_setup();
+    long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    size_t threads = cpus > 0 ? (size_t)cpus : 1;
+    if (threads > map->height)
+    {
+        threads = map->height;
+    }
+    CostBand bands[threads];
+    pthread_t tids[threads];
+    int started[threads];
+
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+    for (size_t i = 0; i < threads; i++)
+    {
+        memset(&bands[i], 0, sizeof(bands[i]));
+        bands[i].map = map;
+        bands[i].y0 = map->height * i / threads;
+        bands[i].y1 = map->height * (i + 1) / threads;
+        started[i] = pthread_create(&tids[i], NULL, cost_band, &bands[i]) == 0;
+    }
+    for (size_t i = 0; i < threads; i++)
+    {
+        // A band whose thread did not start is costed here, every row must be set for encoder and decoder to agree
+        if (started[i])
+        {
+            pthread_join(tids[i], NULL);
+        }
+        else
+        {
+            cost_band(&bands[i]);
+        }
+        for (int c = 0; c < 256; c++)
+        {
+            map->hist[c] += bands[i].hist[c];
+        }
+    }
+    clock_gettime(CLOCK_MONOTONIC, &t1);
+
+    printf("Cost map: %zux%zu in %.1f ms (%s, %zu threads).\n", map->width3 / 3, map->height,
+           (t1.tv_sec - t0.tv_sec) * 1e3 + (t1.tv_nsec - t0.tv_nsec) / 1e6, cost_row_name, threads);
+    return e_success;
+}
+
+/* Extended magic, MODE_ADAPTIVE, cost threshold, then the payload fields in the textured samples */
+Status encode_adaptive_payload(EncodeInfo *encInfo)
+{
+    CostMap map;
+    size_t image_size;
+    unsigned char prefix[16];
+    size_t prefix_len = 0;
+    size_t extn_len = strlen(encInfo->extn_secret_file);
+
+    // STEP 1 : Cost map of the clone (the stego stream is a full copy of the source at this point)
+    if (fflush(encInfo->fptr_stego_image) != 0)
+    {
+        return e_failure;
+    }
+    unsigned char *image = map_image_file(encInfo->fptr_stego_image, encInfo->stego_image_fname, 1, &image_size);
+    if (image == NULL)
+    {
+        printf("Error: Unable to map the stego image.\n");
+        return e_failure;
+    }
+    if (build_cost_map(image, image_size, &map) == e_failure)
+    {
+        munmap(image, image_size);
+        return e_failure;
+    }
+
+    // STEP 2 : Highest threshold that still leaves one sample per payload bit
+    unsigned long long needed = ((unsigned long long)4 + extn_len + 4 + encInfo->size_secret_file) * 8;
+    unsigned long long available = 0;
+    int threshold = 255;
+    for (; threshold >= 1; threshold--)
+    {
+        available += map.hist[threshold];
+        if (available >= needed)
+        {
+            break;
+        }
+    }
+    if (threshold < 1)
+    {
+        printf("Error: Insufficient textured capacity, %llu of %llu payload bits fit.\n", available, needed);
+        free(map.cost);
+        munmap(image, image_size);
+        return e_failure;
+    }
+    printf("Adaptive threshold %d: %llu of %zu samples eligible, %llu used.\n", threshold, available, map.width3 * map.height, needed);
+
+    // STEP 3 : Extended magic, mode word and threshold in file order through the streams, then flushed into the mapping
+    munmap(image, image_size);
+    if (fseek(encInfo->fptr_stego_image, BMP_HEADER, SEEK_SET) != 0 ||
+        encode_magic_string(MAGIC_STRING_EXT, encInfo) == e_failure ||
+        encode_mode_word(MODE_ADAPTIVE, encInfo) == e_failure ||
+        encode_mode_word(threshold, encInfo) == e_failure ||
+        fflush(encInfo->fptr_stego_image) != 0 ||
+        (image = map_image_file(encInfo->fptr_stego_image, encInfo->stego_image_fname, 1, &image_size)) == NULL)
+    {
+        printf("Error: Failed to encode adaptive header.\n");
+        free(map.cost);
+        return e_failure;
+    }
+
+    // STEP 4 : Payload fields, one bit per eligible sample in file order
+    for (int shift = 24; shift >= 0; shift -= 8)
+    {
+        prefix[prefix_len++] = extn_len >> shift;
+    }
+    memcpy(prefix + prefix_len, encInfo->extn_secret_file, extn_len);
+    prefix_len += extn_len;
+    for (int shift = 24; shift >= 0; shift -= 8)
+    {
+        prefix[prefix_len++] = encInfo->size_secret_file >> shift;
+    }
+
+    unsigned char buf[64 * 1024];
+    size_t buf_len = 0, buf_pos = 0, prefix_pos = 0;
+    unsigned char *pixels = image + BMP_HEADER;
+    unsigned long long done = 0;
+    int bit = -1;
+    unsigned char cur = 0;
+    Status ret = e_success;
+    for (size_t i = 0; done < needed && i < map.stride * map.height; i++)
+    {
+        if (map.cost[i] < threshold)
+        {
+            continue;
+        }
+        if (bit < 0)
+        {
+            // Next payload byte: header fields first, then the secret file
+            if (prefix_pos < prefix_len)
+            {
+                cur = prefix[prefix_pos++];
+            }
+            else
+            {
+                if (buf_pos == buf_len)
+                {
+                    buf_len = fread(buf, 1, sizeof(buf), encInfo->fptr_secret);
+                    buf_pos = 0;
+                    if (buf_len == 0)
+                    {
+                        printf("Error: Secret file ended early.\n");
+                        ret = e_failure;
+                        break;
+                    }
+                }
+                cur = buf[buf_pos++];
+            }
+            bit = 7;
+        }
+        pixels[i] = (pixels[i] & 0xFE) | ((cur >> bit--) & 1);
+        done++;
+    }
+
+    free(map.cost);
+    if (munmap(image, image_size) != 0)
+    {
+        ret = e_failure;
+    }
+    return ret;
+}
+
+/* Extract the payload fields from the samples at or above decInfo->adaptive_threshold */
+Status decode_adaptive_payload(DecodeInfo *decInfo)
+{
+    CostMap map;
+    PayloadParser parser;
+    size_t image_size;
+    uint threshold = decInfo->adaptive_threshold;
+
+    if (threshold < 1 || threshold > 255)
+    {
+        printf("ERROR! Invalid adaptive threshold %u\n", threshold);
+        return e_failure;
+    }
+
+    // STEP 1 : Same cost map as the encoder (LSBs do not enter it)
+    unsigned char *image = map_image_file(decInfo->fptr_stego_image, NULL, 0, &image_size);
+    if (image == NULL || build_cost_map(image, image_size, &map) == e_failure)
+    {
+        printf("ERROR! Cannot map the stego image\n");
+        if (image != NULL)
+        {
+            munmap(image, image_size);
+        }
+        return e_failure;
+    }
+
+    // STEP 2 : Bits of the eligible samples in file order, through the payload parser
+    memset(&parser, 0, sizeof(parser));
+    const unsigned char *pixels = image + BMP_HEADER;
+    unsigned char cur = 0;
+    int nbits = 0;
+    for (size_t i = 0; !parser.done && !parser.failed && i < map.stride * map.height; i++)
+    {
+        if (map.cost[i] < threshold)
+        {
+            continue;
+        }
+        cur = (cur << 1) | (pixels[i] & 1);
+        if (++nbits == 8)
+        {
+            parse_payload_byte(decInfo, &parser, cur);
+            nbits = 0;
+        }
+    }
+
+    free(map.cost);
+    munmap(image, image_size);
+    if (!parser.done)
+    {
+        printf("ERROR! Adaptive payload is %s\n", parser.failed ? "corrupt" : "truncated");
+        return e_failure;
+    }
+    return e_success;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/* ============================================================================= END OF CODE ===========================================================================*/
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -0,0 +1,37 @@
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// ============================================================ * * * * * adaptive.h * * * * * ======================================================================== //
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/*
+
+### USAGE OF adaptive.h FILE IN STEGANOGRAPHY PROJECT ?
+--> THIS HEADER FILE DECLARES THE CONTENT-ADAPTIVE EMBEDDING MODE. INSTEAD OF FILLING PIXEL BYTES IN FILE ORDER, A COST MAP (LOCAL GRADIENT OF EVERY COLOUR SAMPLE) IS
+    COMPUTED AND THE PAYLOAD GOES ONLY INTO THE MOST TEXTURED SAMPLES, SO FLAT AREAS STAY UNTOUCHED. THE MAP IS BUILT FROM THE SAMPLES WITH THEIR LSB DROPPED, SO
+    EMBEDDING DOES NOT CHANGE IT AND THE DECODER RECOMPUTES THE SAME MAP AND THE SAME POSITIONS FROM THE STEGO IMAGE AND THE STORED COST THRESHOLD.
+
+*/
+
+// ==================================================================================================================================================================== //
+
+#ifndef ADAPTIVE_H
+#define ADAPTIVE_H
+
+/* ====================================================================== INCLUDES ==================================================================================== */
+
+#include "types.h"
+#include "encode.h"
+#include "decode.h"
+
+/* ================================================================= FUNCTION PROTOTYPES ============================================================================== */
+
+/* Extended magic, MODE_ADAPTIVE, cost threshold, then the payload fields in the textured samples (streams positioned after the BMP header) */
+Status encode_adaptive_payload(EncodeInfo *encInfo);
+
+/* Extract the payload fields from the samples at or above decInfo->adaptive_threshold */
+Status decode_adaptive_payload(DecodeInfo *decInfo);
+
+#endif
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/* ============================================================================= END OF CODE ===========================================================================*/
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -0,0 +1,551 @@
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// ============================================================= * * * * * analyze.c * * * * * ======================================================================== //
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/*
+
+### USAGE OF analyze.c FILE IN STEGANOGRAPHY PROJECT ?
+--> THIS FILE IMPLEMENTS THE STEGANALYSIS MODE. THE PIXEL ARRAY OF AN IMAGE IS MAPPED AND WALKED ONCE IN ANALYZE_STEPS CHUNKS. EACH CHUNK IS ADDED TO A RUNNING BYTE
+    HISTOGRAM (FOUR INTERLEAVED PARTIAL TABLES, SO REPEATED VALUES DO NOT SERIALIZE ON ONE COUNTER) AND THE CHI-SQUARE P VALUE OF THE PREFIX SO FAR IS TAKEN FROM THE
+    PAIRS OF VALUES 2K / 2K + 1. THE SAME CHUNK IS THEN FED TO THE RS KERNEL: EVERY FOUR SAMPLES OF ONE COLOUR CHANNEL IN A ROW (BYTES J, J + 3, J + 6, J + 9) FORM A
+    GROUP, WHOSE SMOOTHNESS IS COMPARED BEFORE AND AFTER FLIPPING THE MIDDLE TWO SAMPLES WITH F1 AND F-1, ON THE IMAGE AND ON ITS LSB-FLIPPED COPY. THE SSE2 / AVX2
+    KERNELS DO 8 / 16 GROUPS AT A TIME IN 16 BIT LANES. THE FOUR REGULAR - SINGULAR DIFFERENCES GIVE THE EMBEDDING RATE THROUGH THE USUAL RS QUADRATIC.
+
+*/
+
+/* ====================================================================== INCLUDES ==================================================================================== */
+
+#include <stdio.h>          // printf, fopen
+#include <stdlib.h>         // calloc, free, atoi
+#include <string.h>         // memset, strcmp
+#include <stdint.h>         // Partial histogram counters
+#include <math.h>           // lgamma, exp, sqrt
+#include <pthread.h>        // Image workers
+#include <unistd.h>         // sysconf
+#include <time.h>           // clock_gettime
+#include <sys/mman.h>       // munmap
+#include "types.h"          // Status
+#include "common.h"         // OPTION_VALUE
+#include "encode.h"         // read_bmp_geometry
+#include "fastcopy.h"       // map_image_file
+#include "index.h"          // ImageList, image_list_add
+#include "analyze.h"        // Prototypes
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>      // SSE2 / AVX2 RS kernels
+#define ANALYZE_HAVE_X86 1
+#endif
+
+/* ======================================================================= MACROS ===================================================================================== */
+
+#define BMP_HEADER 54       // Pixel data offset the rest of the project assumes
+#define RS_SPAN 9           // Distance from the first to the last byte of a group
+#define RS_FLUSH 16384      // Vector iterations before the 16 bit counters are widened
+
+/* ======================================================================= STRUCTURE ================================================================================== */
+
+/* Images of one run and their results, in input order */
+typedef struct
+{
+    ImageList images;
+    AnalyzeResult *results;
+    int next;               // Next image handed to a worker
+} AnalyzeSet;
+
+/* Kernel over the groups starting at 0 .. groups - 1; d[] gets R - S of M, -M, M on the flipped image, -M on the flipped image */
+typedef void (*RsFn)(const unsigned char *b, size_t groups, long long d[4]);
+
+static RsFn rs_groups;
+static size_t rs_width;             // Groups per vector iteration (0 = scalar only)
+static const char *rs_name = "scalar";
+
+/* ================================================================= FUNCTION DEFINITIONS ============================================================================= */
+
+/* Regularised upper incomplete gamma Q(a, x): series below a + 1, continued fraction above */
+static double gamma_q(double a, double x)
+{
+    if (x <= 0)
+    {
+        return 1.0;
+    }
+    double front = exp(-x + a * log(x) - lgamma(a));
+    if (x < a + 1)
+    {
+        double ap = a, del = 1.0 / a, sum = del;
+        for (int n = 0; n < 1000 && fabs(del) > fabs(sum) * 1e-12; n++)
+        {
+            ap += 1;
+            del *= x / ap;
+            sum += del;
+        }
+        return 1.0 - sum * front;
+    }
+
+    double b = x + 1 - a, c = 1e300, d = 1.0 / b, h = d;
+    for (int i = 1; i < 1000; i++)
+    {
+        double an = -i * (i - a);
+        b += 2;
+        d = an * d + b;
+        c = b + an / c;
+        d = fabs(d) < 1e-300 ? 1e300 : 1.0 / d;
+        c = fabs(c) < 1e-300 ? 1e-300 : c;
+        h *= d * c;
+        if (fabs(d * c - 1) < 1e-12)
+        {
+            break;
+        }
+    }
+    return front * h;
+}
+
+/* Chi-square p value of the pairs of values: near 1 when every pair 2k / 2k + 1 is equally frequent, as LSB replacement leaves it */
+static double pairs_p_value(const unsigned long long hist[256])
+{
+    double chi2 = 0;
+    int categories = 0;
+
+    for (int k = 0; k < 128; k++)
+    {
+        double expected = (hist[2 * k] + hist[2 * k + 1]) / 2.0;
+        if (expected > 4)
+        {
+            double diff = hist[2 * k] - expected;
+            chi2 += diff * diff / expected;
+            categories++;
+        }
+    }
+    return categories > 1 ? gamma_q((categories - 1) / 2.0, chi2 / 2) : 0.0;
+}
+
+/* Add len bytes to hist, 8 bytes per load spread over four partial tables */
+static void add_histogram(unsigned long long hist[256], const unsigned char *b, size_t len)
+{
+    uint32_t part[4][256];
+    size_t i = 0;
+
+    memset(part, 0, sizeof(part));
+    while (i < len)
+    {
+        // Partial counts are 32 bit, so very large chunks are taken in slices
+        size_t end = len - i > (1u << 30) ? i + (1u << 30) : len;
+        for (; i + 8 <= end; i += 8)
+        {
+            uint64_t w;
+            memcpy(&w, b + i, 8);
+            part[0][w & 0xFF]++;
+            part[1][(w >> 8) & 0xFF]++;
+            part[2][(w >> 16) & 0xFF]++;
+            part[3][(w >> 24) & 0xFF]++;
+            part[0][(w >> 32) & 0xFF]++;
+            part[1][(w >> 40) & 0xFF]++;
+            part[2][(w >> 48) & 0xFF]++;
+            part[3][w >> 56]++;
+        }
+        for (; i < end; i++)
+        {
+            part[0][b[i]]++;
+        }
+        for (int v = 0; v < 256; v++)
+        {
+            hist[v] += part[0][v] + part[1][v] + part[2][v] + part[3][v];
+            part[0][v] = part[1][v] = part[2][v] = part[3][v] = 0;
+        }
+    }
+}
+
+/* F-1 flipping: 2k <-> 2k - 1 */
+static inline int flip_neg(int x)
+{
+    return x + ((x & 1) << 1) - 1;
+}
+
+/* Smoothness of a group: sum of the absolute steps between neighbours */
+static inline int smooth(int a, int b, int c, int d)
+{
+    return abs(b - a) + abs(c - b) + abs(d - c);
+}
+
+/* +1 for a regular group (flipping made it rougher), -1 for a singular one */
+static inline int rs_class(int f, int flipped)
+{
+    return (flipped > f) - (flipped < f);
+}
+
+static void rs_scalar(const unsigned char *b, size_t from, size_t to, long long d[4])
+{
+    for (size_t j = from; j < to; j++)
+    {
+        int x0 = b[j], x1 = b[j + 3], x2 = b[j + 6], x3 = b[j + 9];
+        int y0 = x0 ^ 1, y1 = x1 ^ 1, y2 = x2 ^ 1, y3 = x3 ^ 1;
+        int f = smooth(x0, x1, x2, x3);
+        int g = smooth(y0, y1, y2, y3);
+
+        d[0] += rs_class(f, smooth(x0, y1, y2, x3));
+        d[1] += rs_class(f, smooth(x0, flip_neg(x1), flip_neg(x2), x3));
+        d[2] += rs_class(g, smooth(y0, x1, x2, y3));
+        d[3] += rs_class(g, smooth(y0, flip_neg(y1), flip_neg(y2), y3));
+    }
+}
+
+#ifdef ANALYZE_HAVE_X86
+__attribute__((target("sse2")))
+static inline __m128i smooth_sse2(__m128i a, __m128i b, __m128i c, __m128i d)
+{
+    __m128i s = _mm_max_epi16(_mm_sub_epi16(b, a), _mm_sub_epi16(a, b));
+    s = _mm_add_epi16(s, _mm_max_epi16(_mm_sub_epi16(c, b), _mm_sub_epi16(b, c)));
+    return _mm_add_epi16(s, _mm_max_epi16(_mm_sub_epi16(d, c), _mm_sub_epi16(c, d)));
+}
+
+__attribute__((target("sse2")))
+static void rs_sse2(const unsigned char *b, size_t groups, long long d[4])
+{
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i one = _mm_set1_epi16(1);
+    __m128i acc[4] = { zero, zero, zero, zero };
+    size_t iter = 0;
+
+    for (size_t j = 0; j < groups; j += 8)
+    {
+        __m128i x0 = _mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i *)(b + j)), zero);
+        __m128i x1 = _mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i *)(b + j + 3)), zero);
+        __m128i x2 = _mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i *)(b + j + 6)), zero);
+        __m128i x3 = _mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i *)(b + j + 9)), zero);
+        __m128i y0 = _mm_xor_si128(x0, one), y1 = _mm_xor_si128(x1, one), y2 = _mm_xor_si128(x2, one), y3 = _mm_xor_si128(x3, one);
+        __m128i n1 = _mm_add_epi16(_mm_sub_epi16(x1, one), _mm_slli_epi16(_mm_and_si128(x1, one), 1));
+        __m128i n2 = _mm_add_epi16(_mm_sub_epi16(x2, one), _mm_slli_epi16(_mm_and_si128(x2, one), 1));
+        __m128i m1 = _mm_add_epi16(_mm_sub_epi16(y1, one), _mm_slli_epi16(_mm_and_si128(y1, one), 1));
+        __m128i m2 = _mm_add_epi16(_mm_sub_epi16(y2, one), _mm_slli_epi16(_mm_and_si128(y2, one), 1));
+        __m128i f = smooth_sse2(x0, x1, x2, x3);
+        __m128i g = smooth_sse2(y0, y1, y2, y3);
+        __m128i t[4] = { smooth_sse2(x0, y1, y2, x3), smooth_sse2(x0, n1, n2, x3), smooth_sse2(y0, x1, x2, y3), smooth_sse2(y0, m1, m2, y3) };
+
+        // Compare masks are -1, so regular - singular = (f > t) - (t > f) as masks
+        for (int k = 0; k < 4; k++)
+        {
+            __m128i base = k < 2 ? f : g;
+            acc[k] = _mm_add_epi16(acc[k], _mm_sub_epi16(_mm_cmpgt_epi16(base, t[k]), _mm_cmpgt_epi16(t[k], base)));
+        }
+        if (++iter == RS_FLUSH || j + 8 >= groups)
+        {
+            for (int k = 0; k < 4; k++)
+            {
+                int32_t lanes[4];
+                _mm_storeu_si128((__m128i *)lanes, _mm_madd_epi16(acc[k], one));
+                d[k] += (long long)lanes[0] + lanes[1] + lanes[2] + lanes[3];
+                acc[k] = zero;
+            }
+            iter = 0;
+        }
+    }
+}
+
+__attribute__((target("avx2")))
+static inline __m256i smooth_avx2(__m256i a, __m256i b, __m256i c, __m256i d)
+{
+    __m256i s = _mm256_abs_epi16(_mm256_sub_epi16(b, a));
+    s = _mm256_add_epi16(s, _mm256_abs_epi16(_mm256_sub_epi16(c, b)));
+    return _mm256_add_epi16(s, _mm256_abs_epi16(_mm256_sub_epi16(d, c)));
+}
+
+__attribute__((target("avx2")))
+static inline __m256i flip_neg_avx2(__m256i x, __m256i one)
+{
+    return _mm256_add_epi16(_mm256_sub_epi16(x, one), _mm256_slli_epi16(_mm256_and_si256(x, one), 1));
+}
+
+__attribute__((target("avx2")))
+static void rs_avx2(const unsigned char *b, size_t groups, long long d[4])
+{
+    const __m256i zero = _mm256_setzero_si256();
+    const __m256i one = _mm256_set1_epi16(1);
+    __m256i acc[4] = { zero, zero, zero, zero };
+    size_t iter = 0;
+
+    for (size_t j = 0; j < groups; j += 16)
+    {
+        __m256i x0 = _mm256_cvtepu8_epi16(_mm_loadu_si128((const __m128i *)(b + j)));
+        __m256i x1 = _mm256_cvtepu8_epi16(_mm_loadu_si128((const __m128i *)(b + j + 3)));
+        __m256i x2 = _mm256_cvtepu8_epi16(_mm_loadu_si128((const __m128i *)(b + j + 6)));
+        __m256i x3 = _mm256_cvtepu8_epi16(_mm_loadu_si128((const __m128i *)(b + j + 9)));
+        __m256i y0 = _mm256_xor_si256(x0, one), y1 = _mm256_xor_si256(x1, one);
+        __m256i y2 = _mm256_xor_si256(x2, one), y3 = _mm256_xor_si256(x3, one);
+        __m256i f = smooth_avx2(x0, x1, x2, x3);
+        __m256i g = smooth_avx2(y0, y1, y2, y3);
+        __m256i t[4] = { smooth_avx2(x0, y1, y2, x3), smooth_avx2(x0, flip_neg_avx2(x1, one), flip_neg_avx2(x2, one), x3),
+                         smooth_avx2(y0, x1, x2, y3), smooth_avx2(y0, flip_neg_avx2(y1, one), flip_neg_avx2(y2, one), y3) };
+
+        for (int k = 0; k < 4; k++)
+        {
+            __m256i base = k < 2 ? f : g;
+            acc[k] = _mm256_add_epi16(acc[k], _mm256_sub_epi16(_mm256_cmpgt_epi16(base, t[k]), _mm256_cmpgt_epi16(t[k], base)));
+        }
+        if (++iter == RS_FLUSH || j + 16 >= groups)
+        {
+            for (int k = 0; k < 4; k++)
+            {
+                int32_t lanes[8];
+                _mm256_storeu_si256((__m256i *)lanes, _mm256_madd_epi16(acc[k], one));
+                for (int l = 0; l < 8; l++)
+                {
+                    d[k] += lanes[l];
+                }
+                acc[k] = zero;
+            }
+            iter = 0;
+        }
+    }
+}
+#endif
+
+/* Pick the widest RS kernel once */
+static void rs_init(void)
+{
+#ifdef ANALYZE_HAVE_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2"))
+    {
+        rs_groups = rs_avx2;
+        rs_width = 16;
+        rs_name = "avx2";
+    }
+    else if (__builtin_cpu_supports("sse2"))
+    {
+        rs_groups = rs_sse2;
+        rs_width = 8;
+        rs_name = "sse2";
+    }
+#endif
+}
+
+/* RS kernel chosen once, even with several callers starting together */
+static void rs_setup(void)
+{
+    static pthread_once_t once = PTHREAD_ONCE_INIT;
+    pthread_once(&once, rs_init);
+}
+
+/* R - S counts of the groups starting in [from, to); the caller keeps to + RS_SPAN inside the pixel array */
+static void rs_range(const unsigned char *b, size_t from, size_t to, long long d[4])
+{
+    if (rs_groups != NULL && to - from >= rs_width)
+    {
+        size_t vec = (to - from) / rs_width * rs_width;
+        rs_groups(b + from, vec, d);
+        from += vec;
+    }
+    rs_scalar(b, from, to, d);
+}
+
+/* Embedding rate from the R - S differences: root of 2(d1 + d0)x^2 + (d-0 - d-1 - d1 - 3d0)x + d0 - d-0 closest to 0, rate = x / (x - 1/2) */
+static double rs_rate(const long long d[4])
+{
+    double d0 = d[0], dn0 = d[1], d1 = d[2], dn1 = d[3];
+    double a = 2 * (d1 + d0), b = dn0 - dn1 - d1 - 3 * d0, c = d0 - dn0;
+    double x;
+
+    if (fabs(a) < 1e-9)
+    {
+        x = fabs(b) < 1e-9 ? 0 : -c / b;
+    }
+    else
+    {
+        double disc = b * b - 4 * a * c;
+        disc = disc > 0 ? sqrt(disc) : 0;
+        double r1 = (-b + disc) / (2 * a), r2 = (-b - disc) / (2 * a);
+        x = fabs(r1) < fabs(r2) ? r1 : r2;
+    }
+    double rate = fabs(x - 0.5) < 1e-12 ? 1.0 : x / (x - 0.5);
+    return rate < 0 ? 0 : rate > 1 ? 1 : rate;
+}
+
+Status analyze_image(const char *fname, AnalyzeResult *res)
+{
+    unsigned long long hist[256];
+    long long d[4] = { 0, 0, 0, 0 };
+    uint width = 0, height = 0;
+    size_t size = 0;
+    unsigned char *image = NULL;
+
+    memset(res, 0, sizeof(*res));
+    res->status = e_failure;
+    rs_setup();
+
+    // STEP 1 : Geometry from the header, then the whole file mapped read-only
+    FILE *fp = fopen(fname, "r");
+    if (fp == NULL)
+    {
+        perror(fname);
+        return e_failure;
+    }
+    if (read_bmp_geometry(fp, &width, &height) == e_success)
+    {
+        image = map_image_file(fp, NULL, 0, &size);
+    }
+    fclose(fp);
+    if (image == NULL || size <= BMP_HEADER + RS_SPAN || image[0] != 'B' || image[1] != 'M')
+    {
+        printf("Error: %s is not a readable BMP image\n", fname);
+        if (image != NULL)
+        {
+            munmap(image, size);
+        }
+        return e_failure;
+    }
+
+    const unsigned char *pixels = image + BMP_HEADER;
+    unsigned long long n = (unsigned long long)width * height * 3;
+    n = n < size - BMP_HEADER ? n : size - BMP_HEADER;
+    size_t groups = n > RS_SPAN ? n - RS_SPAN : 0;
+    res->pixel_bytes = n;
+
+    // STEP 2 : One pass in chunks: running histogram and chi-square p of every prefix, RS counts of the groups starting in the chunk
+    memset(hist, 0, sizeof(hist));
+    int leading = 1;
+    for (int step = 1; step <= ANALYZE_STEPS; step++)
+    {
+        size_t from = n * (step - 1) / ANALYZE_STEPS, to = n * step / ANALYZE_STEPS;
+        add_histogram(hist, pixels + from, to - from);
+        res->chi_p = pairs_p_value(hist);
+        if (leading && res->chi_p >= ANALYZE_CHI_LIMIT)
+        {
+            res->prefix = step * 100 / ANALYZE_STEPS;
+        }
+        else
+        {
+            leading = 0;
+        }
+
+        size_t rs_to = to < groups ? to : groups;
+        if (from < rs_to)
+        {
+            rs_range(pixels, from, rs_to, d);
+        }
+    }
+    res->rs_rate = rs_rate(d);
+
+    munmap(image, size);
+    res->status = e_success;
+    return e_success;
+}
+
+/* Worker body: take the next image until all are done */
+static void *analyze_worker(void *arg)
+{
+    AnalyzeSet *set = arg;
+    int i;
+
+    while ((i = __atomic_fetch_add(&set->next, 1, __ATOMIC_RELAXED)) < set->images.count)
+    {
+        analyze_image(set->images.names[i], &set->results[i]);
+    }
+    return NULL;
+}
+
+Status do_analyze(char *paths[], int count, int opt_count, char *opts[])
+{
+    AnalyzeSet set;
+    long threads = 0;
+    const char *value;
+    struct timespec t0, t1;
+    Status ret = e_success;
+
+    memset(&set, 0, sizeof(set));
+
+    // STEP 1 : Options
+    for (int i = 0; i < opt_count; i++)
+    {
+        if ((value = OPTION_VALUE(opts[i], "--threads=")) != NULL && atoi(value) > 0)
+        {
+            threads = atoi(value);
+        }
+        else
+        {
+            printf("Error: Unknown analyze option %s\n", opts[i]);
+            return e_failure;
+        }
+    }
+
+    // STEP 2 : Image list (directories are walked for .bmp files)
+    for (int i = 0; i < count && ret == e_success; i++)
+    {
+        ret = image_list_add(&set.images, paths[i]);
+    }
+    if (ret == e_success && set.images.count == 0)
+    {
+        printf("Error: No BMP images to analyse\n");
+        ret = e_failure;
+    }
+    if (ret == e_success && (set.results = calloc(set.images.count, sizeof(*set.results))) == NULL)
+    {
+        ret = e_failure;
+    }
+
+    // STEP 3 : One image per worker at a time (one worker per CPU unless given)
+    if (ret == e_success)
+    {
+        if (threads <= 0)
+        {
+            threads = sysconf(_SC_NPROCESSORS_ONLN);
+            threads = threads > 0 ? threads : 1;
+        }
+        if (threads > set.images.count)
+        {
+            threads = set.images.count;
+        }
+
+        pthread_t tids[threads];
+        rs_setup();
+        clock_gettime(CLOCK_MONOTONIC, &t0);
+        long started = 0;
+        while (started < threads && pthread_create(&tids[started], NULL, analyze_worker, &set) == 0)
+        {
+            started++;
+        }
+
+        // A worker that did not start leaves its images to this thread, so every image is still done
+        if (started < threads)
+        {
+            analyze_worker(&set);
+            threads = started + 1;
+        }
+        for (long i = 0; i < started; i++)
+        {
+            pthread_join(tids[i], NULL);
+        }
+        clock_gettime(CLOCK_MONOTONIC, &t1);
+
+        // STEP 4 : Report in input order
+        unsigned long long bytes = 0;
+        int flagged = 0, failed = 0;
+        for (int i = 0; i < set.images.count; i++)
+        {
+            AnalyzeResult *r = &set.results[i];
+            if (r->status != e_success)
+            {
+                failed++;
+                continue;
+            }
+            // Short prefixes have little chi-square power, so only a whole-image p flags an image; the prefix is an estimate
+            int suspicious = r->rs_rate > ANALYZE_RS_LIMIT || r->chi_p >= ANALYZE_CHI_LIMIT;
+            flagged += suspicious;
+            bytes += r->pixel_bytes;
+            printf("%s: chi-square p %.4f, embedded prefix %d %%, RS rate %.4f -> %s\n", set.images.names[i], r->chi_p, r->prefix, r->rs_rate,
+                   suspicious ? "SUSPICIOUS" : "clean");
+        }
+
+        double secs = (t1.tv_sec - t0.tv_sec) + (t1.tv_nsec - t0.tv_nsec) / 1e9;
+        secs = secs > 0 ? secs : 1e-9;
+        printf("Analysed %d images (%.1f MB) in %.3f s on %ld threads, %s RS kernel: %d suspicious, %d failed, %.0f images/s, %.1f MB/s\n",
+               set.images.count - failed, bytes / 1e6, secs, threads, rs_name, flagged, failed, (set.images.count - failed) / secs, bytes / 1e6 / secs);
+        ret = failed == set.images.count ? e_failure : e_success;
+    }
+
+    image_list_free(&set.images);
+    free(set.results);
+    return ret;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/* ============================================================================= END OF CODE ===========================================================================*/
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -0,0 +1,53 @@
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// ============================================================= * * * * * analyze.h * * * * * ======================================================================== //
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/*
+
+### USAGE OF analyze.h FILE IN STEGANOGRAPHY PROJECT ?
+--> THIS HEADER FILE DECLARES THE STEGANALYSIS MODE (-a). EVERY BMP GIVEN ON THE COMMAND LINE (OR FOUND UNDER A GIVEN DIRECTORY) IS CHECKED FOR LSB EMBEDDING WITH TWO
+    CLASSIC DETECTORS: THE CHI-SQUARE ATTACK ON PAIRS OF VALUES, WHICH ALSO ESTIMATES HOW MUCH OF THE IMAGE FROM THE START IS EMBEDDED, AND RS ANALYSIS, WHICH ESTIMATES
+    THE EMBEDDING RATE OF THE WHOLE PIXEL ARRAY. IMAGES ARE ANALYSED IN PARALLEL, ONE PER WORKER THREAD, AND REPORTED IN INPUT ORDER.
+
+*/
+
+// ==================================================================================================================================================================== //
+
+#ifndef ANALYZE_H
+#define ANALYZE_H
+
+/* ====================================================================== INCLUDES ==================================================================================== */
+
+#include "types.h"
+
+/* ======================================================================= MACROS ===================================================================================== */
+
+#define ANALYZE_STEPS 100           // Prefixes of the pixel array tested by the chi-square attack (1 %, 2 % ... 100 %)
+#define ANALYZE_RS_LIMIT 0.10       // RS rate above which an image is reported as suspicious
+#define ANALYZE_CHI_LIMIT 0.5       // Chi-square p value from which a prefix counts as embedded
+
+/* ======================================================================= STRUCTURE ================================================================================== */
+
+/* Result of one image */
+typedef struct
+{
+    unsigned long long pixel_bytes; // Bytes analysed
+    double chi_p;                   // Chi-square p value of the whole pixel array (near 1 = pairs of values equalised)
+    int prefix;                     // Leading percentage of the pixel array with p >= ANALYZE_CHI_LIMIT
+    double rs_rate;                 // RS estimate of the share of pixel bytes carrying payload bits
+    Status status;
+} AnalyzeResult;
+
+/* ================================================================= FUNCTION PROTOTYPES ============================================================================== */
+
+/* Run both detectors on the pixel array of one BMP */
+Status analyze_image(const char *fname, AnalyzeResult *res);
+
+/* Analyse every image / directory in paths (--threads=N workers) and print one line per image and a summary */
+Status do_analyze(char *paths[], int count, int opt_count, char *opts[]);
+
+#endif
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/* ============================================================================= END OF CODE ===========================================================================*/
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
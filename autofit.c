@@ -0,0 +1,259 @@
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// ============================================================= * * * * * autofit.c * * * * * ======================================================================== //
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/*
+
+### USAGE OF autofit.c FILE IN STEGANOGRAPHY PROJECT ?
+--> THIS FILE IMPLEMENTS THE CAPACITY DRIVEN EMBEDDING MODE. THE CANDIDATE FORMATS ARE TRIED IN ORDER OF DISTORTION AND THE FIRST ONE WHOSE PIXELS HOLD THE PAYLOAD
+    WINS. THE EXTENDED MAGIC, MODE WORD AND PARAMETER WORD STAY ONE BIT PER BYTE RIGHT AFTER THE BMP HEADER; THE PAYLOAD FIELDS START AT THE NEXT PIXEL BOUNDARY AND
+    GO THROUGH THE LSB KERNEL OF THE CHOSEN FORMAT IN WHOLE KERNEL UNITS, STRAIGHT INTO A SHARED MAP OF THE CLONED IMAGE. THE DECODER RUNS THE MATCHING EXTRACT KERNEL
+    OVER A READ ONLY MAP AND STOPS AT THE LAST PIXEL OF THE PAYLOAD.
+
+*/
+
+/* ====================================================================== INCLUDES ==================================================================================== */
+
+#include <stdio.h>       // Std inbuilt functions
+#include <stdlib.h>      // malloc, free
+#include <string.h>      // Inbuilt string functions
+#include <sys/stat.h>    // fstat
+#include <sys/mman.h>    // madvise, munmap
+#include "types.h"       // Status
+#include "common.h"      // MAGIC_STRING_EXT and MODE_* flags
+#include "encode.h"      // EncodeInfo
+#include "decode.h"      // DecodeInfo, PayloadParser
+#include "fastcopy.h"    // map_image_file
+#include "lsbkernel.h"   // Kernels of every carrier format
+#include "autofit.h"     // Prototypes
+
+/* ======================================================================= MACROS ===================================================================================== */
+
+#define BMP_HEADER 54                                               // Pixel data offset the rest of the project assumes
+#define AUTOFIT_HEADER_BYTES (BMP_HEADER + 16 + 32 + 32)            // Image bytes holding magic, mode word and parameter word one bit each
+#define AUTOFIT_HEADER_PIXELS ((AUTOFIT_HEADER_BYTES - BMP_HEADER + 2) / 3)
+#define AUTOFIT_DATA_OFFSET (BMP_HEADER + AUTOFIT_HEADER_PIXELS * 3)  // First payload pixel, so kernels see whole BGR pixels
+#define AUTOFIT_CHUNK_UNITS 16384                                   // Kernel units per chunk of payload
+
+/* ======================================================================= STRUCTURE ================================================================================== */
+
+/* Candidate formats, least distortion first */
+static const struct
+{
+    uint bits;
+    uint mask;
+    const char *channels;
+} autofit_formats[] =
+{
+    { 1, LSB_MASK_B,   "B"   },
+    { 1, LSB_MASK_BG,  "BG"  },
+    { 1, LSB_MASK_BGR, "BGR" },
+    { 2, LSB_MASK_B,   "B"   },
+    { 2, LSB_MASK_BG,  "BG"  },
+    { 2, LSB_MASK_BGR, "BGR" },
+    { 4, LSB_MASK_B,   "B"   },
+    { 4, LSB_MASK_BG,  "BG"  },
+    { 4, LSB_MASK_BGR, "BGR" },
+};
+
+/* ================================================================= FUNCTION DEFINITIONS ============================================================================= */
+
+/* Pixels of the whole kernel units holding count payload bytes (the decoder extracts whole units only) */
+static unsigned long long payload_pixels(unsigned long long count, const LsbKernel *k)
+{
+    return (count + k->unit_bytes - 1) / k->unit_bytes * k->unit_pixels;
+}
+
+Status autofit_choose(EncodeInfo *encInfo, unsigned long long image_capacity)
+{
+    struct stat st;
+    unsigned long long payload = 4 + strlen(encInfo->extn_secret_file) + 4 + encInfo->size_secret_file;
+
+    // STEP 1 : Pixels after the header words, within both the dimensions and the file
+    unsigned long long pixels = image_capacity / 3;
+    if (fstat(fileno(encInfo->fptr_src_image), &st) == 0 && st.st_size > AUTOFIT_DATA_OFFSET &&
+        pixels > (unsigned long long)(st.st_size - BMP_HEADER) / 3)
+    {
+        pixels = (st.st_size - BMP_HEADER) / 3;
+    }
+    pixels = pixels > AUTOFIT_HEADER_PIXELS ? pixels - AUTOFIT_HEADER_PIXELS : 0;
+
+    // STEP 2 : First format that fits
+    for (size_t i = 0; i < sizeof(autofit_formats) / sizeof(autofit_formats[0]); i++)
+    {
+        uint bits = autofit_formats[i].bits;
+        const LsbKernel *k = lsb_kernel_select(bits, 3, autofit_formats[i].mask);
+        unsigned long long used = payload_pixels(payload, k);
+        if (used > pixels)
+        {
+            continue;
+        }
+
+        // Every sample carrying bits differs from its new value with probability 1 - 2^-bits
+        unsigned long long samples = payload * 8 / bits;
+        encInfo->auto_bits = bits;
+        encInfo->auto_mask = k->mask;
+        printf("Auto fit: %u LSB%s of %s, %llu of %llu pixels (%.1f %%), about %llu samples changed, %s kernel.\n", bits, bits > 1 ? "s" : "",
+               autofit_formats[i].channels, used, pixels, 100.0 * used / pixels, samples - (samples >> bits), k->name);
+        return e_success;
+    }
+
+    printf("Error: %llu payload bytes do not fit even 4 LSBs of every channel (%llu bytes at most).\n", payload, pixels * 12 / 8);
+    return e_failure;
+}
+
+Status encode_auto_payload(EncodeInfo *encInfo)
+{
+    const LsbKernel *k = lsb_kernel_select(encInfo->auto_bits, 3, encInfo->auto_mask);
+    size_t extn_len = strlen(encInfo->extn_secret_file);
+    size_t image_size;
+    unsigned char *buf;
+
+    // STEP 1 : Extended magic string, mode word and format stay plain LSB
+    if (k == NULL || encode_magic_string(MAGIC_STRING_EXT, encInfo) == e_failure ||
+        encode_mode_word(MODE_AUTO, encInfo) == e_failure ||
+        encode_mode_word(AUTOFIT_PARAM(encInfo->auto_bits, encInfo->auto_mask), encInfo) == e_failure)
+    {
+        printf("Error: Failed to encode extended header.\n");
+        return e_failure;
+    }
+
+    // STEP 2 : Shared map of the clone, the payload pixels are patched in place
+    if (fflush(encInfo->fptr_stego_image) != 0)
+    {
+        return e_failure;
+    }
+    unsigned char *image = map_image_file(encInfo->fptr_stego_image, encInfo->stego_image_fname, 1, &image_size);
+    size_t chunk = (size_t)k->unit_bytes * AUTOFIT_CHUNK_UNITS;
+    unsigned long long payload = 4 + extn_len + 4 + encInfo->size_secret_file;
+    if (image == NULL || image_size < AUTOFIT_DATA_OFFSET + payload_pixels(payload, k) * 3 ||
+        (buf = malloc(chunk)) == NULL)
+    {
+        printf("Error: Unable to map the stego image.\n");
+        if (image != NULL)
+        {
+            munmap(image, image_size);
+        }
+        return e_failure;
+    }
+    madvise(image, image_size, MADV_SEQUENTIAL);
+
+    // STEP 3 : Extension size, extension and file size lead the first chunk, MSB first
+    size_t len = 0;
+    for (int shift = 24; shift >= 0; shift -= 8)
+    {
+        buf[len++] = extn_len >> shift;
+    }
+    memcpy(buf + len, encInfo->extn_secret_file, extn_len);
+    len += extn_len;
+    for (int shift = 24; shift >= 0; shift -= 8)
+    {
+        buf[len++] = encInfo->size_secret_file >> shift;
+    }
+
+    // STEP 4 : Whole chunks of kernel units, the last one may end inside a unit
+    unsigned char *pos = image + AUTOFIT_DATA_OFFSET;
+    unsigned long long embedded = 0;
+    for (;;)
+    {
+        size_t got;
+        while (len < chunk && (got = fread(buf + len, 1, chunk - len, encInfo->fptr_secret)) > 0)
+        {
+            len += got;
+        }
+        if (len == 0)
+        {
+            break;
+        }
+        lsb_kernel_embed(k, pos, buf, len);
+        pos += len / k->unit_bytes * k->unit_pixels * k->bpp;
+        embedded += len;
+        len = 0;
+    }
+    free(buf);
+
+    if (embedded != payload)
+    {
+        printf("Error: Secret file ended early.\n");
+        munmap(image, image_size);
+        return e_failure;
+    }
+    printf("Payload embedded through %s kernel.\n", k->name);
+    return munmap(image, image_size) == 0 ? e_success : e_failure;
+}
+
+Status decode_auto_payload(DecodeInfo *decInfo)
+{
+    PayloadParser parser;
+    size_t image_size;
+    uint bits = decInfo->auto_param >> 8;
+    uint mask = decInfo->auto_param & 0xFF;
+    const LsbKernel *k = lsb_kernel_select(bits, 3, mask);
+
+    if (k == NULL)
+    {
+        printf("ERROR! Invalid carrier format 0x%08x\n", decInfo->auto_param);
+        return e_failure;
+    }
+    unsigned char *image = map_image_file(decInfo->fptr_stego_image, NULL, 0, &image_size);
+    size_t chunk = (size_t)k->unit_bytes * AUTOFIT_CHUNK_UNITS;
+    size_t chunk_carrier = (size_t)k->unit_pixels * k->bpp * AUTOFIT_CHUNK_UNITS;
+    unsigned char *buf = malloc(chunk);
+    if (image == NULL || buf == NULL)
+    {
+        printf("ERROR! Cannot map the stego image\n");
+        if (image != NULL)
+        {
+            munmap(image, image_size);
+        }
+        free(buf);
+        return e_failure;
+    }
+    madvise(image, image_size, MADV_SEQUENTIAL);
+    printf("Decoding %u LSB%s per sample through %s kernel\n", bits, bits > 1 ? "s" : "", k->name);
+
+    // Header fields byte by byte through the parser, then the data straight to the output
+    memset(&parser, 0, sizeof(parser));
+    for (size_t off = AUTOFIT_DATA_OFFSET; !parser.done && !parser.failed && off < image_size; off += chunk_carrier)
+    {
+        size_t units = off + chunk_carrier <= image_size ? AUTOFIT_CHUNK_UNITS : (image_size - off) / (k->unit_pixels * k->bpp);
+        if (units == 0)
+        {
+            break;
+        }
+        size_t n = units * k->unit_bytes;
+        k->extract(image + off, buf, units);
+
+        for (size_t i = 0; i < n && !parser.done && !parser.failed;)
+        {
+            if (parser.index < 4 || parser.index < 8 + parser.extn_size)
+            {
+                parse_payload_byte(decInfo, &parser, buf[i++]);
+                continue;
+            }
+            size_t take = n - i < parser.file_size - parser.written ? n - i : parser.file_size - parser.written;
+            if (fwrite(buf + i, 1, take, decInfo->fptr_output) != take)
+            {
+                parser.failed = 1;
+                break;
+            }
+            i += take;
+            parser.index += take;
+            parser.written += take;
+            parser.done = parser.written == parser.file_size;
+        }
+    }
+
+    free(buf);
+    munmap(image, image_size);
+    if (!parser.done)
+    {
+        printf("ERROR! Auto fitted payload is %s\n", parser.failed ? "corrupt" : "truncated");
+        return e_failure;
+    }
+    return e_success;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/* ============================================================================= END OF CODE ===========================================================================*/
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -0,0 +1,46 @@
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// ============================================================= * * * * * autofit.h * * * * * ======================================================================== //
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/*
+
+### USAGE OF autofit.h FILE IN STEGANOGRAPHY PROJECT ?
+--> THIS HEADER FILE DECLARES THE CAPACITY DRIVEN EMBEDDING MODE (--auto). INSTEAD OF FAILING WHEN THE PAYLOAD DOES NOT FIT ONE BIT PER BYTE, THE ENCODER WORKS OUT
+    FROM THE CARRIER DIMENSIONS AND THE PAYLOAD SIZE THE LEAST DISTORTING CARRIER FORMAT THAT FITS: THE FEWEST LSBS PER SAMPLE FIRST (THE SQUARED ERROR OF A SAMPLE
+    GROWS WITH 4^BITS), THEN THE FEWEST CHANNELS (BLUE, THEN BLUE AND GREEN, THEN ALL THREE). THE PAYLOAD FILLS ONLY THE PIXELS IT NEEDS FROM THE START OF THE PIXEL
+    DATA, SO THE FRACTION OF PIXELS USED FOLLOWS FROM THE PAYLOAD SIZE. THE BITS AND CHANNEL MASK ARE STORED IN THE PARAMETER WORD OF MODE_AUTO AND BOTH SIDES RUN THE
+    SPECIALISED LSB KERNEL OF THAT FORMAT.
+
+*/
+
+// ==================================================================================================================================================================== //
+
+#ifndef AUTOFIT_H
+#define AUTOFIT_H
+
+/* ====================================================================== INCLUDES ==================================================================================== */
+
+#include "types.h"
+#include "encode.h"
+#include "decode.h"
+
+/* ======================================================================= MACROS ===================================================================================== */
+
+#define AUTOFIT_PARAM(bits, mask) ((bits) << 8 | (mask))    // Parameter word of MODE_AUTO
+
+/* ================================================================= FUNCTION PROTOTYPES ============================================================================== */
+
+/* Least distorting bits / channel mask whose pixels hold the payload (image_capacity = width * height * 3), stored in encInfo->auto_bits / auto_mask */
+Status autofit_choose(EncodeInfo *encInfo, unsigned long long image_capacity);
+
+/* Extended magic, MODE_AUTO, bits and mask, then the payload fields through the kernel of that format (streams positioned after the BMP header) */
+Status encode_auto_payload(EncodeInfo *encInfo);
+
+/* Extract the payload fields with the format stored in decInfo->auto_param */
+Status decode_auto_payload(DecodeInfo *decInfo);
+
+#endif
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/* ============================================================================= END OF CODE ===========================================================================*/
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -0,0 +1,587 @@
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// ============================================================== * * * * * cache.c * * * * * ========================================================================= //
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/*
+
+### USAGE OF cache.c FILE IN STEGANOGRAPHY PROJECT ?
+--> THIS FILE IMPLEMENTS THE ENCODE RESULT CACHE. THE HASH IS A FOUR LANE MULTIPLY / ROTATE HASH IN THE STYLE OF XXH64 (32 BYTES PER STEP, A FEW GB/S), FED BLOCK BY
+    BLOCK FROM THE I/O ENGINE CALLBACK. ENTRIES ARE PLAIN FILES NAMED AFTER THE KEY; A HIT TOUCHES ITS ENTRY, SO THE MODIFICATION TIME IS THE LRU CLOCK. EVERY
+    CHANGE OF THE COUNTERS AND EVERY EVICTION HAPPENS UNDER AN EXCLUSIVE FLOCK OF THE STATS FILE, SO SEVERAL ENCODERS (OR DAEMON WORKERS) MAY SHARE ONE CACHE.
+
+*/
+
+/* ====================================================================== INCLUDES ==================================================================================== */
+
+#include <stdio.h>         // printf, snprintf, rename
+#include <stdlib.h>        // strtoull, qsort, realloc
+#include <string.h>        // memcpy, strlen, strncmp
+#include <errno.h>         // errno
+#include <fcntl.h>         // open
+#include <unistd.h>        // link, unlink, pread, pwrite
+#include <dirent.h>        // opendir
+#include <sys/file.h>      // flock
+#include <sys/stat.h>      // fstat, mkdir, futimens
+#include <sys/ioctl.h>     // ioctl
+#ifdef __linux__
+#include <linux/fs.h>      // FICLONE
+#endif
+#include "common.h"        // OPTION_VALUE
+#include "fastcopy.h"      // fast_copy_file
+#include "cache.h"         // Prototypes
+
+/* ======================================================================= MACROS ===================================================================================== */
+
+#define HASH_P1 0x9E3779B185EBCA87ULL
+#define HASH_P2 0xC2B2AE3D27D4EB4FULL
+#define HASH_P3 0x165667B19E3779F9ULL
+#define HASH_P4 0x85EBCA77C2B2AE63ULL
+#define HASH_P5 0x27D4EB2F165667C5ULL
+
+/* ======================================================================= STRUCTURE ================================================================================== */
+
+/* Streaming hash state */
+typedef struct
+{
+    uint64_t v[4];                  // Lane accumulators
+    unsigned char tail[32];         // Bytes of an unfinished 32 byte step
+    size_t tail_len;
+    unsigned long long total;       // Bytes hashed
+    uint64_t seed;
+} CacheHash;
+
+/* One entry found while evicting */
+typedef struct
+{
+    char name[64];
+    struct timespec used;           // Modification time, refreshed by every hit
+    unsigned long long size;
+} CacheEntry;
+
+/* ================================================================= FUNCTION DEFINITIONS ============================================================================= */
+
+Status read_cache_option(const char *opt, EncodeCache *cache)
+{
+    const char *value;
+
+    if ((value = OPTION_VALUE(opt, "--cache=")) != NULL && *value != '\0')
+    {
+        cache->dir = value;
+    }
+    else if ((value = OPTION_VALUE(opt, "--cache-size=")) != NULL)
+    {
+        char *end;
+        unsigned long long mib = strtoull(value, &end, 10);
+        if (*value == '\0' || *end != '\0' || mib == 0 || mib > (1ULL << 30))
+        {
+            printf("Error: --cache-size must be a positive number of MiB.\n");
+            return e_failure;
+        }
+        cache->max_bytes = mib << 20;
+    }
+    else
+    {
+        printf("Error: Unknown cache option %s\n", opt);
+        return e_failure;
+    }
+    return e_success;
+}
+
+static inline uint64_t rotl64(uint64_t x, int k)
+{
+    return (x << k) | (x >> (64 - k));
+}
+
+static inline uint64_t load64(const unsigned char *p)
+{
+    uint64_t x;
+    memcpy(&x, p, 8);
+    return x;
+}
+
+static inline uint64_t hash_round(uint64_t acc, uint64_t in)
+{
+    return rotl64(acc + in * HASH_P2, 31) * HASH_P1;
+}
+
+static void hash_init(CacheHash *h, uint64_t seed)
+{
+    memset(h, 0, sizeof(*h));
+    h->seed = seed;
+    h->v[0] = seed + HASH_P1 + HASH_P2;
+    h->v[1] = seed + HASH_P2;
+    h->v[2] = seed;
+    h->v[3] = seed - HASH_P1;
+}
+
+static void hash_update(CacheHash *h, const unsigned char *p, size_t len)
+{
+    h->total += len;
+
+    // STEP 1 : Complete a step left over from the previous block
+    if (h->tail_len != 0)
+    {
+        size_t take = 32 - h->tail_len < len ? 32 - h->tail_len : len;
+        memcpy(h->tail + h->tail_len, p, take);
+        h->tail_len += take;
+        p += take;
+        len -= take;
+        if (h->tail_len < 32)
+        {
+            return;
+        }
+        for (int i = 0; i < 4; i++)
+        {
+            h->v[i] = hash_round(h->v[i], load64(h->tail + 8 * i));
+        }
+        h->tail_len = 0;
+    }
+
+    // STEP 2 : Whole steps straight from the block, four independent lanes
+    uint64_t v0 = h->v[0], v1 = h->v[1], v2 = h->v[2], v3 = h->v[3];
+    for (; len >= 32; p += 32, len -= 32)
+    {
+        v0 = hash_round(v0, load64(p));
+        v1 = hash_round(v1, load64(p + 8));
+        v2 = hash_round(v2, load64(p + 16));
+        v3 = hash_round(v3, load64(p + 24));
+    }
+    h->v[0] = v0;
+    h->v[1] = v1;
+    h->v[2] = v2;
+    h->v[3] = v3;
+
+    // STEP 3 : Keep the rest for the next block
+    memcpy(h->tail, p, len);
+    h->tail_len = len;
+}
+
+static uint64_t hash_final(const CacheHash *h)
+{
+    uint64_t acc;
+    const unsigned char *p = h->tail;
+    size_t len = h->tail_len;
+
+    if (h->total >= 32)
+    {
+        acc = rotl64(h->v[0], 1) + rotl64(h->v[1], 7) + rotl64(h->v[2], 12) + rotl64(h->v[3], 18);
+        for (int i = 0; i < 4; i++)
+        {
+            acc = (acc ^ hash_round(0, h->v[i])) * HASH_P1 + HASH_P4;
+        }
+    }
+    else
+    {
+        acc = h->seed + HASH_P5;
+    }
+    acc += h->total;
+
+    for (; len >= 8; p += 8, len -= 8)
+    {
+        acc = rotl64(acc ^ hash_round(0, load64(p)), 27) * HASH_P1 + HASH_P4;
+    }
+    for (; len > 0; p++, len--)
+    {
+        acc = rotl64(acc ^ (*p * HASH_P5), 11) * HASH_P1;
+    }
+
+    acc ^= acc >> 33;
+    acc *= HASH_P2;
+    acc ^= acc >> 29;
+    acc *= HASH_P3;
+    return acc ^ (acc >> 32);
+}
+
+/* I/O engine callback: hash a block in file order */
+static Status hash_block(unsigned char *block, size_t len, void *ctx)
+{
+    hash_update(ctx, block, len);
+    return e_success;
+}
+
+static Status hash_file(int fd, uint64_t seed, IoConfig *io, uint64_t *out)
+{
+    CacheHash h;
+    struct stat st;
+    const char *engine;
+
+    hash_init(&h, seed);
+    if (fstat(fd, &st) != 0)
+    {
+        perror("fstat");
+        return e_failure;
+    }
+    if (io_transform_range(fd, -1, 0, st.st_size, hash_block, &h, io, &engine) == e_failure)
+    {
+        return e_failure;
+    }
+    *out = hash_final(&h);
+    return e_success;
+}
+
+Status cache_key(EncodeCache *cache, int carrier_fd, int secret_fd, const void *params, size_t params_len, IoConfig *io)
+{
+    CacheHash h;
+
+    if (cache->max_bytes == 0)
+    {
+        cache->max_bytes = CACHE_DEFAULT_SIZE;
+    }
+    if (mkdir(cache->dir, 0777) != 0 && errno != EEXIST)
+    {
+        perror("mkdir");
+        return e_failure;
+    }
+
+    // One hash per input, each seeded differently so equal files in both roles still give distinct keys
+    hash_init(&h, 2);
+    hash_update(&h, params, params_len);
+    if (hash_file(carrier_fd, 0, io, &cache->key[0]) == e_failure || hash_file(secret_fd, 1, io, &cache->key[1]) == e_failure)
+    {
+        return e_failure;
+    }
+    cache->key[2] = hash_final(&h);
+
+    if ((size_t)snprintf(cache->entry, sizeof(cache->entry), "%s/%016llx%016llx%016llx%s", cache->dir, (unsigned long long)cache->key[0],
+                         (unsigned long long)cache->key[1], (unsigned long long)cache->key[2], CACHE_ENTRY_SUFFIX) >= sizeof(cache->entry))
+    {
+        printf("Error: Cache directory name too long.\n");
+        return e_failure;
+    }
+    return e_success;
+}
+
+/* Open and lock the stats file of the cache, counters loaded into st; -1 on failure */
+static int stats_lock(const EncodeCache *cache, CacheStats *st)
+{
+    char path[4096], text[256];
+
+    memset(st, 0, sizeof(*st));
+    snprintf(path, sizeof(path), "%s/%s", cache->dir, CACHE_STATS_FILE);
+    int fd = open(path, O_RDWR | O_CREAT, 0644);
+    if (fd < 0 || flock(fd, LOCK_EX) != 0)
+    {
+        perror("cache stats");
+        if (fd >= 0)
+        {
+            close(fd);
+        }
+        return -1;
+    }
+    ssize_t n = pread(fd, text, sizeof(text) - 1, 0);
+    text[n > 0 ? n : 0] = '\0';
+    sscanf(text, "hits %llu misses %llu stores %llu evictions %llu bytes_saved %llu", &st->hits, &st->misses, &st->stores, &st->evictions,
+           &st->bytes_saved);
+    return fd;
+}
+
+/* Write the counters back (when changed) and release the lock */
+static void stats_unlock(int fd, const CacheStats *st)
+{
+    if (st != NULL)
+    {
+        char text[256];
+        int len = snprintf(text, sizeof(text), "hits %llu\nmisses %llu\nstores %llu\nevictions %llu\nbytes_saved %llu\n", st->hits, st->misses, st->stores,
+                           st->evictions, st->bytes_saved);
+        if (ftruncate(fd, 0) != 0 || pwrite(fd, text, len, 0) != len)
+        {
+            perror("cache stats");
+        }
+    }
+    flock(fd, LOCK_UN);
+    close(fd);
+}
+
+Status cache_fetch(EncodeCache *cache, const char *output_fname, int stego_fd, int *hit)
+{
+    CacheStats st;
+    struct stat es;
+    const char *method = NULL;
+    Status ret = e_success;
+
+    int lock = stats_lock(cache, &st);
+    if (lock < 0)
+    {
+        return e_failure;
+    }
+
+    // STEP 1 : Miss when there is no entry (or it was evicted meanwhile)
+    int fd = open(cache->entry, O_RDONLY);
+    *hit = fd >= 0 && fstat(fd, &es) == 0;
+    if (!*hit)
+    {
+        if (fd >= 0)
+        {
+            close(fd);
+        }
+        st.misses++;
+        stats_unlock(lock, &st);
+        return e_success;
+    }
+
+    // STEP 2 : Reflink into the open output; else hard link the entry over the output name; else copy
+#ifdef FICLONE
+    if (ioctl(stego_fd, FICLONE, fd) == 0)
+    {
+        method = "reflink";
+    }
+#endif
+    if (method == NULL)
+    {
+        char tmp[4096 + 16];
+        snprintf(tmp, sizeof(tmp), "%s.cache-tmp", output_fname);
+        unlink(tmp);
+        if (link(cache->entry, tmp) == 0 && rename(tmp, output_fname) == 0)
+        {
+            method = "hard link";
+        }
+        else
+        {
+            unlink(tmp);
+            ret = fast_copy_file(fd, stego_fd, NULL, &method);
+        }
+    }
+
+    // STEP 3 : Entry becomes the most recently used
+    if (ret == e_success)
+    {
+        futimens(fd, NULL);
+        st.hits++;
+        st.bytes_saved += es.st_size;
+        printf("Cache hit %016llx%016llx%016llx: stego image taken from the cache (%s), encoding skipped.\n", (unsigned long long)cache->key[0],
+               (unsigned long long)cache->key[1], (unsigned long long)cache->key[2], method);
+    }
+    close(fd);
+    stats_unlock(lock, &st);
+    return ret;
+}
+
+static int entry_older(const void *a, const void *b)
+{
+    const CacheEntry *x = a, *y = b;
+    if (x->used.tv_sec != y->used.tv_sec)
+    {
+        return x->used.tv_sec < y->used.tv_sec ? -1 : 1;
+    }
+    return (x->used.tv_nsec > y->used.tv_nsec) - (x->used.tv_nsec < y->used.tv_nsec);
+}
+
+/* Entries of the cache directory (names of 48 hex digits + suffix); *total is their size */
+static CacheEntry *list_entries(const EncodeCache *cache, size_t *count, unsigned long long *total)
+{
+    CacheEntry *entries = NULL;
+    size_t cap = 0;
+    struct dirent *de;
+    DIR *dir = opendir(cache->dir);
+
+    *count = 0;
+    *total = 0;
+    if (dir == NULL)
+    {
+        return NULL;
+    }
+    while ((de = readdir(dir)) != NULL)
+    {
+        struct stat st;
+        size_t len = strlen(de->d_name);
+        if (len != 48 + strlen(CACHE_ENTRY_SUFFIX) || strcmp(de->d_name + 48, CACHE_ENTRY_SUFFIX) != 0 || fstatat(dirfd(dir), de->d_name, &st, 0) != 0)
+        {
+            continue;
+        }
+        if (*count == cap)
+        {
+            CacheEntry *grown = realloc(entries, (cap = cap ? cap * 2 : 64) * sizeof(*entries));
+            if (grown == NULL)
+            {
+                break;
+            }
+            entries = grown;
+        }
+        memcpy(entries[*count].name, de->d_name, len + 1);
+        entries[*count].used = st.st_mtim;
+        entries[*count].size = st.st_size;
+        *total += st.st_size;
+        (*count)++;
+    }
+    closedir(dir);
+    return entries;
+}
+
+/* Remove least recently used entries until the cache fits --cache-size (caller holds the lock) */
+static void cache_evict(const EncodeCache *cache, CacheStats *st)
+{
+    size_t count;
+    unsigned long long total;
+    CacheEntry *entries = list_entries(cache, &count, &total);
+
+    if (total > cache->max_bytes)
+    {
+        qsort(entries, count, sizeof(*entries), entry_older);
+        for (size_t i = 0; i < count && total > cache->max_bytes; i++)
+        {
+            char path[4096 + 64];
+            snprintf(path, sizeof(path), "%s/%s", cache->dir, entries[i].name);
+            if (unlink(path) == 0)
+            {
+                total -= entries[i].size;
+                st->evictions++;
+            }
+        }
+    }
+    free(entries);
+}
+
+Status cache_store(EncodeCache *cache, const char *output_fname)
+{
+    CacheStats st;
+    char tmp[4096 + 16];
+    const char *method = NULL;
+    Status ret = e_success;
+
+    // STEP 1 : New entry under a temporary name: reflink of the output, else a hard link to it, else a copy
+    snprintf(tmp, sizeof(tmp), "%s.tmp", cache->entry);
+    int src = open(output_fname, O_RDONLY);
+    int dst = open(tmp, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (src < 0 || dst < 0)
+    {
+        perror("cache store");
+        ret = e_failure;
+    }
+#ifdef FICLONE
+    if (ret == e_success && ioctl(dst, FICLONE, src) == 0)
+    {
+        method = "reflink";
+    }
+#endif
+    if (ret == e_success && method == NULL)
+    {
+        close(dst);
+        dst = -1;
+        unlink(tmp);
+        if (link(output_fname, tmp) == 0)
+        {
+            method = "hard link";
+        }
+        else if ((dst = open(tmp, O_WRONLY | O_CREAT | O_TRUNC, 0644)) < 0 || fast_copy_file(src, dst, NULL, &method) == e_failure)
+        {
+            ret = e_failure;
+        }
+    }
+    if (src >= 0)
+    {
+        close(src);
+    }
+    if (dst >= 0)
+    {
+        close(dst);
+    }
+
+    // STEP 2 : Publish it, count it and bring the cache back under its size
+    int lock = ret == e_success ? stats_lock(cache, &st) : -1;
+    if (lock < 0 || rename(tmp, cache->entry) != 0)
+    {
+        printf("Error: Cannot store the result in cache %s\n", cache->dir);
+        unlink(tmp);
+        if (lock >= 0)
+        {
+            stats_unlock(lock, NULL);
+        }
+        return e_failure;
+    }
+    st.stores++;
+    cache_evict(cache, &st);
+    stats_unlock(lock, &st);
+    printf("Stego image stored in the cache (%s).\n", method);
+    return e_success;
+}
+
+void cache_report(const EncodeCache *cache)
+{
+    CacheStats st;
+    size_t count;
+    unsigned long long total;
+
+    int lock = stats_lock(cache, &st);
+    if (lock < 0)
+    {
+        return;
+    }
+    free(list_entries(cache, &count, &total));
+    stats_unlock(lock, NULL);
+    printf("Cache %s: %llu hits, %llu misses, %llu stored, %llu evicted, %zu entries (%.1f of %.1f MB), %.1f MB served from the cache.\n", cache->dir,
+           st.hits, st.misses, st.stores, st.evictions, count, total / 1e6, cache->max_bytes / 1e6, st.bytes_saved / 1e6);
+}
+
+/* Name of the cache entry that is the inode st (a hard link), 0 when there is none */
+static int find_linked_entry(const char *dir, const struct stat *st, char *name, size_t size)
+{
+    struct dirent *de;
+    DIR *d = opendir(dir);
+    int found = 0;
+
+    if (d == NULL)
+    {
+        return 0;
+    }
+    while (!found && (de = readdir(d)) != NULL)
+    {
+        struct stat es;
+        size_t len = strlen(de->d_name);
+        if (len != 48 + strlen(CACHE_ENTRY_SUFFIX) || strcmp(de->d_name + 48, CACHE_ENTRY_SUFFIX) != 0 ||
+            fstatat(dirfd(d), de->d_name, &es, AT_SYMLINK_NOFOLLOW) != 0)
+        {
+            continue;
+        }
+        if (es.st_dev == st->st_dev && es.st_ino == st->st_ino)
+        {
+            snprintf(name, size, "%s", de->d_name);
+            found = 1;
+        }
+    }
+    closedir(d);
+    return found;
+}
+
+Status unshare_file(const char *fname, const char *cache_dir, int keep_data)
+{
+    struct stat st;
+    char tmp[4096 + 16], entry[64];
+    const char *method;
+
+    // Only with --cache, and only a regular file that is the inode of one of its entries; any other link is written through as before
+    if (cache_dir == NULL || lstat(fname, &st) != 0 || !S_ISREG(st.st_mode) || st.st_nlink < 2 ||
+        !find_linked_entry(cache_dir, &st, entry, sizeof(entry)))
+    {
+        return e_success;
+    }
+    if (!keep_data)
+    {
+        return unlink(fname) == 0 ? e_success : e_failure;
+    }
+
+    // Private copy under a temporary name, renamed over the shared one
+    snprintf(tmp, sizeof(tmp), "%s.unshare", fname);
+    int src = open(fname, O_RDONLY);
+    int dst = open(tmp, O_WRONLY | O_CREAT | O_TRUNC, st.st_mode & 07777);
+    Status ret = src >= 0 && dst >= 0 ? fast_copy_file(src, dst, NULL, &method) : e_failure;
+    if (src >= 0)
+    {
+        close(src);
+    }
+    if (dst >= 0 && close(dst) != 0)
+    {
+        ret = e_failure;
+    }
+    if (ret == e_failure || rename(tmp, fname) != 0)
+    {
+        perror("unshare");
+        unlink(tmp);
+        return e_failure;
+    }
+    printf("%s is cache entry %s/%s (hard link), it got its own copy (%s) before being changed.\n", fname, cache_dir, entry, method);
+    return e_success;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/* ============================================================================= END OF CODE ===========================================================================*/
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -0,0 +1,82 @@
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// ============================================================== * * * * * cache.h * * * * * ========================================================================= //
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/*
+
+### USAGE OF cache.h FILE IN STEGANOGRAPHY PROJECT ?
+--> THIS HEADER FILE DECLARES THE ENCODE RESULT CACHE (--cache=DIR). A JOB IS KEYED BY A 64 BIT HASH OF THE CARRIER BYTES, ONE OF THE SECRET BYTES AND ONE OF THE
+    PARAMETERS THAT CHANGE THE OUTPUT; BOTH FILES ARE HASHED AS THEY STREAM THROUGH THE BLOCK I/O ENGINE, SO THE READS STAY AHEAD OF THE HASHING. A JOB SEEN BEFORE
+    IS ANSWERED BY REFLINKING (OR HARD LINKING) ITS STORED STEGO IMAGE TO THE OUTPUT; A NEW RESULT IS LINKED INTO THE CACHE THE SAME WAY. THE CACHE IS KEPT UNDER
+    --cache-size BY EVICTING THE LEAST RECENTLY USED ENTRIES, AND HIT / MISS / STORE / EVICTION COUNTERS ARE KEPT IN A "stats" FILE INSIDE IT.
+
+*/
+
+// ==================================================================================================================================================================== //
+
+#ifndef CACHE_H
+#define CACHE_H
+
+/* ====================================================================== INCLUDES ==================================================================================== */
+
+#include <stddef.h>
+#include <stdint.h>
+#include "types.h"
+#include "ioengine.h"       // IoConfig
+
+/* ======================================================================= MACROS ===================================================================================== */
+
+#define CACHE_DEFAULT_SIZE (1024ULL << 20)  // --cache-size without a value
+#define CACHE_STATS_FILE "stats"            // Counters, also the lock of the cache directory
+#define CACHE_ENTRY_SUFFIX ".bmp"           // Entry name = 48 hex digits of the key + suffix
+
+/* ======================================================================= STRUCTURE ================================================================================== */
+
+/* Counters of one cache directory */
+typedef struct
+{
+    unsigned long long hits;
+    unsigned long long misses;
+    unsigned long long stores;
+    unsigned long long evictions;
+    unsigned long long bytes_saved; // Stego bytes handed out by hits instead of encoded
+} CacheStats;
+
+/* Cache settings and key of one encode */
+typedef struct
+{
+    const char *dir;                // --cache=DIR, NULL = no cache
+    unsigned long long max_bytes;   // --cache-size=MiB
+    uint64_t key[3];                // Carrier, secret and parameter hashes
+    char entry[4096];               // Entry path of the key
+} EncodeCache;
+
+/* ================================================================= FUNCTION PROTOTYPES ============================================================================== */
+
+/* Parse one --cache=DIR or --cache-size=MiB option */
+Status read_cache_option(const char *opt, EncodeCache *cache);
+
+/* Hash both files through the I/O engine (file offsets untouched) and the parameters into the key */
+Status cache_key(EncodeCache *cache, int carrier_fd, int secret_fd, const void *params, size_t params_len, IoConfig *io);
+
+/* Cached result of the key into the output (reflink into stego_fd, else hard link over output_fname, else copy);
+ * *hit is 0 on a miss. The hit or miss is counted
+ */
+Status cache_fetch(EncodeCache *cache, const char *output_fname, int stego_fd, int *hit);
+
+/* Reflink, hard link or copy a finished output into the cache under the key, then evict down to --cache-size */
+Status cache_store(EncodeCache *cache, const char *output_fname);
+
+/* Print the counters and size of the cache */
+void cache_report(const EncodeCache *cache);
+
+/* With --cache (cache_dir not NULL), fname may be a hard link of one of its entries: before it is changed, give it a private copy (keep_data)
+ * or unlink it. Any other file, linked or not, is left alone and written through
+ */
+Status unshare_file(const char *fname, const char *cache_dir, int keep_data);
+
+#endif
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/* ============================================================================= END OF CODE ===========================================================================*/
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -0,0 +1,284 @@
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// =========================================================== * * * * * checkpoint.c * * * * * ======================================================================= //
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/*
+
+### USAGE OF checkpoint.c FILE IN STEGANOGRAPHY PROJECT ?
+--> THIS FILE IMPLEMENTS THE CHECKPOINT JOURNAL AND THE PROGRESS LINES. A SEGMENT IS ONE CALL OF THE I/O ENGINE, WHICH RETURNS ONLY WHEN EVERY WRITE OF THE SEGMENT
+    HAS COMPLETED, SO AFTER FDATASYNC OF THE OUTPUT THE WHOLE SEGMENT IS ON DISK AND THE JOURNAL MAY MOVE PAST IT. THE JOURNAL IS WRITTEN TO A TEMPORARY FILE AND
+    RENAMED OVER THE OLD ONE, SO A CRASH LEAVES EITHER THE OLD OR THE NEW STATE; A CHECKSUM CATCHES ANYTHING ELSE.
+
+*/
+
+/* ====================================================================== INCLUDES ==================================================================================== */
+
+#include <stdio.h>         // printf, fprintf, rename
+#include <stdlib.h>        // atoi, atof
+#include <stddef.h>        // offsetof
+#include <string.h>        // memset, memcmp, strcmp
+#include <unistd.h>        // fdatasync, fsync
+#include <sys/stat.h>      // fstat
+#include "types.h"         // Status
+#include "common.h"        // OPTION_VALUE
+#include "checkpoint.h"    // Prototypes
+
+/* ================================================================= FUNCTION DEFINITIONS ============================================================================= */
+
+/* Parse one --checkpoint[=MiB], --resume or --progress[=SECONDS] option */
+Status read_checkpoint_option(const char *opt, Checkpoint *ck)
+{
+    const char *value;
+
+    if (strcmp(opt, "--checkpoint") == 0)
+    {
+        ck->interval = CKPT_DEFAULT_INTERVAL;
+    }
+    else if ((value = OPTION_VALUE(opt, "--checkpoint=")) != NULL)
+    {
+        int mib = atoi(value);
+        if (mib <= 0 || mib > 1024 * 1024)
+        {
+            printf("Error: --checkpoint must be between 1 and 1048576 MiB.\n");
+            return e_failure;
+        }
+        ck->interval = (unsigned long long)mib << 20;
+    }
+    else if (strcmp(opt, "--resume") == 0)
+    {
+        // Resuming keeps journaling, with the default interval unless one is given
+        ck->resume = 1;
+    }
+    else if (strcmp(opt, "--progress") == 0)
+    {
+        ck->progress_ms = PROGRESS_DEFAULT_MS;
+    }
+    else if ((value = OPTION_VALUE(opt, "--progress=")) != NULL)
+    {
+        double seconds = atof(value);
+        if (seconds < 0.01 || seconds > 86400)
+        {
+            printf("Error: --progress must be between 0.01 and 86400 seconds.\n");
+            return e_failure;
+        }
+        ck->progress_ms = seconds * 1000;
+    }
+    else
+    {
+        printf("Error: Unknown checkpoint option %s\n", opt);
+        return e_failure;
+    }
+    if (ck->resume && ck->interval == 0)
+    {
+        ck->interval = CKPT_DEFAULT_INTERVAL;
+    }
+    return e_success;
+}
+
+/* FNV-1a of the journal fields before the checksum */
+static uint64_t record_check(const CheckpointRecord *rec)
+{
+    const unsigned char *p = (const unsigned char *)rec;
+    uint64_t h = 0xCBF29CE484222325ULL;
+
+    for (size_t i = 0; i < offsetof(CheckpointRecord, check); i++)
+    {
+        h = (h ^ p[i]) * 0x100000001B3ULL;
+    }
+    return h;
+}
+
+/* Size and modification time of an open file */
+static Status file_identity(int fd, uint64_t *size, int64_t *sec, uint32_t *nsec)
+{
+    struct stat st;
+
+    if (fstat(fd, &st) != 0)
+    {
+        perror("fstat");
+        return e_failure;
+    }
+    *size = st.st_size;
+    *sec = st.st_mtim.tv_sec;
+    *nsec = st.st_mtim.tv_nsec;
+    return e_success;
+}
+
+static double elapsed_s(const struct timespec *from, const struct timespec *to)
+{
+    return (to->tv_sec - from->tv_sec) + (to->tv_nsec - from->tv_nsec) / 1e9;
+}
+
+Status checkpoint_open(Checkpoint *ck, CheckpointOp op, const char *output_fname, int carrier_fd, int secret_fd, off_t data_offset, off_t data_length,
+                       uint32_t flags)
+{
+    CheckpointRecord *rec = &ck->rec;
+
+    // STEP 1 : What this run is: files, data region, embedding flags
+    memset(rec, 0, sizeof(*rec));
+    memcpy(rec->magic, CKPT_MAGIC, sizeof(rec->magic));
+    rec->version = CKPT_VERSION;
+    rec->op = op;
+    rec->flags = flags;
+    rec->data_offset = data_offset;
+    rec->data_length = data_length;
+    if (file_identity(carrier_fd, &rec->carrier_size, &rec->carrier_mtime_sec, &rec->carrier_mtime_nsec) == e_failure ||
+        (secret_fd >= 0 && file_identity(secret_fd, &rec->secret_size, &rec->secret_mtime_sec, &rec->secret_mtime_nsec) == e_failure))
+    {
+        return e_failure;
+    }
+    if ((size_t)snprintf(ck->fname, sizeof(ck->fname), "%s%s", output_fname, CKPT_SUFFIX) >= sizeof(ck->fname))
+    {
+        printf("Error: Checkpoint journal name too long.\n");
+        return e_failure;
+    }
+    ck->label = op == e_ckpt_encode ? "encode" : "decode";
+
+    // STEP 2 : --resume: the journal must describe exactly this run, only its progress is taken over
+    if (ck->resume)
+    {
+        CheckpointRecord old;
+        FILE *fp = fopen(ck->fname, "r");
+        int ok = fp != NULL && fread(&old, sizeof(old), 1, fp) == 1;
+        if (fp != NULL)
+        {
+            fclose(fp);
+        }
+        if (!ok || memcmp(old.magic, CKPT_MAGIC, sizeof(old.magic)) != 0 || old.version != CKPT_VERSION || old.check != record_check(&old))
+        {
+            printf("Error: No valid checkpoint journal %s to resume from.\n", ck->fname);
+            return e_failure;
+        }
+        if (memcmp(&old, rec, offsetof(CheckpointRecord, done)) != 0 || old.done > old.data_length || old.done % 8 != 0)
+        {
+            printf("Error: Checkpoint journal %s belongs to different files or options.\n", ck->fname);
+            return e_failure;
+        }
+        *rec = old;
+        printf("Resuming from checkpoint: %llu of %llu data bytes done.\n", (unsigned long long)rec->done / 8,
+               (unsigned long long)rec->data_length / 8);
+    }
+
+    // STEP 3 : Progress clock (the rate only counts bytes of this run)
+    clock_gettime(CLOCK_MONOTONIC, &ck->start);
+    ck->last = ck->start;
+    ck->start_done = rec->done;
+    return e_success;
+}
+
+Status checkpoint_commit(Checkpoint *ck, FILE *durable, unsigned long long done, const LsbMatchState *match)
+{
+    CheckpointRecord *rec = &ck->rec;
+    char tmp_fname[sizeof(ck->fname) + 8];
+
+    // STEP 1 : Everything up to done must be on disk before the journal says so
+    if (fflush(durable) != 0 || fdatasync(fileno(durable)) != 0)
+    {
+        perror("fdatasync");
+        return e_failure;
+    }
+
+    // STEP 2 : New state
+    rec->done = done;
+    if (match != NULL)
+    {
+        memcpy(rec->match_state, match->s, sizeof(rec->match_state));
+        rec->match_changed = match->changed;
+    }
+    rec->check = record_check(rec);
+
+    // STEP 3 : Temporary file, synced, renamed over the previous journal
+    snprintf(tmp_fname, sizeof(tmp_fname), "%s.tmp", ck->fname);
+    FILE *fp = fopen(tmp_fname, "w");
+    if (fp == NULL)
+    {
+        perror("fopen");
+        return e_failure;
+    }
+    int ok = fwrite(rec, sizeof(*rec), 1, fp) == 1 && fflush(fp) == 0 && fsync(fileno(fp)) == 0;
+    if (fclose(fp) != 0 || !ok || rename(tmp_fname, ck->fname) != 0)
+    {
+        perror("write checkpoint");
+        remove(tmp_fname);
+        return e_failure;
+    }
+    return e_success;
+}
+
+Status checkpoint_range(Checkpoint *ck, int in_fd, int out_fd, IoBlockFn fn, void *ctx, IoConfig *io, const char **engine, FILE *durable,
+                        const LsbMatchState *match)
+{
+    CheckpointRecord *rec = &ck->rec;
+    unsigned long long done = rec->done;
+
+    *engine = "none";
+    while (done < rec->data_length)
+    {
+        // One segment per journal commit, the whole rest without a journal
+        unsigned long long left = rec->data_length - done;
+        unsigned long long len = ck->interval != 0 && ck->interval < left ? ck->interval : left;
+
+        if (io_transform_range(in_fd, out_fd, rec->data_offset + done, len, fn, ctx, io, engine) == e_failure)
+        {
+            return e_failure;
+        }
+        done += len;
+        if (ck->interval != 0 && checkpoint_commit(ck, durable, done, match) == e_failure)
+        {
+            return e_failure;
+        }
+    }
+    return e_success;
+}
+
+void checkpoint_close(Checkpoint *ck)
+{
+    if (ck->progress_ms != 0)
+    {
+        progress_report(ck, ck->rec.data_length, 1);
+    }
+    if (ck->interval != 0)
+    {
+        remove(ck->fname);
+    }
+}
+
+void progress_report(Checkpoint *ck, unsigned long long done, int force)
+{
+    struct timespec now;
+
+    if (ck->progress_ms == 0)
+    {
+        return;
+    }
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    if (!force && elapsed_s(&ck->last, &now) * 1000 < ck->progress_ms)
+    {
+        return;
+    }
+    ck->last = now;
+
+    // Carrier bytes of the data region; the rate leaves out what a resumed run found done
+    double secs = elapsed_s(&ck->start, &now);
+    double rate = secs > 0 ? (done - ck->start_done) / secs : 0;
+    double total = ck->rec.data_length ? (double)ck->rec.data_length : 1.0;
+    long eta = rate > 0 ? (long)((ck->rec.data_length - done) / rate) : -1;
+
+    fprintf(stderr, "%s: %5.1f %% (%.1f / %.1f MB), %.1f MB/s, ", ck->label, 100.0 * done / total, done / 1e6, total / 1e6, rate / 1e6);
+    if (done >= ck->rec.data_length)
+    {
+        fprintf(stderr, "done in %.1f s\n", secs);
+    }
+    else if (eta >= 0)
+    {
+        fprintf(stderr, "ETA %ld:%02ld:%02ld\n", eta / 3600, eta / 60 % 60, eta % 60);
+    }
+    else
+    {
+        fprintf(stderr, "ETA unknown\n");
+    }
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/* ============================================================================= END OF CODE ===========================================================================*/
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -0,0 +1,111 @@
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// =========================================================== * * * * * checkpoint.h * * * * * ======================================================================= //
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/*
+
+### USAGE OF checkpoint.h FILE IN STEGANOGRAPHY PROJECT ?
+--> THIS HEADER FILE DECLARES THE CHECKPOINT JOURNAL AND PROGRESS REPORTING OF LONG ENCODE / DECODE RUNS. WITH --checkpoint THE SECRET DATA REGION IS STREAMED IN
+    SEGMENTS; AFTER EVERY SEGMENT THE OUTPUT IS FLUSHED TO DISK AND A SMALL JOURNAL NEXT TO THE OUTPUT (<output>.ckpt) RECORDS HOW FAR THE DATA GOT, WHICH FILES IT
+    BELONGS TO AND THE LSB MATCHING GENERATOR STATE AT THAT POINT. --resume CHECKS THE JOURNAL AGAINST THE FILES OF THE NEW RUN, VERIFIES THE LAST DATA ALREADY
+    WRITTEN AND CONTINUES FROM THE RECORDED OFFSET. --progress PRINTS PERCENTAGE, THROUGHPUT AND ETA TO STDERR AT A FIXED INTERVAL.
+
+*/
+
+// ==================================================================================================================================================================== //
+
+#ifndef CHECKPOINT_H
+#define CHECKPOINT_H
+
+/* ====================================================================== INCLUDES ==================================================================================== */
+
+#include <stdio.h>
+#include <stdint.h>
+#include <time.h>
+#include <sys/types.h>
+#include "types.h"
+#include "ioengine.h"       // IoConfig, IoBlockFn
+#include "lsbmatch.h"       // LsbMatchState
+
+/* ======================================================================= MACROS ===================================================================================== */
+
+#define CKPT_MAGIC "STGCKP1"                    // First 8 bytes of a journal (with the terminating NUL)
+#define CKPT_VERSION 1
+#define CKPT_SUFFIX ".ckpt"                     // Journal name = output file name + suffix
+#define CKPT_DEFAULT_INTERVAL (256ULL << 20)    // Carrier bytes between journal commits (--checkpoint without a value)
+#define CKPT_VERIFY_WINDOW (1 << 20)            // Carrier bytes before the recorded offset re-checked on --resume
+#define CKPT_LSB_MATCH 0x1                      // Journal flag: data embedded by +-1 LSB matching
+#define PROGRESS_DEFAULT_MS 1000                // --progress without a value
+
+/* ======================================================================= STRUCTURE ================================================================================== */
+
+//enum to represent the run a journal belongs to
+typedef enum
+{
+    e_ckpt_encode = 1,
+    e_ckpt_decode
+} CheckpointOp;
+
+/* Journal file, rewritten (temporary file + rename) after every segment */
+typedef struct
+{
+    char magic[8];                  // CKPT_MAGIC
+    uint32_t version;               // CKPT_VERSION
+    uint32_t op;                    // CheckpointOp
+    uint64_t carrier_size;          // Carrier read by the run (source image for encode, stego image for decode)
+    int64_t carrier_mtime_sec;
+    uint32_t carrier_mtime_nsec;
+    uint32_t flags;                 // CKPT_* flags
+    uint64_t secret_size;           // Secret file embedded (encode only)
+    int64_t secret_mtime_sec;
+    uint32_t secret_mtime_nsec;
+    uint32_t reserved;
+    uint64_t data_offset;           // Carrier offset of the first secret data byte
+    uint64_t data_length;           // Carrier bytes holding the secret data
+    uint64_t done;                  // Carrier bytes of the data region durably processed
+    uint64_t match_state[4];        // LSB matching generator after done (CKPT_LSB_MATCH)
+    uint64_t match_changed;
+    uint64_t check;                 // FNV-1a of every field above
+} CheckpointRecord;
+
+/* Checkpoint and progress settings of one run, zero means off */
+typedef struct
+{
+    unsigned long long interval;    // Carrier bytes between journal commits (--checkpoint[=MiB]), 0 = no journal
+    int resume;                     // Continue from the journal (--resume)
+    uint progress_ms;               // Progress report interval (--progress[=SECONDS])
+
+    char fname[4096];               // Journal path
+    CheckpointRecord rec;           // Last committed state
+    const char *label;              // "encode" / "decode" in progress lines
+    struct timespec start, last;    // Run start and last progress line
+    unsigned long long start_done;  // Data bytes already done when the run started
+} Checkpoint;
+
+/* ================================================================= FUNCTION PROTOTYPES ============================================================================== */
+
+/* Parse one --checkpoint[=MiB], --resume or --progress[=SECONDS] option */
+Status read_checkpoint_option(const char *opt, Checkpoint *ck);
+
+/* Describe the data region of a run; with --resume load the journal of output_fname and check it belongs to the same files and region */
+Status checkpoint_open(Checkpoint *ck, CheckpointOp op, const char *output_fname, int carrier_fd, int secret_fd, off_t data_offset, off_t data_length,
+                       uint32_t flags);
+
+/* Flush durable to disk, then record done carrier bytes (and the generator) in the journal */
+Status checkpoint_commit(Checkpoint *ck, FILE *durable, unsigned long long done, const LsbMatchState *match);
+
+/* Stream the rest of the data region through the I/O engine one segment per journal commit (one segment without a journal) */
+Status checkpoint_range(Checkpoint *ck, int in_fd, int out_fd, IoBlockFn fn, void *ctx, IoConfig *io, const char **engine, FILE *durable,
+                        const LsbMatchState *match);
+
+/* Whole data region done: final progress line, journal removed */
+void checkpoint_close(Checkpoint *ck);
+
+/* Progress line to stderr when the interval has passed (or always with force) */
+void progress_report(Checkpoint *ck, unsigned long long done, int force);
+
+#endif
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/* ============================================================================= END OF CODE ===========================================================================*/
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
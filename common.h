@@ -19,6 +19,29 @@
 //It helps the decoder verify if the image contains embedded (stego) data.
 #define MAGIC_STRING "#*"
 
+//Extended magic string: marks stego data whose magic is followed by a 32 bit mode word
+//describing how the rest of the payload was embedded (see MODE_* flags below).
+#define MAGIC_STRING_EXT "#+"
+
+/* Mode word flags (stored MSB first right after MAGIC_STRING_EXT) */
+#define MODE_Y4M_ALL_PLANES 0x00000001  //Y4M carrier: payload spread over Y, U and V planes, not only luma
+#define MODE_FEC            0x00000002  //Reed-Solomon coded payload, parameter word: parity bytes << 16 | interleave depth
+#define MODE_SHARD          0x00000004  //One shard of a payload split over several images, parameter word: shard id << 16 | shard count;
+                                        //the payload stream then starts with a 32 bit payload id and the 32 bit total payload size
+#define MODE_SHARD_PARITY   0x00000008  //Shard set whose last shard is the XOR of all data shards (no parameter word)
+#define MODE_ADAPTIVE       0x00000010  //Payload only in samples whose cost map value reaches the parameter word (cost threshold)
+#define MODE_MATRIX         0x00000020  //Hamming syndrome coded payload, parameter word: p payload bits per group of 2^p - 1 bytes
+#define MODE_AUTO           0x00000040  //Capacity fitted carrier format, parameter word: LSBs per sample << 8 | channel mask (LSB_MASK_*)
+
+//Modes that carry parameters are followed by one 32 bit parameter word each, in flag order
+
+//FEC payloads store the whole extended header (magic string, mode word, parameter word) this many times in a row;
+//the decoder takes the bitwise majority of the copies, so a damaged copy does not lose the payload
+#define FEC_HEADER_COPIES 3
+
+//Returns the value part of a "--name=value" command line option, or NULL if opt is not that option
+#define OPTION_VALUE(opt, name) (strncmp((opt), (name), sizeof(name) - 1) == 0 ? (opt) + sizeof(name) - 1 : NULL)
+
 #endif
 
 //////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -0,0 +1,959 @@
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// ============================================================= * * * * * daemon.c * * * * * ========================================================================= //
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/*
+
+### USAGE OF daemon.c FILE IN STEGANOGRAPHY PROJECT ?
+--> THIS FILE IMPLEMENTS THE DAEMON MODE AND ITS CLIENT. THE MAIN THREAD ACCEPTS CONNECTIONS AND QUEUES THEM; EACH WORKER OWNS A CONNECTION UNTIL THE CLIENT CLOSES
+    IT AND ANSWERS ITS REQUESTS ONE AFTER THE OTHER. A WORKER KEEPS A MEMFD AND A BUFFER FOR ITS WHOLE LIFE: AN INLINE SECRET IS WRITTEN TO THE MEMFD AND AN INLINE
+    OUTPUT IS DECODED INTO IT, SO THE USUAL ENCODE / DECODE STEPS RUN UNCHANGED ON /proc/self/fd PATHS OF THE RECEIVED (OR MEMFD) DESCRIPTORS. SERVICE TIMES GO INTO
+    A LOG2 HISTOGRAM WITH 8 LINEAR SUB-BUCKETS PER POWER OF TWO (WITHIN 12.5 %), FROM WHICH THE PERCENTILES ARE READ.
+
+*/
+
+/* ====================================================================== INCLUDES ==================================================================================== */
+
+#define _GNU_SOURCE             // memfd_create, MSG_CMSG_CLOEXEC
+#include <stdio.h>              // Std inbuilt functions
+#include <stdlib.h>             // malloc, free, atoi
+#include <string.h>             // Inbuilt string functions
+#include <errno.h>              // EINTR
+#include <signal.h>             // SIGINT / SIGTERM shutdown
+#include <pthread.h>            // Worker pool
+#include <time.h>               // clock_gettime
+#include <unistd.h>             // read, write, close, sysconf
+#include <fcntl.h>              // open
+#include <sys/mman.h>           // memfd_create
+#include <sys/socket.h>         // Unix domain socket, SCM_RIGHTS
+#include <sys/stat.h>           // fstat
+#include <sys/un.h>             // sockaddr_un
+#include "types.h"              // Status
+#include "common.h"             // OPTION_VALUE, MODE_* flags
+#include "encode.h"             // EncodeInfo, do_encoding
+#include "decode.h"             // DecodeInfo, do_decoding
+#include "daemon.h"             // Protocol and prototypes
+
+/* ======================================================================= MACROS ===================================================================================== */
+
+#define LAT_BUCKETS 320                     // 8 exact buckets, then 8 per power of two up to 2^41 us
+#define DAEMON_WARM_BUFFER (1u << 20)       // Worker buffer allocated up front
+#define DAEMON_MAX_ARGS 32                  // --options of one job
+
+/* ======================================================================= STRUCTURE ================================================================================== */
+
+/* Latency counters of one operation */
+typedef struct
+{
+    unsigned long long count;
+    unsigned long long failed;
+    unsigned long long sum_ns;
+    unsigned long long max_ns;
+    unsigned long long hist[LAT_BUCKETS];   // Service times in microseconds
+} LatencyStats;
+
+/* Shared state of the daemon */
+typedef struct
+{
+    int listen_fd;
+    int quiet;
+    pthread_mutex_t lock;
+    pthread_cond_t ready;                   // A connection was queued (or stopping was set)
+    pthread_cond_t space;                   // A queued connection was taken
+    int queue[DAEMON_QUEUE];                // Accepted connections, FIFO
+    uint head, queued;
+    int stopping;
+    LatencyStats stats[e_daemon_stats + 1]; // Indexed by DaemonOp
+} Daemon;
+
+/* Per worker state kept between jobs */
+typedef struct
+{
+    Daemon *daemon;
+    int memfd;                              // Inline secret / inline output
+    unsigned char *buf;                     // Inline bytes and reply payloads
+    size_t cap;
+} DaemonWorker;
+
+static volatile sig_atomic_t daemon_stop;
+
+/* ================================================================= FUNCTION DEFINITIONS ============================================================================= */
+
+static unsigned long long now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (unsigned long long)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+/* Bucket of a latency in microseconds: exact below 8, else 8 linear steps per power of two */
+static uint lat_bucket(unsigned long long us)
+{
+    if (us < 8)
+    {
+        return us;
+    }
+    int e = 63 - __builtin_clzll(us);
+    uint idx = (e - 2) * 8 + ((us >> (e - 3)) & 7);
+    return idx < LAT_BUCKETS ? idx : LAT_BUCKETS - 1;
+}
+
+/* Upper bound (exclusive) of a bucket in microseconds */
+static unsigned long long lat_bucket_upper(uint idx)
+{
+    if (idx < 8)
+    {
+        return idx + 1;
+    }
+    uint e = idx / 8 + 2;
+    return (8ULL + idx % 8 + 1) << (e - 3);
+}
+
+static void lat_record(LatencyStats *s, unsigned long long ns, int failed)
+{
+    s->count++;
+    s->failed += failed != 0;
+    s->sum_ns += ns;
+    if (ns > s->max_ns)
+    {
+        s->max_ns = ns;
+    }
+    s->hist[lat_bucket(ns / 1000)]++;
+}
+
+/* Latency (us, bucket upper bound) below which a fraction q of the samples falls */
+static unsigned long long lat_percentile(const LatencyStats *s, double q)
+{
+    unsigned long long want = (unsigned long long)(q * s->count + 0.999999), seen = 0;
+    for (uint i = 0; i < LAT_BUCKETS; i++)
+    {
+        seen += s->hist[i];
+        if (seen >= want && seen != 0)
+        {
+            return lat_bucket_upper(i);
+        }
+    }
+    return 0;
+}
+
+/* One report line: count, failures, mean, p50, p99, max */
+static int lat_format(char *out, size_t size, const char *name, const LatencyStats *s)
+{
+    if (s->count == 0)
+    {
+        return snprintf(out, size, "%-7s n=0\n", name);
+    }
+    return snprintf(out, size, "%-7s n=%llu failed=%llu mean=%.0fus p50<%lluus p99<%lluus max=%.0fus\n", name, s->count, s->failed,
+                    s->sum_ns / 1e3 / s->count, lat_percentile(s, 0.50), lat_percentile(s, 0.99), s->max_ns / 1e3);
+}
+
+static const char *op_name(uint op)
+{
+    static const char *names[] = {"?", "encode", "decode", "scan", "stats"};
+    return op <= e_daemon_stats ? names[op] : "?";
+}
+
+/* Read / write exactly len bytes of a stream socket */
+static Status read_full(int fd, void *data, size_t len)
+{
+    for (size_t done = 0; done < len;)
+    {
+        ssize_t n = read(fd, (char *)data + done, len - done);
+        if (n < 0 && errno == EINTR)
+        {
+            continue;
+        }
+        if (n <= 0)
+        {
+            return e_failure;
+        }
+        done += n;
+    }
+    return e_success;
+}
+
+static Status write_full(int fd, const void *data, size_t len)
+{
+    for (size_t done = 0; done < len;)
+    {
+        ssize_t n = send(fd, (const char *)data + done, len - done, MSG_NOSIGNAL);
+        if (n < 0 && errno == EINTR)
+        {
+            continue;
+        }
+        if (n <= 0)
+        {
+            return e_failure;
+        }
+        done += n;
+    }
+    return e_success;
+}
+
+/* Header bytes with the descriptors attached to the first segment */
+static Status send_with_fds(int sock, const void *data, size_t len, const int *fds, int nfds)
+{
+    char control[CMSG_SPACE(sizeof(int) * DAEMON_MAX_FDS)];
+    struct iovec iov = {(void *)data, len};
+    struct msghdr msg;
+
+    memset(&msg, 0, sizeof(msg));
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    if (nfds > 0)
+    {
+        memset(control, 0, sizeof(control));
+        msg.msg_control = control;
+        msg.msg_controllen = CMSG_SPACE(sizeof(int) * nfds);
+        struct cmsghdr *cmsg = CMSG_FIRSTHDR(&msg);
+        cmsg->cmsg_level = SOL_SOCKET;
+        cmsg->cmsg_type = SCM_RIGHTS;
+        cmsg->cmsg_len = CMSG_LEN(sizeof(int) * nfds);
+        memcpy(CMSG_DATA(cmsg), fds, sizeof(int) * nfds);
+    }
+    ssize_t n = sendmsg(sock, &msg, MSG_NOSIGNAL);
+    if (n <= 0)
+    {
+        return e_failure;
+    }
+    return write_full(sock, (const char *)data + n, len - n);
+}
+
+/* Request header and its descriptors; returns 0 on a clean end of connection */
+static int recv_request(int sock, DaemonRequest *req, int *fds, int *nfds)
+{
+    char control[CMSG_SPACE(sizeof(int) * DAEMON_MAX_FDS)];
+    struct iovec iov = {req, sizeof(*req)};
+    struct msghdr msg;
+    ssize_t n;
+
+    memset(&msg, 0, sizeof(msg));
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    msg.msg_control = control;
+    msg.msg_controllen = sizeof(control);
+    do
+    {
+        n = recvmsg(sock, &msg, MSG_CMSG_CLOEXEC);
+    } while (n < 0 && errno == EINTR);
+    if (n <= 0)
+    {
+        return n == 0 ? 0 : -1;
+    }
+
+    // STEP 1 : Descriptors (more than DAEMON_MAX_FDS arrive truncated and are rejected below)
+    *nfds = 0;
+    for (struct cmsghdr *cmsg = CMSG_FIRSTHDR(&msg); cmsg != NULL; cmsg = CMSG_NXTHDR(&msg, cmsg))
+    {
+        if (cmsg->cmsg_level == SOL_SOCKET && cmsg->cmsg_type == SCM_RIGHTS)
+        {
+            int count = (cmsg->cmsg_len - CMSG_LEN(0)) / sizeof(int);
+            for (int i = 0; i < count; i++)
+            {
+                int fd;
+                memcpy(&fd, CMSG_DATA(cmsg) + i * sizeof(int), sizeof(int));
+                if (*nfds < DAEMON_MAX_FDS)
+                {
+                    fds[(*nfds)++] = fd;
+                }
+                else
+                {
+                    close(fd);
+                }
+            }
+        }
+    }
+    if (msg.msg_flags & MSG_CTRUNC)
+    {
+        *nfds = -1;
+    }
+
+    // STEP 2 : Rest of the header
+    if (read_full(sock, (char *)req + n, sizeof(*req) - n) == e_failure)
+    {
+        return -1;
+    }
+    return 1;
+}
+
+/* Grow the worker buffer (it is never shrunk, later jobs reuse it) */
+static Status worker_reserve(DaemonWorker *w, size_t size)
+{
+    if (size <= w->cap)
+    {
+        return e_success;
+    }
+    unsigned char *buf = realloc(w->buf, size);
+    if (buf == NULL)
+    {
+        return e_failure;
+    }
+    w->buf = buf;
+    w->cap = size;
+    return e_success;
+}
+
+/* Split the space separated option string in place */
+static int split_job_options(char *options, char *args[])
+{
+    int count = 0;
+    char *save;
+    options[DAEMON_MAX_OPTIONS - 1] = '\0';
+    for (char *tok = strtok_r(options, " ", &save); tok != NULL && count < DAEMON_MAX_ARGS; tok = strtok_r(NULL, " ", &save))
+    {
+        args[count++] = tok;
+    }
+    return count;
+}
+
+/* Encode: carrier and stego descriptors, secret as a descriptor or inline in the memfd */
+static Status serve_encode(DaemonWorker *w, DaemonRequest *req, int *fds, size_t *payload_size)
+{
+    char src[32], stego[32], secret[32];
+    char *args[DAEMON_MAX_ARGS];
+    EncodeInfo encInfo;
+
+    memset(&encInfo, 0, sizeof(encInfo));
+    snprintf(src, sizeof(src), "/proc/self/fd/%d", fds[0]);
+    snprintf(stego, sizeof(stego), "/proc/self/fd/%d", fds[1]);
+    snprintf(secret, sizeof(secret), "/proc/self/fd/%d", req->flags & DAEMON_INLINE_SECRET ? w->memfd : fds[2]);
+    encInfo.src_image_fname = src;
+    encInfo.stego_image_fname = stego;
+    encInfo.secret_fname = secret;
+    req->extn[sizeof(req->extn) - 1] = '\0';
+    memcpy(encInfo.extn_secret_file, req->extn, strnlen(req->extn, MAX_FILE_SUFFIX - 1));
+
+    Status ret = e_failure;
+    encInfo.io.restore = 1;
+    if (read_encode_options(split_job_options(req->options, args), args, &encInfo) == e_success)
+    {
+        ret = do_encoding(&encInfo);
+    }
+
+    // --io-prio / --io-nice changed this pooled thread only for the job
+    io_restore_policy(&encInfo.io);
+
+    // do_encoding leaves its streams open for the caller
+    if (encInfo.fptr_src_image != NULL)
+    {
+        fclose(encInfo.fptr_src_image);
+    }
+    if (encInfo.fptr_secret != NULL)
+    {
+        fclose(encInfo.fptr_secret);
+    }
+    if (encInfo.fptr_stego_image != NULL && fclose(encInfo.fptr_stego_image) != 0)
+    {
+        ret = e_failure;
+    }
+
+    // --metrics: the quality counters are the reply payload
+    if (ret == e_success && encInfo.metrics)
+    {
+        memcpy(w->buf, &encInfo.quality, sizeof(encInfo.quality));
+        *payload_size = sizeof(encInfo.quality);
+    }
+    return ret;
+}
+
+/* Decode: stego descriptor, output as a descriptor or into the memfd and back inline */
+static Status serve_decode(DaemonWorker *w, DaemonRequest *req, int *fds, size_t *payload_size)
+{
+    char stego[32], output[32];
+    char *args[DAEMON_MAX_ARGS];
+    DecodeInfo decInfo;
+    struct stat st;
+    int inline_output = req->flags & DAEMON_INLINE_OUTPUT;
+
+    memset(&decInfo, 0, sizeof(decInfo));
+    if (fstat(fds[0], &st) != 0 || st.st_size < 54)
+    {
+        printf("ERROR! Stego image is too small to be a valid BMP\n");
+        return e_failure;
+    }
+    snprintf(stego, sizeof(stego), "/proc/self/fd/%d", fds[0]);
+    snprintf(output, sizeof(output), "/proc/self/fd/%d", inline_output ? w->memfd : fds[1]);
+    decInfo.stego_image_fname = stego;
+    decInfo.output_fname = output;
+    decInfo.size_stego_image = st.st_size;
+    strcpy(decInfo.extn_secret_file, ".txt");
+
+    decInfo.io.restore = 1;
+    Status ret = read_decode_options(split_job_options(req->options, args), args, &decInfo);
+    if (ret == e_success)
+    {
+        ret = do_decoding(&decInfo);
+    }
+
+    // --io-prio / --io-nice changed this pooled thread only for the job
+    io_restore_policy(&decInfo.io);
+    if (ret == e_failure)
+    {
+        return e_failure;
+    }
+
+    // Decoded file back from the memfd
+    if (inline_output)
+    {
+        if (fstat(w->memfd, &st) != 0 || (size_t)st.st_size > DAEMON_MAX_INLINE || worker_reserve(w, st.st_size) == e_failure ||
+            pread(w->memfd, w->buf, st.st_size, 0) != st.st_size)
+        {
+            return e_failure;
+        }
+        *payload_size = st.st_size;
+    }
+    return e_success;
+}
+
+/* Scan: capacity and header of a carrier, without touching it */
+static Status serve_scan(DaemonWorker *w, int fd, size_t *payload_size)
+{
+    DaemonScan scan;
+    DecodeInfo probe;
+    int dup_fd = dup(fd);
+    FILE *fp = dup_fd >= 0 ? fdopen(dup_fd, "rb") : NULL;
+
+    if (fp == NULL)
+    {
+        if (dup_fd >= 0)
+        {
+            close(dup_fd);
+        }
+        return e_failure;
+    }
+    memset(&scan, 0, sizeof(scan));
+    memset(&probe, 0, sizeof(probe));
+    scan.capacity = get_image_size_for_bmp(fp);
+    probe.fptr_stego_image = fp;
+    if (fseek(fp, 54, SEEK_SET) == 0 && decode_magic_string(&probe) == e_success && decode_mode_words(&probe) == e_success)
+    {
+        scan.has_payload = 1;
+        scan.mode_word = probe.mode_word;
+    }
+    fclose(fp);
+
+    memcpy(w->buf, &scan, sizeof(scan));
+    *payload_size = sizeof(scan);
+    return e_success;
+}
+
+/* Stats: one report line per operation */
+static Status serve_stats(DaemonWorker *w, size_t *payload_size)
+{
+    Daemon *d = w->daemon;
+    size_t len = 0;
+
+    pthread_mutex_lock(&d->lock);
+    for (uint op = e_daemon_encode; op <= e_daemon_stats; op++)
+    {
+        len += lat_format((char *)w->buf + len, w->cap - len, op_name(op), &d->stats[op]);
+    }
+    pthread_mutex_unlock(&d->lock);
+    *payload_size = len;
+    return e_success;
+}
+
+/* Run one request and send its reply; e_failure drops the connection */
+static Status serve_request(DaemonWorker *w, int sock, DaemonRequest *req, int *fds, int nfds)
+{
+    DaemonReply reply;
+    size_t payload_size = 0;
+    unsigned long long t0 = now_ns();
+    Status ret = e_failure;
+    int in_sync = 1;
+
+    // STEP 1 : Descriptors the operation needs
+    int want = req->op == e_daemon_encode ? 2 + !(req->flags & DAEMON_INLINE_SECRET) :
+               req->op == e_daemon_decode ? 1 + !(req->flags & DAEMON_INLINE_OUTPUT) :
+               req->op == e_daemon_scan ? 1 : 0;
+
+    // STEP 2 : Inline secret into the memfd (always consumed, so the stream stays in step)
+    if (req->flags & DAEMON_INLINE_SECRET)
+    {
+        if (req->inline_size > DAEMON_MAX_INLINE || worker_reserve(w, req->inline_size) == e_failure ||
+            read_full(sock, w->buf, req->inline_size) == e_failure)
+        {
+            in_sync = 0;
+        }
+        else if (ftruncate(w->memfd, 0) != 0 || pwrite(w->memfd, w->buf, req->inline_size, 0) != (ssize_t)req->inline_size)
+        {
+            want = -1;
+        }
+    }
+
+    // STEP 3 : The job itself
+    if (in_sync && req->magic == DAEMON_MAGIC && nfds == want)
+    {
+        if ((req->flags & DAEMON_INLINE_OUTPUT) && ftruncate(w->memfd, 0) != 0)
+        {
+            ret = e_failure;
+        }
+        else if (req->op == e_daemon_encode)
+        {
+            ret = serve_encode(w, req, fds, &payload_size);
+        }
+        else if (req->op == e_daemon_decode)
+        {
+            ret = serve_decode(w, req, fds, &payload_size);
+        }
+        else if (req->op == e_daemon_scan)
+        {
+            ret = serve_scan(w, fds[0], &payload_size);
+        }
+        else if (req->op == e_daemon_stats)
+        {
+            ret = serve_stats(w, &payload_size);
+        }
+    }
+    for (int i = 0; i < nfds; i++)
+    {
+        close(fds[i]);
+    }
+
+    // STEP 4 : Latency of the job
+    unsigned long long ns = now_ns() - t0;
+    if (req->op >= e_daemon_encode && req->op <= e_daemon_stats)
+    {
+        pthread_mutex_lock(&w->daemon->lock);
+        lat_record(&w->daemon->stats[req->op], ns, ret == e_failure);
+        pthread_mutex_unlock(&w->daemon->lock);
+    }
+    if (!in_sync || req->magic != DAEMON_MAGIC)
+    {
+        return e_failure;
+    }
+
+    // STEP 5 : Reply header, then its payload
+    memset(&reply, 0, sizeof(reply));
+    reply.magic = DAEMON_MAGIC;
+    reply.status = ret;
+    reply.payload_size = ret == e_success ? payload_size : 0;
+    reply.service_ns = ns;
+    if (write_full(sock, &reply, sizeof(reply)) == e_failure ||
+        write_full(sock, w->buf, reply.payload_size) == e_failure)
+    {
+        return e_failure;
+    }
+    return e_success;
+}
+
+/* Worker: take the next connection and answer its requests until it closes */
+static void *daemon_worker(void *arg)
+{
+    DaemonWorker *w = arg;
+    Daemon *d = w->daemon;
+
+    for (;;)
+    {
+        pthread_mutex_lock(&d->lock);
+        while (d->queued == 0 && !d->stopping)
+        {
+            pthread_cond_wait(&d->ready, &d->lock);
+        }
+        if (d->queued == 0)
+        {
+            pthread_mutex_unlock(&d->lock);
+            break;
+        }
+        int sock = d->queue[d->head];
+        d->head = (d->head + 1) % DAEMON_QUEUE;
+        d->queued--;
+        pthread_cond_signal(&d->space);
+        pthread_mutex_unlock(&d->lock);
+
+        DaemonRequest req;
+        int fds[DAEMON_MAX_FDS], nfds;
+        while (recv_request(sock, &req, fds, &nfds) > 0 && serve_request(w, sock, &req, fds, nfds) == e_success)
+        {
+        }
+        close(sock);
+    }
+    return NULL;
+}
+
+static void daemon_signal(int sig)
+{
+    (void)sig;
+    daemon_stop = 1;
+}
+
+/* Serve requests on socket_path until SIGINT / SIGTERM */
+Status do_daemon(const char *socket_path, int opt_count, char *opts[])
+{
+    Daemon d;
+    struct sockaddr_un addr;
+    long threads = 0;
+    const char *value;
+
+    memset(&d, 0, sizeof(d));
+
+    // STEP 1 : Options
+    for (int i = 0; i < opt_count; i++)
+    {
+        if ((value = OPTION_VALUE(opts[i], "--threads=")) != NULL && atoi(value) > 0)
+        {
+            threads = atoi(value);
+        }
+        else if (strcmp(opts[i], "--quiet") == 0)
+        {
+            d.quiet = 1;
+        }
+        else
+        {
+            printf("Error: Unknown daemon option %s\n", opts[i]);
+            return e_failure;
+        }
+    }
+    if (threads <= 0)
+    {
+        threads = sysconf(_SC_NPROCESSORS_ONLN);
+        threads = threads > 0 ? threads : 1;
+    }
+    if (strlen(socket_path) >= sizeof(addr.sun_path))
+    {
+        printf("Error: Socket path %s is too long.\n", socket_path);
+        return e_failure;
+    }
+
+    // STEP 2 : Listening socket (a stale socket file from an earlier run is replaced)
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    strcpy(addr.sun_path, socket_path);
+    d.listen_fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    unlink(socket_path);
+    if (d.listen_fd < 0 || bind(d.listen_fd, (struct sockaddr *)&addr, sizeof(addr)) != 0 || listen(d.listen_fd, DAEMON_QUEUE) != 0)
+    {
+        perror(socket_path);
+        if (d.listen_fd >= 0)
+        {
+            close(d.listen_fd);
+        }
+        return e_failure;
+    }
+
+    // STEP 3 : Warm workers (memfd and buffer allocated once), signals left to the accept loop
+    DaemonWorker workers[threads];
+    pthread_t tids[threads];
+    sigset_t block, old;
+    long started = 0;
+
+    pthread_mutex_init(&d.lock, NULL);
+    pthread_cond_init(&d.ready, NULL);
+    pthread_cond_init(&d.space, NULL);
+    sigemptyset(&block);
+    sigaddset(&block, SIGINT);
+    sigaddset(&block, SIGTERM);
+    pthread_sigmask(SIG_BLOCK, &block, &old);
+    for (; started < threads; started++)
+    {
+        DaemonWorker *w = &workers[started];
+        w->daemon = &d;
+        w->memfd = memfd_create("steg-inline", MFD_CLOEXEC);
+        w->cap = DAEMON_WARM_BUFFER;
+        w->buf = malloc(w->cap);
+        if (w->memfd < 0 || w->buf == NULL || pthread_create(&tids[started], NULL, daemon_worker, w) != 0)
+        {
+            if (w->memfd >= 0)
+            {
+                close(w->memfd);
+            }
+            free(w->buf);
+            break;
+        }
+    }
+    pthread_sigmask(SIG_SETMASK, &old, NULL);
+
+    struct sigaction sa;
+    memset(&sa, 0, sizeof(sa));
+    sa.sa_handler = daemon_signal;   // No SA_RESTART: accept() returns EINTR
+    sigaction(SIGINT, &sa, NULL);
+    sigaction(SIGTERM, &sa, NULL);
+    signal(SIGPIPE, SIG_IGN);
+
+    fprintf(stderr, "Daemon listening on %s with %ld workers.\n", socket_path, started);
+    if (d.quiet)
+    {
+        fflush(stdout);
+        if (freopen("/dev/null", "w", stdout) == NULL)
+        {
+            d.quiet = 0;
+        }
+    }
+
+    // STEP 4 : Accept loop, connections queued for the workers
+    while (!daemon_stop && started > 0)
+    {
+        int sock = accept4(d.listen_fd, NULL, NULL, SOCK_CLOEXEC);
+        if (sock < 0)
+        {
+            if (errno != EINTR)
+            {
+                perror("accept");
+            }
+            continue;
+        }
+        pthread_mutex_lock(&d.lock);
+        while (d.queued == DAEMON_QUEUE && !daemon_stop)
+        {
+            pthread_cond_wait(&d.space, &d.lock);
+        }
+
+        // Stopped while the queue was still full: this connection is dropped, the queued ones are left intact
+        if (d.queued == DAEMON_QUEUE)
+        {
+            pthread_mutex_unlock(&d.lock);
+            close(sock);
+            break;
+        }
+        d.queue[(d.head + d.queued) % DAEMON_QUEUE] = sock;
+        d.queued++;
+        pthread_cond_signal(&d.ready);
+        pthread_mutex_unlock(&d.lock);
+    }
+
+    // STEP 5 : Drain the queue, stop the workers, report
+    close(d.listen_fd);
+    unlink(socket_path);
+    pthread_mutex_lock(&d.lock);
+    d.stopping = 1;
+    pthread_cond_broadcast(&d.ready);
+    pthread_mutex_unlock(&d.lock);
+    for (long i = 0; i < started; i++)
+    {
+        pthread_join(tids[i], NULL);
+        close(workers[i].memfd);
+        free(workers[i].buf);
+    }
+
+    char line[256];
+    for (uint op = e_daemon_encode; op <= e_daemon_stats; op++)
+    {
+        lat_format(line, sizeof(line), op_name(op), &d.stats[op]);
+        fputs(line, stderr);
+    }
+    pthread_mutex_destroy(&d.lock);
+    pthread_cond_destroy(&d.ready);
+    pthread_cond_destroy(&d.space);
+    return started > 0 ? e_success : e_failure;
+}
+
+/* Whole file into memory for an inline secret */
+static unsigned char *read_whole_file(const char *fname, size_t *size)
+{
+    struct stat st;
+    int fd = open(fname, O_RDONLY | O_CLOEXEC);
+    unsigned char *data = NULL;
+
+    if (fd >= 0 && fstat(fd, &st) == 0 && (size_t)st.st_size <= DAEMON_MAX_INLINE && (data = malloc(st.st_size + 1)) != NULL)
+    {
+        if (read_full(fd, data, st.st_size) == e_failure)
+        {
+            free(data);
+            data = NULL;
+        }
+        *size = st.st_size;
+    }
+    if (fd >= 0)
+    {
+        close(fd);
+    }
+    return data;
+}
+
+/* Send the request repeat times on one connection; the last reply and its payload are kept */
+static Status daemon_round_trips(int sock, const DaemonRequest *req, const int *fds, int nfds, const unsigned char *secret, int repeat,
+                                 DaemonReply *reply, unsigned char **payload, LatencyStats *client, unsigned long long *service_ns)
+{
+    for (int r = 0; r < repeat; r++)
+    {
+        unsigned long long t0 = now_ns();
+
+        // STEP 1 : Header with the descriptors, inline secret, reply header
+        if (send_with_fds(sock, req, sizeof(*req), fds, nfds) == e_failure ||
+            write_full(sock, secret, req->inline_size) == e_failure ||
+            read_full(sock, reply, sizeof(*reply)) == e_failure || reply->magic != DAEMON_MAGIC)
+        {
+            printf("Error: Daemon closed the connection.\n");
+            return e_failure;
+        }
+
+        // STEP 2 : Reply payload (NUL terminated for the stats text)
+        free(*payload);
+        *payload = malloc(reply->payload_size + 1);
+        if (*payload == NULL || read_full(sock, *payload, reply->payload_size) == e_failure)
+        {
+            printf("Error: Daemon closed the connection.\n");
+            return e_failure;
+        }
+        (*payload)[reply->payload_size] = '\0';
+        lat_record(client, now_ns() - t0, reply->status != e_success);
+        *service_ns += reply->service_ns;
+    }
+    return e_success;
+}
+
+/* Send one request to the daemon at socket_path */
+Status do_daemon_request(const char *socket_path, int argc, char *argv[], int opt_count, char *opts[])
+{
+    DaemonRequest req;
+    DaemonReply reply;
+    LatencyStats client;
+    struct sockaddr_un addr;
+    int fds[DAEMON_MAX_FDS], nfds = 0;
+    int repeat = 1, inline_io = 0, opened = 1;
+    unsigned char *secret = NULL, *payload = NULL;
+    unsigned long long service_ns = 0;
+    size_t secret_size = 0;
+    const char *value;
+
+    memset(&req, 0, sizeof(req));
+    memset(&reply, 0, sizeof(reply));
+    memset(&client, 0, sizeof(client));
+    req.magic = DAEMON_MAGIC;
+
+    // STEP 1 : Client options, the rest is forwarded to the job
+    size_t used = 0;
+    for (int i = 0; i < opt_count; i++)
+    {
+        if (strcmp(opts[i], "--inline") == 0)
+        {
+            inline_io = 1;
+        }
+        else if ((value = OPTION_VALUE(opts[i], "--repeat=")) != NULL && atoi(value) > 0)
+        {
+            repeat = atoi(value);
+        }
+        else if (used + strlen(opts[i]) + 2 <= DAEMON_MAX_OPTIONS)
+        {
+            used += sprintf(req.options + used, "%s%s", used ? " " : "", opts[i]);
+        }
+        else
+        {
+            printf("Error: Too many job options.\n");
+            return e_failure;
+        }
+    }
+
+    // STEP 2 : Operation and its descriptors
+    if (argc >= 4 && strcmp(argv[0], "encode") == 0)
+    {
+        const char *dot = strrchr(argv[2], '.');
+        req.op = e_daemon_encode;
+        strncpy(req.extn, dot != NULL ? dot + 1 : "txt", sizeof(req.extn) - 1);
+        fds[nfds++] = open(argv[1], O_RDONLY | O_CLOEXEC);
+        fds[nfds++] = open(argv[3], O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+        if (inline_io)
+        {
+            req.flags |= DAEMON_INLINE_SECRET;
+            secret = read_whole_file(argv[2], &secret_size);
+            req.inline_size = secret_size;
+            opened = secret != NULL;
+        }
+        else
+        {
+            fds[nfds++] = open(argv[2], O_RDONLY | O_CLOEXEC);
+        }
+    }
+    else if (argc >= 3 && strcmp(argv[0], "decode") == 0)
+    {
+        req.op = e_daemon_decode;
+        fds[nfds++] = open(argv[1], O_RDONLY | O_CLOEXEC);
+        if (inline_io)
+        {
+            req.flags |= DAEMON_INLINE_OUTPUT;
+        }
+        else
+        {
+            fds[nfds++] = open(argv[2], O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+        }
+    }
+    else if (argc >= 2 && strcmp(argv[0], "scan") == 0)
+    {
+        req.op = e_daemon_scan;
+        fds[nfds++] = open(argv[1], O_RDONLY | O_CLOEXEC);
+    }
+    else if (argc >= 1 && strcmp(argv[0], "stats") == 0)
+    {
+        req.op = e_daemon_stats;
+    }
+    else
+    {
+        printf("Usage: ./program -q socket encode in.bmp secret.txt out.bmp | decode stego.bmp out.txt | scan image.bmp | stats [--inline] [--repeat=N]\n");
+        return e_failure;
+    }
+    for (int i = 0; i < nfds; i++)
+    {
+        opened = opened && fds[i] >= 0;
+    }
+
+    // STEP 3 : Connect and run the round trips
+    Status ret = e_failure;
+    int sock = -1;
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    strncpy(addr.sun_path, socket_path, sizeof(addr.sun_path) - 1);
+    if (!opened)
+    {
+        printf("Error: Unable to open the files of the request.\n");
+    }
+    else if ((sock = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0)) < 0 || connect(sock, (struct sockaddr *)&addr, sizeof(addr)) != 0)
+    {
+        perror(socket_path);
+    }
+    else if (daemon_round_trips(sock, &req, fds, nfds, secret, repeat, &reply, &payload, &client, &service_ns) == e_success)
+    {
+        ret = reply.status == e_success ? e_success : e_failure;
+
+        // STEP 4 : Result of the last round trip
+        if (ret == e_success && req.op == e_daemon_decode && inline_io)
+        {
+            FILE *fp = fopen(argv[2], "w");
+            if (fp == NULL || fwrite(payload, 1, reply.payload_size, fp) != reply.payload_size || fclose(fp) != 0)
+            {
+                printf("Error: Cannot write %s\n", argv[2]);
+                ret = e_failure;
+            }
+        }
+        else if (ret == e_success && req.op == e_daemon_encode && reply.payload_size == sizeof(QualityStats))
+        {
+            QualityStats quality;
+            memcpy(&quality, payload, sizeof(quality));
+            quality_report(&quality);
+        }
+        else if (ret == e_success && req.op == e_daemon_scan && reply.payload_size == sizeof(DaemonScan))
+        {
+            DaemonScan scan;
+            memcpy(&scan, payload, sizeof(scan));
+            printf("%s: capacity %llu bytes, %s", argv[1], (unsigned long long)scan.capacity, scan.has_payload ? "payload present" : "no payload");
+            printf(scan.mode_word ? ", mode word 0x%08x\n" : "\n", scan.mode_word);
+        }
+        else if (ret == e_success && req.op == e_daemon_stats)
+        {
+            printf("%s", (char *)payload);
+        }
+
+        char line[256];
+        lat_format(line, sizeof(line), "client", &client);
+        printf("%s %s, server %.0fus per request\n%s", op_name(req.op), ret == e_success ? "succeeded" : "failed", service_ns / 1e3 / repeat, line);
+    }
+
+    // STEP 5 : Descriptors were duplicated into the daemon, ours are closed here
+    if (sock >= 0)
+    {
+        close(sock);
+    }
+    for (int i = 0; i < nfds; i++)
+    {
+        if (fds[i] >= 0)
+        {
+            close(fds[i]);
+        }
+    }
+    free(secret);
+    free(payload);
+    return ret;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/* ============================================================================= END OF CODE ===========================================================================*/
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
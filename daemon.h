@@ -0,0 +1,91 @@
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// ============================================================= * * * * * daemon.h * * * * * ========================================================================= //
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/*
+
+### USAGE OF daemon.h FILE IN STEGANOGRAPHY PROJECT ?
+--> THIS HEADER FILE DECLARES THE DAEMON MODE (-D) AND ITS CLIENT (-q). THE DAEMON LISTENS ON A UNIX DOMAIN SOCKET AND SERVES ENCODE, DECODE, SCAN AND STATS REQUESTS
+    ON A POOL OF WORKER THREADS THAT STAY UP BETWEEN JOBS. A REQUEST IS A FIXED SIZE HEADER; THE FILES OF THE JOB TRAVEL AS FILE DESCRIPTORS (SCM_RIGHTS), WHILE A
+    SECRET FILE MAY ALSO BE SENT INLINE AFTER THE HEADER AND A DECODED FILE RETURNED INLINE AFTER THE REPLY. EVERY REPLY CARRIES THE SERVICE TIME OF THE JOB, AND THE
+    DAEMON KEEPS A LATENCY HISTOGRAM PER OPERATION (COUNT, FAILURES, P50 / P99 / MAX).
+
+*/
+
+// ==================================================================================================================================================================== //
+
+#ifndef DAEMON_H
+#define DAEMON_H
+
+/* ====================================================================== INCLUDES ==================================================================================== */
+
+#include <stdint.h>
+#include "types.h"
+
+/* ======================================================================= MACROS ===================================================================================== */
+
+#define DAEMON_MAGIC 0x44475453u            // "STGD" little endian, first word of every request and reply
+#define DAEMON_MAX_OPTIONS 256              // Space separated --options of one job
+#define DAEMON_MAX_INLINE (64u << 20)       // Largest inline secret / decoded file
+#define DAEMON_QUEUE 64                     // Accepted connections waiting for a worker
+#define DAEMON_MAX_FDS 3                    // Descriptors of one request (encode: carrier, stego, secret)
+
+#define DAEMON_INLINE_SECRET 0x1            // Secret bytes follow the request instead of a descriptor
+#define DAEMON_INLINE_OUTPUT 0x2            // Decoded file follows the reply instead of going to a descriptor
+
+/* ======================================================================= STRUCTURE ================================================================================== */
+
+//enum to represent the job carried by one request
+typedef enum
+{
+    e_daemon_encode = 1,    //fds: carrier, stego [, secret], reply payload is a QualityStats with --metrics
+    e_daemon_decode,        //fds: stego [, output]
+    e_daemon_scan,          //fds: image, reply payload is a DaemonScan
+    e_daemon_stats          //no fds, reply payload is the latency report text
+} DaemonOp;
+
+/* Request header, sent with its descriptors in one sendmsg */
+typedef struct
+{
+    uint32_t magic;                     // DAEMON_MAGIC
+    uint32_t op;                        // DaemonOp
+    uint32_t flags;                     // DAEMON_INLINE_* flags
+    uint32_t inline_size;               // Secret bytes following the header (DAEMON_INLINE_SECRET)
+    char extn[8];                       // Secret file extension without the dot (encode)
+    char options[DAEMON_MAX_OPTIONS];   // Encode / decode --options, space separated
+} DaemonRequest;
+
+/* Reply header, followed by payload_size bytes */
+typedef struct
+{
+    uint32_t magic;                     // DAEMON_MAGIC
+    uint32_t status;                    // Status of the job
+    uint32_t payload_size;              // Bytes following the reply
+    uint32_t reserved;
+    uint64_t service_ns;                // Time the worker spent on the job
+} DaemonReply;
+
+/* Reply payload of a scan */
+typedef struct
+{
+    uint64_t capacity;                  // Carrier bytes of the pixel array (width * height * 3)
+    uint32_t has_payload;               // LSBs start with a magic string
+    uint32_t mode_word;                 // MODE_* flags of an extended header (0 otherwise)
+} DaemonScan;
+
+/* ================================================================= FUNCTION PROTOTYPES ============================================================================== */
+
+/* Serve requests on socket_path until SIGINT / SIGTERM (--threads=N workers, --quiet silences job output) */
+Status do_daemon(const char *socket_path, int opt_count, char *opts[]);
+
+/* Send one request to the daemon at socket_path: encode in.bmp secret out.bmp | decode stego.bmp out | scan image.bmp | stats
+ * --inline sends the secret / receives the decoded file inline, --repeat=N repeats the request and reports client latency,
+ * every other --option is forwarded to the job
+ */
+Status do_daemon_request(const char *socket_path, int argc, char *argv[], int opt_count, char *opts[]);
+
+#endif
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/* ============================================================================= END OF CODE ===========================================================================*/
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
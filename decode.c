@@ -16,9 +16,16 @@
 #include <stdio.h>     // Std inbuilt functions 
 #include <stdlib.h>    // Std library files
 #include <string.h>    // Inbuilt string functions
+#include <unistd.h>    // pread, ftruncate
 #include "types.h"     // Custom files like status, operation Type
 #include "decode.h"    // Decode func declarations and decodeinfo struct
 #include "common.h"    // Contains MAGIC_STRING macro
+#include "fec.h"       // Reed-Solomon forward error correction
+#include "adaptive.h"  // Content-adaptive extraction
+#include "matrix.h"    // Matrix embedding extraction
+#include "autofit.h"   // Capacity fitted extraction
+#include "differential.h" // Comparison with the original carrier
+#include "lsbkernel.h" // Specialised LSB replacement kernels
 
 /* ================================================================= FUNCTION DEFINITIONS ============================================================================= */
 
@@ -42,26 +49,31 @@ Status read_and_validate_decode_args(int argc, char *argv[], DecodeInfo *decInfo
     if (argc < 4)
     {
         printf("ERROR! Insufficient arguments for decoding.\n");
-        printf("Usage: ./program -d stego_image.bmp output_file [original_stego.bmp]\n");
+        printf("Usage: ./program -d stego_image.bmp output_file [original_carrier.bmp]\n");
         return e_failure;
     }
 
-    // Check for .bmp (stego image)
+    // Check for .bmp (stego image) or .y4m / "-" (stego frame stream)
     if(strstr(argv[2], ".bmp") != NULL)
     {
         decInfo->stego_image_fname = argv[2];
     }
+    else if (strstr(argv[2], ".y4m") != NULL || strcmp(argv[2], "-") == 0)
+    {
+        decInfo->stego_image_fname = argv[2];
+        decInfo->is_y4m = 1;
+    }
     else
     {
-        printf("ERROR! Stego image must be a .bmp file\n");
+        printf("ERROR! Stego image must be a .bmp or .y4m file\n");
         return e_failure;
     }
 
     // Set output filename (argv[3])
     decInfo->output_fname = argv[3];
     
-    // Test if we can create the output file
-    FILE *fp = fopen(decInfo->output_fname, "w");
+    // Test if we can create the output file (append mode: a partial output kept for --resume is not truncated here)
+    FILE *fp = fopen(decInfo->output_fname, "a");
     if (fp == NULL)
     {
         printf("Error: Cannot create output file %s\n", decInfo->output_fname);
@@ -82,6 +94,23 @@ Status read_and_validate_decode_args(int argc, char *argv[], DecodeInfo *decInfo
         strcpy(decInfo->extn_secret_file, ".txt"); // Default fallback
     }
 
+    // Optional original carrier (argv[4]): the stego image is compared with it before extraction
+    if (argc > 4)
+    {
+        if (decInfo->is_y4m || strstr(argv[4], ".bmp") == NULL)
+        {
+            printf("ERROR! The original carrier must be a .bmp file, given with a BMP stego image\n");
+            return e_failure;
+        }
+        decInfo->original_fname = argv[4];
+    }
+
+    // Frame streams are validated while their header is parsed
+    if (decInfo->is_y4m)
+    {
+        return e_success;
+    }
+
     // Get stego image file size
     fp = fopen(decInfo->stego_image_fname, "rb");
     if (fp == NULL)
@@ -103,10 +132,73 @@ Status read_and_validate_decode_args(int argc, char *argv[], DecodeInfo *decInfo
     return e_success;
 }
 
+/* Read optional --name=value decode options */
+Status read_decode_options(int count, char *opts[], DecodeInfo *decInfo)
+{
+    const char *value;
+
+    for (int i = 0; i < count; i++)
+    {
+        if (strncmp(opts[i], "--io", 4) == 0)
+        {
+            // Block I/O engine settings
+            if (read_io_option(opts[i], &decInfo->io) == e_failure)
+            {
+                return e_failure;
+            }
+        }
+        else if (strncmp(opts[i], "--checkpoint", 12) == 0 || strcmp(opts[i], "--resume") == 0 || strncmp(opts[i], "--progress", 10) == 0)
+        {
+            // Checkpoint journal, resuming and progress lines
+            if (read_checkpoint_option(opts[i], &decInfo->ckpt) == e_failure)
+            {
+                return e_failure;
+            }
+        }
+        else if ((value = OPTION_VALUE(opts[i], "--range=")) != NULL)
+        {
+            // Payload bytes OFF .. OFF + LEN - 1 only
+            char *end;
+            decInfo->range_offset = strtoull(value, &end, 0);
+            if (end == value || *value == '-' || *end != ':' || end[1] == '-' ||
+                (decInfo->range_length = strtoull(end + 1, &end, 0)) == 0 || *end != '\0')
+            {
+                printf("Error: --range must be OFF:LEN with LEN > 0\n");
+                return e_failure;
+            }
+            decInfo->has_range = 1;
+        }
+        else
+        {
+            printf("Error: Unknown decode option %s\n", opts[i]);
+            return e_failure;
+        }
+    }
+    if (decInfo->is_y4m && (decInfo->ckpt.interval != 0 || decInfo->ckpt.progress_ms != 0 || decInfo->has_range))
+    {
+        printf("Error: --checkpoint, --resume, --progress and --range only apply to BMP images.\n");
+        return e_failure;
+    }
+    if (decInfo->has_range && (decInfo->ckpt.interval != 0 || decInfo->ckpt.progress_ms != 0))
+    {
+        // A range is read piecewise like decode_range(), not streamed through the journaled engine
+        printf("Error: --range cannot be combined with --checkpoint, --resume or --progress.\n");
+        return e_failure;
+    }
+    return e_success;
+}
+
 /* Open files */
 // Open stego image for reading and output file for writing
 Status open_decode_files(DecodeInfo *decInfo)
 {
+    // Bandwidth caps, I/O class and niceness of this job (--io-limit, --io-prio, --io-nice) cover all the I/O below
+    if (io_apply_policy(&decInfo->io) == e_failure)
+    {
+        fprintf(stderr, "ERROR: Unable to apply the I/O policy\n");
+        return e_failure;
+    }
+
     // Open stego image in binary read mode
     decInfo->fptr_stego_image = fopen(decInfo->stego_image_fname, "rb");
     if (decInfo->fptr_stego_image == NULL)
@@ -116,8 +208,8 @@ Status open_decode_files(DecodeInfo *decInfo)
         return e_failure;
     }
 
-    // Open output file in write mode
-    decInfo->fptr_output = fopen(decInfo->output_fname, "w");
+    // Open output file in write mode (--resume continues the partly written one)
+    decInfo->fptr_output = fopen(decInfo->output_fname, decInfo->ckpt.resume ? "r+" : "w");
     if (decInfo->fptr_output == NULL)
     {
         perror("fopen");
@@ -140,6 +232,38 @@ char decode_byte_from_lsb(char *image_buffer)
     return data;
 }
 
+/* Bitwise majority of three header copies */
+#define MAJORITY3(a, b, c) (((a) & (b)) | ((a) & (c)) | ((b) & (c)))
+
+/* FEC header: bitwise majority of the FEC_HEADER_COPIES copies of magic string, mode word and parameter word from byte 54 on;
+ * succeeds when the vote reads MAGIC_STRING_EXT and MODE_FEC, leaving the stream after the last copy
+ */
+static Status vote_fec_header(FILE *fptr, uint *mode_word, uint *fec_param)
+{
+    char image_buffer[16];
+    uint magic[FEC_HEADER_COPIES], mode[FEC_HEADER_COPIES], param[FEC_HEADER_COPIES];
+
+    if (fseek(fptr, 54, SEEK_SET) != 0)
+    {
+        return e_failure;
+    }
+    for (int copy = 0; copy < FEC_HEADER_COPIES; copy++)
+    {
+        if (fread(image_buffer, sizeof(char), 16, fptr) != 16)
+        {
+            return e_failure;
+        }
+        magic[copy] = (unsigned char)decode_byte_from_lsb(image_buffer) << 8 | (unsigned char)decode_byte_from_lsb(image_buffer + 8);
+        mode[copy] = decode_size_from_lsb(fptr);
+        param[copy] = decode_size_from_lsb(fptr);
+    }
+
+    *mode_word = MAJORITY3(mode[0], mode[1], mode[2]);
+    *fec_param = MAJORITY3(param[0], param[1], param[2]);
+    uint ext = (unsigned char)MAGIC_STRING_EXT[0] << 8 | (unsigned char)MAGIC_STRING_EXT[1];
+    return MAJORITY3(magic[0], magic[1], magic[2]) == ext && *mode_word == MODE_FEC ? e_success : e_failure;
+}
+
 /* Decode magic string and verify */
 Status decode_magic_string(DecodeInfo *decInfo)
 {
@@ -161,10 +285,25 @@ Status decode_magic_string(DecodeInfo *decInfo)
     // Compare decoded magic string with predefined one 
     if (strcmp(magic_str, MAGIC_STRING) == 0)
     {
+        decInfo->is_extended = 0;
+        return e_success;
+    }
+    else if (strcmp(magic_str, MAGIC_STRING_EXT) == 0)
+    {
+        // Extended header, caller reads the mode word next
+        decInfo->is_extended = 1;
         return e_success;
     }
     else
     {
+        // A FEC header still reads "#+" by majority when only its first copy is damaged; the mode words follow as usual
+        uint mode_word, fec_param;
+        if (vote_fec_header(decInfo->fptr_stego_image, &mode_word, &fec_param) == e_success &&
+            fseek(decInfo->fptr_stego_image, 54 + strlen(MAGIC_STRING_EXT) * 8, SEEK_SET) == 0)
+        {
+            decInfo->is_extended = 1;
+            return e_success;
+        }
         printf("ERROR! Magic string mismatch. Expected: %s, Got: %s\n", MAGIC_STRING, magic_str);
         return e_failure;
     }
@@ -215,7 +354,199 @@ Status decode_secret_file_extn(DecodeInfo *decInfo)
     // NULL terminate
     decInfo->extn_secret_file[extn_size] = '\0';
 
-    printf("Decoded file extension: %s\n", decInfo->extn_secret_file);
+    return e_success;
+}
+
+/* State shared with extract_data_block() while the I/O engine streams the carrier */
+typedef struct
+{
+    FILE *fptr_output;  // Output file, written sequentially
+    Checkpoint *ckpt;   // Progress lines (--progress)
+    const LsbKernel *kernel; // LSB replacement kernel of the carrier format
+    unsigned long long done; // Carrier bytes of the data region extracted so far
+    IoConfig *io;       // Output writes paced by the write bucket
+} ExtractBlockCtx;
+
+/* I/O engine callback: extract one secret byte from every 8 carrier bytes of a block */
+static Status extract_data_block(unsigned char *block, size_t len, void *ctx)
+{
+    ExtractBlockCtx *extract = ctx;
+    FILE *fptr_output = extract->fptr_output;
+    size_t count = len / 8;
+
+    // Decoded bytes overwrite the front of the block (never ahead of the carrier bytes still to read), it is not written back
+    lsb_kernel_extract(extract->kernel, block, block, count);
+    io_throttle(extract->io, e_io_write, count);
+    if (fwrite(block, 1, count, fptr_output) != count)
+    {
+        printf("ERROR! Cannot write output file\n");
+        return e_failure;
+    }
+    extract->done += len;
+    progress_report(extract->ckpt, extract->done, 0);
+    return e_success;
+}
+
+/* --resume: the output must end with the bytes the stego image holds just before the checkpoint; anything after it is cut off */
+static Status resume_output_file(DecodeInfo *decInfo)
+{
+    CheckpointRecord *rec = &decInfo->ckpt.rec;
+    size_t window = rec->done < CKPT_VERIFY_WINDOW ? rec->done : CKPT_VERIFY_WINDOW;
+    off_t out_pos = (rec->done - window) / 8;
+    unsigned char *carrier = malloc(window + 8);
+    unsigned char *output = malloc(window / 8 + 1);
+    Status ret = e_success;
+
+    // Window of extracted data just before the checkpoint, compared with the stego LSBs
+    if (carrier == NULL || output == NULL ||
+        pread(fileno(decInfo->fptr_stego_image), carrier, window, rec->data_offset + rec->done - window) != (ssize_t)window ||
+        pread(fileno(decInfo->fptr_output), output, window / 8, out_pos) != (ssize_t)(window / 8))
+    {
+        printf("ERROR! Cannot read the data before the checkpoint\n");
+        ret = e_failure;
+    }
+    for (size_t i = 0; ret == e_success && i < window / 8; i++)
+    {
+        if ((unsigned char)decode_byte_from_lsb((char *)carrier + i * 8) != output[i])
+        {
+            printf("ERROR! %s does not hold the data its checkpoint records (byte %lld differs)\n", decInfo->output_fname, (long long)(out_pos + i));
+            ret = e_failure;
+        }
+    }
+    free(carrier);
+    free(output);
+
+    if (ret == e_success && (ftruncate(fileno(decInfo->fptr_output), rec->done / 8) != 0 || fseek(decInfo->fptr_output, rec->done / 8, SEEK_SET) != 0))
+    {
+        perror("ftruncate");
+        ret = e_failure;
+    }
+    return ret;
+}
+
+/* Payload bytes offset .. offset + length - 1 of a plain payload whose file_size data bytes start at carrier byte data_offset: payload byte i
+ * sits in the 8 carrier bytes at data_offset + 8 * i, so only those are read, RANGE_CHUNK at a time; *decoded stops short at the end of the file
+ */
+static Status read_payload_range(FILE *fptr, off_t data_offset, unsigned long long file_size, unsigned long long offset, size_t length,
+                                 unsigned char *buf, size_t *decoded, IoConfig *io)
+{
+    *decoded = 0;
+    if (offset >= file_size)
+    {
+        return e_success;
+    }
+
+    unsigned char *carrier = malloc(RANGE_CHUNK);
+    if (carrier == NULL)
+    {
+        return e_failure;
+    }
+    const LsbKernel *kernel = lsb_kernel_select(1, 3, LSB_MASK_BGR);
+    off_t start = data_offset + (off_t)offset * 8;
+    size_t count = length < file_size - offset ? length : file_size - offset;
+    Status ret = e_success;
+    while (*decoded < count)
+    {
+        size_t n = count - *decoded < RANGE_CHUNK / 8 ? count - *decoded : RANGE_CHUNK / 8;
+        io_throttle(io, e_io_read, n * 8);
+        if (pread(fileno(fptr), carrier, n * 8, start + (off_t)*decoded * 8) != (ssize_t)(n * 8))
+        {
+            ret = e_failure;
+            break;
+        }
+        lsb_kernel_extract(kernel, carrier, buf + *decoded, n);
+        *decoded += n;
+    }
+    free(carrier);
+    return ret;
+}
+
+/* --range: the requested payload bytes through read_payload_range() into the output file */
+static Status decode_range_to_output(DecodeInfo *decInfo, off_t data_offset, int file_size)
+{
+    if (decInfo->range_offset >= (unsigned long long)file_size)
+    {
+        printf("ERROR! Range starts at byte %llu, past the end of the %d byte file\n", decInfo->range_offset, file_size);
+        return e_failure;
+    }
+    unsigned long long first = decInfo->range_offset;
+    unsigned long long count = decInfo->range_length < file_size - first ? decInfo->range_length : file_size - first;
+    printf("Decoding bytes %llu to %llu only.\n", first, first + count - 1);
+
+    unsigned char *buf = malloc(RANGE_CHUNK / 8);
+    if (buf == NULL)
+    {
+        printf("ERROR! Cannot allocate range buffer\n");
+        return e_failure;
+    }
+    Status ret = e_success;
+    for (unsigned long long done = 0; done < count && ret == e_success;)
+    {
+        size_t n = count - done < RANGE_CHUNK / 8 ? count - done : RANGE_CHUNK / 8, got;
+        if (read_payload_range(decInfo->fptr_stego_image, data_offset, file_size, first + done, n, buf, &got, &decInfo->io) == e_failure ||
+            got != n)
+        {
+            printf("ERROR! Cannot read secret data from image\n");
+            ret = e_failure;
+        }
+        else
+        {
+            io_throttle(&decInfo->io, e_io_write, n);
+            if (fwrite(buf, 1, n, decInfo->fptr_output) != n)
+            {
+                printf("ERROR! Cannot write to output file\n");
+                ret = e_failure;
+            }
+            done += n;
+        }
+    }
+    free(buf);
+    return ret;
+}
+
+/* Mode word of an extended header and the parameter word each of its modes adds (majority voted for FEC headers) */
+Status decode_mode_words(DecodeInfo *decInfo)
+{
+    decInfo->mode_word = 0;
+    if (!decInfo->is_extended)
+    {
+        return e_success;
+    }
+    decInfo->mode_word = decode_size_from_lsb(decInfo->fptr_stego_image);
+
+    // Anything but a clean word of the other modes is taken from the majority of the FEC header copies
+    if (decInfo->mode_word != MODE_ADAPTIVE && decInfo->mode_word != MODE_MATRIX && decInfo->mode_word != MODE_AUTO &&
+        (decInfo->mode_word & ~MODE_SHARD_PARITY) != MODE_SHARD)
+    {
+        long pos = ftell(decInfo->fptr_stego_image);
+        uint mode_word, fec_param;
+        if (vote_fec_header(decInfo->fptr_stego_image, &mode_word, &fec_param) == e_success)
+        {
+            decInfo->mode_word = mode_word;
+            decInfo->fec_param = fec_param;
+            return e_success;
+        }
+        if (fseek(decInfo->fptr_stego_image, pos, SEEK_SET) != 0)
+        {
+            return e_failure;
+        }
+    }
+    if (decInfo->mode_word & MODE_FEC)
+    {
+        decInfo->fec_param = decode_size_from_lsb(decInfo->fptr_stego_image);
+    }
+    if (decInfo->mode_word & MODE_ADAPTIVE)
+    {
+        decInfo->adaptive_threshold = decode_size_from_lsb(decInfo->fptr_stego_image);
+    }
+    if (decInfo->mode_word & MODE_MATRIX)
+    {
+        decInfo->matrix_p = decode_size_from_lsb(decInfo->fptr_stego_image);
+    }
+    if (decInfo->mode_word & MODE_AUTO)
+    {
+        decInfo->auto_param = decode_size_from_lsb(decInfo->fptr_stego_image);
+    }
     return e_success;
 }
 
@@ -231,24 +562,199 @@ Status decode_secret_file_data(DecodeInfo *decInfo)
     }
 
     printf("Decoding file of size: %d bytes\n", file_size);
-    
-    char image_buffer[8];
 
-    // Decode each byte of secret and write to output
-    for (int i = 0; i < file_size; i++)
+    // --range: only the carrier bytes of the requested payload bytes are read, the same way decode_range() does
+    off_t offset = ftell(decInfo->fptr_stego_image);
+    if (decInfo->has_range)
     {
-        if (fread(image_buffer, sizeof(char), 8, decInfo->fptr_stego_image) != 8)
+        return decode_range_to_output(decInfo, offset, file_size);
+    }
+
+    // Journal of this run; --resume takes over the recorded progress once the output checks out
+    Checkpoint *ck = &decInfo->ckpt;
+    if (checkpoint_open(ck, e_ckpt_decode, decInfo->output_fname, fileno(decInfo->fptr_stego_image), -1, offset, (off_t)file_size * 8, 0) == e_failure ||
+        (ck->resume ? resume_output_file(decInfo) == e_failure :
+         ck->interval != 0 && checkpoint_commit(ck, decInfo->fptr_output, 0, NULL) == e_failure))
+    {
+        return e_failure;
+    }
+
+    // The data is the bulk of the image: stream its carrier range through the block I/O engine, one segment per checkpoint
+    const char *engine;
+    ExtractBlockCtx extract = { decInfo->fptr_output, ck, lsb_kernel_select(1, 3, LSB_MASK_BGR), ck->rec.done, &decInfo->io };
+    if (checkpoint_range(ck, fileno(decInfo->fptr_stego_image), -1, extract_data_block, &extract, &decInfo->io, &engine, decInfo->fptr_output,
+                         NULL) == e_failure)
+    {
+        printf("ERROR! Cannot read secret data from image\n");
+        return e_failure;
+    }
+    checkpoint_close(ck);
+    printf("Secret data extracted through %s engine.\n", engine);
+
+    return e_success;
+}
+
+Status decode_range(const char *stego_fname, unsigned long long offset, size_t length, unsigned char *buf, size_t *decoded)
+{
+    DecodeInfo decInfo;
+    int file_size = -1;
+    Status ret = e_failure;
+
+    memset(&decInfo, 0, sizeof(decInfo));
+    *decoded = 0;
+
+    // STEP 1 : Header fields in front of the data, read as do_decoding() reads them: magic string, mode words, extension and file size
+    decInfo.stego_image_fname = (char *)stego_fname;
+    decInfo.fptr_stego_image = fopen(stego_fname, "rb");
+    if (decInfo.fptr_stego_image == NULL)
+    {
+        return e_failure;
+    }
+    if (fseek(decInfo.fptr_stego_image, 54, SEEK_SET) == 0 && decode_magic_string(&decInfo) == e_success &&
+        decode_mode_words(&decInfo) == e_success && decInfo.mode_word == 0 && decode_secret_file_extn(&decInfo) == e_success &&
+        (file_size = decode_size_from_lsb(decInfo.fptr_stego_image)) > 0)
+    {
+        // STEP 2 : Carrier bytes of the requested payload bytes only, as for --range
+        ret = read_payload_range(decInfo.fptr_stego_image, ftell(decInfo.fptr_stego_image), file_size, offset, length, buf, decoded, NULL);
+    }
+
+    fclose(decInfo.fptr_stego_image);
+    return ret;
+}
+
+/* Route one byte of a payload stream into the header fields or the output file */
+void parse_payload_byte(DecodeInfo *decInfo, PayloadParser *parser, unsigned char byte)
+{
+    uint i = parser->index++;
+
+    if (parser->done || parser->failed)
+    {
+        return;
+    }
+
+    if (i < 4)
+    {
+        // Extension size, MSB first
+        parser->extn_size = (parser->extn_size << 8) | byte;
+        if (i == 3 && (parser->extn_size == 0 || parser->extn_size >= MAX_FILE_SUFFIX))
         {
-            printf("ERROR! Cannot read secret data from image at byte %d\n", i);
-            return e_failure;
+            printf("ERROR! Invalid extension size: %u\n", parser->extn_size);
+            parser->failed = 1;
+        }
+    }
+    else if (i < 4 + parser->extn_size)
+    {
+        // Extension characters
+        decInfo->extn_secret_file[i - 4] = byte;
+        if (i == 3 + parser->extn_size)
+        {
+            decInfo->extn_secret_file[parser->extn_size] = '\0';
+            printf("Decoded file extension: %s\n", decInfo->extn_secret_file);
+        }
+    }
+    else if (i < 8 + parser->extn_size)
+    {
+        // File size, MSB first
+        parser->file_size = (parser->file_size << 8) | byte;
+        if (i == 7 + parser->extn_size)
+        {
+            printf("Decoding file of size: %u bytes\n", parser->file_size);
+            parser->done = parser->file_size == 0;
         }
-        char ch = decode_byte_from_lsb(image_buffer);
-        fputc(ch, decInfo->fptr_output); // Write character to output file
     }
+    else
+    {
+        fputc(byte, decInfo->fptr_output);
+        parser->done = ++parser->written == parser->file_size;
+    }
+}
 
+/* Decode extension and data stored one bit per image byte */
+Status decode_plain_payload(DecodeInfo *decInfo)
+{
+    // Decode extension
+    printf("Decoding file extension...\n");
+    if (decode_secret_file_extn(decInfo) == e_failure)
+    {
+        printf("ERROR! Failed to decode secret file extension.\n");
+        return e_failure;
+    }
+    printf("Decoded file extension: %s\n", decInfo->extn_secret_file);
+
+    // Decode and write secret data to output file
+    printf("Decoding secret file data...\n");
+    if (decode_secret_file_data(decInfo) == e_failure)
+    {
+        printf("ERROR! Failed to decode secret file data.\n");
+        return e_failure;
+    }
     return e_success;
 }
 
+/* Decode a Reed-Solomon coded payload, one interleaved group at a time */
+Status decode_fec_payload(DecodeInfo *decInfo)
+{
+    FecCodec fec;
+    PayloadParser parser;
+    char image_buffer[8];
+    Status ret = e_success;
+
+    memset(&parser, 0, sizeof(parser));
+    if (fec_init(&fec, decInfo->fec_param >> 16, decInfo->fec_param & 0xFFFF) == e_failure)
+    {
+        return e_failure;
+    }
+    printf("Decoding RS(255,%u) x %u interleaved payload (%s kernel)...\n", fec.k, fec.depth, fec_kernel_name());
+
+    size_t group_data = (size_t)fec.k * fec.depth;
+    size_t group_size = (size_t)FEC_BLOCK_SIZE * fec.depth;
+    while (!parser.done && !parser.failed)
+    {
+        // STEP 1 : Read a whole group, symbols past the end of the image are erasures
+        size_t missing = 0;
+        for (size_t i = 0; i < group_size; i++)
+        {
+            if (fread(image_buffer, sizeof(char), 8, decInfo->fptr_stego_image) == 8)
+            {
+                fec.rows[i] = decode_byte_from_lsb(image_buffer);
+                fec.erased[i] = 0;
+            }
+            else
+            {
+                fec.rows[i] = 0;
+                fec.erased[i] = 1;
+                missing++;
+            }
+        }
+        if (missing == group_size)
+        {
+            printf("ERROR! Image ended before the payload was complete\n");
+            ret = e_failure;
+            break;
+        }
+
+        // STEP 2 : Correct the group, then hand its data rows to the payload parser
+        if (fec_decode_group(&fec) == e_failure)
+        {
+            printf("ERROR! Uncorrectable FEC group\n");
+            ret = e_failure;
+            break;
+        }
+        for (size_t i = 0; i < group_data && !parser.done && !parser.failed; i++)
+        {
+            parse_payload_byte(decInfo, &parser, fec.rows[i]);
+        }
+    }
+    if (parser.failed)
+    {
+        ret = e_failure;
+    }
+
+    printf("FEC corrected %lu symbols.\n", fec.corrected);
+    fec_free(&fec);
+    return ret;
+}
+
 /* Do Decoding */
 Status do_decoding(DecodeInfo *decInfo)
 {
@@ -281,21 +787,57 @@ Status do_decoding(DecodeInfo *decInfo)
     }
     printf("Magic string validated successfully.\n");
 
-    // Decode extension
-    printf("Decoding file extension...\n");
-    if (decode_secret_file_extn(decInfo) == e_failure)
+    // Extended header: read the mode word describing how the payload was embedded
+    decInfo->mode_word = 0;
+    if (decInfo->is_extended)
     {
-        printf("ERROR! Failed to decode secret file extension.\n");
+        if (decode_mode_words(decInfo) == e_failure)
+        {
+            printf("ERROR! Cannot read the mode words\n");
+            fclose(decInfo->fptr_stego_image);
+            fclose(decInfo->fptr_output);
+            return e_failure;
+        }
+        if (decInfo->mode_word & MODE_SHARD)
+        {
+            printf("ERROR! %s holds one shard of a split payload, use -j with all its shard images.\n", decInfo->stego_image_fname);
+            fclose(decInfo->fptr_stego_image);
+            fclose(decInfo->fptr_output);
+            return e_failure;
+        }
+        if (decInfo->ckpt.interval != 0 || decInfo->ckpt.progress_ms != 0 || decInfo->has_range)
+        {
+            printf("ERROR! --checkpoint, --resume, --progress and --range only apply to plain payloads.\n");
+            fclose(decInfo->fptr_stego_image);
+            fclose(decInfo->fptr_output);
+            return e_failure;
+        }
+        if ((decInfo->mode_word & ~(MODE_FEC | MODE_ADAPTIVE | MODE_MATRIX | MODE_AUTO)) != 0 ||
+            __builtin_popcount(decInfo->mode_word & (MODE_FEC | MODE_ADAPTIVE | MODE_MATRIX | MODE_AUTO)) > 1)
+        {
+            printf("ERROR! Unsupported embedding mode 0x%08x for a BMP image.\n", decInfo->mode_word);
+            fclose(decInfo->fptr_stego_image);
+            fclose(decInfo->fptr_output);
+            return e_failure;
+        }
+    }
+
+    // Differential check against the original carrier: span, count and kind of changed bytes, which must fit the mode word
+    if (decInfo->original_fname != NULL && diff_validate_embedding(decInfo) == e_failure)
+    {
+        printf("ERROR! Embedding does not validate against %s\n", decInfo->original_fname);
         fclose(decInfo->fptr_stego_image);
         fclose(decInfo->fptr_output);
         return e_failure;
     }
 
-    // Decode and write secret data to output file
-    printf("Decoding secret file data...\n");
-    if (decode_secret_file_data(decInfo) == e_failure)
+    // Decode extension and data (Reed-Solomon coded, cost map driven, syndrome coded or capacity fitted when the mode word says so)
+    Status payload = (decInfo->mode_word & MODE_FEC) ? decode_fec_payload(decInfo) :
+                     (decInfo->mode_word & MODE_ADAPTIVE) ? decode_adaptive_payload(decInfo) :
+                     (decInfo->mode_word & MODE_MATRIX) ? decode_matrix_payload(decInfo) :
+                     (decInfo->mode_word & MODE_AUTO) ? decode_auto_payload(decInfo) : decode_plain_payload(decInfo);
+    if (payload == e_failure)
     {
-        printf("ERROR! Failed to decode secret file data.\n");
         fclose(decInfo->fptr_stego_image);
         fclose(decInfo->fptr_output);
         return e_failure;
@@ -305,6 +847,9 @@ Status do_decoding(DecodeInfo *decInfo)
     fclose(decInfo->fptr_stego_image);
     fclose(decInfo->fptr_output);
 
+    // Bytes moved and time throttled under the I/O policy
+    io_report(&decInfo->io);
+
     // SUCCESS message
     printf("Decoding completed successfully. Data written to: %s\n", decInfo->output_fname);
     return e_success;
@@ -312,4 +857,4 @@ Status do_decoding(DecodeInfo *decInfo)
 
 //////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 /* ============================================================================= END OF CODE ===========================================================================*/
-//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
\ No newline at end of file
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
\ No newline at end of file
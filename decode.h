@@ -21,8 +21,11 @@
 
 #include <stdio.h>
 #include "types.h"
+#include "ioengine.h"
+#include "checkpoint.h"
 
 #define MAX_FILE_SUFFIX 4
+#define RANGE_CHUNK (1 << 20)   // Carrier bytes read per pread by decode_range() and --range
 
 /* ======================================================================= STRUCTURE ================================================================================== */
 
@@ -34,29 +37,72 @@ typedef struct _DecodeInfo
     FILE *fptr_stego_image;
     long size_stego_image;
 
+    /* Original Carrier Info */
+    char *original_fname; // Carrier the stego image was made from (optional 4th argument), compared before extraction
+
     /* Output File Info */
     char *output_fname;
     FILE *fptr_output;
     char extn_secret_file[MAX_FILE_SUFFIX];
 
+    /* Embedding Info */
+    int is_y4m;     // Stego carrier is a YUV4MPEG2 frame stream
+    int is_extended; // Magic string was MAGIC_STRING_EXT, a mode word follows it
+    uint mode_word; // MODE_* flags decoded after an extended magic string
+    uint fec_param; // Parity bytes << 16 | interleave depth when MODE_FEC is set
+    uint adaptive_threshold; // Lowest cost of a sample carrying payload when MODE_ADAPTIVE is set
+    uint matrix_p; // Payload bits per group of 2^p - 1 carrier bytes when MODE_MATRIX is set
+    uint auto_param; // LSBs per sample << 8 | channel mask when MODE_AUTO is set
+
+    /* I/O Info */
+    IoConfig io;    // Block I/O engine used for the secret data region
+    Checkpoint ckpt; // Checkpoint journal, --resume and progress lines of the secret data region
+
+    /* Range Info */
+    int has_range;  // Only payload bytes [range_offset, range_offset + range_length) are decoded (--range=OFF:LEN)
+    unsigned long long range_offset;
+    unsigned long long range_length;
+
 } DecodeInfo;
 
+/* Progress through a payload byte stream of (extension size, extension, file size, data) */
+typedef struct _PayloadParser
+{
+    uint index;     // Bytes consumed so far
+    uint extn_size;
+    uint file_size;
+    uint written;   // Data bytes written to the output file
+    int done;       // Whole secret file written
+    int failed;     // Invalid header field seen
+} PayloadParser;
+
 /* ================================================================= FUNCTION DEFINITIONS ============================================================================= */
 
 /* Function Prototypes */
 Status read_and_validate_decode_args(int argc, char *argv[], DecodeInfo *decInfo);
+Status read_decode_options(int count, char *opts[], DecodeInfo *decInfo);
 Status open_decode_files(DecodeInfo *decInfo);
 Status decode_magic_string(DecodeInfo *decInfo);
+Status decode_mode_words(DecodeInfo *decInfo);
 Status decode_secret_file_extn(DecodeInfo *decInfo);
 Status decode_secret_file_data(DecodeInfo *decInfo);
 Status do_decoding(DecodeInfo *decInfo);
+Status decode_plain_payload(DecodeInfo *decInfo);
+Status decode_fec_payload(DecodeInfo *decInfo);
+
+/* Decode payload bytes [offset, offset + length) of the plain payload in a stego BMP into buf, reading only their carrier bytes;
+ * *decoded is the number of bytes stored (fewer when the range runs past the end of the hidden file). Only header errors are printed; a stego
+ * image with another embedding mode fails. The CLI --range path shares the header parse and the carrier reads with it
+ */
+Status decode_range(const char *stego_fname, unsigned long long offset, size_t length, unsigned char *buf, size_t *decoded);
 
 /* Helper functions */
 char decode_byte_from_lsb(char *image_buffer);
 int decode_size_from_lsb(FILE *fptr_stego_image);
+void parse_payload_byte(DecodeInfo *decInfo, PayloadParser *parser, unsigned char byte);
 
 #endif
 
 //////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 /* ==================================================================== END OF CODE ====================================================================================*/
-//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
\ No newline at end of file
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
\ No newline at end of file
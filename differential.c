@@ -0,0 +1,376 @@
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// ========================================================== * * * * * differential.c * * * * * ====================================================================== //
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/*
+
+### USAGE OF differential.c FILE IN STEGANOGRAPHY PROJECT ?
+--> THIS FILE IMPLEMENTS THE DIFFERENTIAL CHECK. BOTH IMAGES ARE MAPPED READ ONLY AND COMPARED 128 BYTES AT A TIME: THE XORS OF FOUR VECTORS ARE ORED AND TESTED ONCE,
+    SO UNCHANGED STRETCHES (ALL OF THE IMAGE FOR SPARSE MODES) COST ONE LOAD PAIR AND ONE TEST PER VECTOR. ONLY A VECTOR WITH A DIFFERENCE IS TAKEN APART WITH
+    COMPARE MASKS: ITS CHANGED BYTES, LSB FLIPS (XOR = 1) AND UNIT STEPS (|A - B| = 1) ARE COUNTED WITH POPCOUNT AND THE SPAN IS MOVED WITH CTZ / CLZ OF THE MASK.
+    SCALAR, SSE2 AND AVX2 KERNELS EXIST; THE WIDEST ONE THE CPU SUPPORTS IS PICKED ONCE.
+
+*/
+
+/* ====================================================================== INCLUDES ==================================================================================== */
+
+#include <stdio.h>          // printf
+#include <string.h>         // memcpy
+#include <stdint.h>         // uint64_t words
+#include <time.h>           // clock_gettime
+#include <sys/mman.h>       // madvise, munmap
+#include <pthread.h>        // pthread_once
+#include "types.h"          // Status
+#include "common.h"         // MODE_* flags
+#include "encode.h"         // MAX_FILE_SUFFIX
+#include "decode.h"         // DecodeInfo
+#include "fastcopy.h"       // map_image_file
+#include "differential.h"   // Prototypes
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>      // SSE2 / AVX2 kernels
+#define DIFF_HAVE_X86 1
+#endif
+
+/* ======================================================================= MACROS ===================================================================================== */
+
+#define BMP_HEADER 54       // Pixel data offset the rest of the project assumes
+
+/* ======================================================================= STRUCTURE ================================================================================== */
+
+/* Kernel over len bytes, offsets reported from base */
+typedef void (*DiffFn)(const unsigned char *a, const unsigned char *b, size_t len, size_t base, DiffSpan *span);
+
+static DiffFn diff_kernel;
+static const char *diff_kernel_name = "scalar";
+
+/* ================================================================= FUNCTION DEFINITIONS ============================================================================= */
+
+/* Count one differing byte at offset off */
+static inline void note_byte(DiffSpan *span, size_t off, unsigned char a, unsigned char b)
+{
+    unsigned char x = a ^ b;
+
+    if (span->changed++ == 0)
+    {
+        span->first = off;
+    }
+    span->last = off;
+    span->lsb_flips += x == 1;
+    span->unit_steps += a - b == 1 || b - a == 1;
+    span->planes |= x;
+}
+
+static void diff_scalar(const unsigned char *a, const unsigned char *b, size_t len, size_t base, DiffSpan *span)
+{
+    size_t i = 0;
+
+    // Whole words that match are skipped with one compare
+    for (; i + 8 <= len; i += 8)
+    {
+        uint64_t x, y;
+        memcpy(&x, a + i, 8);
+        memcpy(&y, b + i, 8);
+        if (x == y)
+        {
+            continue;
+        }
+        for (size_t k = i; k < i + 8; k++)
+        {
+            if (a[k] != b[k])
+            {
+                note_byte(span, base + k, a[k], b[k]);
+            }
+        }
+    }
+    for (; i < len; i++)
+    {
+        if (a[i] != b[i])
+        {
+            note_byte(span, base + i, a[i], b[i]);
+        }
+    }
+}
+
+#ifdef DIFF_HAVE_X86
+/* Masks of one 16 byte vector with a difference */
+__attribute__((target("sse2")))
+static inline void note_sse2(__m128i va, __m128i vb, size_t off, DiffSpan *span, __m128i *planes)
+{
+    const __m128i one = _mm_set1_epi8(1);
+    __m128i x = _mm_xor_si128(va, vb);
+    __m128i d = _mm_or_si128(_mm_subs_epu8(va, vb), _mm_subs_epu8(vb, va));
+    uint32_t ne = ~_mm_movemask_epi8(_mm_cmpeq_epi8(va, vb)) & 0xFFFF;
+
+    if (ne == 0)
+    {
+        return;
+    }
+    if (span->changed == 0)
+    {
+        span->first = off + __builtin_ctz(ne);
+    }
+    span->last = off + 31 - __builtin_clz(ne);
+    span->changed += __builtin_popcount(ne);
+    span->lsb_flips += __builtin_popcount(_mm_movemask_epi8(_mm_cmpeq_epi8(x, one)));
+    span->unit_steps += __builtin_popcount(_mm_movemask_epi8(_mm_cmpeq_epi8(d, one)));
+    *planes = _mm_or_si128(*planes, x);
+}
+
+__attribute__((target("sse2")))
+static void diff_sse2(const unsigned char *a, const unsigned char *b, size_t len, size_t base, DiffSpan *span)
+{
+    __m128i planes = _mm_setzero_si128();
+    size_t i = 0;
+
+    for (; i + 64 <= len; i += 64)
+    {
+        __m128i va[4], vb[4];
+        for (int q = 0; q < 4; q++)
+        {
+            va[q] = _mm_loadu_si128((const __m128i *)(a + i + 16 * q));
+            vb[q] = _mm_loadu_si128((const __m128i *)(b + i + 16 * q));
+        }
+        __m128i any = _mm_or_si128(_mm_or_si128(_mm_xor_si128(va[0], vb[0]), _mm_xor_si128(va[1], vb[1])),
+                                   _mm_or_si128(_mm_xor_si128(va[2], vb[2]), _mm_xor_si128(va[3], vb[3])));
+        if (_mm_movemask_epi8(_mm_cmpeq_epi8(any, _mm_setzero_si128())) == 0xFFFF)
+        {
+            continue;
+        }
+        for (int q = 0; q < 4; q++)
+        {
+            note_sse2(va[q], vb[q], base + i + 16 * q, span, &planes);
+        }
+    }
+
+    unsigned char p[16];
+    _mm_storeu_si128((__m128i *)p, planes);
+    for (int k = 0; k < 16; k++)
+    {
+        span->planes |= p[k];
+    }
+    diff_scalar(a + i, b + i, len - i, base + i, span);
+}
+
+/* Masks of one 32 byte vector with a difference */
+__attribute__((target("avx2")))
+static inline void note_avx2(__m256i va, __m256i vb, size_t off, DiffSpan *span, __m256i *planes)
+{
+    const __m256i one = _mm256_set1_epi8(1);
+    __m256i x = _mm256_xor_si256(va, vb);
+    __m256i d = _mm256_or_si256(_mm256_subs_epu8(va, vb), _mm256_subs_epu8(vb, va));
+    uint32_t ne = ~(uint32_t)_mm256_movemask_epi8(_mm256_cmpeq_epi8(va, vb));
+
+    if (ne == 0)
+    {
+        return;
+    }
+    if (span->changed == 0)
+    {
+        span->first = off + __builtin_ctz(ne);
+    }
+    span->last = off + 31 - __builtin_clz(ne);
+    span->changed += __builtin_popcount(ne);
+    span->lsb_flips += __builtin_popcount(_mm256_movemask_epi8(_mm256_cmpeq_epi8(x, one)));
+    span->unit_steps += __builtin_popcount(_mm256_movemask_epi8(_mm256_cmpeq_epi8(d, one)));
+    *planes = _mm256_or_si256(*planes, x);
+}
+
+__attribute__((target("avx2")))
+static void diff_avx2(const unsigned char *a, const unsigned char *b, size_t len, size_t base, DiffSpan *span)
+{
+    __m256i planes = _mm256_setzero_si256();
+    size_t i = 0;
+
+    for (; i + 128 <= len; i += 128)
+    {
+        __m256i va[4], vb[4];
+        for (int q = 0; q < 4; q++)
+        {
+            va[q] = _mm256_loadu_si256((const __m256i *)(a + i + 32 * q));
+            vb[q] = _mm256_loadu_si256((const __m256i *)(b + i + 32 * q));
+        }
+        __m256i any = _mm256_or_si256(_mm256_or_si256(_mm256_xor_si256(va[0], vb[0]), _mm256_xor_si256(va[1], vb[1])),
+                                      _mm256_or_si256(_mm256_xor_si256(va[2], vb[2]), _mm256_xor_si256(va[3], vb[3])));
+        if (_mm256_testz_si256(any, any))
+        {
+            continue;
+        }
+        for (int q = 0; q < 4; q++)
+        {
+            note_avx2(va[q], vb[q], base + i + 32 * q, span, &planes);
+        }
+    }
+
+    unsigned char p[32];
+    _mm256_storeu_si256((__m256i *)p, planes);
+    for (int k = 0; k < 32; k++)
+    {
+        span->planes |= p[k];
+    }
+    diff_scalar(a + i, b + i, len - i, base + i, span);
+}
+#endif
+
+static void diff_init(void)
+{
+    diff_kernel = diff_scalar;
+#ifdef DIFF_HAVE_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2"))
+    {
+        diff_kernel = diff_avx2;
+        diff_kernel_name = "avx2";
+    }
+    else if (__builtin_cpu_supports("sse2"))
+    {
+        diff_kernel = diff_sse2;
+        diff_kernel_name = "sse2";
+    }
+#endif
+}
+
+/* Kernel chosen once, daemon decode jobs may get here together */
+static void diff_setup(void)
+{
+    static pthread_once_t once = PTHREAD_ONCE_INIT;
+    pthread_once(&once, diff_init);
+}
+
+void diff_scan(const unsigned char *a, const unsigned char *b, size_t len, DiffSpan *span)
+{
+    memset(span, 0, sizeof(*span));
+    diff_setup();
+    diff_kernel(a, b, len, 0, span);
+}
+
+/* nbits LSBs from consecutive image bytes, MSB first */
+static unsigned long long lsb_word(const unsigned char *p, uint nbits)
+{
+    unsigned long long value = 0;
+    for (uint i = 0; i < nbits; i++)
+    {
+        value = value << 1 | (p[i] & 1);
+    }
+    return value;
+}
+
+Status diff_validate_embedding(DecodeInfo *decInfo)
+{
+    size_t stego_size = 0, orig_size = 0;
+    struct timespec t0, t1;
+    DiffSpan span;
+    Status ret = e_success;
+
+    // STEP 1 : Both images mapped read only (the stego stream keeps its position)
+    FILE *fptr_orig = fopen(decInfo->original_fname, "rb");
+    unsigned char *stego = map_image_file(decInfo->fptr_stego_image, NULL, 0, &stego_size);
+    unsigned char *orig = fptr_orig != NULL ? map_image_file(fptr_orig, NULL, 0, &orig_size) : NULL;
+    if (stego == NULL || orig == NULL)
+    {
+        printf("ERROR! Cannot map %s\n", stego == NULL ? decInfo->stego_image_fname : decInfo->original_fname);
+        ret = e_failure;
+    }
+    else if (stego_size != orig_size)
+    {
+        printf("ERROR! %s (%zu bytes) cannot be the carrier of %s (%zu bytes)\n", decInfo->original_fname, orig_size, decInfo->stego_image_fname,
+               stego_size);
+        ret = e_failure;
+    }
+
+    // STEP 2 : Every differing byte, its kind and the span they cover
+    if (ret == e_success)
+    {
+        madvise(stego, stego_size, MADV_SEQUENTIAL);
+        madvise(orig, orig_size, MADV_SEQUENTIAL);
+        clock_gettime(CLOCK_MONOTONIC, &t0);
+        diff_scan(stego, orig, stego_size, &span);
+        clock_gettime(CLOCK_MONOTONIC, &t1);
+        double secs = (t1.tv_sec - t0.tv_sec) + (t1.tv_nsec - t0.tv_nsec) / 1e9;
+        secs = secs > 0 ? secs : 1e-9;
+
+        printf("Differential check (%s kernel, %.1f ms, %.1f GB/s): %llu of %zu bytes changed", diff_kernel_name, secs * 1e3, stego_size / 1e9 / secs,
+               span.changed, stego_size);
+        if (span.changed != 0)
+        {
+            printf(" in span [%zu, %zu] (%zu bytes): %llu LSB flips, %llu other +-1 steps, %llu larger changes, bit planes 0x%02x",
+                   span.first, span.last, span.last - span.first + 1, span.lsb_flips, span.unit_steps - span.lsb_flips,
+                   span.changed - span.unit_steps, span.planes);
+        }
+        printf("\n");
+
+        // STEP 3 : Changes must fit the mode the header declares
+        uint mode = decInfo->is_extended ? decInfo->mode_word : 0;
+        if (span.changed == 0)
+        {
+            printf("ERROR! %s is identical to the original carrier, nothing was embedded\n", decInfo->stego_image_fname);
+            ret = e_failure;
+        }
+        else if (span.first < BMP_HEADER)
+        {
+            printf("ERROR! The BMP header differs from the original carrier at byte %zu\n", span.first);
+            ret = e_failure;
+        }
+        else if (mode & MODE_AUTO)
+        {
+            uint low = (1u << (decInfo->auto_param >> 8)) - 1;
+            if (span.planes & ~low)
+            {
+                printf("ERROR! Bit planes 0x%02x changed, the declared format only writes 0x%02x\n", span.planes, low);
+                ret = e_failure;
+            }
+        }
+        else if (mode != 0 && span.lsb_flips != span.changed)
+        {
+            printf("ERROR! %llu bytes changed beyond their LSB, mode 0x%08x only flips LSBs\n", span.changed - span.lsb_flips, mode);
+            ret = e_failure;
+        }
+        else if (mode == 0 && span.unit_steps != span.changed)
+        {
+            printf("ERROR! %llu bytes changed by more than 1, a plain payload is LSB replaced or +-1 matched\n", span.changed - span.unit_steps);
+            ret = e_failure;
+        }
+
+        // STEP 4 : A plain payload also bounds the span: its fields say where its carrier bytes end
+        if (ret == e_success && mode == 0 && stego_size >= BMP_HEADER + 16 + 32)
+        {
+            unsigned long long extn_size = lsb_word(stego + BMP_HEADER + 16, 32);
+            unsigned long long field = BMP_HEADER + 16 + 32 + extn_size * 8;
+            if (extn_size < MAX_FILE_SUFFIX && field + 32 <= stego_size)
+            {
+                unsigned long long end = field + 32 + lsb_word(stego + field, 32) * 8;
+                if (span.last >= end)
+                {
+                    printf("ERROR! Byte %zu changed past the payload carrier bytes [%d, %llu)\n", span.last, BMP_HEADER, end);
+                    ret = e_failure;
+                }
+                else
+                {
+                    printf("Payload carrier bytes [%d, %llu): %.1f %% of them changed\n", BMP_HEADER, end, 100.0 * span.changed / (end - BMP_HEADER));
+                }
+            }
+        }
+        if (ret == e_success)
+        {
+            printf("Embedding validated against %s.\n", decInfo->original_fname);
+        }
+    }
+
+    if (stego != NULL)
+    {
+        munmap(stego, stego_size);
+    }
+    if (orig != NULL)
+    {
+        munmap(orig, orig_size);
+    }
+    if (fptr_orig != NULL)
+    {
+        fclose(fptr_orig);
+    }
+    return ret;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/* ============================================================================= END OF CODE ===========================================================================*/
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -0,0 +1,51 @@
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// ========================================================== * * * * * differential.h * * * * * ====================================================================== //
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/*
+
+### USAGE OF differential.h FILE IN STEGANOGRAPHY PROJECT ?
+--> THIS HEADER FILE DECLARES THE DIFFERENTIAL CHECK OF A DECODE. WHEN THE ORIGINAL CARRIER IS GIVEN AFTER THE OUTPUT FILE (-d stego.bmp out.txt original.bmp), BOTH
+    IMAGES ARE COMPARED BYTE BY BYTE WITH SIMD KERNELS BEFORE THE PAYLOAD IS EXTRACTED. THE REPORT GIVES THE EXACT SPAN AND COUNT OF CHANGED BYTES AND HOW THEY CHANGED
+    (LSB FLIPS, +-1 STEPS, HIGHEST BIT PLANE TOUCHED), AND THE EMBEDDING IS VALIDATED AGAINST THE MODE THE STEGO HEADER DECLARES: HEADER UNTOUCHED, ONLY THE BIT PLANES
+    THAT MODE WRITES CHANGED AND, FOR A PLAIN PAYLOAD, NO CHANGE OUTSIDE ITS CARRIER BYTES. A FAILED CHECK STOPS THE DECODE.
+
+*/
+
+// ==================================================================================================================================================================== //
+
+#ifndef DIFFERENTIAL_H
+#define DIFFERENTIAL_H
+
+/* ====================================================================== INCLUDES ==================================================================================== */
+
+#include <stddef.h>
+#include "types.h"
+#include "decode.h"
+
+/* ======================================================================= STRUCTURE ================================================================================== */
+
+/* Differences between two equally long byte arrays */
+typedef struct
+{
+    size_t first;                   // Offset of the first differing byte (valid when changed != 0)
+    size_t last;                    // Offset of the last differing byte
+    unsigned long long changed;     // Differing bytes
+    unsigned long long lsb_flips;   // Differing in bit 0 only
+    unsigned long long unit_steps;  // Differing in value by exactly 1 (every LSB flip, and +-1 steps that carry into higher bits)
+    uint planes;                    // OR of every XOR: bit k set when bit plane k changed somewhere
+} DiffSpan;
+
+/* ================================================================= FUNCTION PROTOTYPES ============================================================================= */
+
+/* Compare a and b over len bytes with the widest kernel the CPU supports */
+void diff_scan(const unsigned char *a, const unsigned char *b, size_t len, DiffSpan *span);
+
+/* Compare the stego image with decInfo->original_fname, print the report and check the changes fit the decoded mode word */
+Status diff_validate_embedding(DecodeInfo *decInfo);
+
+#endif
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/* ============================================================================= END OF CODE ===========================================================================*/
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
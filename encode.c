@@ -13,9 +13,22 @@
 /* ======================================================================= INCLUDES =================================================================================== */
 
 #include <stdio.h>   //Std inbuilt functions
+#include <stdlib.h>  //atoi
+#include <sys/random.h> //getrandom
+#include <time.h>    //Fallback LSB matching key
+#include <unistd.h>  //getpid, pread
+#include <fcntl.h>   //open
+#include <sys/stat.h> //fstat of a resumed stego image
 #include "encode.h"  //Encoding function declarations and struct
 #include "types.h"   //Custom types like Status and Operation Type
 #include "common.h"  //Magic string macro used for encoding check
+#include "fec.h"     //Reed-Solomon forward error correction
+#include "fastcopy.h" //Reflink / copy_file_range carrier clone
+#include "pipeline.h" //Staged read / embed / write pipeline
+#include "adaptive.h" //Content-adaptive embedding
+#include "matrix.h" //Matrix embedding
+#include "lsbkernel.h" //Specialised LSB replacement kernels
+#include "autofit.h" //Capacity fitted carrier format
 
 /* ================================================================= FUNCTION DEFINITIONS ============================================================================= */
 
@@ -28,22 +41,34 @@
 
 uint get_image_size_for_bmp(FILE *fptr_image)
 {
-    uint width, height;
-    // Seek to 18th byte
-    fseek(fptr_image, 18, SEEK_SET);
+    uint width = 0, height = 0;
 
-    // Read the width (an int) from BMP Header
-    fread(&width, sizeof(int), 1, fptr_image);
+    // Read width and height from the BMP Header
+    read_bmp_geometry(fptr_image, &width, &height);
     printf("width = %u\n", width);
-
-    // Read the height (an int) from BMP Header
-    fread(&height, sizeof(int), 1, fptr_image);
     printf("height = %u\n", height);
 
     // Each pixel = 3 bytes (RGB), return total image capacity in bytes
     return width * height * 3;
 }
 
+/* Read width and height (4 bytes each from offset 18) from the BMP header, without printing */
+Status read_bmp_geometry(FILE *fptr_image, uint *width, uint *height)
+{
+    // Seek to 18th byte
+    if (fseek(fptr_image, 18, SEEK_SET) != 0)
+    {
+        return e_failure;
+    }
+
+    // Read the width, then the height (an int each)
+    if (fread(width, sizeof(int), 1, fptr_image) != 1 || fread(height, sizeof(int), 1, fptr_image) != 1)
+    {
+        return e_failure;
+    }
+    return e_success;
+}
+
 /* 
  * Get File pointers for i/p and o/p files
  * Inputs: Src Image file, Secret file and
@@ -54,6 +79,13 @@ uint get_image_size_for_bmp(FILE *fptr_image)
 
 Status open_files(EncodeInfo *encInfo)
 {
+    // Bandwidth caps, I/O class and niceness of this job (--io-limit, --io-prio, --io-nice) cover all the I/O below
+    if (io_apply_policy(&encInfo->io) == e_failure)
+    {
+        fprintf(stderr, "ERROR: Unable to apply the I/O policy\n");
+        return e_failure;
+    }
+
     // Open Src Image file for reading
     encInfo->fptr_src_image = fopen(encInfo->src_image_fname, "r");
     // Do Error handling
@@ -76,8 +108,14 @@ Status open_files(EncodeInfo *encInfo)
         return e_failure;
     }
 
-    // Open Stego Image file for writing
-    encInfo->fptr_stego_image = fopen(encInfo->stego_image_fname, "w");
+    // Open Stego Image file for writing (--resume continues the partly written one)
+    // With --cache, an output hard linked with a cache entry is unlinked (or copied when resumed) first, so the entry is never written through it
+    if (unshare_file(encInfo->stego_image_fname, encInfo->cache.dir, encInfo->ckpt.resume) == e_failure)
+    {
+        fprintf(stderr, "ERROR: Unable to unshare file %s\n", encInfo->stego_image_fname);
+        return e_failure;
+    }
+    encInfo->fptr_stego_image = fopen(encInfo->stego_image_fname, encInfo->ckpt.resume ? "r+" : "w");
     // Do Error handling
     if (encInfo->fptr_stego_image == NULL)
     {
@@ -102,10 +140,16 @@ Status read_and_validate_encode_args(char *argv[], EncodeInfo *encInfo)
         //STEP 2 : Store the src_image name in encInfo->src_image_fname (storing src image filename address here[i.e. a char pointer])
         encInfo->src_image_fname = argv[2];
     }
+    else if (strstr(argv[2], ".y4m") != NULL || strcmp(argv[2], "-") == 0)
+    {
+        //STEP 2a : Raw video carrier, frames are streamed from the file or from stdin ("-")
+        encInfo->src_image_fname = argv[2];
+        encInfo->is_y4m = 1;
+    }
     else
     {
         //STEP 3 : Print error msg like (please pass .bmp file) and return e_failure
-        printf("Error: Source image must be a .bmp file.\n");
+        printf("Error: Source image must be a .bmp or .y4m file.\n");
         return e_failure;
     }
 
@@ -139,8 +183,8 @@ Status read_and_validate_encode_args(char *argv[], EncodeInfo *encInfo)
     //STEP 7 : Check if argv[4] is passed or NOT, if YES GOTO STEP 8, if NO, GOTO STEP 11
     if (argv[4] != NULL)
     {
-        //STEP 8 : Check the file is .bmp or NOT, if YES GOTO STEP 9, if NOT GOTO STEP 10
-        if (strstr(argv[4], ".bmp") != NULL)
+        //STEP 8 : Check the file is .bmp (.y4m for video carriers) or NOT, if YES GOTO STEP 9, if NOT GOTO STEP 10
+        if (strstr(argv[4], encInfo->is_y4m ? ".y4m" : ".bmp") != NULL)
         {
             //STEP 9 :  Store the file name in stego_image_fname
             encInfo->stego_image_fname = argv[4];
@@ -148,20 +192,230 @@ Status read_and_validate_encode_args(char *argv[], EncodeInfo *encInfo)
         else
         {
             //STEP 10 : Print error msg and return e_failure
-            printf("Error: Stego image file must be a .bmp file.\n");
+            printf("Error: Stego image file must be a %s file.\n", encInfo->is_y4m ? ".y4m" : ".bmp");
             return e_failure;
         }
     }
     else
     {
-        //STEP 11 : Print the msg and store the default filename[stego.bmp] in a stego_image_fname
-        printf("Info: Output stego image not specified. Defaulting to stego.bmp\n");
-        encInfo->stego_image_fname = "stego.bmp";
+        //STEP 11 : Print the msg and store the default filename[stego.bmp / stego.y4m] in a stego_image_fname
+        encInfo->stego_image_fname = encInfo->is_y4m ? "stego.y4m" : "stego.bmp";
+        printf("Info: Output stego image not specified. Defaulting to %s\n", encInfo->stego_image_fname);
     }
     //STEP 12 : Return e_success
     return e_success;
 }
 
+//Reads the optional --name=value options collected from the command line
+Status read_encode_options(int count, char *opts[], EncodeInfo *encInfo)
+{
+    for (int i = 0; i < count; i++)
+    {
+        const char *value;
+
+        if ((value = OPTION_VALUE(opts[i], "--planes=")) != NULL)
+        {
+            // Which planes of a Y4M frame carry the payload
+            if (strcmp(value, "luma") == 0)
+            {
+                encInfo->y4m_planes = e_planes_luma;
+            }
+            else if (strcmp(value, "all") == 0)
+            {
+                encInfo->y4m_planes = e_planes_all;
+            }
+            else
+            {
+                printf("Error: --planes must be 'luma' or 'all'.\n");
+                return e_failure;
+            }
+        }
+        else if ((value = OPTION_VALUE(opts[i], "--threads=")) != NULL)
+        {
+            // Number of embedding worker threads
+            int threads = atoi(value);
+            if (threads <= 0)
+            {
+                printf("Error: --threads must be a positive number.\n");
+                return e_failure;
+            }
+            encInfo->threads = threads;
+        }
+        else if ((value = OPTION_VALUE(opts[i], "--fec=")) != NULL)
+        {
+            // Reed-Solomon parity symbols per 255 byte codeword
+            int nsym = atoi(value);
+            if (nsym <= 0 || nsym >= FEC_BLOCK_SIZE)
+            {
+                printf("Error: --fec must be between 1 and %d parity bytes.\n", FEC_BLOCK_SIZE - 1);
+                return e_failure;
+            }
+            encInfo->fec_nsym = nsym;
+        }
+        else if ((value = OPTION_VALUE(opts[i], "--fec-depth=")) != NULL)
+        {
+            // Codewords interleaved per group
+            int depth = atoi(value);
+            if (depth <= 0 || depth > FEC_MAX_DEPTH)
+            {
+                printf("Error: --fec-depth must be between 1 and %d.\n", FEC_MAX_DEPTH);
+                return e_failure;
+            }
+            encInfo->fec_depth = depth;
+        }
+        else if (strcmp(opts[i], "--adaptive") == 0)
+        {
+            // Content-adaptive embedding into the most textured samples
+            encInfo->adaptive = 1;
+        }
+        else if (strcmp(opts[i], "--matrix") == 0)
+        {
+            // Hamming matrix embedding, fewest changed carrier bytes
+            encInfo->matrix = 1;
+        }
+        else if (strcmp(opts[i], "--auto") == 0)
+        {
+            // Carrier format fitted to the payload size instead of one bit per byte
+            encInfo->auto_fit = 1;
+        }
+        else if (strcmp(opts[i], "--metrics") == 0)
+        {
+            // Quality metrics of the stego image, gathered while embedding
+            encInfo->metrics = 1;
+        }
+        else if (strcmp(opts[i], "--lsb-match") == 0)
+        {
+            // +-1 LSB matching with a fresh random key
+            uint64_t key;
+            if (getrandom(&key, sizeof(key), 0) != sizeof(key))
+            {
+                key = (uint64_t)time(NULL) << 20 ^ (uint64_t)getpid();
+            }
+            lsb_match_seed(&encInfo->match, key);
+            encInfo->lsb_match = 1;
+        }
+        else if ((value = OPTION_VALUE(opts[i], "--lsb-match=")) != NULL)
+        {
+            // +-1 LSB matching with a fixed key (repeatable output)
+            char *end;
+            uint64_t key = strtoull(value, &end, 0);
+            if (*value == '\0' || *end != '\0')
+            {
+                printf("Error: --lsb-match key must be a number.\n");
+                return e_failure;
+            }
+            lsb_match_seed(&encInfo->match, key);
+            encInfo->lsb_match = 1;
+        }
+        else if (strcmp(opts[i], "--pipeline") == 0)
+        {
+            // Staged read / embed / write pipeline with the default buffer pool
+            encInfo->pipeline_buffers = PIPE_DEFAULT_BUFFERS;
+        }
+        else if ((value = OPTION_VALUE(opts[i], "--pipeline=")) != NULL)
+        {
+            // Staged pipeline with N pooled buffers in flight
+            int buffers = atoi(value);
+            if (buffers <= 0 || buffers > PIPE_MAX_BUFFERS)
+            {
+                printf("Error: --pipeline must be between 1 and %d buffers.\n", PIPE_MAX_BUFFERS);
+                return e_failure;
+            }
+            encInfo->pipeline_buffers = buffers;
+        }
+        else if (strncmp(opts[i], "--io", 4) == 0)
+        {
+            // Block I/O engine settings
+            if (read_io_option(opts[i], &encInfo->io) == e_failure)
+            {
+                return e_failure;
+            }
+        }
+        else if (strncmp(opts[i], "--checkpoint", 12) == 0 || strcmp(opts[i], "--resume") == 0 || strncmp(opts[i], "--progress", 10) == 0)
+        {
+            // Checkpoint journal, resuming and progress lines
+            if (read_checkpoint_option(opts[i], &encInfo->ckpt) == e_failure)
+            {
+                return e_failure;
+            }
+        }
+        else if (strncmp(opts[i], "--cache", 7) == 0)
+        {
+            // Result cache keyed by carrier, secret and parameters
+            if (read_cache_option(opts[i], &encInfo->cache) == e_failure)
+            {
+                return e_failure;
+            }
+        }
+        else
+        {
+            printf("Error: Unknown encode option %s\n", opts[i]);
+            return e_failure;
+        }
+    }
+    if (encInfo->fec_nsym != 0 && encInfo->fec_depth == 0)
+    {
+        encInfo->fec_depth = FEC_DEFAULT_DEPTH;
+    }
+    if (encInfo->fec_nsym != 0 && encInfo->is_y4m)
+    {
+        printf("Error: --fec is only supported for BMP carriers.\n");
+        return e_failure;
+    }
+    if (encInfo->adaptive && (encInfo->is_y4m || encInfo->fec_nsym != 0 || encInfo->pipeline_buffers != 0))
+    {
+        printf("Error: --adaptive cannot be combined with Y4M carriers, --fec or --pipeline.\n");
+        return e_failure;
+    }
+    if (encInfo->matrix && (encInfo->is_y4m || encInfo->fec_nsym != 0 || encInfo->adaptive || encInfo->pipeline_buffers != 0))
+    {
+        printf("Error: --matrix cannot be combined with Y4M carriers, --fec, --adaptive or --pipeline.\n");
+        return e_failure;
+    }
+    if (encInfo->auto_fit && (encInfo->is_y4m || encInfo->fec_nsym != 0 || encInfo->adaptive || encInfo->matrix || encInfo->pipeline_buffers != 0))
+    {
+        printf("Error: --auto cannot be combined with Y4M carriers, --fec, --adaptive, --matrix or --pipeline.\n");
+        return e_failure;
+    }
+    if (encInfo->lsb_match && (encInfo->is_y4m || encInfo->fec_nsym != 0 || encInfo->adaptive || encInfo->matrix || encInfo->auto_fit))
+    {
+        printf("Error: --lsb-match cannot be combined with Y4M carriers, --fec, --adaptive, --matrix or --auto.\n");
+        return e_failure;
+    }
+    if (encInfo->metrics && (encInfo->is_y4m || encInfo->fec_nsym != 0 || encInfo->adaptive || encInfo->matrix || encInfo->auto_fit))
+    {
+        printf("Error: --metrics only applies to plain and --lsb-match BMP payloads.\n");
+        return e_failure;
+    }
+    if (encInfo->pipeline_buffers != 0 && (encInfo->is_y4m || encInfo->fec_nsym != 0))
+    {
+        printf("Error: --pipeline only applies to plain BMP payloads.\n");
+        return e_failure;
+    }
+    if ((encInfo->ckpt.interval != 0 || encInfo->ckpt.progress_ms != 0) &&
+        (encInfo->is_y4m || encInfo->fec_nsym != 0 || encInfo->adaptive || encInfo->matrix || encInfo->auto_fit || encInfo->pipeline_buffers != 0))
+    {
+        printf("Error: --checkpoint, --resume and --progress only apply to plain and --lsb-match BMP payloads without --pipeline.\n");
+        return e_failure;
+    }
+    if (encInfo->ckpt.resume && encInfo->metrics)
+    {
+        printf("Error: --metrics cannot be gathered by a resumed encode.\n");
+        return e_failure;
+    }
+    if (encInfo->cache.max_bytes != 0 && encInfo->cache.dir == NULL)
+    {
+        printf("Error: --cache-size needs --cache=DIR.\n");
+        return e_failure;
+    }
+    if (encInfo->cache.dir != NULL && (encInfo->is_y4m || encInfo->metrics || encInfo->ckpt.resume))
+    {
+        printf("Error: --cache cannot be combined with Y4M carriers, --metrics or --resume.\n");
+        return e_failure;
+    }
+    return e_success;
+}
+
 //Get size of file in bytes
 uint get_file_size(FILE *fptr)
 {
@@ -180,7 +434,7 @@ uint get_file_size(FILE *fptr)
     return size;
 }
 
-//Check if the image has enough capacity to store secret data
+//Check if the image has enough capacity to store secret data (with --auto, pick the carrier format that holds it)
 Status check_capacity(EncodeInfo *encInfo)
 {
     // Get the total number of bytes available in the image for encoding
@@ -188,8 +442,16 @@ Status check_capacity(EncodeInfo *encInfo)
 
     // Get the size of the secret file (in bytes) and store it in the struct
     encInfo -> size_secret_file = get_file_size(encInfo->fptr_secret);
+    encInfo->quality.pixel_bytes = image_capacity;
 
-    // Check if the image has enough capacity to store:
+    // With --auto the LSBs per sample and the channels are picked first, as the least distorting format the payload fits;
+    // that choice is the capacity check, the fixed one bit per byte layout below does not apply
+    if (encInfo->auto_fit)
+    {
+        return autofit_choose(encInfo, image_capacity);
+    }
+
+    // Otherwise check if the image has enough capacity to store, one bit per byte:
     // - MAGIC STRING length in bits
     // - Extension size (32 bits)
     // - Extension characters in bits
@@ -197,7 +459,16 @@ Status check_capacity(EncodeInfo *encInfo)
     // - Actual secret data in bits
 
     //Required space = header + magic string + extn size + extn data + file size + secret
-    if(image_capacity > 54 + (strlen(MAGIC_STRING) * 8) + 32 + strlen(encInfo -> extn_secret_file) * 8 + 32 + (encInfo -> size_secret_file * 8))
+    unsigned long long required = 54 + (strlen(MAGIC_STRING) * 8) + 32 + strlen(encInfo -> extn_secret_file) * 8 + 32 + (encInfo -> size_secret_file * 8);
+
+    //With FEC: header + copies of (magic string + mode word + FEC parameters) + whole coded groups
+    if (encInfo->fec_nsym != 0)
+    {
+        unsigned long long plain = 4 + strlen(encInfo->extn_secret_file) + 4 + encInfo->size_secret_file;
+        required = 54 + FEC_HEADER_COPIES * ((strlen(MAGIC_STRING_EXT) * 8) + 32 + 32) + fec_encoded_size(plain, encInfo->fec_nsym, encInfo->fec_depth) * 8;
+    }
+
+    if(image_capacity > required)
     {
         //if enough capacity
         return e_success;
@@ -282,6 +553,28 @@ Status copy_bmp_header(FILE *src, FILE *dest)
     return e_success;
 }
 
+//Clone the source image into the stego image (reflink / copy_file_range / buffered), then
+//position both streams at the first pixel byte so the payload overwrites the copy in place
+Status clone_carrier_image(EncodeInfo *encInfo)
+{
+    const char *method;
+
+    // STEP 1 : Nothing may sit in the stdio buffer of the output while the kernel copies
+    fflush(encInfo->fptr_stego_image);
+    if (fast_copy_file(fileno(encInfo->fptr_src_image), fileno(encInfo->fptr_stego_image), &encInfo->io, &method) == e_failure)
+    {
+        return e_failure;
+    }
+    printf("Source image cloned (%s).\n", method);
+
+    // STEP 2 : Skip the 54 byte header in both images
+    if (fseek(encInfo->fptr_src_image, 54, SEEK_SET) != 0 || fseek(encInfo->fptr_stego_image, 54, SEEK_SET) != 0)
+    {
+        return e_failure;
+    }
+    return e_success;
+}
+
 //Encode the extension length (3 for txt, etc) into 32 bits
 Status encode_secret_extn_size(long extn_size, EncodeInfo *encInfo)
 {
@@ -323,29 +616,433 @@ Status encode_secret_file_extn(const char *extn, EncodeInfo *encInfo)
     return encode_data_to_image(extn, strlen(extn), encInfo->fptr_src_image, encInfo->fptr_stego_image);
 }
 
+//State shared with embed_data_block() while the I/O engine streams the carrier
+typedef struct
+{
+    FILE *fptr_secret;  //Secret file, read sequentially
+    char *data;         //Secret bytes for the current block
+    LsbMatchState *match; //+-1 LSB matching generator, NULL for LSB replacement
+    const LsbKernel *kernel; //LSB replacement kernel of the carrier format
+    QualityStats *quality; //Change counters, NULL without --metrics
+    unsigned char *before; //Copy of the block before embedding (--metrics)
+    off_t offset;         //File offset of the next block
+    Checkpoint *ckpt;     //Progress lines (--progress)
+} EmbedBlockCtx;
+
+//I/O engine callback: embed the next len / 8 secret bytes into a block of carrier bytes
+static Status embed_data_block(unsigned char *block, size_t len, void *ctx)
+{
+    EmbedBlockCtx *embed = ctx;
+    size_t count = len / 8;
+
+    // STEP 1 : Secret bytes that belong to this block
+    if (fread(embed->data, 1, count, embed->fptr_secret) != count)
+    {
+        printf("Error: Secret file ended early.\n");
+        return e_failure;
+    }
+
+    // STEP 2 : One secret byte into every 8 carrier bytes, the block is compared with its copy afterwards
+    if (embed->quality != NULL)
+    {
+        memcpy(embed->before, block, len);
+    }
+    if (embed->match != NULL)
+    {
+        lsb_match_block(embed->match, block, (const unsigned char *)embed->data, count);
+    }
+    else
+    {
+        lsb_kernel_embed(embed->kernel, block, (const unsigned char *)embed->data, count);
+    }
+
+    // STEP 3 : Changes of this block (--metrics)
+    if (embed->quality != NULL)
+    {
+        quality_update(embed->quality, embed->before, block, len, embed->offset);
+    }
+    embed->offset += len;
+    progress_report(embed->ckpt, embed->offset - embed->ckpt->rec.data_offset, 0);
+    return e_success;
+}
+
+//Changes of the header fields already written before the data region (--metrics)
+//The stego stream is write only, its few header bytes are read back through a second descriptor
+static Status measure_header_fields(EncodeInfo *encInfo, off_t end)
+{
+    unsigned char before[1024], after[1024];
+    size_t len = end - 54;
+    int fd = open(encInfo->stego_image_fname, O_RDONLY);
+    Status ret = e_failure;
+
+    if (fd >= 0 && end >= 54 && len <= sizeof(before) &&
+        pread(fileno(encInfo->fptr_src_image), before, len, 54) == (ssize_t)len &&
+        pread(fd, after, len, 54) == (ssize_t)len)
+    {
+        quality_update(&encInfo->quality, before, after, len, 54);
+        ret = e_success;
+    }
+    if (fd >= 0)
+    {
+        close(fd);
+    }
+    return ret;
+}
+
+//--resume: check that the last secret bytes before the recorded offset come back out of the stego LSBs,
+//then restore the LSB matching generator and move the secret file to the recorded offset
+static Status resume_secret_data(EncodeInfo *encInfo)
+{
+    CheckpointRecord *rec = &encInfo->ckpt.rec;
+    size_t window = rec->done < CKPT_VERIFY_WINDOW ? rec->done : CKPT_VERIFY_WINDOW;
+    off_t secret_pos = (rec->done - window) / 8;
+    unsigned char *carrier = malloc(window + 8);
+    unsigned char *secret = malloc(window / 8 + 1);
+    Status ret = e_success;
+
+    // STEP 1 : Window of embedded data just before the checkpoint
+    if (carrier == NULL || secret == NULL ||
+        pread(fileno(encInfo->fptr_stego_image), carrier, window, rec->data_offset + rec->done - window) != (ssize_t)window ||
+        pread(fileno(encInfo->fptr_secret), secret, window / 8, secret_pos) != (ssize_t)(window / 8))
+    {
+        printf("Error: Cannot read the data before the checkpoint.\n");
+        ret = e_failure;
+    }
+    for (size_t i = 0; ret == e_success && i < window / 8; i++)
+    {
+        unsigned char byte = 0;
+        for (int k = 0; k < 8; k++)
+        {
+            byte = (byte << 1) | (carrier[i * 8 + k] & 1);
+        }
+        if (byte != secret[i])
+        {
+            printf("Error: %s does not hold the secret data its checkpoint records (byte %lld differs).\n", encInfo->stego_image_fname,
+                   (long long)(secret_pos + i));
+            ret = e_failure;
+        }
+    }
+    free(carrier);
+    free(secret);
+
+    // STEP 2 : Generator and secret file continue where the checkpoint left them
+    if (ret == e_success && encInfo->lsb_match)
+    {
+        memcpy(encInfo->match.s, rec->match_state, sizeof(encInfo->match.s));
+        encInfo->match.changed = rec->match_changed;
+    }
+    if (ret == e_success && fseek(encInfo->fptr_secret, rec->done / 8, SEEK_SET) != 0)
+    {
+        ret = e_failure;
+    }
+    return ret;
+}
+
 //Read entire secret file and encode its content
+//The data is the bulk of the payload, so it goes through the block I/O engine: the carrier
+//bytes from the current source position are read in large blocks, embedded and written to
+//the same offset of the (cloned) stego image; with --pipeline the staged pipeline does the same
+//with reading, embedding and writing on separate threads
 Status encode_secret_file_data(EncodeInfo *encInfo)
 {
-    char ch;
-    while (fread(&ch, 1, 1, encInfo->fptr_secret))
+    EmbedBlockCtx embed;
+    IoConfig *io = &encInfo->io;
+    const char *engine;
+
+    // STEP 1 : Carrier range holding the data, stdio buffers handed over to the engine
+    off_t offset = ftell(encInfo->fptr_src_image);
+    off_t length = (off_t)encInfo->size_secret_file * 8;
+    if (fflush(encInfo->fptr_stego_image) != 0)
     {
-        char image_buffer[8];
-        
-        // Read 8 bytes from source image
-        fread(image_buffer, sizeof(char), 8, encInfo->fptr_src_image);
-        
-        // Encode the byte into the buffer
-        if (encode_byte_to_lsb(ch, image_buffer) == e_failure)
+        return e_failure;
+    }
+    if (encInfo->metrics && measure_header_fields(encInfo, offset) == e_failure)
+    {
+        return e_failure;
+    }
+
+    // STEP 2 : Staged pipeline when asked for, otherwise stream the range through the engine
+    if (encInfo->pipeline_buffers != 0)
+    {
+        if (pipeline_embed_range(encInfo, offset, length, encInfo->pipeline_buffers) == e_failure)
+        {
+            return e_failure;
+        }
+    }
+    else
+    {
+        // STEP 3 : Journal of this run; --resume takes over the recorded progress once the data before it checks out
+        Checkpoint *ck = &encInfo->ckpt;
+        if (checkpoint_open(ck, e_ckpt_encode, encInfo->stego_image_fname, fileno(encInfo->fptr_src_image), fileno(encInfo->fptr_secret),
+                            offset, length, encInfo->lsb_match ? CKPT_LSB_MATCH : 0) == e_failure)
+        {
+            return e_failure;
+        }
+        if (ck->resume ? resume_secret_data(encInfo) == e_failure :
+            ck->interval != 0 && checkpoint_commit(ck, encInfo->fptr_stego_image, 0, encInfo->lsb_match ? &encInfo->match : NULL) == e_failure)
+        {
+            return e_failure;
+        }
+
+        embed.fptr_secret = encInfo->fptr_secret;
+        embed.match = encInfo->lsb_match ? &encInfo->match : NULL;
+        embed.kernel = lsb_kernel_select(1, 3, LSB_MASK_BGR);
+        embed.quality = encInfo->metrics ? &encInfo->quality : NULL;
+        embed.offset = offset + ck->rec.done;
+        embed.ckpt = ck;
+        embed.data = malloc((io->block_size ? io->block_size : IO_DEFAULT_BLOCK) / 8);
+        embed.before = encInfo->metrics ? malloc(io->block_size ? io->block_size : IO_DEFAULT_BLOCK) : NULL;
+        if (embed.data == NULL || (encInfo->metrics && embed.before == NULL))
+        {
+            free(embed.data);
+            free(embed.before);
+            return e_failure;
+        }
+
+        // STEP 4 : Rest of the data region through the engine, one segment per checkpoint
+        Status ret = checkpoint_range(ck, fileno(encInfo->fptr_src_image), fileno(encInfo->fptr_stego_image), embed_data_block, &embed, io, &engine,
+                                      encInfo->fptr_stego_image, embed.match);
+        free(embed.data);
+        free(embed.before);
+        if (ret == e_failure)
+        {
+            return e_failure;
+        }
+        checkpoint_close(ck);
+        printf("Secret data embedded through %s engine.\n", engine);
+    }
+
+    // STEP 5 : Both streams continue after the data
+    fseek(encInfo->fptr_src_image, offset + length, SEEK_SET);
+    fseek(encInfo->fptr_stego_image, offset + length, SEEK_SET);
+    return e_success;
+}
+
+//Plain payload: magic string, extension size, extension, file size and data, one bit per image byte
+Status encode_plain_payload(EncodeInfo *encInfo)
+{
+    // STEP 1: Encode magic string
+    if (encode_magic_string(MAGIC_STRING, encInfo) == e_failure)
+    {
+        printf("Error: Failed to encode magic string.\n");
+        return e_failure;
+    }
+
+    // STEP 2-5: Extension size, extension, file size and data
+    return encode_payload_fields(encInfo);
+}
+
+//Plain payload layout embedded by +-1 LSB matching: the header fields go through the same kernel as the data
+Status encode_matched_payload(EncodeInfo *encInfo)
+{
+    unsigned char fields[2 * MAX_FILE_SUFFIX + 16];
+    unsigned char carrier[sizeof(fields) * 8];
+    size_t len = 0;
+    size_t extn_len = strlen(encInfo->extn_secret_file);
+
+    // STEP 1 : Magic string, extension size, extension and file size, sizes MSB first
+    memcpy(fields, MAGIC_STRING, strlen(MAGIC_STRING));
+    len += strlen(MAGIC_STRING);
+    for (int shift = 24; shift >= 0; shift -= 8)
+    {
+        fields[len++] = extn_len >> shift;
+    }
+    memcpy(fields + len, encInfo->extn_secret_file, extn_len);
+    len += extn_len;
+    for (int shift = 24; shift >= 0; shift -= 8)
+    {
+        fields[len++] = encInfo->size_secret_file >> shift;
+    }
+
+    // STEP 2 : Header carrier bytes through the kernel
+    if (fread(carrier, 1, len * 8, encInfo->fptr_src_image) != len * 8)
+    {
+        printf("Error: Failed to read the image header region.\n");
+        return e_failure;
+    }
+    lsb_match_block(&encInfo->match, carrier, fields, len);
+    if (fwrite(carrier, 1, len * 8, encInfo->fptr_stego_image) != len * 8)
+    {
+        printf("Error: Failed to write the image header region.\n");
+        return e_failure;
+    }
+
+    // STEP 3 : Secret data through the I/O engine (or pipeline) with the same generator
+    if (encode_secret_file_data(encInfo) == e_failure)
+    {
+        printf("Error: Failed to encode secret file data.\n");
+        return e_failure;
+    }
+    printf("LSB matching (%s): %llu carrier bytes changed by +-1.\n", lsb_match_kernel_name(), encInfo->match.changed);
+    return e_success;
+}
+
+//Continue an interrupted encode: the clone and the header fields were made durable before the first checkpoint,
+//so they are only checked (same size as the source, header fields decode to this secret file) and the data goes on
+Status encode_resumed_payload(EncodeInfo *encInfo)
+{
+    unsigned char fields[2 * MAX_FILE_SUFFIX + 16];
+    unsigned char carrier[sizeof(fields) * 8];
+    size_t len = 0;
+    size_t extn_len = strlen(encInfo->extn_secret_file);
+    struct stat src_st, stego_st;
+
+    // STEP 1 : Expected magic string, extension size, extension and file size
+    memcpy(fields, MAGIC_STRING, strlen(MAGIC_STRING));
+    len += strlen(MAGIC_STRING);
+    for (int shift = 24; shift >= 0; shift -= 8)
+    {
+        fields[len++] = extn_len >> shift;
+    }
+    memcpy(fields + len, encInfo->extn_secret_file, extn_len);
+    len += extn_len;
+    for (int shift = 24; shift >= 0; shift -= 8)
+    {
+        fields[len++] = encInfo->size_secret_file >> shift;
+    }
+
+    // STEP 2 : The stego image must be a whole clone carrying exactly those fields
+    if (fstat(fileno(encInfo->fptr_src_image), &src_st) != 0 || fstat(fileno(encInfo->fptr_stego_image), &stego_st) != 0 ||
+        src_st.st_size != stego_st.st_size || pread(fileno(encInfo->fptr_stego_image), carrier, len * 8, 54) != (ssize_t)(len * 8))
+    {
+        printf("Error: %s is not a complete clone of %s, cannot resume.\n", encInfo->stego_image_fname, encInfo->src_image_fname);
+        return e_failure;
+    }
+    for (size_t i = 0; i < len; i++)
+    {
+        unsigned char byte = 0;
+        for (int k = 0; k < 8; k++)
+        {
+            byte = (byte << 1) | (carrier[i * 8 + k] & 1);
+        }
+        if (byte != fields[i])
         {
+            printf("Error: Payload header of %s does not match this secret file, cannot resume.\n", encInfo->stego_image_fname);
             return e_failure;
         }
-        
-        // Write the modified buffer to stego image
-        fwrite(image_buffer, sizeof(char), 8, encInfo->fptr_stego_image);
     }
+
+    // STEP 3 : Both streams at the first data byte, then the journal takes over
+    if (fseek(encInfo->fptr_src_image, 54 + len * 8, SEEK_SET) != 0 || fseek(encInfo->fptr_stego_image, 54 + len * 8, SEEK_SET) != 0 ||
+        encode_secret_file_data(encInfo) == e_failure)
+    {
+        printf("Error: Failed to resume secret file data.\n");
+        return e_failure;
+    }
+    if (encInfo->lsb_match)
+    {
+        printf("LSB matching (%s): %llu carrier bytes changed by +-1.\n", lsb_match_kernel_name(), encInfo->match.changed);
+    }
+    return e_success;
+}
+
+//Payload fields that follow the magic string (and mode words): extension size, extension, file size and data
+Status encode_payload_fields(EncodeInfo *encInfo)
+{
+    // STEP 2: Encode secret file extension size
+    if (encode_secret_extn_size(strlen(encInfo->extn_secret_file), encInfo) == e_failure)
+    {
+        printf("Error: Failed to encode secret file extension size.\n");
+        return e_failure;
+    }
+
+    // STEP 3: Encode secret file extension
+    if (encode_data_to_image(encInfo->extn_secret_file, strlen(encInfo->extn_secret_file),
+                            encInfo->fptr_src_image, encInfo->fptr_stego_image) == e_failure)
+    {
+        printf("Error: Failed to encode secret file extension.\n");
+        return e_failure;
+    }
+
+    // STEP 4: Encode size of secret file
+    if (encode_secret_file_size(encInfo->size_secret_file, encInfo) == e_failure)
+    {
+        printf("Error: Failed to encode secret file size.\n");
+        return e_failure;
+    }
+
+    // STEP 5: Encode the actual secret file content
+    if (encode_secret_file_data(encInfo) == e_failure)
+    {
+        printf("Error: Failed to encode secret file data.\n");
+        return e_failure;
+    }
+
     return e_success;
 }
 
+//Store a 32 bit mode word (or mode parameter word) after the extended magic string
+Status encode_mode_word(uint mode_word, EncodeInfo *encInfo)
+{
+    // Same 32 byte layout as the size fields
+    return encode_secret_file_size(mode_word, encInfo);
+}
+
+//FEC payload: copies of extended magic, mode word and FEC parameters, then the Reed-Solomon coded
+//(extension size, extension, file size, data) stream, one interleaved group at a time
+Status encode_fec_payload(EncodeInfo *encInfo)
+{
+    FecCodec fec;
+    unsigned char prefix[16];
+    size_t extn_len = strlen(encInfo->extn_secret_file);
+    size_t prefix_len = 0, prefix_pos = 0;
+
+    // STEP 1: Extended magic string, mode word and FEC parameter word, FEC_HEADER_COPIES times for the decoder's majority vote
+    for (int copy = 0; copy < FEC_HEADER_COPIES; copy++)
+    {
+        if (encode_magic_string(MAGIC_STRING_EXT, encInfo) == e_failure ||
+            encode_mode_word(MODE_FEC, encInfo) == e_failure ||
+            encode_mode_word(encInfo->fec_nsym << 16 | encInfo->fec_depth, encInfo) == e_failure)
+        {
+            printf("Error: Failed to encode extended header.\n");
+            return e_failure;
+        }
+    }
+
+    // STEP 2: Header fields in the same order and bit order as the plain layout
+    for (int shift = 24; shift >= 0; shift -= 8)
+    {
+        prefix[prefix_len++] = extn_len >> shift;
+    }
+    memcpy(prefix + prefix_len, encInfo->extn_secret_file, extn_len);
+    prefix_len += extn_len;
+    for (int shift = 24; shift >= 0; shift -= 8)
+    {
+        prefix[prefix_len++] = encInfo->size_secret_file >> shift;
+    }
+
+    if (fec_init(&fec, encInfo->fec_nsym, encInfo->fec_depth) == e_failure)
+    {
+        return e_failure;
+    }
+
+    // STEP 3: Fill the data rows of a group, add parity, embed all rows, until the payload is used up
+    size_t group_data = (size_t)fec.k * fec.depth;
+    size_t group_size = (size_t)FEC_BLOCK_SIZE * fec.depth;
+    Status ret = e_success;
+    while (ret == e_success)
+    {
+        size_t filled = 0;
+        while (filled < group_data && prefix_pos < prefix_len)
+        {
+            fec.rows[filled++] = prefix[prefix_pos++];
+        }
+        filled += fread(fec.rows + filled, 1, group_data - filled, encInfo->fptr_secret);
+        if (filled == 0)
+        {
+            break;
+        }
+        memset(fec.rows + filled, 0, group_data - filled);
+
+        fec_encode_group(&fec);
+        ret = encode_data_to_image((const char *)fec.rows, group_size, encInfo->fptr_src_image, encInfo->fptr_stego_image);
+    }
+
+    printf("Payload protected with RS(255,%u) x %u interleave (%s kernel).\n", fec.k, fec.depth, fec_kernel_name());
+    fec_free(&fec);
+    return ret;
+}
+
 //Copy rest of the image (after encoding) as is
 Status copy_remaining_img_data(FILE * src, FILE * dest)
 {
@@ -360,6 +1057,46 @@ Status copy_remaining_img_data(FILE * src, FILE * dest)
 }
 
 
+//Parameters that change the stego image, hashed into the cache key with the carrier and secret bytes
+typedef struct
+{
+    char version[8];            //Layout of this key, bumped when the embedding of any mode changes
+    char extn[MAX_FILE_SUFFIX];
+    uint fec_nsym;
+    uint fec_depth;
+    int adaptive;
+    int matrix;
+    int auto_fit;
+    int lsb_match;
+    uint64_t match_state[4];    //Generator seeded from the --lsb-match key
+} CacheParams;
+
+//Key of this job from the carrier, the secret and the parameters, then the cached result if there is one
+static Status lookup_cached_result(EncodeInfo *encInfo, int *hit)
+{
+    CacheParams params;
+
+    memset(&params, 0, sizeof(params));
+    memcpy(params.version, "STGKEY1", 8);
+    memcpy(params.extn, encInfo->extn_secret_file, MAX_FILE_SUFFIX);
+    params.fec_nsym = encInfo->fec_nsym;
+    params.fec_depth = encInfo->fec_depth;
+    params.adaptive = encInfo->adaptive;
+    params.matrix = encInfo->matrix;
+    params.auto_fit = encInfo->auto_fit;
+    params.lsb_match = encInfo->lsb_match;
+    if (encInfo->lsb_match)
+    {
+        memcpy(params.match_state, encInfo->match.s, sizeof(params.match_state));
+    }
+
+    if (cache_key(&encInfo->cache, fileno(encInfo->fptr_src_image), fileno(encInfo->fptr_secret), &params, sizeof(params), &encInfo->io) == e_failure)
+    {
+        return e_failure;
+    }
+    return cache_fetch(&encInfo->cache, encInfo->stego_image_fname, fileno(encInfo->fptr_stego_image), hit);
+}
+
 //Master func to perform complete encoding process
 Status do_encoding(EncodeInfo *encInfo)
 {
@@ -374,7 +1111,7 @@ Status do_encoding(EncodeInfo *encInfo)
         printf("Files opened successfully.\n");
     }
 
-    // Step 2: Check capacity of image
+    // Step 2: Check capacity of image (with --auto: fit the LSBs per sample and channels to the payload)
     if (check_capacity(encInfo) == e_failure)
     {
         printf("Error: Insufficient image capacity.\n");
@@ -385,56 +1122,65 @@ Status do_encoding(EncodeInfo *encInfo)
         printf("Image has sufficient capacity.\n");
     }
 
-    // Step 3: Copy BMP header from source to stego image
-    if (copy_bmp_header(encInfo->fptr_src_image, encInfo->fptr_stego_image) == e_failure)
+    // Step 3: --cache: a job seen before (same carrier, secret and parameters) is answered from the cache
+    int cached = 0;
+    if (encInfo->cache.dir != NULL && lookup_cached_result(encInfo, &cached) == e_failure)
     {
-        printf("Error: Failed to copy BMP header.\n");
+        printf("Error: Encode cache lookup failed.\n");
         return e_failure;
     }
-
-    // Step 4: Encode magic string
-    if (encode_magic_string(MAGIC_STRING, encInfo) == e_failure)
+    if (cached)
     {
-        printf("Error: Failed to encode magic string.\n");
-        return e_failure;
+        cache_report(&encInfo->cache);
+        io_report(&encInfo->io);
+        printf("Encoding completed successfully.\n");
+        return e_success;
     }
 
-    // Step 5: Encode secret file extension size
-    if (encode_secret_extn_size(strlen(encInfo->extn_secret_file), encInfo) == e_failure)
+    // Step 4: Clone the whole source image (header and tail included), only the payload region is rewritten below
+    // (a resumed encode keeps the clone it made before its first checkpoint)
+    if (!encInfo->ckpt.resume && clone_carrier_image(encInfo) == e_failure)
     {
-        printf("Error: Failed to encode secret file extension size.\n");
+        printf("Error: Failed to copy source image.\n");
         return e_failure;
     }
 
-    // Step 6: Encode secret file extension
-    if (encode_data_to_image(encInfo->extn_secret_file, strlen(encInfo->extn_secret_file),
-                            encInfo->fptr_src_image, encInfo->fptr_stego_image) == e_failure)
+    // Step 5-9: Encode magic string, extension, size and data (Reed-Solomon coded with --fec, cost map driven with --adaptive,
+    // syndrome coded with --matrix, capacity fitted with --auto, +-1 matched with --lsb-match, continued from the journal with --resume)
+    Status payload = encInfo->ckpt.resume ? encode_resumed_payload(encInfo) :
+                     encInfo->fec_nsym != 0 ? encode_fec_payload(encInfo) :
+                     encInfo->adaptive ? encode_adaptive_payload(encInfo) :
+                     encInfo->matrix ? encode_matrix_payload(encInfo) :
+                     encInfo->auto_fit ? encode_auto_payload(encInfo) :
+                     encInfo->lsb_match ? encode_matched_payload(encInfo) : encode_plain_payload(encInfo);
+    if (payload == e_failure)
     {
-        printf("Error: Failed to encode secret file extension.\n");
         return e_failure;
     }
 
-    // Step 7: Encode size of secret file
-    if (encode_secret_file_size(encInfo->size_secret_file, encInfo) == e_failure)
+    // Step 10: Remaining image data is already in place from the clone
+    if (fflush(encInfo->fptr_stego_image) != 0)
     {
-        printf("Error: Failed to encode secret file size.\n");
+        printf("Error: Failed to write stego image.\n");
         return e_failure;
     }
 
-    // Step 8: Encode the actual secret file content
-    if (encode_secret_file_data(encInfo) == e_failure)
+    // Step 11: Quality report gathered during embedding (--metrics)
+    if (encInfo->metrics)
     {
-        printf("Error: Failed to encode secret file data.\n");
-        return e_failure;
+        quality_report(&encInfo->quality);
     }
 
-    // Step 9: Copy remaining image data
-    if (copy_remaining_img_data(encInfo->fptr_src_image, encInfo->fptr_stego_image) == e_failure)
+    // Step 12: New result into the cache (a failed store leaves the output intact)
+    if (encInfo->cache.dir != NULL)
     {
-        printf("Error: Failed to copy remaining image data.\n"); 
-        return e_failure;
+        cache_store(&encInfo->cache, encInfo->stego_image_fname);
+        cache_report(&encInfo->cache);
     }
 
+    // Step 13: Bytes moved and time throttled under the I/O policy
+    io_report(&encInfo->io);
+
     printf("Encoding completed successfully.\n");
     return e_success;
 }
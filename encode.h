@@ -21,6 +21,11 @@
 #include<stdio.h>   //Inbuilt STD operations
 #include "types.h"  // Contains user defined types
 #include<string.h>  //string inbuilt func
+#include "ioengine.h" //Block I/O engine settings
+#include "lsbmatch.h" //LSB matching generator state
+#include "quality.h" //Quality metrics gathered while embedding
+#include "checkpoint.h" //Checkpoint journal and progress reporting
+#include "cache.h" //Encode result cache
 
 /* ========================================================================== */
 /* 
@@ -75,6 +80,32 @@ typedef struct _EncodeInfo
     char *stego_image_fname; //Pointer to output stego image filename
     FILE *fptr_stego_image; //File pointer to write the stego image
 
+    /* --------------- Carrier Options --------------- */
+    int is_y4m; //Source is a YUV4MPEG2 frame stream (.y4m file or "-" for stdin)
+    Y4mPlanes y4m_planes; //Planes of each frame that carry payload bits
+    uint threads; //Embedding worker threads (0 = one per online CPU)
+
+    /* --------------- Payload Options --------------- */
+    uint fec_nsym; //Reed-Solomon parity bytes per 255 byte codeword (0 = no FEC)
+    uint fec_depth; //Codewords interleaved per FEC group
+    int adaptive; //Embed only into textured samples chosen from a cost map (--adaptive)
+    int matrix; //Hamming matrix embedding, at most one changed LSB per group (--matrix)
+    int auto_fit; //Least distorting LSBs per sample and channels that hold the payload (--auto)
+    uint auto_bits; //LSBs per sample chosen by check_capacity() with --auto
+    uint auto_mask; //LSB_MASK_* channels chosen by check_capacity() with --auto
+    int lsb_match; //+-1 LSB matching instead of LSB replacement (--lsb-match[=KEY])
+    LsbMatchState match; //Keyed generator of the +-1 directions
+
+    /* --------------- Report Options --------------- */
+    int metrics; //Gather change histograms, MSE and PSNR while embedding (--metrics)
+    QualityStats quality; //Counters filled by the embedding steps
+
+    /* --------------- I/O Options --------------- */
+    IoConfig io; //Block I/O engine used for the secret data region
+    uint pipeline_buffers; //Pooled buffers of the staged encoding pipeline (0 = pipeline off)
+    Checkpoint ckpt; //Checkpoint journal, --resume and progress lines of the secret data region
+    EncodeCache cache; //Result cache of whole encode jobs (--cache=DIR, --cache-size=MiB)
+
 } EncodeInfo;
 
 /* ================================================================= FUNCTION PROTOTYPES ============================================================================== */
@@ -87,6 +118,9 @@ typedef struct _EncodeInfo
 /* Read and validate Encode args from argv */
 Status read_and_validate_encode_args(char *argv[], EncodeInfo *encInfo);
 
+/* Read optional --name=value encode options */
+Status read_encode_options(int count, char *opts[], EncodeInfo *encInfo);
+
 /* Perform the encoding */
 Status do_encoding(EncodeInfo *encInfo);
 
@@ -99,12 +133,21 @@ Status check_capacity(EncodeInfo *encInfo);
 /* Get image size */
 uint get_image_size_for_bmp(FILE *fptr_image);
 
+/* Width and height from the BMP header (quiet version of the above) */
+Status read_bmp_geometry(FILE *fptr_image, uint *width, uint *height);
+
 /* Get file size */
 uint get_file_size(FILE *fptr);
 
 /* Copy bmp image header */
 Status copy_bmp_header(FILE *fptr_src_image, FILE *fptr_dest_image);
 
+/* Clone the whole source image into the stego image */
+Status clone_carrier_image(EncodeInfo *encInfo);
+
+/* Continue an interrupted plain / LSB matching encode from its checkpoint journal */
+Status encode_resumed_payload(EncodeInfo *encInfo);
+
 /* Store Magic String */
 Status encode_magic_string(const char *magic_string, EncodeInfo *encInfo);
 
@@ -120,6 +163,21 @@ Status encode_secret_extn_size(long extn_size, EncodeInfo *encInfo);
 /* Encode secret file data*/
 Status encode_secret_file_data(EncodeInfo *encInfo);
 
+/* Encode magic string, extension, size and data one bit per image byte */
+Status encode_plain_payload(EncodeInfo *encInfo);
+
+/* Encode extension size, extension, file size and data after the magic string */
+Status encode_payload_fields(EncodeInfo *encInfo);
+
+/* Encode a 32 bit mode word after the extended magic string */
+Status encode_mode_word(uint mode_word, EncodeInfo *encInfo);
+
+/* Encode magic string, extension, size and data by +-1 LSB matching */
+Status encode_matched_payload(EncodeInfo *encInfo);
+
+/* Encode the payload as interleaved Reed-Solomon codewords */
+Status encode_fec_payload(EncodeInfo *encInfo);
+
 /* Encode function, which does the real encoding */
 Status encode_data_to_image(const char *data, int size, FILE *fptr_src_image, FILE *fptr_stego_image);
 
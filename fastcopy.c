@@ -0,0 +1,140 @@
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// ============================================================ * * * * * fastcopy.c * * * * * ======================================================================== //
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/*
+
+### USAGE OF fastcopy.c FILE IN STEGANOGRAPHY PROJECT ?
+--> THIS FILE COPIES A WHOLE FILE FROM ONE DESCRIPTOR TO ANOTHER AS CHEAPLY AS THE FILESYSTEM ALLOWS. ON XFS / BTRFS A REFLINK SHARES THE EXTENTS SO NOTHING IS COPIED
+    UNTIL THE PAYLOAD REGION IS REWRITTEN; copy_file_range() KEEPS THE DATA IN THE KERNEL ELSEWHERE; THE BUFFERED LOOP WORKS EVERYWHERE. EXPLICIT OFFSETS ARE USED
+    THROUGHOUT SO THE FILE POSITIONS OF THE CALLER'S FILE STREAMS ARE LEFT ALONE.
+
+*/
+
+/* ====================================================================== INCLUDES ==================================================================================== */
+
+#define _GNU_SOURCE    // copy_file_range
+#include <stdio.h>     // printf, perror
+#include <stdlib.h>    // malloc, free
+#include <fcntl.h>     // open
+#include <unistd.h>    // pread, pwrite, copy_file_range
+#include <sys/mman.h>  // mmap
+#include <sys/stat.h>  // fstat
+#include <sys/ioctl.h> // ioctl
+#ifdef __linux__
+#include <linux/fs.h>  // FICLONE
+#endif
+#include "types.h"     // Status
+#include "fastcopy.h"  // Prototypes
+
+/* ================================================================= FUNCTION DEFINITIONS ============================================================================= */
+
+/* Large buffer fallback */
+static Status buffered_copy(int src_fd, int dest_fd, off_t size, IoConfig *io)
+{
+    char *buf = malloc(FASTCOPY_BUF_SIZE);
+    off_t pos = 0;
+
+    if (buf == NULL)
+    {
+        printf("ERROR! Out of memory for copy buffer\n");
+        return e_failure;
+    }
+    while (pos < size)
+    {
+        io_throttle(io, e_io_read, FASTCOPY_BUF_SIZE);
+        ssize_t got = pread(src_fd, buf, FASTCOPY_BUF_SIZE, pos);
+        if (got > 0)
+        {
+            io_throttle(io, e_io_write, got);
+        }
+        if (got <= 0 || pwrite(dest_fd, buf, got, pos) != got)
+        {
+            perror("copy");
+            free(buf);
+            return e_failure;
+        }
+        pos += got;
+    }
+    free(buf);
+    return e_success;
+}
+
+/* Copy all of src_fd into the (empty) dest_fd without moving either file offset */
+Status fast_copy_file(int src_fd, int dest_fd, IoConfig *io, const char **method)
+{
+    struct stat st;
+
+    if (fstat(src_fd, &st) != 0)
+    {
+        perror("fstat");
+        return e_failure;
+    }
+
+#ifdef FICLONE
+    // STEP 1 : Reflink, the output shares the carrier's extents until they are overwritten
+    if (ioctl(dest_fd, FICLONE, src_fd) == 0)
+    {
+        *method = "reflink";
+        return e_success;
+    }
+#endif
+
+#ifdef __linux__
+    // STEP 2 : In-kernel copy (also reflinks on filesystems that support it), in small chunks when a cap paces it
+    loff_t in_off = 0, out_off = 0;
+    size_t chunk = io != NULL && (io->bucket[e_io_read].rate != 0 || io->bucket[e_io_write].rate != 0) ? FASTCOPY_PACED_CHUNK : FASTCOPY_CHUNK;
+    while (in_off < st.st_size)
+    {
+        size_t want = st.st_size - in_off < (off_t)chunk ? (size_t)(st.st_size - in_off) : chunk;
+        io_throttle(io, e_io_read, want);
+        io_throttle(io, e_io_write, want);
+        ssize_t done = copy_file_range(src_fd, &in_off, dest_fd, &out_off, want, 0);
+        if (done <= 0)
+        {
+            break;
+        }
+    }
+    if (in_off == st.st_size)
+    {
+        *method = "copy_file_range";
+        return e_success;
+    }
+    // Nothing or only part was copied (EXDEV, ENOSYS, EINVAL...), the buffered loop redoes it from the start
+#endif
+
+    // STEP 3 : Plain read / write with a large buffer
+    *method = "buffered";
+    return buffered_copy(src_fd, dest_fd, st.st_size, io);
+}
+
+/* Map a whole image file shared; writable maps go through their own read-write descriptor */
+unsigned char *map_image_file(FILE *fp, const char *fname, int writable, size_t *size)
+{
+    struct stat st;
+    int fd = writable ? open(fname, O_RDWR) : fileno(fp);
+    unsigned char *image = NULL;
+
+    if (fd >= 0 && fstat(fd, &st) == 0 && st.st_size > 0)
+    {
+        void *map = mmap(NULL, st.st_size, PROT_READ | (writable ? PROT_WRITE : 0), MAP_SHARED, fd, 0);
+        if (map == MAP_FAILED)
+        {
+            perror("mmap");
+        }
+        else
+        {
+            image = map;
+            *size = st.st_size;
+        }
+    }
+    if (writable && fd >= 0)
+    {
+        close(fd);
+    }
+    return image;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/* ============================================================================= END OF CODE ===========================================================================*/
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -0,0 +1,46 @@
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// ============================================================ * * * * * fastcopy.h * * * * * ======================================================================== //
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/*
+
+### USAGE OF fastcopy.h FILE IN STEGANOGRAPHY PROJECT ?
+--> THIS HEADER FILE DECLARES THE WHOLE FILE COPY USED TO CLONE A CARRIER INTO THE STEGO OUTPUT BEFORE THE PAYLOAD REGION IS OVERWRITTEN. THE COPY TRIES A REFLINK
+    (FICLONE) FIRST, THEN IN-KERNEL copy_file_range(), AND ONLY THEN FALLS BACK TO A LARGE BUFFER READ/WRITE LOOP. PAYLOAD MODES THAT PATCH THE CLONE AT SCATTERED
+    POSITIONS MAP IT SHARED, SO ONLY THE PAGES THEY ACTUALLY CHANGE ARE WRITTEN BACK.
+
+*/
+
+// ==================================================================================================================================================================== //
+
+#ifndef FASTCOPY_H
+#define FASTCOPY_H
+
+/* ====================================================================== INCLUDES ==================================================================================== */
+
+#include <stdio.h>
+#include <stddef.h>
+#include "types.h"
+#include "ioengine.h"   // IoConfig, io_throttle
+
+/* ======================================================================= MACROS ===================================================================================== */
+
+#define FASTCOPY_BUF_SIZE (1 << 20)     // Buffer of the read/write fallback
+#define FASTCOPY_CHUNK (1 << 30)        // Bytes asked from one copy_file_range() call
+#define FASTCOPY_PACED_CHUNK (4 << 20)  // Same, when a bandwidth cap paces the copy
+
+/* ================================================================= FUNCTION PROTOTYPES ============================================================================== */
+
+/* Copy all of src_fd into the (empty) dest_fd without moving either file offset
+ * method is set to "reflink", "copy_file_range" or "buffered"; the copied bytes are paced by the buckets of io (NULL = no caps)
+ */
+Status fast_copy_file(int src_fd, int dest_fd, IoConfig *io, const char **method);
+
+/* Map a whole image shared: read-only through fp, or read-write through a new descriptor on fname; munmap(image, *size) when done */
+unsigned char *map_image_file(FILE *fp, const char *fname, int writable, size_t *size);
+
+#endif
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/* ============================================================================= END OF CODE ===========================================================================*/
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -0,0 +1,481 @@
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// =============================================================== * * * * * fec.c * * * * * ========================================================================== //
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/*
+
+### USAGE OF fec.c FILE IN STEGANOGRAPHY PROJECT ?
+--> THIS FILE IMPLEMENTS SYSTEMATIC REED-SOLOMON CODING OVER GF(2^8) (POLYNOMIAL 0x11D, GENERATOR 2, FIRST ROOT 1). BECAUSE A GROUP IS STORED ROW BY ROW (SYMBOL J OF
+    EVERY CODEWORD NEXT TO EACH OTHER), BOTH THE PARITY LFSR AND THE SYNDROME HORNER STEPS WORK ON WHOLE ROWS: "ROW = C * ROW ^ ROW" OVER DEPTH BYTES. THAT REGION MULTIPLY
+    USES SPLIT NIBBLE TABLES (C * LOW NIBBLE, C * HIGH NIBBLE) LOOKED UP 16 OR 32 BYTES AT A TIME WITH PSHUFB ON SSSE3 / AVX2 CPUS. ONLY CODEWORDS WITH A NON ZERO
+    SYNDROME GO THROUGH THE SCALAR BERLEKAMP-MASSEY / CHIEN / FORNEY DECODER.
+
+*/
+
+/* ====================================================================== INCLUDES ==================================================================================== */
+
+#include <stdio.h>     // printf
+#include <stdlib.h>    // malloc, free
+#include <string.h>    // memset, memcpy
+#include <pthread.h>   // pthread_once
+#include "types.h"     // Status
+#include "fec.h"       // FecCodec and prototypes
+
+#define FEC_TILE 2048          // Columns processed together so the rows of a tile stay cache resident
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h> // SSSE3 / AVX2 shuffles
+#define FEC_HAVE_X86 1
+#endif
+
+/* ================================================================ GF(2^8) ARITHMETIC ================================================================================ */
+
+static unsigned char gf_exp[512];   // alpha^i, doubled so products need no modulo
+static unsigned char gf_log[256];   // log_alpha(x), gf_log[0] unused
+static unsigned char gf_split[256][2][16]; // c * low nibble, c * high nibble for every constant c
+
+/* dst[i] = c * a[i] ^ b[i] over n bytes (dst may alias a or b) */
+typedef void (*RegionFn)(unsigned char *dst, const unsigned char *a, unsigned char c, const unsigned char *b, size_t n);
+static RegionFn gf_region;
+static const char *gf_region_name;
+
+static unsigned char gf_mul(unsigned char a, unsigned char b)
+{
+    if (a == 0 || b == 0)
+    {
+        return 0;
+    }
+    return gf_exp[gf_log[a] + gf_log[b]];
+}
+
+static unsigned char gf_inv(unsigned char a)
+{
+    return gf_exp[255 - gf_log[a]];
+}
+
+/* alpha^e for any (also negative) exponent */
+static unsigned char gf_pow_alpha(int e)
+{
+    e %= 255;
+    if (e < 0)
+    {
+        e += 255;
+    }
+    return gf_exp[e];
+}
+
+static void region_scalar(unsigned char *dst, const unsigned char *a, unsigned char c, const unsigned char *b, size_t n)
+{
+    const unsigned char *lo = gf_split[c][0], *hi = gf_split[c][1];
+    for (size_t i = 0; i < n; i++)
+    {
+        dst[i] = lo[a[i] & 0x0F] ^ hi[a[i] >> 4] ^ b[i];
+    }
+}
+
+#ifdef FEC_HAVE_X86
+__attribute__((target("ssse3")))
+static void region_ssse3(unsigned char *dst, const unsigned char *a, unsigned char c, const unsigned char *b, size_t n)
+{
+    const unsigned char *lo = gf_split[c][0], *hi = gf_split[c][1];
+    size_t i = 0;
+
+    __m128i tlo = _mm_loadu_si128((const __m128i *)lo);
+    __m128i thi = _mm_loadu_si128((const __m128i *)hi);
+    __m128i mask = _mm_set1_epi8(0x0F);
+    for (; i + 16 <= n; i += 16)
+    {
+        __m128i x = _mm_loadu_si128((const __m128i *)(a + i));
+        __m128i l = _mm_shuffle_epi8(tlo, _mm_and_si128(x, mask));
+        __m128i h = _mm_shuffle_epi8(thi, _mm_and_si128(_mm_srli_epi64(x, 4), mask));
+        __m128i y = _mm_xor_si128(_mm_xor_si128(l, h), _mm_loadu_si128((const __m128i *)(b + i)));
+        _mm_storeu_si128((__m128i *)(dst + i), y);
+    }
+    for (; i < n; i++)
+    {
+        dst[i] = lo[a[i] & 0x0F] ^ hi[a[i] >> 4] ^ b[i];
+    }
+}
+
+__attribute__((target("avx2")))
+static void region_avx2(unsigned char *dst, const unsigned char *a, unsigned char c, const unsigned char *b, size_t n)
+{
+    const unsigned char *lo = gf_split[c][0], *hi = gf_split[c][1];
+    size_t i = 0;
+
+    __m256i tlo = _mm256_broadcastsi128_si256(_mm_loadu_si128((const __m128i *)lo));
+    __m256i thi = _mm256_broadcastsi128_si256(_mm_loadu_si128((const __m128i *)hi));
+    __m256i mask = _mm256_set1_epi8(0x0F);
+    for (; i + 32 <= n; i += 32)
+    {
+        __m256i x = _mm256_loadu_si256((const __m256i *)(a + i));
+        __m256i l = _mm256_shuffle_epi8(tlo, _mm256_and_si256(x, mask));
+        __m256i h = _mm256_shuffle_epi8(thi, _mm256_and_si256(_mm256_srli_epi64(x, 4), mask));
+        __m256i y = _mm256_xor_si256(_mm256_xor_si256(l, h), _mm256_loadu_si256((const __m256i *)(b + i)));
+        _mm256_storeu_si256((__m256i *)(dst + i), y);
+    }
+    for (; i < n; i++)
+    {
+        dst[i] = lo[a[i] & 0x0F] ^ hi[a[i] >> 4] ^ b[i];
+    }
+}
+#endif
+
+/* Build log / antilog tables and pick the widest region kernel once */
+static void gf_init(void)
+{
+    unsigned int x = 1;
+    for (int i = 0; i < 255; i++)
+    {
+        gf_exp[i] = x;
+        gf_log[x] = i;
+        x <<= 1;
+        if (x & 0x100)
+        {
+            x ^= 0x11D;
+        }
+    }
+    for (int i = 255; i < 512; i++)
+    {
+        gf_exp[i] = gf_exp[i - 255];
+    }
+    for (int c = 0; c < 256; c++)
+    {
+        for (int i = 0; i < 16; i++)
+        {
+            gf_split[c][0][i] = gf_mul(c, i);
+            gf_split[c][1][i] = gf_mul(c, i << 4);
+        }
+    }
+
+    gf_region = region_scalar;
+    gf_region_name = "scalar";
+#ifdef FEC_HAVE_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2"))
+    {
+        gf_region = region_avx2;
+        gf_region_name = "avx2";
+    }
+    else if (__builtin_cpu_supports("ssse3"))
+    {
+        gf_region = region_ssse3;
+        gf_region_name = "ssse3";
+    }
+#endif
+}
+
+/* Tables built once; concurrent daemon jobs wait for the first builder */
+static void gf_setup(void)
+{
+    static pthread_once_t once = PTHREAD_ONCE_INIT;
+    pthread_once(&once, gf_init);
+}
+
+/* Name of the GF(2^8) region kernel picked for this CPU */
+const char *fec_kernel_name(void)
+{
+    gf_setup();
+    return gf_region_name;
+}
+
+/* ================================================================= FUNCTION DEFINITIONS ============================================================================= */
+
+/* Set up generator polynomial and group buffers */
+Status fec_init(FecCodec *fec, uint nsym, uint depth)
+{
+    memset(fec, 0, sizeof(*fec));
+    if (nsym == 0 || nsym >= FEC_BLOCK_SIZE || depth == 0 || depth > FEC_MAX_DEPTH)
+    {
+        printf("ERROR! Invalid FEC parameters: %u parity symbols, depth %u\n", nsym, depth);
+        return e_failure;
+    }
+    gf_setup();
+
+    fec->nsym = nsym;
+    fec->k = FEC_BLOCK_SIZE - nsym;
+    fec->depth = depth;
+
+    // g(x) = (x - a^0)(x - a^1)...(x - a^(nsym-1)), highest degree first
+    fec->gen[0] = 1;
+    for (uint i = 0; i < nsym; i++)
+    {
+        unsigned char root = gf_exp[i];
+        fec->gen[i + 1] = 0;
+        for (uint j = i + 1; j > 0; j--)
+        {
+            fec->gen[j] ^= gf_mul(fec->gen[j - 1], root);
+        }
+    }
+
+    fec->rows = malloc((size_t)FEC_BLOCK_SIZE * depth);
+    fec->erased = calloc((size_t)FEC_BLOCK_SIZE * depth, 1);
+    fec->scratch = malloc((size_t)(nsym + 2) * depth);
+    if (fec->rows == NULL || fec->erased == NULL || fec->scratch == NULL)
+    {
+        printf("ERROR! Out of memory for FEC group\n");
+        fec_free(fec);
+        return e_failure;
+    }
+    return e_success;
+}
+
+/* Release group buffers */
+void fec_free(FecCodec *fec)
+{
+    free(fec->rows);
+    free(fec->erased);
+    free(fec->scratch);
+    fec->rows = fec->erased = fec->scratch = NULL;
+}
+
+/* Bytes produced by coding plain_size bytes (whole groups) */
+unsigned long long fec_encoded_size(unsigned long long plain_size, uint nsym, uint depth)
+{
+    unsigned long long group_data = (unsigned long long)(FEC_BLOCK_SIZE - nsym) * depth;
+    unsigned long long groups = (plain_size + group_data - 1) / group_data;
+    return groups * FEC_BLOCK_SIZE * depth;
+}
+
+/* Fill the parity rows of a group whose k data rows are loaded */
+void fec_encode_group(FecCodec *fec)
+{
+    size_t d = fec->depth;
+    unsigned char *parity = fec->rows + (size_t)fec->k * d;
+    unsigned char *feedback = fec->scratch;
+    unsigned char *zero = fec->scratch + d;
+
+    memset(parity, 0, (size_t)fec->nsym * d);
+    memset(zero, 0, d);
+
+    // LFSR division by g(x), one data row (one symbol of every codeword) per step,
+    // over column tiles so the parity rows of a tile stay in L1
+    for (size_t col = 0; col < d; col += FEC_TILE)
+    {
+        size_t w = d - col < FEC_TILE ? d - col : FEC_TILE;
+        for (uint j = 0; j < fec->k; j++)
+        {
+            const unsigned char *data = fec->rows + j * d + col;
+            for (size_t b = 0; b < w; b++)
+            {
+                feedback[b] = data[b] ^ parity[col + b];
+            }
+            for (uint i = 0; i < fec->nsym; i++)
+            {
+                const unsigned char *next = i + 1 < fec->nsym ? parity + (i + 1) * d + col : zero;
+                gf_region(parity + i * d + col, feedback, fec->gen[i + 1], next, w);
+            }
+        }
+    }
+}
+
+/* Berlekamp-Massey: shortest LFSR (lowest degree first) generating s[0..n-1], returns its length */
+static int berlekamp_massey(const unsigned char *s, int n, unsigned char *c)
+{
+    unsigned char b_poly[FEC_BLOCK_SIZE + 1] = {1}, t[FEC_BLOCK_SIZE + 1];
+    int L = 0, m = 1;
+    unsigned char b = 1;
+
+    memset(c, 0, FEC_BLOCK_SIZE + 1);
+    c[0] = 1;
+    for (int r = 0; r < n; r++)
+    {
+        unsigned char d = s[r];
+        for (int i = 1; i <= L; i++)
+        {
+            d ^= gf_mul(c[i], s[r - i]);
+        }
+        if (d == 0)
+        {
+            m++;
+            continue;
+        }
+
+        unsigned char coef = gf_mul(d, gf_inv(b));
+        memcpy(t, c, sizeof(t));
+        for (int i = 0; i + m <= FEC_BLOCK_SIZE; i++)
+        {
+            c[i + m] ^= gf_mul(coef, b_poly[i]);
+        }
+        if (2 * L <= r)
+        {
+            L = r + 1 - L;
+            memcpy(b_poly, t, sizeof(t));
+            b = d;
+            m = 1;
+        }
+        else
+        {
+            m++;
+        }
+    }
+    return L;
+}
+
+/* Evaluate a lowest-degree-first polynomial of degree deg at x */
+static unsigned char poly_eval(const unsigned char *p, int deg, unsigned char x)
+{
+    unsigned char y = 0;
+    for (int i = deg; i >= 0; i--)
+    {
+        y = gf_mul(y, x) ^ p[i];
+    }
+    return y;
+}
+
+/* Repair one codeword (r[0..254]) given its syndromes and erased positions */
+static Status decode_codeword(FecCodec *fec, unsigned char *r, const unsigned char *synd, const int *erasures, int nerase)
+{
+    int nsym = fec->nsym;
+    unsigned char gamma[FEC_BLOCK_SIZE + 1] = {1}, lambda[FEC_BLOCK_SIZE + 1] = {0}, sigma[FEC_BLOCK_SIZE + 1];
+    unsigned char forney[FEC_BLOCK_SIZE], omega[FEC_BLOCK_SIZE] = {0};
+
+    if (nerase > nsym)
+    {
+        return e_failure;
+    }
+
+    // STEP 1 : Erasure locator gamma(x) = prod (1 - X x), X = a^(254 - position)
+    for (int e = 0; e < nerase; e++)
+    {
+        unsigned char X = gf_pow_alpha(FEC_BLOCK_SIZE - 1 - erasures[e]);
+        for (int i = e + 1; i > 0; i--)
+        {
+            gamma[i] ^= gf_mul(gamma[i - 1], X);
+        }
+    }
+
+    // STEP 2 : Forney syndromes (S(x) gamma(x) mod x^nsym, first nerase terms dropped), then error locator
+    for (int i = nerase; i < nsym; i++)
+    {
+        unsigned char t = 0;
+        for (int j = 0; j <= nerase; j++)
+        {
+            t ^= gf_mul(gamma[j], synd[i - j]);
+        }
+        forney[i - nerase] = t;
+    }
+    int nerr = berlekamp_massey(forney, nsym - nerase, sigma);
+    if (2 * nerr + nerase > nsym)
+    {
+        return e_failure;
+    }
+
+    // STEP 3 : Errata locator lambda = sigma * gamma
+    int deg = nerr + nerase;
+    for (int i = 0; i <= nerr; i++)
+    {
+        for (int j = 0; j <= nerase; j++)
+        {
+            lambda[i + j] ^= gf_mul(sigma[i], gamma[j]);
+        }
+    }
+
+    // STEP 4 : Error evaluator omega = S * lambda mod x^nsym
+    for (int i = 0; i < nsym; i++)
+    {
+        for (int j = 0; j <= i && j <= deg; j++)
+        {
+            omega[i] ^= gf_mul(lambda[j], synd[i - j]);
+        }
+    }
+
+    // STEP 5 : Chien search for the roots X^-1 and Forney magnitudes Y = X omega(X^-1) / lambda'(X^-1)
+    int found = 0;
+    for (int pos = 0; pos < FEC_BLOCK_SIZE; pos++)
+    {
+        int power = FEC_BLOCK_SIZE - 1 - pos;
+        unsigned char x_inv = gf_pow_alpha(-power);
+        if (poly_eval(lambda, deg, x_inv) != 0)
+        {
+            continue;
+        }
+
+        unsigned char derivative = 0;
+        for (int i = 1; i <= deg; i += 2)
+        {
+            derivative ^= gf_mul(lambda[i], gf_pow_alpha(-power * (i - 1)));
+        }
+        if (derivative == 0)
+        {
+            return e_failure;
+        }
+        unsigned char y = gf_mul(gf_pow_alpha(power), poly_eval(omega, nsym - 1, x_inv));
+        r[pos] ^= gf_mul(y, gf_inv(derivative));
+        found++;
+    }
+    if (found != deg)
+    {
+        return e_failure;
+    }
+
+    fec->corrected += found;
+    return e_success;
+}
+
+/* Correct errors and erasures of a loaded group in place */
+Status fec_decode_group(FecCodec *fec)
+{
+    size_t d = fec->depth;
+    uint nsym = fec->nsym;
+    unsigned char *synd = fec->scratch;
+    Status ret = e_success;
+
+    // STEP 1 : Syndromes of every codeword at once, S_i = S_i * a^i ^ row_j (Horner over the rows, tile by tile)
+    memset(synd, 0, (size_t)nsym * d);
+    for (size_t col = 0; col < d; col += FEC_TILE)
+    {
+        size_t w = d - col < FEC_TILE ? d - col : FEC_TILE;
+        for (uint j = 0; j < FEC_BLOCK_SIZE; j++)
+        {
+            const unsigned char *row = fec->rows + j * d + col;
+            for (uint i = 0; i < nsym; i++)
+            {
+                gf_region(synd + i * d + col, synd + i * d + col, gf_exp[i], row, w);
+            }
+        }
+    }
+
+    // STEP 2 : Only codewords with a non zero syndrome or known erasures need the scalar decoder
+    for (size_t b = 0; b < d; b++)
+    {
+        unsigned char s[FEC_BLOCK_SIZE], r[FEC_BLOCK_SIZE];
+        int erasures[FEC_BLOCK_SIZE], nerase = 0, dirty = 0;
+
+        for (uint i = 0; i < nsym; i++)
+        {
+            s[i] = synd[i * d + b];
+            dirty |= s[i];
+        }
+        for (int j = 0; j < FEC_BLOCK_SIZE; j++)
+        {
+            if (fec->erased[j * d + b])
+            {
+                erasures[nerase++] = j;
+            }
+        }
+        if (!dirty)
+        {
+            continue;
+        }
+
+        for (int j = 0; j < FEC_BLOCK_SIZE; j++)
+        {
+            r[j] = fec->rows[j * d + b];
+        }
+        if (decode_codeword(fec, r, s, erasures, nerase) == e_failure)
+        {
+            ret = e_failure;
+            continue;
+        }
+        for (int j = 0; j < FEC_BLOCK_SIZE; j++)
+        {
+            fec->rows[j * d + b] = r[j];
+        }
+    }
+    return ret;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/* ============================================================================= END OF CODE ===========================================================================*/
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
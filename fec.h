@@ -0,0 +1,73 @@
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// =============================================================== * * * * * fec.h * * * * * ========================================================================== //
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/*
+
+### USAGE OF fec.h FILE IN STEGANOGRAPHY PROJECT ?
+--> THIS HEADER FILE DECLARES THE OPTIONAL REED-SOLOMON FORWARD ERROR CORRECTION LAYER. THE PAYLOAD (EXTENSION SIZE, EXTENSION, FILE SIZE AND DATA) IS CUT INTO GROUPS OF
+    "DEPTH" RS(255, 255 - NSYM) CODEWORDS THAT ARE INTERLEAVED SYMBOL BY SYMBOL, SO A BURST OF DAMAGED CARRIER BYTES IS SPREAD OVER MANY CODEWORDS. ONE GROUP IS HELD IN
+    MEMORY AT A TIME, SO ENCODING AND DECODING STREAM THROUGH PAYLOADS OF ANY SIZE.
+
+*/
+
+// ==================================================================================================================================================================== //
+
+#ifndef FEC_H
+#define FEC_H
+
+/* ====================================================================== INCLUDES ==================================================================================== */
+
+#include <stddef.h>
+#include "types.h"
+
+/* ======================================================================= MACROS ===================================================================================== */
+
+#define FEC_BLOCK_SIZE 255      // Symbols per Reed-Solomon codeword (GF(2^8))
+#define FEC_DEFAULT_DEPTH 32    // Codewords interleaved per group
+#define FEC_MAX_DEPTH 4096      // Largest accepted interleave depth
+
+/* ======================================================================= STRUCTURE ================================================================================== */
+
+/*
+ * One interleaved group of codewords
+ * rows[j * depth + b] is symbol j of codeword b, so row j is exactly the run of bytes
+ * embedded / extracted for symbol position j; data rows come first, parity rows last
+ */
+typedef struct _FecCodec
+{
+    uint nsym;                          // Parity symbols per codeword
+    uint k;                             // Data symbols per codeword (255 - nsym)
+    uint depth;                         // Codewords per group
+    unsigned char gen[FEC_BLOCK_SIZE];  // Generator polynomial, highest degree first
+    unsigned char *rows;                // FEC_BLOCK_SIZE * depth symbols of the current group
+    unsigned char *erased;              // One flag per symbol of rows: position known to be lost
+    unsigned char *scratch;             // (nsym + 2) * depth bytes of syndrome / feedback rows
+    unsigned long corrected;            // Symbols repaired so far
+} FecCodec;
+
+/* ================================================================= FUNCTION PROTOTYPES ============================================================================== */
+
+/* Set up generator polynomial and group buffers */
+Status fec_init(FecCodec *fec, uint nsym, uint depth);
+
+/* Release group buffers */
+void fec_free(FecCodec *fec);
+
+/* Bytes produced by coding plain_size bytes (whole groups) */
+unsigned long long fec_encoded_size(unsigned long long plain_size, uint nsym, uint depth);
+
+/* Fill the parity rows of a group whose k data rows are loaded */
+void fec_encode_group(FecCodec *fec);
+
+/* Correct errors and erasures of a loaded group in place */
+Status fec_decode_group(FecCodec *fec);
+
+/* Name of the GF(2^8) region kernel picked for this CPU */
+const char *fec_kernel_name(void);
+
+#endif
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/* ============================================================================= END OF CODE ===========================================================================*/
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -0,0 +1,487 @@
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// ============================================================== * * * * * index.c * * * * * ========================================================================= //
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/*
+
+### USAGE OF index.c FILE IN STEGANOGRAPHY PROJECT ?
+--> THIS FILE IMPLEMENTS THE PERSISTENT CARRIER INDEX. AN UPDATE WALKS THE CARRIER DIRECTORY, STATS EVERY BMP FILE AND REUSES THE OLD RECORD WHEN PATH, SIZE AND MTIME
+    STILL MATCH; ONLY NEW OR CHANGED FILES HAVE THEIR 54 BYTE HEADER READ. THE NEW INDEX IS WRITTEN TO A TEMPORARY FILE AND RENAMED OVER THE OLD ONE. PICK MAPS THE INDEX,
+    BINARY SEARCHES THE CAPACITY SORTED RECORDS FOR THE FIRST CARRIER LARGE ENOUGH FOR THE PAYLOAD AND MARKS IT USED IN PLACE.
+
+*/
+
+/* ====================================================================== INCLUDES ==================================================================================== */
+
+#include <stdio.h>       // Std inbuilt functions
+#include <stdlib.h>      // malloc, realloc, qsort, bsearch
+#include <string.h>      // Inbuilt string functions
+#include <dirent.h>      // opendir, readdir
+#include <fcntl.h>       // open
+#include <unistd.h>      // pread, close, fsync
+#include <time.h>        // clock_gettime
+#include <sys/mman.h>    // mmap
+#include <sys/stat.h>    // stat, lstat
+#include "types.h"       // Status
+#include "common.h"      // MAGIC_STRING
+#include "index.h"       // Index layout and prototypes
+
+/* ======================================================================= STRUCTURE ================================================================================== */
+
+/* Record of the previous index, looked up by path during an update */
+typedef struct
+{
+    const char *name;
+    uint16_t len;
+    const IndexRecord *rec;
+} NameRef;
+
+/* Index being built by an update */
+typedef struct
+{
+    IndexRecord *recs;
+    size_t count, cap;
+    char *names;                // New path table
+    size_t names_size, names_cap;
+
+    NameRef *old;               // Previous records sorted by path
+    size_t old_count;
+
+    unsigned long reused;       // Unchanged files, header not read
+    unsigned long added;        // New or changed files, header read
+    unsigned long skipped;      // Not a readable 24 bit / 32 bit BMP
+    unsigned long matched;      // Paths that were in the previous index
+} IndexBuild;
+
+/* ================================================================= FUNCTION DEFINITIONS ============================================================================= */
+
+/* Map an index file and check its layout; returns the header or NULL */
+static IndexHeader *map_index(const char *fname, int writable, size_t *map_size)
+{
+    struct stat st;
+    int fd = open(fname, writable ? O_RDWR : O_RDONLY);
+    if (fd < 0 || fstat(fd, &st) != 0 || (size_t)st.st_size < sizeof(IndexHeader))
+    {
+        if (fd >= 0)
+        {
+            close(fd);
+        }
+        return NULL;
+    }
+
+    void *map = mmap(NULL, st.st_size, PROT_READ | (writable ? PROT_WRITE : 0), MAP_SHARED, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED)
+    {
+        perror("mmap");
+        return NULL;
+    }
+
+    IndexHeader *hdr = map;
+    if (memcmp(hdr->magic, INDEX_MAGIC, sizeof(hdr->magic)) != 0 || hdr->version != INDEX_VERSION ||
+        hdr->names_offset != sizeof(IndexHeader) + (uint64_t)hdr->count * sizeof(IndexRecord) ||
+        hdr->names_offset + hdr->names_size > (uint64_t)st.st_size)
+    {
+        printf("Error: %s is not a carrier index.\n", fname);
+        munmap(map, st.st_size);
+        return NULL;
+    }
+    *map_size = st.st_size;
+    return hdr;
+}
+
+/* Order of NameRef entries: by path bytes, then length */
+static int compare_names(const void *a, const void *b)
+{
+    const NameRef *x = a, *y = b;
+    int cmp = memcmp(x->name, y->name, x->len < y->len ? x->len : y->len);
+    return cmp != 0 ? cmp : (int)x->len - (int)y->len;
+}
+
+/* Order of the records in the file: by capacity, then path */
+static char *sort_names;
+static int compare_records(const void *a, const void *b)
+{
+    const IndexRecord *x = a, *y = b;
+    if (x->capacity != y->capacity)
+    {
+        return x->capacity < y->capacity ? -1 : 1;
+    }
+    NameRef nx = { sort_names + x->name_offset, x->name_len, x }, ny = { sort_names + y->name_offset, y->name_len, y };
+    return compare_names(&nx, &ny);
+}
+
+/* Fill dimensions, bit depth, pixel offset and capacity from the BMP header of path */
+static Status read_bmp_record(const char *path, IndexRecord *rec)
+{
+    unsigned char hdr[54];
+    int fd = open(path, O_RDONLY);
+    if (fd < 0)
+    {
+        return e_failure;
+    }
+    ssize_t n = pread(fd, hdr, sizeof(hdr), 0);
+    close(fd);
+    if (n != sizeof(hdr) || hdr[0] != 'B' || hdr[1] != 'M')
+    {
+        return e_failure;
+    }
+
+    // Little endian header fields: bfOffBits at 10, width at 18, height at 22, bit count at 28
+    int32_t width = hdr[18] | hdr[19] << 8 | hdr[20] << 16 | (uint32_t)hdr[21] << 24;
+    int32_t height = hdr[22] | hdr[23] << 8 | hdr[24] << 16 | (uint32_t)hdr[25] << 24;
+    rec->pixel_offset = hdr[10] | hdr[11] << 8 | hdr[12] << 16 | (uint32_t)hdr[13] << 24;
+    rec->bpp = hdr[28] | hdr[29] << 8;
+    rec->width = width < 0 ? -width : width;
+    rec->height = height < 0 ? -height : height;
+    if (rec->bpp != 24 && rec->bpp != 32)
+    {
+        return e_failure;
+    }
+
+    // Same capacity the encoder's check_capacity() works with
+    rec->capacity = (uint64_t)rec->width * rec->height * 3;
+    return e_success;
+}
+
+/* Add one BMP file to the index, reusing its previous record when size and mtime are unchanged */
+static Status add_carrier(const char *path, const struct stat *st, void *ctx)
+{
+    IndexBuild *b = ctx;
+    IndexRecord rec;
+    size_t len = strlen(path);
+    if (len > UINT16_MAX)
+    {
+        b->skipped++;
+        return e_success;
+    }
+
+    // STEP 1 : Previous record for this path
+    NameRef key = { path, (uint16_t)len, NULL };
+    NameRef *old = b->old_count ? bsearch(&key, b->old, b->old_count, sizeof(*b->old), compare_names) : NULL;
+    b->matched += old != NULL;
+    if (old != NULL && old->rec->file_size == (uint64_t)st->st_size && old->rec->mtime_sec == st->st_mtim.tv_sec &&
+        old->rec->mtime_nsec == (uint32_t)st->st_mtim.tv_nsec)
+    {
+        rec = *old->rec;
+        b->reused++;
+    }
+    else
+    {
+        // STEP 2 : New or changed file, read its header
+        memset(&rec, 0, sizeof(rec));
+        if (read_bmp_record(path, &rec) == e_failure)
+        {
+            b->skipped++;
+            return e_success;
+        }
+        rec.file_size = st->st_size;
+        rec.mtime_sec = st->st_mtim.tv_sec;
+        rec.mtime_nsec = st->st_mtim.tv_nsec;
+        b->added++;
+    }
+
+    // STEP 3 : Append record and path
+    if (b->count == b->cap)
+    {
+        size_t cap = b->cap ? b->cap * 2 : 1024;
+        IndexRecord *recs = realloc(b->recs, cap * sizeof(*recs));
+        if (recs == NULL)
+        {
+            return e_failure;
+        }
+        b->recs = recs;
+        b->cap = cap;
+    }
+    if (b->names_size + len > b->names_cap)
+    {
+        size_t cap = b->names_cap ? b->names_cap * 2 : 64 * 1024;
+        while (cap < b->names_size + len)
+        {
+            cap *= 2;
+        }
+        char *names = realloc(b->names, cap);
+        if (names == NULL)
+        {
+            return e_failure;
+        }
+        b->names = names;
+        b->names_cap = cap;
+    }
+    if (b->names_size + len > UINT32_MAX)
+    {
+        printf("Error: Carrier paths exceed the index path table limit.\n");
+        return e_failure;
+    }
+    memcpy(b->names + b->names_size, path, len);
+    rec.name_offset = b->names_size;
+    rec.name_len = len;
+    b->names_size += len;
+    b->recs[b->count++] = rec;
+    return e_success;
+}
+
+/* Walk dir recursively and visit every regular .bmp file; symbolic links are not followed, so the walk stays inside dir */
+Status walk_bmp_files(const char *dir, BmpVisitor visit, void *ctx)
+{
+    DIR *d = opendir(dir);
+    struct dirent *ent;
+    Status ret = e_success;
+
+    if (d == NULL)
+    {
+        perror(dir);
+        return e_failure;
+    }
+    while (ret == e_success && (ent = readdir(d)) != NULL)
+    {
+        if (strcmp(ent->d_name, ".") == 0 || strcmp(ent->d_name, "..") == 0)
+        {
+            continue;
+        }
+
+        char path[4096];
+        struct stat st;
+        if ((size_t)snprintf(path, sizeof(path), "%s/%s", dir, ent->d_name) >= sizeof(path) || lstat(path, &st) != 0)
+        {
+            continue;
+        }
+        if (S_ISDIR(st.st_mode))
+        {
+            ret = walk_bmp_files(path, visit, ctx);
+        }
+        else if (S_ISREG(st.st_mode) && strstr(ent->d_name, ".bmp") != NULL)
+        {
+            ret = visit(path, &st, ctx);
+        }
+    }
+    closedir(d);
+    return ret;
+}
+
+/* Walker callback: remember one image path */
+static Status list_image(const char *path, const struct stat *st, void *ctx)
+{
+    ImageList *list = ctx;
+
+    (void)st;
+    if (list->count == list->cap)
+    {
+        int cap = list->cap ? list->cap * 2 : 64;
+        char **names = realloc(list->names, cap * sizeof(*names));
+        if (names == NULL)
+        {
+            return e_failure;
+        }
+        list->names = names;
+        list->cap = cap;
+    }
+    if ((list->names[list->count] = strdup(path)) == NULL)
+    {
+        return e_failure;
+    }
+    list->count++;
+    return e_success;
+}
+
+Status image_list_add(ImageList *list, const char *path)
+{
+    struct stat st;
+
+    // A path named on the command line is taken as given, links below it are not
+    if (stat(path, &st) == 0 && S_ISDIR(st.st_mode))
+    {
+        return walk_bmp_files(path, list_image, list);
+    }
+    return list_image(path, &st, list);
+}
+
+void image_list_free(ImageList *list)
+{
+    for (int i = 0; i < list->count; i++)
+    {
+        free(list->names[i]);
+    }
+    free(list->names);
+    memset(list, 0, sizeof(*list));
+}
+
+/* Write the sorted index to a temporary file and rename it over index_fname */
+static Status write_index(const char *index_fname, IndexBuild *b)
+{
+    char tmp_fname[4096];
+    IndexHeader hdr;
+
+    // STEP 1 : Records sorted by capacity for the binary search of pick
+    sort_names = b->names;
+    qsort(b->recs, b->count, sizeof(*b->recs), compare_records);
+
+    memset(&hdr, 0, sizeof(hdr));
+    memcpy(hdr.magic, INDEX_MAGIC, sizeof(hdr.magic));
+    hdr.version = INDEX_VERSION;
+    hdr.count = b->count;
+    hdr.names_offset = sizeof(hdr) + (uint64_t)b->count * sizeof(IndexRecord);
+    hdr.names_size = b->names_size;
+
+    // STEP 2 : Header, records, paths; the old index stays valid until the rename
+    snprintf(tmp_fname, sizeof(tmp_fname), "%s.tmp", index_fname);
+    FILE *fp = fopen(tmp_fname, "w");
+    if (fp == NULL)
+    {
+        perror("fopen");
+        return e_failure;
+    }
+    int ok = fwrite(&hdr, sizeof(hdr), 1, fp) == 1 &&
+             fwrite(b->recs, sizeof(*b->recs), b->count, fp) == b->count &&
+             fwrite(b->names, 1, b->names_size, fp) == b->names_size &&
+             fflush(fp) == 0 && fsync(fileno(fp)) == 0;
+    if (fclose(fp) != 0 || !ok || rename(tmp_fname, index_fname) != 0)
+    {
+        perror("write index");
+        remove(tmp_fname);
+        return e_failure;
+    }
+    return e_success;
+}
+
+/* Create or refresh index_fname from the BMP files under dir */
+Status do_index_update(const char *index_fname, const char *dir)
+{
+    IndexBuild b;
+    IndexHeader *old_hdr;
+    size_t old_size = 0;
+    Status ret;
+
+    memset(&b, 0, sizeof(b));
+
+    // STEP 1 : Previous index (if any), its records sorted by path for lookups
+    old_hdr = map_index(index_fname, 0, &old_size);
+    if (old_hdr != NULL)
+    {
+        const IndexRecord *recs = (const IndexRecord *)(old_hdr + 1);
+        const char *names = (const char *)old_hdr + old_hdr->names_offset;
+        b.old = malloc((old_hdr->count ? old_hdr->count : 1) * sizeof(*b.old));
+        if (b.old == NULL)
+        {
+            munmap(old_hdr, old_size);
+            return e_failure;
+        }
+        for (uint i = 0; i < old_hdr->count; i++)
+        {
+            b.old[i].name = names + recs[i].name_offset;
+            b.old[i].len = recs[i].name_len;
+            b.old[i].rec = &recs[i];
+        }
+        b.old_count = old_hdr->count;
+        qsort(b.old, b.old_count, sizeof(*b.old), compare_names);
+    }
+
+    // STEP 2 : Walk the library, then write the new index
+    ret = walk_bmp_files(dir, add_carrier, &b);
+    if (ret == e_success)
+    {
+        ret = write_index(index_fname, &b);
+    }
+    if (ret == e_success)
+    {
+        printf("Indexed %zu carriers: %lu unchanged, %lu new or changed, %lu skipped, %lu dropped.\n", b.count, b.reused, b.added,
+               b.skipped, b.old_count - b.matched);
+    }
+
+    free(b.recs);
+    free(b.names);
+    free(b.old);
+    if (old_hdr != NULL)
+    {
+        munmap(old_hdr, old_size);
+    }
+    return ret;
+}
+
+/* Print the smallest unused carrier that fits secret_fname and mark it used */
+Status do_index_pick(const char *index_fname, const char *secret_fname)
+{
+    struct stat st;
+    struct timespec t0, t1;
+    size_t map_size;
+
+    // STEP 1 : Carrier bytes the plain payload of this secret needs (same formula as check_capacity)
+    const char *extn = strrchr(secret_fname, '.');
+    if (stat(secret_fname, &st) != 0)
+    {
+        perror(secret_fname);
+        return e_failure;
+    }
+    unsigned long long required = 54 + strlen(MAGIC_STRING) * 8 + 32 + (extn ? strlen(extn + 1) : 0) * 8 + 32 + (unsigned long long)st.st_size * 8;
+
+    IndexHeader *hdr = map_index(index_fname, 1, &map_size);
+    if (hdr == NULL)
+    {
+        printf("Error: Unable to open carrier index %s.\n", index_fname);
+        return e_failure;
+    }
+    IndexRecord *recs = (IndexRecord *)(hdr + 1);
+    const char *names = (const char *)hdr + hdr->names_offset;
+
+    // STEP 2 : First record whose capacity exceeds the requirement
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+    uint lo = 0, hi = hdr->count;
+    while (lo < hi)
+    {
+        uint mid = lo + (hi - lo) / 2;
+        if (recs[mid].capacity <= required)
+        {
+            lo = mid + 1;
+        }
+        else
+        {
+            hi = mid;
+        }
+    }
+
+    // STEP 3 : From there, the first unused carrier that has not changed since it was indexed
+    IndexRecord *pick = NULL;
+    char path[UINT16_MAX + 1];
+    for (uint i = lo; i < hdr->count && pick == NULL; i++)
+    {
+        if (recs[i].flags & INDEX_USED)
+        {
+            continue;
+        }
+        memcpy(path, names + recs[i].name_offset, recs[i].name_len);
+        path[recs[i].name_len] = '\0';
+        if (stat(path, &st) != 0 || (uint64_t)st.st_size != recs[i].file_size || st.st_mtim.tv_sec != recs[i].mtime_sec ||
+            (uint32_t)st.st_mtim.tv_nsec != recs[i].mtime_nsec)
+        {
+            printf("Warning: %s changed since it was indexed, skipped (run -i again).\n", path);
+            continue;
+        }
+        pick = &recs[i];
+    }
+    clock_gettime(CLOCK_MONOTONIC, &t1);
+
+    // STEP 4 : Mark it used in the mapped index so the next pick moves on
+    Status ret = e_success;
+    if (pick == NULL)
+    {
+        printf("Error: No unused carrier can hold %llu bytes.\n", required);
+        ret = e_failure;
+    }
+    else
+    {
+        pick->flags |= INDEX_USED;
+        printf("%s\n", path);
+        printf("Capacity %llu bytes for %llu required (%ux%u, %u bpp), found in %.1f us.\n", (unsigned long long)pick->capacity, required,
+               pick->width, pick->height, pick->bpp, ((t1.tv_sec - t0.tv_sec) * 1e9 + (t1.tv_nsec - t0.tv_nsec)) / 1e3);
+    }
+    if (munmap(hdr, map_size) != 0)
+    {
+        perror("munmap");
+        ret = e_failure;
+    }
+    return ret;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/* ============================================================================= END OF CODE ===========================================================================*/
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -0,0 +1,92 @@
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// ============================================================== * * * * * index.h * * * * * ========================================================================= //
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/*
+
+### USAGE OF index.h FILE IN STEGANOGRAPHY PROJECT ?
+--> THIS HEADER FILE DECLARES THE PERSISTENT CARRIER INDEX. A LIBRARY OF BMP CARRIERS IS DESCRIBED BY ONE COMPACT BINARY FILE: A HEADER, FIXED SIZE RECORDS SORTED BY
+    CAPACITY AND A TABLE OF PATHS. THE FILE IS MAPPED WITH MMAP AS IS, SO PICKING THE SMALLEST UNUSED CARRIER THAT FITS A PAYLOAD IS A BINARY SEARCH WITHOUT OPENING ANY
+    IMAGE. REBUILDING THE INDEX ONLY READS THE HEADERS OF IMAGES THAT ARE NEW OR WHOSE SIZE / MTIME CHANGED.
+
+*/
+
+// ==================================================================================================================================================================== //
+
+#ifndef INDEX_H
+#define INDEX_H
+
+/* ====================================================================== INCLUDES ==================================================================================== */
+
+#include <stdint.h>
+#include <sys/stat.h>
+#include "types.h"
+
+/* ======================================================================= MACROS ===================================================================================== */
+
+#define INDEX_MAGIC "STGIDX1"       // First 8 bytes of an index file (with the terminating NUL)
+#define INDEX_VERSION 1
+#define INDEX_USED 0x1              // Record flag: carrier already handed out by pick
+
+/* ======================================================================= STRUCTURE ================================================================================== */
+
+/* File header, followed by count records and names_size bytes of paths */
+typedef struct
+{
+    char magic[8];
+    uint32_t version;
+    uint32_t count;             // Records
+    uint64_t names_offset;      // File offset of the path table
+    uint64_t names_size;        // Bytes in the path table
+} IndexHeader;
+
+/* One carrier; records are sorted by capacity, then path */
+typedef struct
+{
+    uint64_t capacity;          // Carrier bytes usable by the encoder (width * height * 3)
+    uint64_t file_size;         // Size when indexed
+    int64_t mtime_sec;          // Modification time when indexed
+    uint32_t mtime_nsec;
+    uint32_t width;
+    uint32_t height;
+    uint32_t pixel_offset;      // BMP bfOffBits
+    uint32_t name_offset;       // Path position in the path table
+    uint16_t name_len;          // Path length (not NUL terminated)
+    uint16_t bpp;               // Bits per pixel
+    uint32_t flags;             // INDEX_USED
+    uint32_t reserved;
+} IndexRecord;
+
+/* Paths of the images named on the command line or found under a named directory */
+typedef struct
+{
+    char **names;
+    int count;
+    int cap;
+} ImageList;
+
+/* Called by walk_bmp_files for every BMP file (st is its lstat) */
+typedef Status (*BmpVisitor)(const char *path, const struct stat *st, void *ctx);
+
+/* ================================================================= FUNCTION PROTOTYPES ============================================================================== */
+
+/* Create or refresh index_fname from the BMP files under dir: -i <carriers.idx> <dir> */
+Status do_index_update(const char *index_fname, const char *dir);
+
+/* Print the smallest unused carrier that fits secret_fname and mark it used: -p <carriers.idx> <secret.txt> */
+Status do_index_pick(const char *index_fname, const char *secret_fname);
+
+/* Visit every regular .bmp file under dir, recursively; symbolic links are skipped, so nothing outside dir is reached */
+Status walk_bmp_files(const char *dir, BmpVisitor visit, void *ctx);
+
+/* Add path to list, or every .bmp file under it when it is a directory */
+Status image_list_add(ImageList *list, const char *path);
+
+/* Free the paths of list */
+void image_list_free(ImageList *list);
+
+#endif
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/* ============================================================================= END OF CODE ===========================================================================*/
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -0,0 +1,626 @@
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// ============================================================ * * * * * ioengine.c * * * * * ======================================================================== //
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/*
+
+### USAGE OF ioengine.c FILE IN STEGANOGRAPHY PROJECT ?
+--> THIS FILE IMPLEMENTS THE BLOCK I/O ENGINE. THE IO_URING PATH TALKS TO THE KERNEL DIRECTLY (io_uring_setup / io_uring_enter / io_uring_register, NO LIBURING NEEDED):
+    BLOCK I LIVES IN BUFFER SLOT I % DEPTH, READS ARE QUEUED AHEAD INTO EVERY FREE SLOT, THE CALLBACK RUNS ON BLOCKS AS SOON AS THEY ARRIVE IN ORDER, AND THE WRITE OF
+    A BLOCK FREES ITS SLOT FOR THE READ DEPTH BLOCKS LATER. THE PORTABLE PATH IS A PREAD / CALLBACK / PWRITE LOOP WITH READ-AHEAD HINTS. BOTH PATHS TAKE TOKENS
+    BEFORE EVERY READ AND WRITE: A BUCKET ONLY STORES THE TIME ITS GRANTED BYTES ARE PAID FOR, SO A GRANT IS ONE COMPARE-AND-SWAP AND THE CALLER SLEEPS OFF ANY DEBT.
+
+*/
+
+/* ====================================================================== INCLUDES ==================================================================================== */
+
+#include <stdio.h>         // printf, perror
+#include <stdlib.h>        // posix_memalign, free, atoi
+#include <string.h>        // memset, strcmp
+#include <errno.h>         // errno
+#include <fcntl.h>         // posix_fadvise
+#include <unistd.h>        // pread, pwrite, geteuid
+#include <time.h>          // clock_gettime, nanosleep
+#include <sys/resource.h>  // setpriority, getpriority, getrlimit
+#include "types.h"         // Status
+#include "common.h"        // OPTION_VALUE
+#include "ioengine.h"      // IoConfig and prototypes
+
+#ifdef __linux__
+#include <sys/mman.h>      // mmap of the rings
+#include <sys/syscall.h>   // __NR_io_uring_*
+#include <sys/uio.h>       // struct iovec
+#include <linux/io_uring.h>
+#define IO_HAVE_URING 1
+#endif
+
+/* ======================================================================= MACROS ===================================================================================== */
+
+#define IO_PRIO_VALUE(class, level) ((class) << 13 | (level))  // ioprio_set() argument
+#define IO_PRIO_WHO_PROCESS 1                                   // ioprio_set() target: one thread (0 = the caller)
+
+/* ======================================================================= STRUCTURE ================================================================================== */
+
+static const char *const io_prio_names[] = { "unchanged", "realtime", "best-effort", "idle" };
+
+/* ================================================================= FUNCTION DEFINITIONS ============================================================================= */
+
+/* Parse one --io, --io-depth or --io-block option */
+Status read_io_option(const char *opt, IoConfig *cfg)
+{
+    const char *value;
+
+    if ((value = OPTION_VALUE(opt, "--io=")) != NULL)
+    {
+        if (strcmp(value, "uring") == 0)
+        {
+            cfg->mode = e_io_uring;
+        }
+        else if (strcmp(value, "sync") == 0)
+        {
+            cfg->mode = e_io_sync;
+        }
+        else if (strcmp(value, "auto") == 0)
+        {
+            cfg->mode = e_io_auto;
+        }
+        else
+        {
+            printf("Error: --io must be 'auto', 'uring' or 'sync'.\n");
+            return e_failure;
+        }
+    }
+    else if ((value = OPTION_VALUE(opt, "--io-depth=")) != NULL)
+    {
+        int depth = atoi(value);
+        if (depth <= 0 || depth > IO_MAX_DEPTH)
+        {
+            printf("Error: --io-depth must be between 1 and %d.\n", IO_MAX_DEPTH);
+            return e_failure;
+        }
+        cfg->queue_depth = depth;
+    }
+    else if ((value = OPTION_VALUE(opt, "--io-block=")) != NULL)
+    {
+        int kib = atoi(value);
+        if (kib <= 0 || kib > 64 * 1024)
+        {
+            printf("Error: --io-block must be between 1 and 65536 KiB.\n");
+            return e_failure;
+        }
+        cfg->block_size = (size_t)kib * 1024;
+    }
+    else if ((value = OPTION_VALUE(opt, "--io-limit=")) != NULL || (value = OPTION_VALUE(opt, "--io-read-limit=")) != NULL ||
+             (value = OPTION_VALUE(opt, "--io-write-limit=")) != NULL)
+    {
+        // Bandwidth cap in MiB/s (fractions allowed) for both directions or one of them
+        char *end;
+        double mib = strtod(value, &end);
+        if (*value == '\0' || *end != '\0' || mib <= 0 || mib > 1048576)
+        {
+            printf("Error: I/O bandwidth limits are positive MiB/s values.\n");
+            return e_failure;
+        }
+        unsigned long long rate = mib * 1048576;
+        if (strncmp(opt, "--io-write", 10) != 0)
+        {
+            cfg->bucket[e_io_read].rate = rate;
+        }
+        if (strncmp(opt, "--io-read", 9) != 0)
+        {
+            cfg->bucket[e_io_write].rate = rate;
+        }
+    }
+    else if ((value = OPTION_VALUE(opt, "--io-prio=")) != NULL)
+    {
+        // Scheduling class, with a level for realtime and best effort
+        const char *level = strchr(value, ':');
+        size_t len = level != NULL ? (size_t)(level - value) : strlen(value);
+        cfg->prio_class = len == 4 && strncmp(value, "idle", 4) == 0 ? 3 :
+                          len == 2 && strncmp(value, "be", 2) == 0 ? 2 :
+                          len == 2 && strncmp(value, "rt", 2) == 0 ? 1 : 0;
+        cfg->prio_level = level != NULL ? atoi(level + 1) : 4;
+        if (cfg->prio_class == 0 || (level != NULL && (cfg->prio_class == 3 || level[1] < '0' || level[1] > '7' || level[2] != '\0')))
+        {
+            printf("Error: --io-prio must be 'idle', 'be[:0-7]' or 'rt[:0-7]'.\n");
+            return e_failure;
+        }
+    }
+    else if ((value = OPTION_VALUE(opt, "--io-nice=")) != NULL)
+    {
+        // CPU niceness, only lowering it needs no privilege
+        char *end;
+        long nice = strtol(value, &end, 10);
+        if (*value == '\0' || *end != '\0' || nice < -20 || nice > 19)
+        {
+            printf("Error: --io-nice must be between -20 and 19.\n");
+            return e_failure;
+        }
+        cfg->nice = nice;
+        cfg->has_nice = 1;
+    }
+    else
+    {
+        printf("Error: Unknown I/O option %s\n", opt);
+        return e_failure;
+    }
+    return e_success;
+}
+
+static long long now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+Status io_apply_policy(IoConfig *cfg)
+{
+    // STEP 1 : Counters of this job, full buckets
+    for (int d = e_io_read; d <= e_io_write; d++)
+    {
+        cfg->bucket[d].paid_ns = 0;
+        cfg->bucket[d].bytes = 0;
+        cfg->bucket[d].throttled_ns = 0;
+        cfg->bucket[d].waits = 0;
+    }
+
+    // STEP 2 : I/O class and CPU niceness of the calling thread (Linux keeps both per thread), the previous ones kept for io_restore_policy
+#if defined(__linux__) && defined(SYS_ioprio_set)
+    if (cfg->prio_class != 0)
+    {
+        int prev = syscall(SYS_ioprio_get, IO_PRIO_WHO_PROCESS, 0);
+        if (prev < 0 || syscall(SYS_ioprio_set, IO_PRIO_WHO_PROCESS, 0, IO_PRIO_VALUE(cfg->prio_class, cfg->prio_class == 3 ? 0 : cfg->prio_level)) != 0)
+        {
+            perror("ioprio_set");
+            return e_failure;
+        }
+        cfg->saved_ioprio = prev;
+        cfg->prio_changed = 1;
+    }
+#else
+    if (cfg->prio_class != 0)
+    {
+        printf("Error: --io-prio is not supported on this system.\n");
+        return e_failure;
+    }
+#endif
+    if (cfg->has_nice)
+    {
+        errno = 0;
+        int prev = getpriority(PRIO_PROCESS, 0);
+        if (prev == -1 && errno != 0)
+        {
+            perror("getpriority");
+            return e_failure;
+        }
+
+        // A worker may only be niced down when it is allowed to come back up (CAP_SYS_NICE or RLIMIT_NICE)
+        struct rlimit rl;
+        if (cfg->restore && cfg->nice > prev && geteuid() != 0 &&
+            (getrlimit(RLIMIT_NICE, &rl) != 0 || (rl.rlim_cur != RLIM_INFINITY && 20 - (long)rl.rlim_cur > prev)))
+        {
+            printf("Error: --io-nice=%d could not be undone on this daemon worker (needs CAP_SYS_NICE or RLIMIT_NICE).\n", cfg->nice);
+            io_restore_policy(cfg);
+            return e_failure;
+        }
+        if (setpriority(PRIO_PROCESS, 0, cfg->nice) != 0)
+        {
+            perror("setpriority");
+            io_restore_policy(cfg);
+            return e_failure;
+        }
+        cfg->saved_nice = prev;
+        cfg->nice_changed = 1;
+    }
+    return e_success;
+}
+
+void io_restore_policy(IoConfig *cfg)
+{
+#if defined(__linux__) && defined(SYS_ioprio_set)
+    if (cfg->prio_changed && syscall(SYS_ioprio_set, IO_PRIO_WHO_PROCESS, 0, cfg->saved_ioprio) != 0)
+    {
+        perror("ioprio_set");
+    }
+#endif
+    if (cfg->nice_changed && setpriority(PRIO_PROCESS, 0, cfg->saved_nice) != 0)
+    {
+        perror("setpriority");
+    }
+    cfg->prio_changed = 0;
+    cfg->nice_changed = 0;
+}
+
+void io_throttle(IoConfig *cfg, IoDirection dir, size_t len)
+{
+    if (cfg == NULL)
+    {
+        return;
+    }
+    IoBucket *b = &cfg->bucket[dir];
+    __atomic_fetch_add(&b->bytes, len, __ATOMIC_RELAXED);
+    if (b->rate == 0)
+    {
+        return;
+    }
+
+    // STEP 1 : Pay for len bytes after what is already granted; an idle bucket only holds IO_BURST_NS of tokens
+    long long cost = (long long)((double)len * 1e9 / b->rate);
+    long long now = now_ns();
+    long long paid = __atomic_load_n(&b->paid_ns, __ATOMIC_RELAXED), next;
+    do
+    {
+        next = (paid > now - IO_BURST_NS ? paid : now - IO_BURST_NS) + cost;
+    } while (!__atomic_compare_exchange_n(&b->paid_ns, &paid, next, 0, __ATOMIC_RELAXED, __ATOMIC_RELAXED));
+
+    // STEP 2 : Sleep off the debt
+    if (next > now)
+    {
+        struct timespec ts = { (next - now) / 1000000000LL, (next - now) % 1000000000LL };
+        while (nanosleep(&ts, &ts) != 0)
+        {
+        }
+        __atomic_fetch_add(&b->throttled_ns, now_ns() - now, __ATOMIC_RELAXED);
+        __atomic_fetch_add(&b->waits, 1, __ATOMIC_RELAXED);
+    }
+}
+
+void io_report(const IoConfig *cfg)
+{
+    const IoBucket *r = &cfg->bucket[e_io_read], *w = &cfg->bucket[e_io_write];
+    char caps[2][32];
+
+    if (r->rate == 0 && w->rate == 0 && cfg->prio_class == 0 && !cfg->has_nice)
+    {
+        return;
+    }
+    for (int d = e_io_read; d <= e_io_write; d++)
+    {
+        if (cfg->bucket[d].rate != 0)
+        {
+            snprintf(caps[d], sizeof(caps[d]), "cap %.1f MiB/s", cfg->bucket[d].rate / 1048576.0);
+        }
+        else
+        {
+            snprintf(caps[d], sizeof(caps[d]), "no cap");
+        }
+    }
+    printf("I/O policy: read %.1f MB (%s, throttled %.3f s in %llu waits), written %.1f MB (%s, throttled %.3f s in %llu waits), ioprio %s",
+           r->bytes / 1e6, caps[e_io_read], r->throttled_ns / 1e9, r->waits, w->bytes / 1e6, caps[e_io_write], w->throttled_ns / 1e9, w->waits,
+           io_prio_names[cfg->prio_class]);
+    if (cfg->prio_class == 1 || cfg->prio_class == 2)
+    {
+        printf(":%d", cfg->prio_level);
+    }
+    if (cfg->has_nice)
+    {
+        printf(", nice %d", cfg->nice);
+    }
+    printf("\n");
+}
+
+/* Read or write all of len bytes at off */
+static Status full_pio(int fd, unsigned char *buf, size_t len, off_t off, int is_write)
+{
+    while (len > 0)
+    {
+        ssize_t done = is_write ? pwrite(fd, buf, len, off) : pread(fd, buf, len, off);
+        if (done <= 0)
+        {
+            if (done < 0)
+            {
+                perror(is_write ? "pwrite" : "pread");
+            }
+            return e_failure;
+        }
+        buf += done;
+        len -= done;
+        off += done;
+    }
+    return e_success;
+}
+
+/* Portable engine: pread, callback, pwrite, with the next blocks hinted to the kernel */
+static Status sync_transform(int in_fd, int out_fd, off_t offset, off_t length, IoBlockFn fn, void *ctx, IoConfig *cfg, size_t bs, uint depth)
+{
+    unsigned char *buf;
+    Status ret = e_success;
+
+    if (posix_memalign((void **)&buf, 4096, bs) != 0)
+    {
+        printf("ERROR! Out of memory for I/O buffer\n");
+        return e_failure;
+    }
+    for (off_t pos = offset; pos < offset + length && ret == e_success; pos += bs)
+    {
+        size_t len = offset + length - pos < (off_t)bs ? (size_t)(offset + length - pos) : bs;
+
+        posix_fadvise(in_fd, pos + len, (off_t)bs * depth, POSIX_FADV_WILLNEED);
+        io_throttle(cfg, e_io_read, len);
+        ret = full_pio(in_fd, buf, len, pos, 0);
+        if (ret == e_success)
+        {
+            ret = fn(buf, len, ctx);
+        }
+        if (ret == e_success && out_fd >= 0)
+        {
+            io_throttle(cfg, e_io_write, len);
+            ret = full_pio(out_fd, buf, len, pos, 1);
+        }
+    }
+    free(buf);
+    return ret;
+}
+
+#ifdef IO_HAVE_URING
+
+/* Submission / completion rings mapped from the kernel */
+typedef struct
+{
+    int fd;
+    unsigned *sq_tail, *sq_mask, *sq_array;
+    unsigned *cq_head, *cq_tail, *cq_mask;
+    struct io_uring_sqe *sqes;
+    struct io_uring_cqe *cqes;
+    void *sq_ptr, *cq_ptr;
+    size_t sq_len, cq_len, sqes_len;
+    unsigned to_submit;
+} Uring;
+
+/* States of a buffer slot */
+enum { e_slot_free, e_slot_reading, e_slot_ready, e_slot_writing };
+
+static void uring_close(Uring *ring)
+{
+    if (ring->sqes != NULL && ring->sqes != MAP_FAILED)
+    {
+        munmap(ring->sqes, ring->sqes_len);
+    }
+    if (ring->cq_ptr != NULL && ring->cq_ptr != MAP_FAILED && ring->cq_ptr != ring->sq_ptr)
+    {
+        munmap(ring->cq_ptr, ring->cq_len);
+    }
+    if (ring->sq_ptr != NULL && ring->sq_ptr != MAP_FAILED)
+    {
+        munmap(ring->sq_ptr, ring->sq_len);
+    }
+    if (ring->fd >= 0)
+    {
+        close(ring->fd);
+    }
+}
+
+/* Create the rings, e_failure if io_uring is unavailable */
+static Status uring_open(Uring *ring, unsigned entries)
+{
+    struct io_uring_params p;
+
+    memset(ring, 0, sizeof(*ring));
+    memset(&p, 0, sizeof(p));
+    ring->fd = syscall(__NR_io_uring_setup, entries, &p);
+    if (ring->fd < 0)
+    {
+        return e_failure;
+    }
+
+    ring->sq_len = p.sq_off.array + p.sq_entries * sizeof(unsigned);
+    ring->cq_len = p.cq_off.cqes + p.cq_entries * sizeof(struct io_uring_cqe);
+    if (p.features & IORING_FEAT_SINGLE_MMAP)
+    {
+        ring->sq_len = ring->cq_len = ring->sq_len > ring->cq_len ? ring->sq_len : ring->cq_len;
+    }
+    ring->sq_ptr = mmap(NULL, ring->sq_len, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring->fd, IORING_OFF_SQ_RING);
+    ring->cq_ptr = (p.features & IORING_FEAT_SINGLE_MMAP) ? ring->sq_ptr :
+                   mmap(NULL, ring->cq_len, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring->fd, IORING_OFF_CQ_RING);
+    ring->sqes_len = p.sq_entries * sizeof(struct io_uring_sqe);
+    ring->sqes = mmap(NULL, ring->sqes_len, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring->fd, IORING_OFF_SQES);
+    if (ring->sq_ptr == MAP_FAILED || ring->cq_ptr == MAP_FAILED || ring->sqes == MAP_FAILED)
+    {
+        uring_close(ring);
+        return e_failure;
+    }
+
+    char *sq = ring->sq_ptr, *cq = ring->cq_ptr;
+    ring->sq_tail = (unsigned *)(sq + p.sq_off.tail);
+    ring->sq_mask = (unsigned *)(sq + p.sq_off.ring_mask);
+    ring->sq_array = (unsigned *)(sq + p.sq_off.array);
+    ring->cq_head = (unsigned *)(cq + p.cq_off.head);
+    ring->cq_tail = (unsigned *)(cq + p.cq_off.tail);
+    ring->cq_mask = (unsigned *)(cq + p.cq_off.ring_mask);
+    ring->cqes = (struct io_uring_cqe *)(cq + p.cq_off.cqes);
+    return e_success;
+}
+
+/* Queue one read or write of a slot buffer */
+static void uring_queue(Uring *ring, int fd, int is_write, int fixed, unsigned slot, unsigned char *buf, size_t len, off_t off)
+{
+    unsigned tail = *ring->sq_tail;
+    unsigned idx = tail & *ring->sq_mask;
+    struct io_uring_sqe *sqe = &ring->sqes[idx];
+
+    memset(sqe, 0, sizeof(*sqe));
+    if (fixed)
+    {
+        sqe->opcode = is_write ? IORING_OP_WRITE_FIXED : IORING_OP_READ_FIXED;
+        sqe->buf_index = slot;
+    }
+    else
+    {
+        sqe->opcode = is_write ? IORING_OP_WRITE : IORING_OP_READ;
+    }
+    sqe->fd = fd;
+    sqe->addr = (unsigned long)buf;
+    sqe->len = len;
+    sqe->off = off;
+    sqe->user_data = (unsigned long long)slot << 1 | is_write;
+    ring->sq_array[idx] = idx;
+    __atomic_store_n(ring->sq_tail, tail + 1, __ATOMIC_RELEASE);
+    ring->to_submit++;
+}
+
+/* io_uring engine on an open ring (closed on return): reads run ahead into free slots, writes drain behind the callback */
+static Status uring_transform(Uring *ring, int in_fd, int out_fd, off_t offset, off_t length, IoBlockFn fn, void *ctx, IoConfig *cfg, size_t bs,
+                              uint depth)
+{
+    unsigned char *pool;
+    unsigned char state[IO_MAX_DEPTH];
+    size_t slot_len[IO_MAX_DEPTH];
+    struct iovec iov[IO_MAX_DEPTH];
+    unsigned long long nblocks = (length + bs - 1) / bs, next_read = 0, next_fn = 0;
+    unsigned inflight = 0;
+    int failed = 0;
+
+    if (posix_memalign((void **)&pool, 4096, bs * depth) != 0)
+    {
+        printf("ERROR! Out of memory for I/O buffers\n");
+        uring_close(ring);
+        return e_failure;
+    }
+
+    // Registered buffers save the per request page pinning; plain READ / WRITE if the memlock limit refuses them
+    for (uint i = 0; i < depth; i++)
+    {
+        iov[i].iov_base = pool + i * bs;
+        iov[i].iov_len = bs;
+        state[i] = e_slot_free;
+    }
+    int fixed = syscall(__NR_io_uring_register, ring->fd, IORING_REGISTER_BUFFERS, iov, depth) == 0;
+
+    while (1)
+    {
+        // STEP 1 : Queue reads for upcoming blocks into every free slot
+        while (!failed && next_read < nblocks && state[next_read % depth] == e_slot_free)
+        {
+            unsigned slot = next_read % depth;
+            off_t pos = offset + (off_t)(next_read * bs);
+            size_t len = offset + length - pos < (off_t)bs ? (size_t)(offset + length - pos) : bs;
+            io_throttle(cfg, e_io_read, len);
+            uring_queue(ring, in_fd, 0, fixed, slot, pool + slot * bs, len, pos);
+            slot_len[slot] = len;
+            state[slot] = e_slot_reading;
+            inflight++;
+            next_read++;
+        }
+
+        // STEP 2 : Run the callback on blocks that arrived, in order, and queue their writes
+        while (!failed && next_fn < nblocks && state[next_fn % depth] == e_slot_ready)
+        {
+            unsigned slot = next_fn % depth;
+            off_t pos = offset + (off_t)(next_fn * bs);
+            size_t len = offset + length - pos < (off_t)bs ? (size_t)(offset + length - pos) : bs;
+            if (fn(pool + slot * bs, len, ctx) == e_failure)
+            {
+                failed = 1;
+                break;
+            }
+            if (out_fd >= 0)
+            {
+                io_throttle(cfg, e_io_write, len);
+                uring_queue(ring, out_fd, 1, fixed, slot, pool + slot * bs, len, pos);
+                state[slot] = e_slot_writing;
+                inflight++;
+            }
+            else
+            {
+                state[slot] = e_slot_free;
+            }
+            next_fn++;
+        }
+
+        if (inflight == 0 && (failed || next_fn == nblocks))
+        {
+            break;
+        }
+        if (ring->to_submit == 0 && inflight == 0)
+        {
+            // Without an output every consumed slot is free again at once: refill before waiting
+            continue;
+        }
+
+        // STEP 3 : Submit what was queued and wait for at least one completion
+        if (syscall(__NR_io_uring_enter, ring->fd, ring->to_submit, 1, IORING_ENTER_GETEVENTS, NULL, 0) < 0)
+        {
+            // Requests may still be in flight into pool, so it is not freed on this path
+            perror("io_uring_enter");
+            uring_close(ring);
+            return e_failure;
+        }
+        ring->to_submit = 0;
+
+        // STEP 4 : Reap completions, a short transfer means the carrier ended early
+        unsigned head = *ring->cq_head;
+        unsigned tail = __atomic_load_n(ring->cq_tail, __ATOMIC_ACQUIRE);
+        for (; head != tail; head++)
+        {
+            struct io_uring_cqe *cqe = &ring->cqes[head & *ring->cq_mask];
+            unsigned slot = cqe->user_data >> 1;
+            int is_write = cqe->user_data & 1;
+
+            if (cqe->res < 0)
+            {
+                printf("ERROR! io_uring %s failed: %s\n", is_write ? "write" : "read", strerror(-cqe->res));
+                failed = 1;
+            }
+            else if ((size_t)cqe->res != slot_len[slot])
+            {
+                printf("ERROR! Short %s, carrier ended early\n", is_write ? "write" : "read");
+                failed = 1;
+            }
+            state[slot] = is_write ? e_slot_free : e_slot_ready;
+            inflight--;
+        }
+        __atomic_store_n(ring->cq_head, head, __ATOMIC_RELEASE);
+    }
+
+    free(pool);
+    uring_close(ring);
+    return failed ? e_failure : e_success;
+}
+
+#endif
+
+/* Stream in_fd[offset, offset + length) through fn; write each block to out_fd at the same offset unless out_fd < 0 */
+Status io_transform_range(int in_fd, int out_fd, off_t offset, off_t length, IoBlockFn fn, void *ctx, IoConfig *cfg, const char **engine)
+{
+    size_t bs = cfg->block_size ? cfg->block_size : IO_DEFAULT_BLOCK;
+    uint depth = cfg->queue_depth ? cfg->queue_depth : IO_DEFAULT_DEPTH;
+
+    // Blocks must hold whole payload bytes (8 carrier bytes each)
+    bs &= ~(size_t)7;
+    if (length <= 0)
+    {
+        *engine = "none";
+        return e_success;
+    }
+
+#ifdef IO_HAVE_URING
+    if (cfg->mode != e_io_sync)
+    {
+        Uring ring;
+        if (uring_open(&ring, depth) == e_success)
+        {
+            *engine = "io_uring";
+            return uring_transform(&ring, in_fd, out_fd, offset, length, fn, ctx, cfg, bs, depth);
+        }
+        if (cfg->mode == e_io_uring)
+        {
+            printf("ERROR! io_uring is not available on this system\n");
+            return e_failure;
+        }
+    }
+#else
+    if (cfg->mode == e_io_uring)
+    {
+        printf("ERROR! io_uring is not available on this system\n");
+        return e_failure;
+    }
+#endif
+
+    *engine = "pread/pwrite";
+    return sync_transform(in_fd, out_fd, offset, length, fn, ctx, cfg, bs, depth);
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/* ============================================================================= END OF CODE ===========================================================================*/
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -0,0 +1,108 @@
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// ============================================================ * * * * * ioengine.h * * * * * ======================================================================== //
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/*
+
+### USAGE OF ioengine.h FILE IN STEGANOGRAPHY PROJECT ?
+--> THIS HEADER FILE DECLARES THE BLOCK I/O ENGINE USED FOR THE BULK OF THE CARRIER (THE BYTES HOLDING THE SECRET FILE DATA). A BYTE RANGE OF THE CARRIER IS READ IN LARGE
+    BLOCKS, EACH BLOCK IS HANDED TO A CALLBACK (EMBED OR EXTRACT) IN ORDER, AND, WHEN AN OUTPUT IS GIVEN, WRITTEN BACK AT THE SAME OFFSET. ON LINUX THE ENGINE USES
+    IO_URING WITH REGISTERED BUFFERS AND KEEPS A QUEUE OF READS AND WRITES IN FLIGHT WHILE THE CALLBACK WORKS; ELSEWHERE (OR WITH --io=sync) IT USES PREAD / PWRITE.
+    BACKGROUND JOBS CAN CAP THEIR READ AND WRITE BANDWIDTH (ONE TOKEN BUCKET PER DIRECTION, SHARED BY EVERY BULK TRANSFER OF THE JOB) AND LOWER THEIR I/O PRIORITY
+    AND CPU NICENESS; THE TIME SPENT WAITING FOR TOKENS IS COUNTED AND REPORTED AT THE END OF THE JOB.
+
+*/
+
+// ==================================================================================================================================================================== //
+
+#ifndef IOENGINE_H
+#define IOENGINE_H
+
+/* ====================================================================== INCLUDES ==================================================================================== */
+
+#include <stddef.h>
+#include <sys/types.h>
+#include "types.h"
+
+/* ======================================================================= MACROS ===================================================================================== */
+
+#define IO_DEFAULT_DEPTH 8              // Blocks in flight
+#define IO_DEFAULT_BLOCK (256 * 1024)   // Bytes per read / write
+#define IO_MAX_DEPTH 256                // Largest accepted --io-depth
+#define IO_BURST_NS 100000000LL         // An idle bucket holds at most 100 ms of tokens
+
+/* ======================================================================= STRUCTURE ================================================================================== */
+
+//enum to represent the I/O engine requested on the command line
+typedef enum
+{
+    e_io_auto,   //io_uring when the kernel allows it, else pread/pwrite ->> default
+    e_io_uring,  //io_uring only ->> (--io=uring)
+    e_io_sync    //pread/pwrite only ->> (--io=sync)
+} IoMode;
+
+//enum to index the token bucket of a transfer direction
+typedef enum
+{
+    e_io_read,
+    e_io_write
+} IoDirection;
+
+/* Token bucket of one direction, kept as the time at which every byte granted so far is paid for (lock free) */
+typedef struct
+{
+    unsigned long long rate;            // Bytes per second, 0 = unlimited (--io-read-limit= / --io-write-limit= in MiB/s)
+    long long paid_ns;                  // CLOCK_MONOTONIC time the granted bytes are paid for
+    unsigned long long bytes;           // Bytes granted
+    unsigned long long throttled_ns;    // Time spent waiting for tokens
+    unsigned long long waits;           // Transfers that had to wait
+} IoBucket;
+
+/* I/O engine settings, zero means default */
+typedef struct _IoConfig
+{
+    IoMode mode;        // Engine requested with --io=
+    uint queue_depth;   // Blocks in flight (--io-depth=)
+    size_t block_size;  // Bytes per block (--io-block= in KiB), always a multiple of 8
+    IoBucket bucket[2]; // Bandwidth caps and counters, indexed by IoDirection
+    int prio_class;     // I/O scheduling class from --io-prio= (1 = realtime, 2 = best effort, 3 = idle), 0 = unchanged
+    int prio_level;     // Level 0 (highest) to 7 inside the realtime and best effort classes
+    int has_nice;       // --io-nice=N given
+    int nice;           // CPU niceness of the job
+    int restore;        // Daemon job: the worker thread gets its class and niceness back from io_restore_policy
+    int prio_changed;   // io_apply_policy changed the I/O class, saved_ioprio holds the previous one
+    int saved_ioprio;
+    int nice_changed;   // io_apply_policy changed the niceness, saved_nice holds the previous one
+    int saved_nice;
+} IoConfig;
+
+/* Callback run on every block, in file order; it may change the block in place before it is written */
+typedef Status (*IoBlockFn)(unsigned char *block, size_t len, void *ctx);
+
+/* ================================================================= FUNCTION PROTOTYPES ============================================================================== */
+
+/* Parse one --io, --io-depth, --io-block, --io-limit, --io-read-limit, --io-write-limit, --io-prio or --io-nice option */
+Status read_io_option(const char *opt, IoConfig *cfg);
+
+/* Start the job's I/O policy: empty the counters, fill the buckets and apply --io-prio / --io-nice to the calling thread */
+Status io_apply_policy(IoConfig *cfg);
+
+/* Give the calling thread back the I/O class and niceness io_apply_policy replaced (pooled daemon workers outlive their jobs) */
+void io_restore_policy(IoConfig *cfg);
+
+/* Take len bytes from the bucket of dir, sleeping until they are paid for (no wait without a cap; cfg may be NULL) */
+void io_throttle(IoConfig *cfg, IoDirection dir, size_t len);
+
+/* Bytes moved, caps, time throttled and priority of the job (nothing when no policy option was given) */
+void io_report(const IoConfig *cfg);
+
+/* Stream in_fd[offset, offset + length) through fn; write each block to out_fd at the same offset unless out_fd < 0
+ * engine is set to the name of the engine that ran; every read and write is paced by the buckets of cfg
+ */
+Status io_transform_range(int in_fd, int out_fd, off_t offset, off_t length, IoBlockFn fn, void *ctx, IoConfig *cfg, const char **engine);
+
+#endif
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/* ============================================================================= END OF CODE ===========================================================================*/
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
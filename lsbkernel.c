@@ -0,0 +1,370 @@
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// ============================================================ * * * * * lsbkernel.c * * * * * ======================================================================= //
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/*
+
+### USAGE OF lsbkernel.c FILE IN STEGANOGRAPHY PROJECT ?
+--> THIS FILE GENERATES THE LSB REPLACEMENT KERNELS. embed_units() AND extract_units() ARE WRITTEN ONCE FOR ANY FORMAT AND ALWAYS INLINED; LSB_KERNELS() LISTS THE
+    SUPPORTED FORMATS AND EXPANDS TWICE, ONCE INTO A PAIR OF FUNCTIONS THAT CALL THEM WITH CONSTANT ARGUMENTS (SO THE COMPILER FOLDS THE CHANNEL TESTS AWAY AND
+    UNROLLS THE LOOP OVER THE SAMPLES OF A UNIT) AND ONCE INTO THE DISPATCH TABLE. ONE BIT FORMATS WITH EVERY BYTE CARRYING PAYLOAD SPREAD / GATHER A PAYLOAD BYTE
+    OVER 8 CARRIER BYTES WITH ONE 64 BIT MULTIPLY.
+
+*/
+
+/* ====================================================================== INCLUDES ==================================================================================== */
+
+#include <stdio.h>         // printf
+#include <stdlib.h>        // malloc, free, atoi
+#include <stdint.h>        // uint32_t, uint64_t
+#include <string.h>        // memcpy, memcmp
+#include <time.h>          // clock_gettime
+#include "common.h"        // OPTION_VALUE
+#include "encode.h"        // encode_byte_to_lsb (per byte loop in the benchmark)
+#include "decode.h"        // decode_byte_from_lsb
+#include "lsbkernel.h"     // Prototypes
+
+/* ======================================================================= MACROS ===================================================================================== */
+
+#define LSB_CHANNELS(mask) (((mask) & 1) + (((mask) >> 1) & 1) + (((mask) >> 2) & 1) + (((mask) >> 3) & 1))
+#define LSB_SWAR (__BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__)   // 64 bit loads put carrier byte j in bits 8j..8j+7
+
+#define LSB_ONES 0x0101010101010101ULL
+
+/* name, bits, bytes per pixel, channel mask, payload bytes per unit, pixels per unit */
+#define LSB_KERNELS(X)                          \
+    X(bgr24_k1,  1, 3, LSB_MASK_BGR,  3, 8)     \
+    X(bgr24_k2,  2, 3, LSB_MASK_BGR,  3, 4)     \
+    X(bgr24_k4,  4, 3, LSB_MASK_BGR,  3, 2)     \
+    X(bgr24_b1,  1, 3, LSB_MASK_B,    1, 8)     \
+    X(bgr24_bg1, 1, 3, LSB_MASK_BG,   1, 4)     \
+    X(bgr24_b2,  2, 3, LSB_MASK_B,    1, 4)     \
+    X(bgr24_b4,  4, 3, LSB_MASK_B,    1, 2)     \
+    X(bgr24_bg2, 2, 3, LSB_MASK_BG,   1, 2)     \
+    X(bgr24_bg4, 4, 3, LSB_MASK_BG,   1, 1)     \
+    X(bgrx32_k1, 1, 4, LSB_MASK_BGR,  3, 8)     \
+    X(bgrx32_k2, 2, 4, LSB_MASK_BGR,  3, 4)     \
+    X(bgrx32_k4, 4, 4, LSB_MASK_BGR,  3, 2)     \
+    X(bgra32_k1, 1, 4, LSB_MASK_BGRA, 1, 2)     \
+    X(bgra32_k2, 2, 4, LSB_MASK_BGRA, 1, 1)     \
+    X(bgra32_k4, 4, 4, LSB_MASK_BGRA, 2, 1)
+
+/* ================================================================= FUNCTION DEFINITIONS ============================================================================= */
+
+/* Byte j of the result is bit 7 - j of b */
+static inline uint64_t spread_bits(unsigned char b)
+{
+    uint64_t x = (b * LSB_ONES) & 0x0102040810204080ULL;
+    return ((x + 0x7F7F7F7F7F7F7F7FULL) >> 7) & LSB_ONES;
+}
+
+/* Bit 7 - j of the result is the LSB of byte j (the partial products never overlap, so nothing carries) */
+static inline unsigned char gather_bits(uint64_t x)
+{
+    return ((x & LSB_ONES) * 0x8040201008040201ULL) >> 56;
+}
+
+/* Template of every embed kernel: called with constants only, specialised by inlining */
+static inline __attribute__((always_inline)) void embed_units(unsigned char *carrier, const unsigned char *payload, size_t units, const uint bits,
+                                                              const uint bpp, const uint mask, const uint unit_bytes, const uint unit_pixels)
+{
+    const unsigned char low = (1u << bits) - 1;
+
+    for (size_t u = 0; u < units; u++, carrier += unit_pixels * bpp, payload += unit_bytes)
+    {
+        if (LSB_SWAR && bits == 1 && LSB_CHANNELS(mask) == bpp)
+        {
+            // Every carrier byte carries one bit: 8 carrier bytes per payload byte
+#pragma GCC unroll 8
+            for (uint i = 0; i < unit_bytes; i++)
+            {
+                uint64_t c;
+                memcpy(&c, carrier + i * 8, 8);
+                c = (c & ~LSB_ONES) | spread_bits(payload[i]);
+                memcpy(carrier + i * 8, &c, 8);
+            }
+            continue;
+        }
+
+        // STEP 1 : Payload bits of the unit, MSB first
+        uint32_t word = 0;
+#pragma GCC unroll 8
+        for (uint i = 0; i < unit_bytes; i++)
+        {
+            word = word << 8 | payload[i];
+        }
+
+        // STEP 2 : The next bits into every carrying sample
+        uint shift = unit_bytes * 8;
+#pragma GCC unroll 64
+        for (uint s = 0; s < unit_pixels * bpp; s++)
+        {
+            if ((mask >> (s % bpp)) & 1)
+            {
+                shift -= bits;
+                carrier[s] = (carrier[s] & ~low) | ((word >> shift) & low);
+            }
+        }
+    }
+}
+
+/* Template of every extract kernel */
+static inline __attribute__((always_inline)) void extract_units(const unsigned char *carrier, unsigned char *payload, size_t units, const uint bits,
+                                                                const uint bpp, const uint mask, const uint unit_bytes, const uint unit_pixels)
+{
+    const unsigned char low = (1u << bits) - 1;
+
+    for (size_t u = 0; u < units; u++, carrier += unit_pixels * bpp, payload += unit_bytes)
+    {
+        if (LSB_SWAR && bits == 1 && LSB_CHANNELS(mask) == bpp)
+        {
+#pragma GCC unroll 8
+            for (uint i = 0; i < unit_bytes; i++)
+            {
+                uint64_t c;
+                memcpy(&c, carrier + i * 8, 8);
+                payload[i] = gather_bits(c);
+            }
+            continue;
+        }
+
+        // STEP 1 : Bits of every carrying sample, in order
+        uint32_t word = 0;
+#pragma GCC unroll 64
+        for (uint s = 0; s < unit_pixels * bpp; s++)
+        {
+            if ((mask >> (s % bpp)) & 1)
+            {
+                word = word << bits | (carrier[s] & low);
+            }
+        }
+
+        // STEP 2 : Back to payload bytes
+#pragma GCC unroll 8
+        for (uint i = unit_bytes; i-- > 0; word >>= 8)
+        {
+            payload[i] = word;
+        }
+    }
+}
+
+/* One kernel pair per format */
+#define LSB_INSTANTIATE(name, bits, bpp, mask, unit_bytes, unit_pixels)                                                  \
+    _Static_assert((unit_bytes) * 8 == (unit_pixels) * (bits) * LSB_CHANNELS(mask), #name ": a unit must fill its pixels"); \
+    static void embed_##name(unsigned char *carrier, const unsigned char *payload, size_t units)                         \
+    {                                                                                                                    \
+        embed_units(carrier, payload, units, bits, bpp, mask, unit_bytes, unit_pixels);                                  \
+    }                                                                                                                    \
+    static void extract_##name(const unsigned char *carrier, unsigned char *payload, size_t units)                       \
+    {                                                                                                                    \
+        extract_units(carrier, payload, units, bits, bpp, mask, unit_bytes, unit_pixels);                                \
+    }
+
+#define LSB_TABLE_ENTRY(name, bits, bpp, mask, unit_bytes, unit_pixels) \
+    { #name, bits, bpp, mask, unit_bytes, unit_pixels, embed_##name, extract_##name },
+
+LSB_KERNELS(LSB_INSTANTIATE)
+
+static const LsbKernel lsb_kernels[] = { LSB_KERNELS(LSB_TABLE_ENTRY) };
+
+const LsbKernel *lsb_kernel_select(uint bits, uint bpp, uint mask)
+{
+    for (size_t i = 0; i < sizeof(lsb_kernels) / sizeof(lsb_kernels[0]); i++)
+    {
+        if (lsb_kernels[i].bits == bits && lsb_kernels[i].bpp == bpp && lsb_kernels[i].mask == mask)
+        {
+            return &lsb_kernels[i];
+        }
+    }
+    return NULL;
+}
+
+void lsb_generic_embed(const LsbKernel *k, unsigned char *carrier, const unsigned char *payload, size_t count)
+{
+    unsigned char low = (1u << k->bits) - 1;
+    size_t s = 0;
+
+    // bits divides 8, so the bits of a sample never straddle two payload bytes
+    for (size_t i = 0; i < count; i++)
+    {
+        for (int shift = 8 - k->bits; shift >= 0; s++)
+        {
+            if ((k->mask >> (s % k->bpp)) & 1)
+            {
+                carrier[s] = (carrier[s] & ~low) | ((payload[i] >> shift) & low);
+                shift -= k->bits;
+            }
+        }
+    }
+}
+
+void lsb_generic_extract(const LsbKernel *k, const unsigned char *carrier, unsigned char *payload, size_t count)
+{
+    unsigned char low = (1u << k->bits) - 1;
+    size_t s = 0;
+
+    for (size_t i = 0; i < count; i++)
+    {
+        unsigned char byte = 0;
+        for (uint got = 0; got < 8; s++)
+        {
+            if ((k->mask >> (s % k->bpp)) & 1)
+            {
+                byte = byte << k->bits | (carrier[s] & low);
+                got += k->bits;
+            }
+        }
+        payload[i] = byte;
+    }
+}
+
+void lsb_kernel_embed(const LsbKernel *k, unsigned char *carrier, const unsigned char *payload, size_t count)
+{
+    size_t units = count / k->unit_bytes;
+
+    k->embed(carrier, payload, units);
+    lsb_generic_embed(k, carrier + units * k->unit_pixels * k->bpp, payload + units * k->unit_bytes, count % k->unit_bytes);
+}
+
+void lsb_kernel_extract(const LsbKernel *k, const unsigned char *carrier, unsigned char *payload, size_t count)
+{
+    size_t units = count / k->unit_bytes;
+
+    k->extract(carrier, payload, units);
+    lsb_generic_extract(k, carrier + units * k->unit_pixels * k->bpp, payload + units * k->unit_bytes, count % k->unit_bytes);
+}
+
+static double now_s(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+/* The per byte loops of encode.c / decode.c on a one bit BGR24 carrier, for comparison with bgr24_k1 */
+static void per_byte_embed(const LsbKernel *k, unsigned char *carrier, const unsigned char *payload, size_t count)
+{
+    (void)k;
+    for (size_t i = 0; i < count; i++)
+    {
+        encode_byte_to_lsb(payload[i], (char *)carrier + i * 8);
+    }
+}
+
+static void per_byte_extract(const LsbKernel *k, const unsigned char *carrier, unsigned char *payload, size_t count)
+{
+    (void)k;
+    for (size_t i = 0; i < count; i++)
+    {
+        payload[i] = decode_byte_from_lsb((char *)carrier + i * 8);
+    }
+}
+
+/* Best embed and extract times of one reference loop and of the kernel on the same data; the outputs must agree */
+static Status bench_kernel(const char *label, const LsbKernel *k, int repeat, unsigned char *carrier, unsigned char *ref, const unsigned char *payload,
+                           unsigned char *out, unsigned char *ref_out, size_t units,
+                           void (*embed_ref)(const LsbKernel *, unsigned char *, const unsigned char *, size_t),
+                           void (*extract_ref)(const LsbKernel *, const unsigned char *, unsigned char *, size_t))
+{
+    size_t len = units * k->unit_pixels * k->bpp, count = units * k->unit_bytes;
+    double t[4] = { 1e30, 1e30, 1e30, 1e30 };
+
+    memcpy(ref, carrier, len);
+    for (int r = 0; r < repeat; r++)
+    {
+        double t0 = now_s();
+        embed_ref(k, ref, payload, count);
+        double t1 = now_s();
+        k->embed(carrier, payload, units);
+        double t2 = now_s();
+        extract_ref(k, ref, ref_out, count);
+        double t3 = now_s();
+        k->extract(carrier, out, units);
+        double t4 = now_s();
+
+        t[0] = t1 - t0 < t[0] ? t1 - t0 : t[0];
+        t[1] = t2 - t1 < t[1] ? t2 - t1 : t[1];
+        t[2] = t3 - t2 < t[2] ? t3 - t2 : t[2];
+        t[3] = t4 - t3 < t[3] ? t4 - t3 : t[3];
+    }
+    if (memcmp(ref, carrier, len) != 0 || memcmp(ref_out, payload, count) != 0 || memcmp(out, payload, count) != 0)
+    {
+        printf("Error: Kernel %s does not match the reference loop\n", k->name);
+        return e_failure;
+    }
+
+    printf("%-22s %4u %3u  0x%X  %9.0f %9.0f %6.2fx   %9.0f %9.0f %6.2fx\n", label, k->bits, k->bpp, k->mask, len / 1e6 / t[0], len / 1e6 / t[1],
+           t[0] / t[1], len / 1e6 / t[2], len / 1e6 / t[3], t[2] / t[3]);
+    return e_success;
+}
+
+Status do_kernel_bench(const char *mib, int opt_count, char *opts[])
+{
+    const char *value;
+    int repeat = 3;
+    size_t size = (size_t)atoi(mib) << 20;
+
+    // STEP 1 : Options
+    if (atoi(mib) <= 0 || atoi(mib) > 4096)
+    {
+        printf("Error: Benchmark size must be between 1 and 4096 MiB\n");
+        return e_failure;
+    }
+    for (int i = 0; i < opt_count; i++)
+    {
+        if ((value = OPTION_VALUE(opts[i], "--repeat=")) != NULL && atoi(value) > 0)
+        {
+            repeat = atoi(value);
+        }
+        else
+        {
+            printf("Error: Unknown benchmark option %s\n", opts[i]);
+            return e_failure;
+        }
+    }
+
+    // STEP 2 : Random carrier and payload (a payload byte needs at least 2 carrier bytes)
+    unsigned char *carrier = malloc(size), *ref = malloc(size), *payload = malloc(size / 2), *out = malloc(size / 2), *ref_out = malloc(size / 2);
+    Status ret = carrier && ref && payload && out && ref_out ? e_success : e_failure;
+    uint64_t x = 0x9E3779B97F4A7C15ULL;
+    for (size_t i = 0; ret == e_success && i < size; i++)
+    {
+        x ^= x << 13;
+        x ^= x >> 7;
+        x ^= x << 17;
+        carrier[i] = x;
+        if (i < size / 2)
+        {
+            payload[i] = x >> 32;
+        }
+    }
+
+    // STEP 3 : Every kernel against the generic loop, the default format also against the per byte loop
+    printf("%-22s %4s %3s %5s  %9s %9s %7s   %9s %9s %7s\n", "Kernel (carrier MB/s)", "bits", "bpp", "mask", "embed ref", "kernel", "speedup",
+           "extr. ref", "kernel", "speedup");
+    for (size_t i = 0; ret == e_success && i < sizeof(lsb_kernels) / sizeof(lsb_kernels[0]); i++)
+    {
+        const LsbKernel *k = &lsb_kernels[i];
+        size_t units = size / (k->unit_pixels * k->bpp);
+        ret = bench_kernel(k->name, k, repeat, carrier, ref, payload, out, ref_out, units, lsb_generic_embed, lsb_generic_extract);
+        if (ret == e_success && k == lsb_kernel_select(1, 3, LSB_MASK_BGR))
+        {
+            ret = bench_kernel("bgr24_k1 vs per byte", k, repeat, carrier, ref, payload, out, ref_out, units, per_byte_embed, per_byte_extract);
+        }
+    }
+
+    free(carrier);
+    free(ref);
+    free(payload);
+    free(out);
+    free(ref_out);
+    if (ret == e_failure)
+    {
+        printf("Error: Benchmark failed\n");
+    }
+    return ret;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/* ============================================================================= END OF CODE ===========================================================================*/
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
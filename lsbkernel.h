@@ -0,0 +1,71 @@
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// ============================================================ * * * * * lsbkernel.h * * * * * ======================================================================= //
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/*
+
+### USAGE OF lsbkernel.h FILE IN STEGANOGRAPHY PROJECT ?
+--> THIS HEADER FILE DECLARES THE FAMILY OF SPECIALISED LSB REPLACEMENT KERNELS. A CARRIER FORMAT IS DESCRIBED BY THE PAYLOAD BITS PER SAMPLE (1, 2 OR 4 LSBS), THE
+    BYTES PER PIXEL (3 = BGR24, 4 = BGRA32) AND THE CHANNEL MASK (WHICH BYTES OF A PIXEL CARRY PAYLOAD, E.G. BGRA32 WITH THE ALPHA BYTE SKIPPED). EVERY SUPPORTED
+    COMBINATION IS GENERATED AT COMPILE TIME FROM ONE MACRO, SO ITS INNER LOOP IS FULLY UNROLLED WITH NO TEST OF THE FORMAT LEFT IN IT; A JOB LOOKS ITS KERNEL UP IN
+    THE DISPATCH TABLE ONCE AND CALLS IT FOR EVERY BLOCK. THE RUNTIME GENERIC LOOP IS KEPT AS THE REFERENCE AND FOR THE BENCHMARK MODE (-b).
+
+*/
+
+// ==================================================================================================================================================================== //
+
+#ifndef LSBKERNEL_H
+#define LSBKERNEL_H
+
+/* ====================================================================== INCLUDES ==================================================================================== */
+
+#include <stddef.h>
+#include "types.h"
+
+/* ======================================================================= MACROS ===================================================================================== */
+
+#define LSB_MASK_B 0x1          // Channel masks: bit c set = byte c of the pixel carries payload
+#define LSB_MASK_BG 0x3
+#define LSB_MASK_BGR 0x7        // Every byte of a BGR24 pixel, or BGRA32 with the alpha byte skipped
+#define LSB_MASK_BGRA 0xF
+
+/* ======================================================================= STRUCTURE ================================================================================== */
+
+/* Kernels for whole units: unit_bytes payload bytes into / out of unit_pixels pixels */
+typedef void (*LsbEmbedFn)(unsigned char *carrier, const unsigned char *payload, size_t units);
+typedef void (*LsbExtractFn)(const unsigned char *carrier, unsigned char *payload, size_t units);
+
+/* One entry of the dispatch table */
+typedef struct
+{
+    const char *name;
+    uint bits;              // Payload bits per carrying sample, MSB first
+    uint bpp;               // Carrier bytes per pixel
+    uint mask;              // LSB_MASK_* channels carrying payload
+    uint unit_bytes;        // Payload bytes per unit
+    uint unit_pixels;       // Pixels per unit (unit_bytes * 8 bits exactly fill them)
+    LsbEmbedFn embed;
+    LsbExtractFn extract;
+} LsbKernel;
+
+/* ================================================================= FUNCTION PROTOTYPES ============================================================================== */
+
+/* Kernel of a carrier format, NULL when the combination is not instantiated */
+const LsbKernel *lsb_kernel_select(uint bits, uint bpp, uint mask);
+
+/* Embed / extract count payload bytes: whole units through the specialised kernel, the rest through the generic loop */
+void lsb_kernel_embed(const LsbKernel *k, unsigned char *carrier, const unsigned char *payload, size_t count);
+void lsb_kernel_extract(const LsbKernel *k, const unsigned char *carrier, unsigned char *payload, size_t count);
+
+/* Generic loop reading bits, bpp and mask at runtime, same bytes as the kernels */
+void lsb_generic_embed(const LsbKernel *k, unsigned char *carrier, const unsigned char *payload, size_t count);
+void lsb_generic_extract(const LsbKernel *k, const unsigned char *carrier, unsigned char *payload, size_t count);
+
+/* Time every kernel against the generic loop on mib MiB of carrier (--repeat=N runs, best kept) */
+Status do_kernel_bench(const char *mib, int opt_count, char *opts[]);
+
+#endif
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/* ============================================================================= END OF CODE ===========================================================================*/
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
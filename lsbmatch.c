@@ -0,0 +1,222 @@
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// ============================================================ * * * * * lsbmatch.c * * * * * ======================================================================== //
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/*
+
+### USAGE OF lsbmatch.c FILE IN STEGANOGRAPHY PROJECT ?
+--> THIS FILE IMPLEMENTS THE LSB MATCHING KERNEL. CARRIER BYTES ARE TAKEN 64 AT A TIME (8 PAYLOAD BYTES) WITH ONE 64 BIT RANDOM WORD, ONE DIRECTION BIT PER BYTE.
+    PAYLOAD BITS AND DIRECTION BITS ARE SPREAD TO ONE MASK BYTE PER CARRIER BYTE, AND EVERY CARRIER BYTE GETS C + (MISMATCH & (UP ? 1 : -1)) WITHOUT A BRANCH, WHERE
+    UP IS THE RANDOM BIT FORCED ON FOR 0 AND OFF FOR 255. THE SCALAR, SSSE3 AND AVX2 KERNELS PRODUCE THE SAME BYTES; THE WIDEST ONE THE CPU SUPPORTS IS PICKED ONCE.
+
+*/
+
+/* ====================================================================== INCLUDES ==================================================================================== */
+
+#include <string.h>      // memcpy
+#include <pthread.h>     // pthread_once
+#include "lsbmatch.h"    // Prototypes
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>   // SSSE3 / AVX2 kernels
+#define LSBMATCH_HAVE_X86 1
+#endif
+
+/* ======================================================================= STRUCTURE ================================================================================== */
+
+/* Kernel for whole groups of 8 payload bytes (64 carrier bytes) */
+typedef void (*LsbMatchFn)(LsbMatchState *st, unsigned char *carrier, const unsigned char *payload, size_t groups);
+
+static LsbMatchFn match_groups;
+static const char *match_groups_name;
+
+/* ================================================================= FUNCTION DEFINITIONS ============================================================================= */
+
+static inline uint64_t rotl64(uint64_t x, int k)
+{
+    return (x << k) | (x >> (64 - k));
+}
+
+/* Next xoshiro256** word */
+static inline uint64_t match_next(LsbMatchState *st)
+{
+    uint64_t *s = st->s;
+    uint64_t result = rotl64(s[1] * 5, 7) * 9;
+    uint64_t t = s[1] << 17;
+
+    s[2] ^= s[0];
+    s[3] ^= s[1];
+    s[1] ^= s[2];
+    s[0] ^= s[3];
+    s[2] ^= t;
+    s[3] = rotl64(s[3], 45);
+    return result;
+}
+
+void lsb_match_seed(LsbMatchState *st, uint64_t key)
+{
+    // splitmix64 turns any key (even 0) into a usable state
+    for (int i = 0; i < 4; i++)
+    {
+        uint64_t z = (key += 0x9E3779B97F4A7C15ULL);
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+        st->s[i] = z ^ (z >> 31);
+    }
+    st->changed = 0;
+}
+
+/* Carrier byte 8 * i + k: payload bit 7 - k of payload[i], direction bit 7 - k of byte i of the random word */
+static void match_bytes_scalar(LsbMatchState *st, unsigned char *carrier, const unsigned char *payload, size_t count, uint64_t r)
+{
+    for (size_t i = 0; i < count; i++)
+    {
+        unsigned char dir = r >> (8 * i);
+        for (int k = 0; k < 8; k++)
+        {
+            unsigned char c = carrier[i * 8 + k];
+            unsigned char mismatch = (c ^ (payload[i] >> (7 - k))) & 1;
+            unsigned char up = (((dir >> (7 - k)) & 1) | (c == 0)) & (c != 255);
+            carrier[i * 8 + k] = c + (unsigned char)(mismatch * ((up << 1) - 1));
+            st->changed += mismatch;
+        }
+    }
+}
+
+static void match_groups_scalar(LsbMatchState *st, unsigned char *carrier, const unsigned char *payload, size_t groups)
+{
+    for (size_t g = 0; g < groups; g++)
+    {
+        match_bytes_scalar(st, carrier + g * 64, payload + g * 8, 8, match_next(st));
+    }
+}
+
+#ifdef LSBMATCH_HAVE_X86
+/* One mask byte per bit: byte j of the result is 0xFF when bit 7 - j % 8 of source byte j / 8 is set */
+__attribute__((target("ssse3")))
+static inline __m128i spread_bits_ssse3(uint16_t two)
+{
+    const __m128i spread = _mm_set_epi8(1, 1, 1, 1, 1, 1, 1, 1, 0, 0, 0, 0, 0, 0, 0, 0);
+    const __m128i bitsel = _mm_set_epi8(1, 2, 4, 8, 16, 32, 64, (char)128, 1, 2, 4, 8, 16, 32, 64, (char)128);
+    __m128i v = _mm_shuffle_epi8(_mm_cvtsi32_si128(two), spread);
+    return _mm_cmpeq_epi8(_mm_and_si128(v, bitsel), bitsel);
+}
+
+__attribute__((target("ssse3,popcnt")))
+static void match_groups_ssse3(LsbMatchState *st, unsigned char *carrier, const unsigned char *payload, size_t groups)
+{
+    const __m128i one = _mm_set1_epi8(1);
+    const __m128i two = _mm_set1_epi8(2);
+    const __m128i ff = _mm_set1_epi8((char)0xFF);
+    const __m128i zero = _mm_setzero_si128();
+
+    for (size_t g = 0; g < groups; g++)
+    {
+        uint64_t r = match_next(st);
+        for (int q = 0; q < 4; q++)
+        {
+            unsigned char *p = carrier + g * 64 + q * 16;
+            uint16_t bits, dirs = r >> (16 * q);
+            memcpy(&bits, payload + g * 8 + q * 2, 2);
+
+            __m128i c = _mm_loadu_si128((const __m128i *)p);
+            __m128i lsb = _mm_cmpeq_epi8(_mm_and_si128(c, one), one);
+            __m128i mismatch = _mm_xor_si128(lsb, spread_bits_ssse3(bits));
+            __m128i up = _mm_andnot_si128(_mm_cmpeq_epi8(c, ff), _mm_or_si128(spread_bits_ssse3(dirs), _mm_cmpeq_epi8(c, zero)));
+            __m128i step = _mm_sub_epi8(_mm_and_si128(up, two), one);
+            _mm_storeu_si128((__m128i *)p, _mm_add_epi8(c, _mm_and_si128(step, mismatch)));
+            st->changed += __builtin_popcount(_mm_movemask_epi8(mismatch));
+        }
+    }
+}
+
+__attribute__((target("avx2")))
+static inline __m256i spread_bits_avx2(uint32_t four)
+{
+    // Each 128 bit lane holds all four bytes, so the in-lane shuffle reaches bytes 2 and 3 from the upper lane
+    const __m256i spread = _mm256_set_epi8(3, 3, 3, 3, 3, 3, 3, 3, 2, 2, 2, 2, 2, 2, 2, 2, 1, 1, 1, 1, 1, 1, 1, 1, 0, 0, 0, 0, 0, 0, 0, 0);
+    const __m256i bitsel = _mm256_set1_epi64x((long long)0x0102040810204080ULL);
+    __m256i v = _mm256_shuffle_epi8(_mm256_set1_epi32(four), spread);
+    return _mm256_cmpeq_epi8(_mm256_and_si256(v, bitsel), bitsel);
+}
+
+__attribute__((target("avx2,popcnt")))
+static void match_groups_avx2(LsbMatchState *st, unsigned char *carrier, const unsigned char *payload, size_t groups)
+{
+    const __m256i one = _mm256_set1_epi8(1);
+    const __m256i two = _mm256_set1_epi8(2);
+    const __m256i ff = _mm256_set1_epi8((char)0xFF);
+    const __m256i zero = _mm256_setzero_si256();
+
+    for (size_t g = 0; g < groups; g++)
+    {
+        uint64_t r = match_next(st);
+        for (int h = 0; h < 2; h++)
+        {
+            unsigned char *p = carrier + g * 64 + h * 32;
+            uint32_t bits, dirs = r >> (32 * h);
+            memcpy(&bits, payload + g * 8 + h * 4, 4);
+
+            __m256i c = _mm256_loadu_si256((const __m256i *)p);
+            __m256i lsb = _mm256_cmpeq_epi8(_mm256_and_si256(c, one), one);
+            __m256i mismatch = _mm256_xor_si256(lsb, spread_bits_avx2(bits));
+            __m256i up = _mm256_andnot_si256(_mm256_cmpeq_epi8(c, ff), _mm256_or_si256(spread_bits_avx2(dirs), _mm256_cmpeq_epi8(c, zero)));
+            __m256i step = _mm256_sub_epi8(_mm256_and_si256(up, two), one);
+            _mm256_storeu_si256((__m256i *)p, _mm256_add_epi8(c, _mm256_and_si256(step, mismatch)));
+            st->changed += __builtin_popcount((uint32_t)_mm256_movemask_epi8(mismatch));
+        }
+    }
+}
+#endif
+
+/* Pick the widest kernel once */
+static void match_init(void)
+{
+    match_groups = match_groups_scalar;
+    match_groups_name = "scalar";
+#ifdef LSBMATCH_HAVE_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2"))
+    {
+        match_groups = match_groups_avx2;
+        match_groups_name = "avx2";
+    }
+    else if (__builtin_cpu_supports("ssse3"))
+    {
+        match_groups = match_groups_ssse3;
+        match_groups_name = "ssse3";
+    }
+#endif
+}
+
+/* Kernel chosen once, concurrent encode jobs wait for the first */
+static void match_setup(void)
+{
+    static pthread_once_t once = PTHREAD_ONCE_INIT;
+    pthread_once(&once, match_init);
+}
+
+void lsb_match_block(LsbMatchState *st, unsigned char *carrier, const unsigned char *payload, size_t count)
+{
+    match_setup();
+
+    // STEP 1 : Whole groups of 8 payload bytes through the vector kernel
+    size_t groups = count / 8;
+    match_groups(st, carrier, payload, groups);
+
+    // STEP 2 : Short tail with its own random word
+    if (count % 8 != 0)
+    {
+        match_bytes_scalar(st, carrier + groups * 64, payload + groups * 8, count % 8, match_next(st));
+    }
+}
+
+const char *lsb_match_kernel_name(void)
+{
+    match_setup();
+    return match_groups_name;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/* ============================================================================= END OF CODE ===========================================================================*/
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
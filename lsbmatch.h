@@ -0,0 +1,49 @@
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// ============================================================ * * * * * lsbmatch.h * * * * * ======================================================================== //
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/*
+
+### USAGE OF lsbmatch.h FILE IN STEGANOGRAPHY PROJECT ?
+--> THIS HEADER FILE DECLARES THE LSB MATCHING (+-1) EMBEDDING KERNEL. INSTEAD OF OVERWRITING THE LSB, A CARRIER BYTE WHOSE LSB DOES NOT MATCH THE PAYLOAD BIT IS
+    INCREMENTED OR DECREMENTED AT RANDOM (0 IS ALWAYS INCREMENTED, 255 ALWAYS DECREMENTED), WHICH AVOIDS THE PAIRS OF VALUES SIGNATURE OF LSB REPLACEMENT. THE LSBS
+    END UP THE SAME AS WITH REPLACEMENT, SO DECODING IS UNCHANGED. THE RANDOM DIRECTIONS COME FROM A KEYED XOSHIRO256** GENERATOR.
+
+*/
+
+// ==================================================================================================================================================================== //
+
+#ifndef LSBMATCH_H
+#define LSBMATCH_H
+
+/* ====================================================================== INCLUDES ==================================================================================== */
+
+#include <stddef.h>
+#include <stdint.h>
+#include "types.h"
+
+/* ======================================================================= STRUCTURE ================================================================================== */
+
+/* Generator state and counters of one embedding run */
+typedef struct
+{
+    uint64_t s[4];                  // xoshiro256** state
+    unsigned long long changed;     // Carrier bytes moved by +-1
+} LsbMatchState;
+
+/* ================================================================= FUNCTION PROTOTYPES ============================================================================== */
+
+/* Seed the generator from key (splitmix64 expansion) */
+void lsb_match_seed(LsbMatchState *st, uint64_t key);
+
+/* Embed count payload bytes into the LSBs of count * 8 carrier bytes, MSB first, by +-1 changes */
+void lsb_match_block(LsbMatchState *st, unsigned char *carrier, const unsigned char *payload, size_t count);
+
+/* Name of the kernel lsb_match_block runs ("scalar", "ssse3" or "avx2") */
+const char *lsb_match_kernel_name(void);
+
+#endif
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/* ============================================================================= END OF CODE ===========================================================================*/
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -0,0 +1,317 @@
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// ============================================================= * * * * * matrix.c * * * * * ========================================================================= //
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/*
+
+### USAGE OF matrix.c FILE IN STEGANOGRAPHY PROJECT ?
+--> THIS FILE IMPLEMENTS THE MATRIX EMBEDDING MODE. THE SYNDROME OF A GROUP IS THE XOR OF (I + 1) OVER ALL GROUP BYTES I WHOSE LSB IS 1. IT IS COMPUTED BIT-PARALLEL:
+    THE LSBS OF THE GROUP ARE PACKED INTO 64 BIT WORDS (8 BYTES AT A TIME WITH ONE MULTIPLY), AND SYNDROME BIT J IS THE PARITY OF THOSE WORDS ANDED WITH A PRECOMPUTED
+    MASK OF THE POSITIONS WHOSE INDEX + 1 HAS BIT J SET. TO EMBED A MESSAGE M THE ENCODER FLIPS THE LSB OF BYTE (SYNDROME XOR M) - 1, OR NOTHING WHEN THEY ALREADY
+    MATCH. THE ENCODER PATCHES A SHARED MAP OF THE CLONED IMAGE, SO ONLY PAGES WITH A FLIPPED BYTE ARE WRITTEN BACK.
+
+*/
+
+/* ====================================================================== INCLUDES ==================================================================================== */
+
+#include <stdio.h>       // Std inbuilt functions
+#include <stdlib.h>      // malloc, free
+#include <string.h>      // Inbuilt string functions
+#include <stdint.h>      // uint64_t LSB words
+#include <sys/mman.h>    // munmap
+#include "types.h"       // Status
+#include "common.h"      // MAGIC_STRING_EXT and MODE_* flags
+#include "encode.h"      // EncodeInfo
+#include "decode.h"      // DecodeInfo, PayloadParser
+#include "fastcopy.h"    // map_image_file
+#include "matrix.h"      // Prototypes
+
+/* ======================================================================= MACROS ===================================================================================== */
+
+#define BMP_HEADER 54                                       // Pixel data offset the rest of the project assumes
+#define MATRIX_HEADER_BYTES (BMP_HEADER + 16 + 32 + 32)     // Image bytes holding magic, mode word and p one bit each
+
+/* ======================================================================= STRUCTURE ================================================================================== */
+
+/* Hamming code of one group size */
+typedef struct
+{
+    uint p;                                     // Payload bits per group
+    uint n;                                     // Carrier bytes per group (2^p - 1)
+    uint words;                                 // 64 bit words covering n LSBs
+    uint64_t masks[MATRIX_MAX_P][MATRIX_WORDS]; // masks[j]: positions i with bit j of (i + 1) set
+} MatrixCode;
+
+/* Payload bit stream: header fields, then the secret file, zero padded to whole groups */
+typedef struct
+{
+    unsigned char prefix[16];
+    size_t prefix_len, prefix_pos;
+    FILE *fptr_secret;
+    unsigned char buf[64 * 1024];
+    size_t buf_len, buf_pos;
+    unsigned char cur;
+    int bits_left;
+} BitSource;
+
+/* ================================================================= FUNCTION DEFINITIONS ============================================================================= */
+
+/* Fill the position masks of the (2^p - 1) code */
+static MatrixCode *matrix_code(uint p)
+{
+    MatrixCode *code = calloc(1, sizeof(*code));
+    if (code == NULL)
+    {
+        return NULL;
+    }
+    code->p = p;
+    code->n = (1u << p) - 1;
+    code->words = (code->n + 63) / 64;
+    for (uint i = 0; i < code->n; i++)
+    {
+        for (uint j = 0; j < p; j++)
+        {
+            if (((i + 1) >> j) & 1)
+            {
+                code->masks[j][i / 64] |= 1ULL << (i % 64);
+            }
+        }
+    }
+    return code;
+}
+
+/* Syndrome of the n bytes at group: LSBs packed into words, one masked parity per syndrome bit */
+static uint group_syndrome(const MatrixCode *code, const unsigned char *group)
+{
+    uint64_t lsb[MATRIX_WORDS];
+
+    // STEP 1 : Pack 8 LSBs per multiply: bit k of the top byte collects the LSB of byte k
+    for (uint w = 0; w < code->words; w++)
+    {
+        uint64_t v = 0;
+        for (uint k = 0; k < 8; k++)
+        {
+            uint base = w * 64 + k * 8;
+            if (base + 8 <= code->n)
+            {
+                uint64_t x;
+                memcpy(&x, group + base, 8);
+                v |= (((x & 0x0101010101010101ULL) * 0x0102040810204080ULL) >> 56) << (k * 8);
+            }
+            else
+            {
+                for (uint b = base; b < code->n && b < base + 8; b++)
+                {
+                    v |= (uint64_t)(group[b] & 1) << (b - w * 64);
+                }
+            }
+        }
+        lsb[w] = v;
+    }
+
+    // STEP 2 : Syndrome bit j = parity of the LSBs at positions whose index + 1 has bit j
+    uint s = 0;
+    for (uint j = 0; j < code->p; j++)
+    {
+        uint64_t acc = 0;
+        for (uint w = 0; w < code->words; w++)
+        {
+            acc ^= lsb[w] & code->masks[j][w];
+        }
+        s |= (uint)(__builtin_popcountll(acc) & 1) << j;
+    }
+    return s;
+}
+
+/* Next nbits of the payload stream, MSB first */
+static uint next_bits(BitSource *src, uint nbits)
+{
+    uint value = 0;
+    for (uint i = 0; i < nbits; i++)
+    {
+        if (src->bits_left == 0)
+        {
+            if (src->prefix_pos < src->prefix_len)
+            {
+                src->cur = src->prefix[src->prefix_pos++];
+            }
+            else
+            {
+                if (src->buf_pos == src->buf_len)
+                {
+                    src->buf_len = fread(src->buf, 1, sizeof(src->buf), src->fptr_secret);
+                    src->buf_pos = 0;
+                }
+                // Past the end only the padding of the last group is read
+                src->cur = src->buf_pos < src->buf_len ? src->buf[src->buf_pos++] : 0;
+            }
+            src->bits_left = 8;
+        }
+        value = (value << 1) | ((src->cur >> --src->bits_left) & 1);
+    }
+    return value;
+}
+
+/* Store nbits of value, MSB first, in the LSBs of nbits image bytes; returns the bytes that changed */
+static unsigned long put_lsb_bits(unsigned char *dst, uint value, uint nbits)
+{
+    unsigned long changed = 0;
+    for (uint i = 0; i < nbits; i++)
+    {
+        unsigned char want = (dst[i] & 0xFE) | ((value >> (nbits - 1 - i)) & 1);
+        changed += want != dst[i];
+        dst[i] = want;
+    }
+    return changed;
+}
+
+/* Extended magic, MODE_MATRIX, p, then the payload fields p bits per group */
+Status encode_matrix_payload(EncodeInfo *encInfo)
+{
+    BitSource *src;
+    size_t image_size;
+    size_t extn_len = strlen(encInfo->extn_secret_file);
+
+    // STEP 1 : Shared map of the clone, only touched pages get written back
+    if (fflush(encInfo->fptr_stego_image) != 0)
+    {
+        return e_failure;
+    }
+    unsigned char *image = map_image_file(encInfo->fptr_stego_image, encInfo->stego_image_fname, 1, &image_size);
+    if (image == NULL || image_size <= MATRIX_HEADER_BYTES)
+    {
+        printf("Error: Unable to map the stego image.\n");
+        if (image != NULL)
+        {
+            munmap(image, image_size);
+        }
+        return e_failure;
+    }
+
+    // STEP 2 : Largest p whose groups still fit (same capacity rule as check_capacity)
+    unsigned long long bits = ((unsigned long long)4 + extn_len + 4 + encInfo->size_secret_file) * 8;
+    unsigned long long image_capacity = (unsigned long long)(image[18] | image[19] << 8 | image[20] << 16 | (uint)image[21] << 24) *
+                                        (image[22] | image[23] << 8 | image[24] << 16 | (uint)image[25] << 24) * 3;
+    unsigned long long available = image_capacity > MATRIX_HEADER_BYTES ? image_capacity - MATRIX_HEADER_BYTES - 1 : 0;
+    if (available > image_size - MATRIX_HEADER_BYTES)
+    {
+        available = image_size - MATRIX_HEADER_BYTES;
+    }
+    uint p = MATRIX_MAX_P;
+    for (; p >= 1; p--)
+    {
+        if ((bits + p - 1) / p * ((1ULL << p) - 1) <= available)
+        {
+            break;
+        }
+    }
+    if (p < 1)
+    {
+        printf("Error: Insufficient image capacity.\n");
+        munmap(image, image_size);
+        return e_failure;
+    }
+
+    MatrixCode *code = matrix_code(p);
+    src = calloc(1, sizeof(*src));
+    if (code == NULL || src == NULL)
+    {
+        free(code);
+        free(src);
+        munmap(image, image_size);
+        return e_failure;
+    }
+
+    // STEP 3 : Header in plain LSBs right after the BMP header
+    unsigned char *pos = image + BMP_HEADER;
+    unsigned long changed = put_lsb_bits(pos, MAGIC_STRING_EXT[0], 8) + put_lsb_bits(pos + 8, MAGIC_STRING_EXT[1], 8);
+    changed += put_lsb_bits(pos + 16, MODE_MATRIX, 32) + put_lsb_bits(pos + 48, p, 32);
+    pos = image + MATRIX_HEADER_BYTES;
+
+    // STEP 4 : Payload fields, p bits per group, at most one flipped LSB per group
+    for (int shift = 24; shift >= 0; shift -= 8)
+    {
+        src->prefix[src->prefix_len++] = extn_len >> shift;
+    }
+    memcpy(src->prefix + src->prefix_len, encInfo->extn_secret_file, extn_len);
+    src->prefix_len += extn_len;
+    for (int shift = 24; shift >= 0; shift -= 8)
+    {
+        src->prefix[src->prefix_len++] = encInfo->size_secret_file >> shift;
+    }
+    src->fptr_secret = encInfo->fptr_secret;
+
+    unsigned long long groups = (bits + p - 1) / p;
+    for (unsigned long long g = 0; g < groups; g++, pos += code->n)
+    {
+        uint flip = group_syndrome(code, pos) ^ next_bits(src, p);
+        if (flip != 0)
+        {
+            pos[flip - 1] ^= 1;
+            changed++;
+        }
+    }
+    printf("Matrix embedding p = %u: %llu groups of %u bytes, %lu carrier bytes changed for %llu payload bits.\n",
+           p, groups, code->n, changed, bits);
+
+    free(code);
+    free(src);
+    return munmap(image, image_size) == 0 ? e_success : e_failure;
+}
+
+/* Extract the payload fields as the group syndromes of code decInfo->matrix_p */
+Status decode_matrix_payload(DecodeInfo *decInfo)
+{
+    PayloadParser parser;
+    size_t image_size;
+    uint p = decInfo->matrix_p;
+
+    if (p < 1 || p > MATRIX_MAX_P)
+    {
+        printf("ERROR! Invalid matrix embedding parameter %u\n", p);
+        return e_failure;
+    }
+    unsigned char *image = map_image_file(decInfo->fptr_stego_image, NULL, 0, &image_size);
+    MatrixCode *code = matrix_code(p);
+    if (image == NULL || code == NULL)
+    {
+        printf("ERROR! Cannot map the stego image\n");
+        if (image != NULL)
+        {
+            munmap(image, image_size);
+        }
+        free(code);
+        return e_failure;
+    }
+
+    // Every group syndrome is the next p payload bits
+    memset(&parser, 0, sizeof(parser));
+    unsigned char cur = 0;
+    int nbits = 0;
+    for (size_t off = MATRIX_HEADER_BYTES; !parser.done && !parser.failed && off + code->n <= image_size; off += code->n)
+    {
+        uint s = group_syndrome(code, image + off);
+        for (int j = p - 1; j >= 0 && !parser.done && !parser.failed; j--)
+        {
+            cur = (cur << 1) | ((s >> j) & 1);
+            if (++nbits == 8)
+            {
+                parse_payload_byte(decInfo, &parser, cur);
+                nbits = 0;
+            }
+        }
+    }
+
+    free(code);
+    munmap(image, image_size);
+    if (!parser.done)
+    {
+        printf("ERROR! Matrix embedded payload is %s\n", parser.failed ? "corrupt" : "truncated");
+        return e_failure;
+    }
+    return e_success;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/* ============================================================================= END OF CODE ===========================================================================*/
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -0,0 +1,42 @@
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// ============================================================= * * * * * matrix.h * * * * * ========================================================================= //
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/*
+
+### USAGE OF matrix.h FILE IN STEGANOGRAPHY PROJECT ?
+--> THIS HEADER FILE DECLARES THE MATRIX EMBEDDING MODE. THE PAYLOAD IS CUT INTO P BIT MESSAGES AND EACH MESSAGE IS CARRIED BY A GROUP OF 2^P - 1 CARRIER BYTES AS THE
+    SYNDROME OF A (2^P - 1, 2^P - 1 - P) HAMMING CODE OVER THEIR LSBS. THE ENCODER MAKES THE SYNDROME EQUAL THE MESSAGE BY FLIPPING AT MOST ONE LSB PER GROUP, SO FAR
+    FEWER CARRIER BYTES CHANGE THAN WITH ONE BIT PER BYTE. P IS THE LARGEST VALUE THE CARRIER CAPACITY ALLOWS AND IS STORED AFTER THE MODE WORD.
+
+*/
+
+// ==================================================================================================================================================================== //
+
+#ifndef MATRIX_H
+#define MATRIX_H
+
+/* ====================================================================== INCLUDES ==================================================================================== */
+
+#include "types.h"
+#include "encode.h"
+#include "decode.h"
+
+/* ======================================================================= MACROS ===================================================================================== */
+
+#define MATRIX_MAX_P 16                             // Largest code: 65535 carrier bytes per 16 payload bits
+#define MATRIX_WORDS ((1 << MATRIX_MAX_P) / 64)     // 64 bit words holding the LSBs of the largest group
+
+/* ================================================================= FUNCTION PROTOTYPES ============================================================================== */
+
+/* Extended magic, MODE_MATRIX, p, then the payload fields p bits per group (streams positioned after the BMP header) */
+Status encode_matrix_payload(EncodeInfo *encInfo);
+
+/* Extract the payload fields as the group syndromes of code decInfo->matrix_p */
+Status decode_matrix_payload(DecodeInfo *decInfo);
+
+#endif
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/* ============================================================================= END OF CODE ===========================================================================*/
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
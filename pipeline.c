@@ -0,0 +1,474 @@
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// ============================================================ * * * * * pipeline.c * * * * * ======================================================================== //
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/*
+
+### USAGE OF pipeline.c FILE IN STEGANOGRAPHY PROJECT ?
+--> THIS FILE IMPLEMENTS THE STAGED ENCODING PIPELINE. EVERY STAGE IS ONE THREAD THAT POPS A BUFFER FROM ITS INPUT RING, WORKS ON IT AND PUSHES IT TO THE NEXT RING; THE
+    WRITE STAGE HANDS BUFFERS BACK TO THE READ STAGE THROUGH THE FREE RING, SO THE THREE RINGS FORM A CYCLE AND EVERY RING HAS EXACTLY ONE PRODUCER AND ONE CONSUMER.
+    THE RINGS ARE BOUNDED ARRAYS WITH ATOMIC HEAD / TAIL INDICES (NO LOCKS ON THE FAST PATH); A STAGE THAT FINDS ITS INPUT EMPTY OR ITS OUTPUT FULL SPINS BRIEFLY,
+    YIELDS A FEW TIMES AND THEN SLEEPS ON THE CONDITION VARIABLE OF THE RING UNTIL THE OTHER SIDE MOVES IT, SO A STARVED STAGE DOES NOT BURN A CORE WHILE I/O IS SLOW.
+    THE TIME EACH STAGE SPENDS WORKING, WAITING FOR INPUT AND BLOCKED ON OUTPUT IS COUNTED AND PRINTED AT THE END.
+
+*/
+
+/* ====================================================================== INCLUDES ==================================================================================== */
+
+#include <stdio.h>       // Std inbuilt functions
+#include <stdlib.h>      // malloc, free
+#include <string.h>      // memset, memcpy
+#include <stdatomic.h>   // Ring indices and failure flag
+#include <pthread.h>     // Stage threads
+#include <sched.h>       // sched_yield
+#include <time.h>        // clock_gettime
+#include <unistd.h>      // pread, pwrite
+#include "types.h"       // Status
+#include "encode.h"      // EncodeInfo
+#include "lsbkernel.h"   // lsb_kernel_embed
+#include "pipeline.h"    // Prototypes
+
+/* ======================================================================= MACROS ===================================================================================== */
+
+#define PIPE_STAGES 3           // read -> embed -> write
+#define PIPE_CACHE_LINE 64      // Keeps producer and consumer indices on separate lines
+
+/* ======================================================================= STRUCTURE ================================================================================== */
+
+/* One pooled buffer: a block of carrier bytes and the payload bytes embedded into it */
+typedef struct
+{
+    unsigned char *carrier;         // PIPE_BLOCK carrier bytes
+    unsigned char *payload;         // PIPE_BLOCK / 8 payload bytes
+    off_t offset;                   // Carrier offset of the block
+    size_t len;                     // Carrier bytes used (0 = end of stream marker)
+} PipeBuffer;
+
+/* Bounded single-producer / single-consumer ring of buffer pointers */
+typedef struct
+{
+    _Alignas(PIPE_CACHE_LINE) atomic_size_t head;   // Next slot the producer fills
+    _Alignas(PIPE_CACHE_LINE) atomic_size_t tail;   // Next slot the consumer empties
+    _Alignas(PIPE_CACHE_LINE) PipeBuffer **items;
+    size_t mask;                                    // Capacity - 1 (capacity is a power of two)
+    atomic_int sleeping;                            // A stage sleeps on cond, the other side signals after moving the ring
+    pthread_mutex_t lock;
+    pthread_cond_t cond;
+} SpscRing;
+
+/* Utilization counters of one stage */
+typedef struct
+{
+    const char *name;
+    unsigned long blocks;           // Buffers worked on
+    unsigned long long busy_ns;     // Time spent working
+    unsigned long long starved_ns;  // Time waiting on an empty input ring
+    unsigned long long blocked_ns;  // Time waiting on a full output ring
+} StageStats;
+
+/* Shared state of one pipeline run */
+typedef struct
+{
+    EncodeInfo *encInfo;
+    int in_fd;                      // Source image
+    int out_fd;                     // Stego image
+    off_t next;                     // Next carrier offset handed to the read stage
+    off_t end;                      // End of the carrier range
+    unsigned char *before;          // Copy of the block being embedded (--metrics)
+    const LsbKernel *kernel;        // LSB replacement kernel of the carrier format
+
+    SpscRing rings[PIPE_STAGES];    // rings[i] feeds stage i; rings[0] is the free ring filled by the write stage
+    StageStats stats[PIPE_STAGES];
+    atomic_int failed;              // Set by a stage that fails, stops every wait loop
+} Pipeline;
+
+/* Argument of a stage thread */
+typedef struct
+{
+    Pipeline *p;
+    int index;
+} StageArg;
+
+/* ================================================================= FUNCTION DEFINITIONS ============================================================================= */
+
+/* Monotonic clock in nanoseconds */
+static unsigned long long now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (unsigned long long)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+/* Allocate a ring that holds at least min_items pointers */
+static Status ring_init(SpscRing *r, size_t min_items)
+{
+    size_t capacity = 1;
+    while (capacity < min_items)
+    {
+        capacity <<= 1;
+    }
+    atomic_init(&r->head, 0);
+    atomic_init(&r->tail, 0);
+    atomic_init(&r->sleeping, 0);
+    pthread_mutex_init(&r->lock, NULL);
+    pthread_cond_init(&r->cond, NULL);
+    r->mask = capacity - 1;
+    r->items = malloc(capacity * sizeof(*r->items));
+    return r->items != NULL ? e_success : e_failure;
+}
+
+/* Free slot to push into (want_space) or buffer to pop */
+static int ring_ready(SpscRing *r, int want_space)
+{
+    size_t head = atomic_load(&r->head);
+    size_t tail = atomic_load(&r->tail);
+    return want_space ? head - tail <= r->mask : head != tail;
+}
+
+/* Wake the stage sleeping on the other side of r, if any (called after head or tail moved) */
+static void ring_wake(SpscRing *r)
+{
+    if (atomic_load(&r->sleeping))
+    {
+        pthread_mutex_lock(&r->lock);
+        pthread_cond_broadcast(&r->cond);
+        pthread_mutex_unlock(&r->lock);
+    }
+}
+
+/* Wait until r can be pushed to (want_space) or popped from: spin, then yield, then sleep; returns 0 if the pipeline failed meanwhile.
+ * sleeping is set before the last check and head / tail are moved before it is read, both sequentially consistent, so a wake-up is never lost
+ */
+static int ring_wait(Pipeline *p, SpscRing *r, int want_space, unsigned long long *waited_ns)
+{
+    unsigned long long start = 0;
+
+    for (uint spins = 1; !ring_ready(r, want_space); spins++)
+    {
+        if (atomic_load_explicit(&p->failed, memory_order_relaxed))
+        {
+            return 0;
+        }
+        if (start == 0)
+        {
+            start = now_ns();
+        }
+        if (spins % PIPE_SPIN != 0)
+        {
+            continue;
+        }
+        if (spins < PIPE_SPIN * PIPE_YIELDS)
+        {
+            sched_yield();
+            continue;
+        }
+
+        pthread_mutex_lock(&r->lock);
+        atomic_store(&r->sleeping, 1);
+        while (!ring_ready(r, want_space) && !atomic_load(&p->failed))
+        {
+            pthread_cond_wait(&r->cond, &r->lock);
+        }
+        atomic_store(&r->sleeping, 0);
+        pthread_mutex_unlock(&r->lock);
+    }
+    if (start != 0)
+    {
+        *waited_ns += now_ns() - start;
+    }
+    return 1;
+}
+
+/* Append a buffer, waiting while the ring is full; returns 0 if the pipeline failed meanwhile */
+static int ring_push(Pipeline *p, SpscRing *r, PipeBuffer *buf, StageStats *st)
+{
+    if (!ring_wait(p, r, 1, &st->blocked_ns))
+    {
+        return 0;
+    }
+    size_t head = atomic_load_explicit(&r->head, memory_order_relaxed);
+    r->items[head & r->mask] = buf;
+    atomic_store(&r->head, head + 1);
+    ring_wake(r);
+    return 1;
+}
+
+/* Take the oldest buffer, waiting while the ring is empty; returns NULL if the pipeline failed meanwhile */
+static PipeBuffer *ring_pop(Pipeline *p, SpscRing *r, StageStats *st)
+{
+    if (!ring_wait(p, r, 0, &st->starved_ns))
+    {
+        return NULL;
+    }
+    size_t tail = atomic_load_explicit(&r->tail, memory_order_relaxed);
+    PipeBuffer *buf = r->items[tail & r->mask];
+    atomic_store(&r->tail, tail + 1);
+    ring_wake(r);
+    return buf;
+}
+
+/* Stop every stage: flag the failure and wake whoever sleeps on a ring */
+static void pipeline_fail(Pipeline *p)
+{
+    atomic_store(&p->failed, 1);
+    for (int i = 0; i < PIPE_STAGES; i++)
+    {
+        pthread_mutex_lock(&p->rings[i].lock);
+        pthread_cond_broadcast(&p->rings[i].cond);
+        pthread_mutex_unlock(&p->rings[i].lock);
+    }
+}
+
+/* Stage 0 : load the next payload slice and carrier block (len = 0 once the range is done) */
+static Status read_stage(Pipeline *p, PipeBuffer *buf)
+{
+    off_t left = p->end - p->next;
+    buf->offset = p->next;
+    buf->len = left < PIPE_BLOCK ? (size_t)left : PIPE_BLOCK;
+    if (buf->len == 0)
+    {
+        return e_success;
+    }
+    p->next += buf->len;
+
+    // STEP 1 : Payload bytes embedded into this block
+    size_t count = buf->len / 8;
+    if (fread(buf->payload, 1, count, p->encInfo->fptr_secret) != count)
+    {
+        printf("Error: Secret file ended early.\n");
+        return e_failure;
+    }
+
+    // STEP 2 : Carrier bytes of the block, paced by the read bucket
+    io_throttle(&p->encInfo->io, e_io_read, buf->len);
+    for (size_t done = 0; done < buf->len;)
+    {
+        ssize_t n = pread(p->in_fd, buf->carrier + done, buf->len - done, buf->offset + done);
+        if (n <= 0)
+        {
+            perror("pread");
+            return e_failure;
+        }
+        done += n;
+    }
+    return e_success;
+}
+
+/* Stage 1 : one payload byte into the LSBs of every 8 carrier bytes (+-1 matched with --lsb-match) */
+static Status embed_stage(Pipeline *p, PipeBuffer *buf)
+{
+    if (p->before != NULL)
+    {
+        memcpy(p->before, buf->carrier, buf->len);
+    }
+    if (p->encInfo->lsb_match)
+    {
+        lsb_match_block(&p->encInfo->match, buf->carrier, buf->payload, buf->len / 8);
+    }
+    else
+    {
+        lsb_kernel_embed(p->kernel, buf->carrier, buf->payload, buf->len / 8);
+    }
+    if (p->before != NULL)
+    {
+        quality_update(&p->encInfo->quality, p->before, buf->carrier, buf->len, buf->offset);
+    }
+    return e_success;
+}
+
+/* Stage 2 : block back to the same offset of the stego image */
+static Status write_stage(Pipeline *p, PipeBuffer *buf)
+{
+    io_throttle(&p->encInfo->io, e_io_write, buf->len);
+    for (size_t done = 0; done < buf->len;)
+    {
+        ssize_t n = pwrite(p->out_fd, buf->carrier + done, buf->len - done, buf->offset + done);
+        if (n <= 0)
+        {
+            perror("pwrite");
+            return e_failure;
+        }
+        done += n;
+    }
+    return e_success;
+}
+
+/* Work done by each stage, indexed like Pipeline.rings */
+static Status (*const stage_work[PIPE_STAGES])(Pipeline *, PipeBuffer *) =
+{
+    read_stage, embed_stage, write_stage
+};
+
+/* Body of every stage thread: pop, work, push until the end of stream marker has passed */
+static void *stage_thread(void *arg)
+{
+    StageArg *s = arg;
+    Pipeline *p = s->p;
+    StageStats *st = &p->stats[s->index];
+    SpscRing *in = &p->rings[s->index];
+    SpscRing *out = &p->rings[(s->index + 1) % PIPE_STAGES];
+
+    for (;;)
+    {
+        PipeBuffer *buf = ring_pop(p, in, st);
+        if (buf == NULL)
+        {
+            break;
+        }
+
+        // The read stage turns a free buffer into a block (or the end marker), the others skip the marker
+        if (s->index == 0 || buf->len != 0)
+        {
+            unsigned long long start = now_ns();
+            if (stage_work[s->index](p, buf) == e_failure)
+            {
+                pipeline_fail(p);
+                break;
+            }
+            st->busy_ns += now_ns() - start;
+            st->blocks += buf->len != 0;
+        }
+
+        int last = buf->len == 0;
+        if (last && s->index == PIPE_STAGES - 1)
+        {
+            break;
+        }
+        if (!ring_push(p, out, buf, st) || last)
+        {
+            break;
+        }
+    }
+    return NULL;
+}
+
+/* Print per stage utilization and name the stage that set the pace */
+static void print_stage_stats(const Pipeline *p, unsigned long long wall_ns, off_t length)
+{
+    int slowest = 0;
+    double wall = wall_ns ? (double)wall_ns : 1.0;
+
+    printf("Pipeline: %.1f MB of carrier in %.3f s (%.1f MB/s)\n", length / 1e6, wall_ns / 1e9, length / 1e6 / (wall / 1e9));
+    for (int i = 0; i < PIPE_STAGES; i++)
+    {
+        const StageStats *st = &p->stats[i];
+        printf("  %-9s : %6lu blocks, busy %5.1f%%, waiting for input %5.1f%%, blocked on output %5.1f%%\n", st->name, st->blocks,
+               100.0 * st->busy_ns / wall, 100.0 * st->starved_ns / wall, 100.0 * st->blocked_ns / wall);
+        if (st->busy_ns > p->stats[slowest].busy_ns)
+        {
+            slowest = i;
+        }
+    }
+    printf("  Bottleneck: %s stage\n", p->stats[slowest].name);
+}
+
+/* Embed the secret file into carrier range [offset, offset + length) through the staged pipeline */
+Status pipeline_embed_range(EncodeInfo *encInfo, off_t offset, off_t length, uint buffers)
+{
+    static const char *const names[PIPE_STAGES] = { "read", "embed", "write" };
+    Pipeline p;
+    PipeBuffer *pool;
+    Status ret = e_success;
+
+    // STEP 1 : Shared state; every stage ring holds half the pool so a fast stage blocks on its output,
+    //          the free ring holds the whole pool
+    memset(&p, 0, sizeof(p));
+    p.encInfo = encInfo;
+    p.in_fd = fileno(encInfo->fptr_src_image);
+    p.out_fd = fileno(encInfo->fptr_stego_image);
+    p.next = offset;
+    p.end = offset + length;
+    atomic_init(&p.failed, 0);
+    if (buffers == 0)
+    {
+        buffers = PIPE_DEFAULT_BUFFERS;
+    }
+    for (int i = 0; i < PIPE_STAGES; i++)
+    {
+        p.stats[i].name = names[i];
+        if (ring_init(&p.rings[i], i == 0 ? buffers : (buffers + 1) / 2) == e_failure)
+        {
+            ret = e_failure;
+        }
+    }
+
+    // STEP 2 : Buffer pool, all of it starts in the free ring (plus the embed stage's compare copy with --metrics)
+    p.kernel = lsb_kernel_select(1, 3, LSB_MASK_BGR);
+    if (encInfo->metrics && (p.before = malloc(PIPE_BLOCK)) == NULL)
+    {
+        ret = e_failure;
+    }
+    pool = calloc(buffers, sizeof(*pool));
+    for (uint i = 0; pool != NULL && i < buffers && ret == e_success; i++)
+    {
+        pool[i].carrier = malloc(PIPE_BLOCK);
+        pool[i].payload = malloc(PIPE_BLOCK / 8);
+        if (pool[i].carrier == NULL || pool[i].payload == NULL)
+        {
+            ret = e_failure;
+            break;
+        }
+        p.rings[0].items[i] = &pool[i];
+    }
+    if (pool == NULL || ret == e_failure)
+    {
+        printf("Error: Unable to allocate pipeline buffers.\n");
+        ret = e_failure;
+    }
+
+    // STEP 3 : One thread per stage, wait for the end marker to drain through all of them
+    if (ret == e_success)
+    {
+        pthread_t threads[PIPE_STAGES];
+        StageArg args[PIPE_STAGES];
+        atomic_store(&p.rings[0].head, buffers);
+
+        unsigned long long start = now_ns();
+        int started = 0;
+        for (; started < PIPE_STAGES; started++)
+        {
+            args[started].p = &p;
+            args[started].index = started;
+            if (pthread_create(&threads[started], NULL, stage_thread, &args[started]) != 0)
+            {
+                // A stage is missing: wake and stop the ones already running, then only join those
+                printf("Error: Cannot start the %s stage thread.\n", names[started]);
+                pipeline_fail(&p);
+                break;
+            }
+        }
+        for (int i = 0; i < started; i++)
+        {
+            pthread_join(threads[i], NULL);
+        }
+
+        if (atomic_load(&p.failed))
+        {
+            ret = e_failure;
+        }
+        else
+        {
+            print_stage_stats(&p, now_ns() - start, length);
+        }
+    }
+
+    // STEP 4 : Release pool and rings
+    for (uint i = 0; pool != NULL && i < buffers; i++)
+    {
+        free(pool[i].carrier);
+        free(pool[i].payload);
+    }
+    free(pool);
+    free(p.before);
+    for (int i = 0; i < PIPE_STAGES; i++)
+    {
+        free(p.rings[i].items);
+        pthread_mutex_destroy(&p.rings[i].lock);
+        pthread_cond_destroy(&p.rings[i].cond);
+    }
+    return ret;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/* ============================================================================= END OF CODE ===========================================================================*/
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -0,0 +1,42 @@
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// ============================================================ * * * * * pipeline.h * * * * * ======================================================================== //
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/*
+
+### USAGE OF pipeline.h FILE IN STEGANOGRAPHY PROJECT ?
+--> THIS HEADER FILE DECLARES THE STAGED ENCODING PIPELINE FOR THE SECRET DATA REGION. THREE THREADS (READ -> EMBED -> WRITE) PASS POOLED BLOCK BUFFERS TO EACH
+    OTHER THROUGH BOUNDED LOCK-FREE SINGLE-PRODUCER / SINGLE-CONSUMER RINGS, SO BIT EMBEDDING AND DISK I/O OVERLAP AND THE SLOWEST STAGE SETS THE THROUGHPUT. WHEN THE POOL IS EMPTY THE READER WAITS, WHICH IS THE BACKPRESSURE THAT BOUNDS MEMORY.
+
+*/
+
+// ==================================================================================================================================================================== //
+
+#ifndef PIPELINE_H
+#define PIPELINE_H
+
+/* ====================================================================== INCLUDES ==================================================================================== */
+
+#include <stddef.h>
+#include <sys/types.h>
+#include "types.h"
+#include "encode.h"
+
+/* ======================================================================= MACROS ===================================================================================== */
+
+#define PIPE_DEFAULT_BUFFERS 8          // Pooled buffers in flight (--pipeline)
+#define PIPE_MAX_BUFFERS 1024           // Largest accepted --pipeline=N
+#define PIPE_BLOCK (256 * 1024)         // Carrier bytes per buffer (payload bytes = PIPE_BLOCK / 8)
+#define PIPE_SPIN 64                    // Empty / full ring polls before a waiting stage yields the CPU
+#define PIPE_YIELDS 8                   // Yields before a waiting stage sleeps until the ring moves
+
+/* ================================================================= FUNCTION PROTOTYPES ============================================================================== */
+
+/* Embed the secret file into carrier range [offset, offset + length) of the source, written to the same range of the stego image */
+Status pipeline_embed_range(EncodeInfo *encInfo, off_t offset, off_t length, uint buffers);
+
+#endif
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/* ============================================================================= END OF CODE ===========================================================================*/
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -0,0 +1,248 @@
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// ============================================================ * * * * * quality.c * * * * * ========================================================================= //
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/*
+
+### USAGE OF quality.c FILE IN STEGANOGRAPHY PROJECT ?
+--> THIS FILE IMPLEMENTS THE QUALITY METRICS. THE SSE2 / AVX2 KERNELS TAKE THREE VECTORS AT A TIME (48 / 96 BYTES, SO EVERY UNIT STARTS ON THE SAME COLOUR CHANNEL),
+    TURN "WENT UP", "WENT DOWN" AND "MOVED BY MORE THAN ONE" INTO BYTE MASKS WITH SATURATING SUBTRACTS AND COUNT THEM PER CHANNEL WITH A MOVEMASK AND A POPCOUNT
+    AGAINST PRECOMPUTED CHANNEL BIT PATTERNS. A +-1 CHANGE ADDS 1 TO THE SQUARED ERROR, SO ONLY THE RARE VECTORS WITH LARGER CHANGES ARE SUMMED BYTE BY BYTE.
+
+*/
+
+/* ====================================================================== INCLUDES ==================================================================================== */
+
+#include <stdio.h>       // printf
+#include <string.h>      // memset
+#include <stdint.h>      // uint32_t channel masks
+#include <math.h>        // log10
+#include <pthread.h>     // pthread_once
+#include "quality.h"     // Prototypes
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>   // SSE2 / AVX2 kernels
+#define QUALITY_HAVE_X86 1
+#endif
+
+/* ======================================================================= MACROS ===================================================================================== */
+
+#define BMP_HEADER 54    // Pixel data offset the rest of the project assumes
+
+/* ======================================================================= STRUCTURE ================================================================================== */
+
+/* Counts of one call; bin 2 (unchanged) is derived from the channel byte counts afterwards */
+typedef struct
+{
+    unsigned long long hist[3][QUALITY_BINS];
+    unsigned long long sse[3];
+} QualityAcc;
+
+/* Kernel over units of 3 vectors; bits[k][c] has bit i set when byte i of vector k belongs to channel c */
+typedef void (*QualityFn)(QualityAcc *acc, const unsigned char *before, const unsigned char *after, size_t units, const uint32_t bits[3][3]);
+
+static QualityFn quality_units;
+static size_t quality_width;     // Vector width of quality_units in bytes (0 = scalar only)
+
+/* ================================================================= FUNCTION DEFINITIONS ============================================================================= */
+
+/* Byte by byte, channel phase first */
+static void quality_scalar(QualityAcc *acc, const unsigned char *before, const unsigned char *after, size_t len, uint32_t channel)
+{
+    for (size_t i = 0; i < len; i++)
+    {
+        int d = after[i] - before[i];
+        if (d != 0)
+        {
+            acc->hist[channel][d <= -2 ? 0 : d >= 2 ? 4 : d + 2]++;
+            acc->sse[channel] += d * d;
+        }
+        channel = channel == 2 ? 0 : channel + 1;
+    }
+}
+
+/* Masks of one vector: count every change class per channel */
+static inline void count_masks(QualityAcc *acc, uint32_t up, uint32_t down, uint32_t big, const uint32_t bits[3])
+{
+    for (int c = 0; c < 3; c++)
+    {
+        acc->hist[c][0] += __builtin_popcount(down & big & bits[c]);
+        acc->hist[c][1] += __builtin_popcount(down & ~big & bits[c]);
+        acc->hist[c][3] += __builtin_popcount(up & ~big & bits[c]);
+        acc->hist[c][4] += __builtin_popcount(up & big & bits[c]);
+        acc->sse[c] += __builtin_popcount((up | down) & ~big & bits[c]);
+    }
+}
+
+/* Squared error of the bytes that moved by more than one */
+static inline void add_big_sse(QualityAcc *acc, const unsigned char *before, const unsigned char *after, uint32_t big, const uint32_t bits[3])
+{
+    while (big != 0)
+    {
+        int i = __builtin_ctz(big);
+        int d = after[i] - before[i];
+        int c = (bits[0] >> i) & 1 ? 0 : (bits[1] >> i) & 1 ? 1 : 2;
+        acc->sse[c] += d * d;
+        big &= big - 1;
+    }
+}
+
+#ifdef QUALITY_HAVE_X86
+__attribute__((target("sse2,popcnt")))
+static void quality_sse2(QualityAcc *acc, const unsigned char *before, const unsigned char *after, size_t units, const uint32_t bits[3][3])
+{
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i one = _mm_set1_epi8(1);
+
+    for (size_t u = 0; u < units; u++)
+    {
+        for (int k = 0; k < 3; k++)
+        {
+            size_t at = u * 48 + k * 16;
+            __m128i b = _mm_loadu_si128((const __m128i *)(before + at));
+            __m128i a = _mm_loadu_si128((const __m128i *)(after + at));
+            __m128i up = _mm_subs_epu8(a, b);
+            __m128i down = _mm_subs_epu8(b, a);
+            uint32_t m_up = ~_mm_movemask_epi8(_mm_cmpeq_epi8(up, zero)) & 0xFFFF;
+            uint32_t m_down = ~_mm_movemask_epi8(_mm_cmpeq_epi8(down, zero)) & 0xFFFF;
+            if ((m_up | m_down) == 0)
+            {
+                continue;
+            }
+            uint32_t m_big = ~_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_subs_epu8(_mm_or_si128(up, down), one), zero)) & 0xFFFF;
+            count_masks(acc, m_up, m_down, m_big, bits[k]);
+            add_big_sse(acc, before + at, after + at, m_big, bits[k]);
+        }
+    }
+}
+
+__attribute__((target("avx2,popcnt")))
+static void quality_avx2(QualityAcc *acc, const unsigned char *before, const unsigned char *after, size_t units, const uint32_t bits[3][3])
+{
+    const __m256i zero = _mm256_setzero_si256();
+    const __m256i one = _mm256_set1_epi8(1);
+
+    for (size_t u = 0; u < units; u++)
+    {
+        for (int k = 0; k < 3; k++)
+        {
+            size_t at = u * 96 + k * 32;
+            __m256i b = _mm256_loadu_si256((const __m256i *)(before + at));
+            __m256i a = _mm256_loadu_si256((const __m256i *)(after + at));
+            __m256i up = _mm256_subs_epu8(a, b);
+            __m256i down = _mm256_subs_epu8(b, a);
+            uint32_t m_up = ~(uint32_t)_mm256_movemask_epi8(_mm256_cmpeq_epi8(up, zero));
+            uint32_t m_down = ~(uint32_t)_mm256_movemask_epi8(_mm256_cmpeq_epi8(down, zero));
+            if ((m_up | m_down) == 0)
+            {
+                continue;
+            }
+            uint32_t m_big = ~(uint32_t)_mm256_movemask_epi8(_mm256_cmpeq_epi8(_mm256_subs_epu8(_mm256_or_si256(up, down), one), zero));
+            count_masks(acc, m_up, m_down, m_big, bits[k]);
+            add_big_sse(acc, before + at, after + at, m_big, bits[k]);
+        }
+    }
+}
+#endif
+
+/* Pick the widest kernel once */
+static void quality_init(void)
+{
+#ifdef QUALITY_HAVE_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2"))
+    {
+        quality_units = quality_avx2;
+        quality_width = 32;
+    }
+    else if (__builtin_cpu_supports("sse2"))
+    {
+        quality_units = quality_sse2;
+        quality_width = 16;
+    }
+#endif
+}
+
+/* Kernel chosen once, safe for concurrent --metrics jobs */
+static void quality_setup(void)
+{
+    static pthread_once_t once = PTHREAD_ONCE_INIT;
+    pthread_once(&once, quality_init);
+}
+
+void quality_update(QualityStats *q, const unsigned char *before, const unsigned char *after, size_t len, unsigned long long offset)
+{
+    QualityAcc acc;
+    size_t done = 0;
+    uint32_t phase = offset >= BMP_HEADER ? (offset - BMP_HEADER) % 3 : 0;
+
+    memset(&acc, 0, sizeof(acc));
+    quality_setup();
+
+    // STEP 1 : Whole units through the vector kernel, channel patterns for this phase
+    if (quality_units != NULL && len >= 3 * quality_width)
+    {
+        uint32_t bits[3][3];
+        memset(bits, 0, sizeof(bits));
+        for (size_t k = 0; k < 3; k++)
+        {
+            for (size_t i = 0; i < quality_width; i++)
+            {
+                bits[k][(phase + k * quality_width + i) % 3] |= 1u << i;
+            }
+        }
+        size_t units = len / (3 * quality_width);
+        quality_units(&acc, before, after, units, bits);
+        done = units * 3 * quality_width;
+    }
+
+    // STEP 2 : Tail (a unit is a multiple of 3 bytes, so the phase is unchanged)
+    quality_scalar(&acc, before + done, after + done, len - done, phase);
+
+    // STEP 3 : Unchanged bytes = bytes of the channel in this range - changed ones
+    for (uint32_t c = 0; c < 3; c++)
+    {
+        size_t first = (c + 3 - phase) % 3;
+        unsigned long long channel_bytes = len > first ? (len - first + 2) / 3 : 0;
+        unsigned long long changed = 0;
+        for (int bin = 0; bin < QUALITY_BINS; bin++)
+        {
+            q->hist[c][bin] += acc.hist[c][bin];
+            changed += acc.hist[c][bin];
+        }
+        q->hist[c][2] += channel_bytes - changed;
+        q->sse[c] += acc.sse[c];
+    }
+    q->compared += len;
+}
+
+/* PSNR of 8 bit samples for a mean squared error */
+static double psnr_db(double mse)
+{
+    return mse > 0 ? 10.0 * log10(255.0 * 255.0 / mse) : INFINITY;
+}
+
+void quality_report(const QualityStats *q)
+{
+    static const char *const channels[3] = { "blue", "green", "red" };
+    unsigned long long changed = 0, sse = 0;
+    double pixel_bytes = q->pixel_bytes ? (double)q->pixel_bytes : 1.0;
+
+    for (int c = 0; c < 3; c++)
+    {
+        changed += q->hist[c][0] + q->hist[c][1] + q->hist[c][3] + q->hist[c][4];
+        sse += q->sse[c];
+    }
+    printf("Quality: %llu of %llu pixel bytes changed (%.3f %%), MSE %.6f, PSNR %.2f dB\n", changed, q->pixel_bytes,
+           100.0 * changed / pixel_bytes, sse / pixel_bytes, psnr_db(sse / pixel_bytes));
+    for (int c = 0; c < 3; c++)
+    {
+        double mse = q->sse[c] / (pixel_bytes / 3);
+        printf("  %-5s : <=-2 %llu, -1 %llu, 0 %llu, +1 %llu, >=+2 %llu, MSE %.6f, PSNR %.2f dB\n", channels[c], q->hist[c][0],
+               q->hist[c][1], q->hist[c][2], q->hist[c][3], q->hist[c][4], mse, psnr_db(mse));
+    }
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/* ============================================================================= END OF CODE ===========================================================================*/
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
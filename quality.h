@@ -0,0 +1,50 @@
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// ============================================================ * * * * * quality.h * * * * * ========================================================================= //
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/*
+
+### USAGE OF quality.h FILE IN STEGANOGRAPHY PROJECT ?
+--> THIS HEADER FILE DECLARES THE IMAGE QUALITY METRICS GATHERED WHILE EMBEDDING (--metrics). EVERY BLOCK OF CARRIER BYTES IS COMPARED BEFORE AND AFTER IT IS EMBEDDED,
+    SO THE STEGO IMAGE NEVER HAS TO BE READ BACK: PER COLOUR CHANNEL A HISTOGRAM OF THE BYTE CHANGES AND THE SUM OF SQUARED DIFFERENCES ARE KEPT, FROM WHICH THE
+    CHANGED BYTE COUNT, MSE AND PSNR OF THE WHOLE PIXEL ARRAY ARE REPORTED.
+
+*/
+
+// ==================================================================================================================================================================== //
+
+#ifndef QUALITY_H
+#define QUALITY_H
+
+/* ====================================================================== INCLUDES ==================================================================================== */
+
+#include <stddef.h>
+
+/* ======================================================================= MACROS ===================================================================================== */
+
+#define QUALITY_BINS 5      // Change histogram bins: <= -2, -1, 0, +1, >= +2
+
+/* ======================================================================= STRUCTURE ================================================================================== */
+
+/* Change counters of one embedding run; channel 0 / 1 / 2 is blue / green / red (BMP byte order) */
+typedef struct
+{
+    unsigned long long pixel_bytes;                 // Size of the pixel array (width * height * 3), the MSE denominator
+    unsigned long long compared;                    // Carrier bytes passed through quality_update()
+    unsigned long long hist[3][QUALITY_BINS];       // Per channel change histogram
+    unsigned long long sse[3];                      // Per channel sum of squared differences
+} QualityStats;
+
+/* ================================================================= FUNCTION PROTOTYPES ============================================================================= */
+
+/* Count the changes between the before and after copies of len carrier bytes that start at file offset offset */
+void quality_update(QualityStats *q, const unsigned char *before, const unsigned char *after, size_t len, unsigned long long offset);
+
+/* Print changed bytes, MSE and PSNR, overall and per channel */
+void quality_report(const QualityStats *q);
+
+#endif
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/* ============================================================================= END OF CODE ===========================================================================*/
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -0,0 +1,454 @@
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// ============================================================ * * * * * sanitize.c * * * * * ======================================================================== //
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/*
+
+### USAGE OF sanitize.c FILE IN STEGANOGRAPHY PROJECT ?
+--> THIS FILE IMPLEMENTS THE LSB SANITIZER. THE PIXEL ROWS ARE FOUND FROM THE BMP HEADERS (PIXEL OFFSET, WIDTH, HEIGHT, BITS PER PIXEL); WITHOUT ROW PADDING THE
+    WHOLE PIXEL ARRAY IS ONE RUN, OTHERWISE EVERY ROW IS ONE. THE ZERO KERNEL ANDS EVERY BYTE WITH 0xFE; THE RANDOM KERNEL STEPS FOUR XORSHIFT128+ LANES AND USES
+    EACH 64 BIT WORD FOR 64 BYTES (BIT K OF EVERY BYTE OF THE WORD, K = 0 .. 7, BECOMES ONE LSB MASK). SCALAR, SSE2 AND AVX2 KERNELS EXIST; THE WIDEST ONE THE CPU
+    SUPPORTS IS PICKED ONCE.
+
+*/
+
+/* ====================================================================== INCLUDES ==================================================================================== */
+
+#include <stdio.h>          // printf
+#include <stdlib.h>         // calloc, free, atoi
+#include <string.h>         // memcpy, memset, strcmp
+#include <pthread.h>        // Image workers
+#include <unistd.h>         // sysconf, getpid
+#include <time.h>           // clock_gettime
+#include <sys/mman.h>       // madvise, munmap
+#include <sys/random.h>     // getrandom
+#include "common.h"         // OPTION_VALUE
+#include "fastcopy.h"       // map_image_file
+#include "index.h"          // ImageList, image_list_add
+#include "sanitize.h"       // Prototypes
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>      // SSE2 / AVX2 kernels
+#define SANITIZE_HAVE_X86 1
+#endif
+
+/* ======================================================================= MACROS ===================================================================================== */
+
+#define LSB_ONES 0x0101010101010101ULL
+
+/* ======================================================================= STRUCTURE ================================================================================== */
+
+/* Images of one run and their results, in input order */
+typedef struct
+{
+    ImageList images;
+    unsigned long long *pixel_bytes;
+    Status *status;
+    int next;               // Next image handed to a worker
+    int next_seed;          // Next worker seed index
+    SanitizeMode mode;
+    uint64_t seed;
+} SanitizeSet;
+
+/* Kernel over len bytes */
+typedef void (*SanitizeFn)(unsigned char *p, size_t len, SanitizeRng *rng);
+
+static SanitizeFn zero_kernel, random_kernel;
+static const char *kernel_name = "scalar";
+
+/* ================================================================= FUNCTION DEFINITIONS ============================================================================= */
+
+Status read_bmp_layout(const unsigned char *image, size_t size, BmpLayout *layout)
+{
+    uint32_t offset, compression;
+    int32_t width, height;
+    uint16_t bpp;
+
+    if (size < 54 || image[0] != 'B' || image[1] != 'M')
+    {
+        return e_failure;
+    }
+    memcpy(&offset, image + 10, 4);
+    memcpy(&width, image + 18, 4);
+    memcpy(&height, image + 22, 4);
+    memcpy(&bpp, image + 28, 2);
+    memcpy(&compression, image + 30, 4);
+
+    // Uncompressed 24 bit, or 32 bit (also with bit field masks); a negative height only means top-down rows
+    if (offset < 54 || width <= 0 || height == 0 || height == INT32_MIN || (bpp != 24 && bpp != 32) || !(compression == 0 || (compression == 3 && bpp == 32)))
+    {
+        return e_failure;
+    }
+    uint64_t row_bytes = (uint64_t)width * (bpp / 8);
+    uint64_t stride = (row_bytes + 3) & ~3ULL;
+    uint64_t rows = height < 0 ? -(int64_t)height : height;
+    if (offset + stride * rows > size)
+    {
+        return e_failure;
+    }
+    layout->data_offset = offset;
+    layout->row_bytes = row_bytes;
+    layout->stride = stride;
+    layout->rows = rows;
+    return e_success;
+}
+
+void sanitize_seed(SanitizeRng *rng, uint64_t seed)
+{
+    // splitmix64 expansion, no lane starts all zero
+    for (int i = 0; i < 8; i++)
+    {
+        uint64_t z = (seed += 0x9E3779B97F4A7C15ULL);
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+        (i < 4 ? rng->s0 : rng->s1)[i % 4] = (z ^ (z >> 31)) | 1;
+    }
+}
+
+/* Next word of lane 0 */
+static inline uint64_t rng_next(SanitizeRng *rng)
+{
+    uint64_t s1 = rng->s0[0];
+    const uint64_t s0 = rng->s1[0];
+
+    rng->s0[0] = s0;
+    s1 ^= s1 << 23;
+    rng->s1[0] = s1 ^ s0 ^ (s1 >> 17) ^ (s0 >> 26);
+    return rng->s1[0] + s0;
+}
+
+static void zero_scalar(unsigned char *p, size_t len, SanitizeRng *rng)
+{
+    (void)rng;
+    for (; len >= 8; p += 8, len -= 8)
+    {
+        uint64_t x;
+        memcpy(&x, p, 8);
+        x &= ~LSB_ONES;
+        memcpy(p, &x, 8);
+    }
+    for (; len > 0; p++, len--)
+    {
+        *p &= 0xFE;
+    }
+}
+
+static void random_scalar(unsigned char *p, size_t len, SanitizeRng *rng)
+{
+    while (len > 0)
+    {
+        uint64_t r = rng_next(rng);
+        for (int k = 0; k < 8 && len > 0; k++)
+        {
+            uint64_t bits = (r >> k) & LSB_ONES;
+            if (len >= 8)
+            {
+                uint64_t x;
+                memcpy(&x, p, 8);
+                x = (x & ~LSB_ONES) | bits;
+                memcpy(p, &x, 8);
+                p += 8;
+                len -= 8;
+            }
+            else
+            {
+                for (size_t i = 0; i < len; i++)
+                {
+                    p[i] = (p[i] & 0xFE) | ((bits >> (8 * i)) & 1);
+                }
+                len = 0;
+            }
+        }
+    }
+}
+
+#ifdef SANITIZE_HAVE_X86
+__attribute__((target("sse2")))
+static void zero_sse2(unsigned char *p, size_t len, SanitizeRng *rng)
+{
+    const __m128i keep = _mm_set1_epi8((char)0xFE);
+
+    for (; len >= 64; p += 64, len -= 64)
+    {
+        for (int q = 0; q < 4; q++)
+        {
+            __m128i x = _mm_loadu_si128((const __m128i *)(p + 16 * q));
+            _mm_storeu_si128((__m128i *)(p + 16 * q), _mm_and_si128(x, keep));
+        }
+    }
+    zero_scalar(p, len, rng);
+}
+
+/* Lanes 0 and 1: 16 random bytes spread over 128 carrier bytes per step */
+__attribute__((target("sse2")))
+static void random_sse2(unsigned char *p, size_t len, SanitizeRng *rng)
+{
+    const __m128i keep = _mm_set1_epi8((char)0xFE);
+    const __m128i ones = _mm_set1_epi8(1);
+    __m128i a = _mm_loadu_si128((const __m128i *)rng->s0);
+    __m128i b = _mm_loadu_si128((const __m128i *)rng->s1);
+
+    for (; len >= 128; p += 128, len -= 128)
+    {
+        __m128i s1 = a, s0 = b;
+        a = s0;
+        s1 = _mm_xor_si128(s1, _mm_slli_epi64(s1, 23));
+        b = _mm_xor_si128(_mm_xor_si128(s1, s0), _mm_xor_si128(_mm_srli_epi64(s1, 17), _mm_srli_epi64(s0, 26)));
+        __m128i r = _mm_add_epi64(b, s0);
+#pragma GCC unroll 8
+        for (int k = 0; k < 8; k++)
+        {
+            __m128i x = _mm_loadu_si128((const __m128i *)(p + 16 * k));
+            __m128i bits = _mm_and_si128(_mm_srli_epi64(r, k), ones);
+            _mm_storeu_si128((__m128i *)(p + 16 * k), _mm_or_si128(_mm_and_si128(x, keep), bits));
+        }
+    }
+    _mm_storeu_si128((__m128i *)rng->s0, a);
+    _mm_storeu_si128((__m128i *)rng->s1, b);
+    random_scalar(p, len, rng);
+}
+
+__attribute__((target("avx2")))
+static void zero_avx2(unsigned char *p, size_t len, SanitizeRng *rng)
+{
+    const __m256i keep = _mm256_set1_epi8((char)0xFE);
+
+    for (; len >= 128; p += 128, len -= 128)
+    {
+        for (int q = 0; q < 4; q++)
+        {
+            __m256i x = _mm256_loadu_si256((const __m256i *)(p + 32 * q));
+            _mm256_storeu_si256((__m256i *)(p + 32 * q), _mm256_and_si256(x, keep));
+        }
+    }
+    zero_scalar(p, len, rng);
+}
+
+/* All four lanes: 32 random bytes spread over 256 carrier bytes per step */
+__attribute__((target("avx2")))
+static void random_avx2(unsigned char *p, size_t len, SanitizeRng *rng)
+{
+    const __m256i keep = _mm256_set1_epi8((char)0xFE);
+    const __m256i ones = _mm256_set1_epi8(1);
+    __m256i a = _mm256_loadu_si256((const __m256i *)rng->s0);
+    __m256i b = _mm256_loadu_si256((const __m256i *)rng->s1);
+
+    for (; len >= 256; p += 256, len -= 256)
+    {
+        __m256i s1 = a, s0 = b;
+        a = s0;
+        s1 = _mm256_xor_si256(s1, _mm256_slli_epi64(s1, 23));
+        b = _mm256_xor_si256(_mm256_xor_si256(s1, s0), _mm256_xor_si256(_mm256_srli_epi64(s1, 17), _mm256_srli_epi64(s0, 26)));
+        __m256i r = _mm256_add_epi64(b, s0);
+#pragma GCC unroll 8
+        for (int k = 0; k < 8; k++)
+        {
+            __m256i x = _mm256_loadu_si256((const __m256i *)(p + 32 * k));
+            __m256i bits = _mm256_and_si256(_mm256_srli_epi64(r, k), ones);
+            _mm256_storeu_si256((__m256i *)(p + 32 * k), _mm256_or_si256(_mm256_and_si256(x, keep), bits));
+        }
+    }
+    _mm256_storeu_si256((__m256i *)rng->s0, a);
+    _mm256_storeu_si256((__m256i *)rng->s1, b);
+    random_scalar(p, len, rng);
+}
+#endif
+
+static void sanitize_init(void)
+{
+    zero_kernel = zero_scalar;
+    random_kernel = random_scalar;
+#ifdef SANITIZE_HAVE_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2"))
+    {
+        zero_kernel = zero_avx2;
+        random_kernel = random_avx2;
+        kernel_name = "avx2";
+    }
+    else if (__builtin_cpu_supports("sse2"))
+    {
+        zero_kernel = zero_sse2;
+        random_kernel = random_sse2;
+        kernel_name = "sse2";
+    }
+#endif
+}
+
+/* Kernels chosen once, the image workers may all start here */
+static void sanitize_setup(void)
+{
+    static pthread_once_t once = PTHREAD_ONCE_INIT;
+    pthread_once(&once, sanitize_init);
+}
+
+void sanitize_lsbs(unsigned char *p, size_t len, SanitizeMode mode, SanitizeRng *rng)
+{
+    sanitize_setup();
+    (mode == e_sanitize_zero ? zero_kernel : random_kernel)(p, len, rng);
+}
+
+Status sanitize_image(const char *fname, SanitizeMode mode, SanitizeRng *rng, unsigned long long *pixel_bytes)
+{
+    BmpLayout lay;
+    size_t size = 0;
+    unsigned char *image = NULL;
+
+    sanitize_setup();
+    *pixel_bytes = 0;
+
+    // STEP 1 : Whole file mapped read-write and shared, so every hard link of the image loses the payload with it
+    image = map_image_file(NULL, fname, 1, &size);
+    if (image == NULL || read_bmp_layout(image, size, &lay) == e_failure)
+    {
+        printf("Error: %s is not a writable 24 / 32 bit uncompressed BMP image\n", fname);
+        if (image != NULL)
+        {
+            munmap(image, size);
+        }
+        return e_failure;
+    }
+    madvise(image, size, MADV_SEQUENTIAL);
+
+    // STEP 2 : Pixel bytes only: one run without row padding, one run per row with it
+    SanitizeFn fn = mode == e_sanitize_zero ? zero_kernel : random_kernel;
+    unsigned char *pixels = image + lay.data_offset;
+    if (lay.stride == lay.row_bytes)
+    {
+        fn(pixels, (size_t)lay.row_bytes * lay.rows, rng);
+    }
+    else
+    {
+        for (uint32_t r = 0; r < lay.rows; r++)
+        {
+            fn(pixels + (size_t)r * lay.stride, lay.row_bytes, rng);
+        }
+    }
+    *pixel_bytes = (unsigned long long)lay.row_bytes * lay.rows;
+
+    munmap(image, size);
+    return e_success;
+}
+
+/* Worker body: own generator, then take the next image until all are done */
+static void *sanitize_worker(void *arg)
+{
+    SanitizeSet *set = arg;
+    SanitizeRng rng;
+    int i;
+
+    sanitize_seed(&rng, set->seed + 0x1000003ULL * __atomic_fetch_add(&set->next_seed, 1, __ATOMIC_RELAXED));
+    while ((i = __atomic_fetch_add(&set->next, 1, __ATOMIC_RELAXED)) < set->images.count)
+    {
+        set->status[i] = sanitize_image(set->images.names[i], set->mode, &rng, &set->pixel_bytes[i]);
+    }
+    return NULL;
+}
+
+Status do_sanitize(char *paths[], int count, int opt_count, char *opts[])
+{
+    SanitizeSet set;
+    long threads = 0;
+    const char *value;
+    struct timespec t0, t1;
+    Status ret = e_success;
+
+    memset(&set, 0, sizeof(set));
+
+    // STEP 1 : Options
+    for (int i = 0; i < opt_count; i++)
+    {
+        if ((value = OPTION_VALUE(opts[i], "--threads=")) != NULL && atoi(value) > 0)
+        {
+            threads = atoi(value);
+        }
+        else if ((value = OPTION_VALUE(opts[i], "--mode=")) != NULL && (strcmp(value, "random") == 0 || strcmp(value, "zero") == 0))
+        {
+            set.mode = strcmp(value, "zero") == 0 ? e_sanitize_zero : e_sanitize_random;
+        }
+        else
+        {
+            printf("Error: Unknown sanitize option %s\n", opts[i]);
+            return e_failure;
+        }
+    }
+    if (getrandom(&set.seed, sizeof(set.seed), 0) != sizeof(set.seed))
+    {
+        set.seed = (uint64_t)time(NULL) << 20 ^ (uint64_t)getpid();
+    }
+
+    // STEP 2 : Image list (directories are walked for .bmp files)
+    for (int i = 0; i < count && ret == e_success; i++)
+    {
+        ret = image_list_add(&set.images, paths[i]);
+    }
+    if (ret == e_success && set.images.count == 0)
+    {
+        printf("Error: No BMP images to sanitize\n");
+        ret = e_failure;
+    }
+    if (ret == e_success && ((set.pixel_bytes = calloc(set.images.count, sizeof(*set.pixel_bytes))) == NULL ||
+                             (set.status = calloc(set.images.count, sizeof(*set.status))) == NULL))
+    {
+        ret = e_failure;
+    }
+
+    // STEP 3 : One image per worker at a time (one worker per CPU unless given)
+    if (ret == e_success)
+    {
+        if (threads <= 0)
+        {
+            threads = sysconf(_SC_NPROCESSORS_ONLN);
+            threads = threads > 0 ? threads : 1;
+        }
+        if (threads > set.images.count)
+        {
+            threads = set.images.count;
+        }
+
+        pthread_t tids[threads];
+        sanitize_setup();
+        clock_gettime(CLOCK_MONOTONIC, &t0);
+        long started = 0;
+        while (started < threads && pthread_create(&tids[started], NULL, sanitize_worker, &set) == 0)
+        {
+            started++;
+        }
+
+        // A worker that did not start leaves its images to this thread, so every image is still done
+        if (started < threads)
+        {
+            sanitize_worker(&set);
+            threads = started + 1;
+        }
+        for (long i = 0; i < started; i++)
+        {
+            pthread_join(tids[i], NULL);
+        }
+        clock_gettime(CLOCK_MONOTONIC, &t1);
+
+        // STEP 4 : Summary (failed images were reported by the workers)
+        unsigned long long bytes = 0;
+        int failed = 0;
+        for (int i = 0; i < set.images.count; i++)
+        {
+            failed += set.status[i] != e_success;
+            bytes += set.pixel_bytes[i];
+        }
+        double secs = (t1.tv_sec - t0.tv_sec) + (t1.tv_nsec - t0.tv_nsec) / 1e9;
+        secs = secs > 0 ? secs : 1e-9;
+        printf("Sanitized %d images (%.1f MB of pixels, LSBs %s) in %.3f s on %ld threads, %s kernel: %d failed, %.0f images/s, %.1f MB/s\n",
+               set.images.count - failed, bytes / 1e6, set.mode == e_sanitize_zero ? "zeroed" : "randomized", secs, threads, kernel_name, failed,
+               (set.images.count - failed) / secs, bytes / 1e6 / secs);
+        ret = failed == 0 ? e_success : e_failure;
+    }
+
+    image_list_free(&set.images);
+    free(set.pixel_bytes);
+    free(set.status);
+    return ret;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/* ============================================================================= END OF CODE ===========================================================================*/
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
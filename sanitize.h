@@ -0,0 +1,71 @@
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// ============================================================ * * * * * sanitize.h * * * * * ======================================================================== //
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/*
+
+### USAGE OF sanitize.h FILE IN STEGANOGRAPHY PROJECT ?
+--> THIS HEADER FILE DECLARES THE SANITIZER MODE (-z). EVERY BMP GIVEN ON THE COMMAND LINE (OR FOUND UNDER A GIVEN DIRECTORY) IS REWRITTEN IN PLACE SO ITS PIXEL LSB
+    PLANE NO LONGER CARRIES WHATEVER WAS HIDDEN IN IT: EACH LSB IS REPLACED BY A RANDOM BIT (--mode=random, THE DEFAULT) OR CLEARED (--mode=zero).
+    THE HEADERS AND THE PADDING AT THE END OF EVERY PIXEL ROW ARE LEFT AS THEY ARE. IMAGES ARE MAPPED INTO MEMORY AND PROCESSED BY SIMD KERNELS,
+    ONE IMAGE PER WORKER THREAD.
+
+*/
+
+// ==================================================================================================================================================================== //
+
+#ifndef SANITIZE_H
+#define SANITIZE_H
+
+/* ====================================================================== INCLUDES ==================================================================================== */
+
+#include <stdint.h>
+#include "types.h"
+
+/* ======================================================================= STRUCTURE ================================================================================== */
+
+//enum to represent what replaces the LSB plane
+typedef enum
+{
+    e_sanitize_random,  //A fresh random bit per byte ->> (--mode=random)
+    e_sanitize_zero     //Every LSB cleared ->> (--mode=zero)
+} SanitizeMode;
+
+/* Random bit generator of one worker: four xorshift128+ lanes */
+typedef struct
+{
+    uint64_t s0[4];
+    uint64_t s1[4];
+} SanitizeRng;
+
+/* Pixel layout of one BMP, from its headers */
+typedef struct
+{
+    uint32_t data_offset;           // First pixel byte (bfOffBits)
+    uint32_t row_bytes;             // Pixel bytes of one row (width * bytes per pixel)
+    uint32_t stride;                // Row bytes rounded up to 4, the rest is padding
+    uint32_t rows;
+} BmpLayout;
+
+/* ================================================================= FUNCTION PROTOTYPES ============================================================================== */
+
+/* Pixel layout of a mapped BMP (24 or 32 bit uncompressed), checked against its size */
+Status read_bmp_layout(const unsigned char *image, size_t size, BmpLayout *layout);
+
+/* Seed a generator (distinct seeds for distinct workers) */
+void sanitize_seed(SanitizeRng *rng, uint64_t seed);
+
+/* Replace the LSBs of len bytes at p (random bits or zeros) through the best kernel of the CPU */
+void sanitize_lsbs(unsigned char *p, size_t len, SanitizeMode mode, SanitizeRng *rng);
+
+/* Replace the LSB plane of one image in place; *pixel_bytes is the number of bytes rewritten */
+Status sanitize_image(const char *fname, SanitizeMode mode, SanitizeRng *rng, unsigned long long *pixel_bytes);
+
+/* Sanitize every image / directory in paths (--mode=random|zero, --threads=N) and print a summary */
+Status do_sanitize(char *paths[], int count, int opt_count, char *opts[]);
+
+#endif
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/* ============================================================================= END OF CODE ===========================================================================*/
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -0,0 +1,647 @@
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// ============================================================== * * * * * shard.c * * * * * ========================================================================= //
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/*
+
+### USAGE OF shard.c FILE IN STEGANOGRAPHY PROJECT ?
+--> THIS FILE IMPLEMENTS THE SHARDED MODE. ENCODING FIRST PLANS THE SPLIT (ONE CHUNK PER CARRIER, EACH AS LARGE AS THAT CARRIER CAN HOLD, THE PARITY CHUNK AS LARGE AS
+    THE LARGEST DATA CHUNK), BUILDS THE XOR PARITY IN MEMORY, THEN A POOL OF WORKER THREADS EMBEDS ONE SHARD PER CARRIER. EVERY SHARD IS AN EXTENDED PAYLOAD: "#+", MODE
+    WORD (MODE_SHARD [| MODE_SHARD_PARITY]), SHARD ID / COUNT, PAYLOAD ID, TOTAL SIZE, THEN THE USUAL EXTENSION SIZE, EXTENSION, CHUNK SIZE AND CHUNK DATA.
+    JOINING READS EVERY SHARD HEADER, CHECKS THAT ALL SHARDS BELONG TO THE SAME PAYLOAD AND THAT AT MOST ONE DATA SHARD IS MISSING (ONLY WITH PARITY), THEN WORKER
+    THREADS WRITE EACH CHUNK STRAIGHT TO ITS OFFSET OF THE OUTPUT FILE. A MISSING CHUNK IS REBUILT AS PARITY XOR ALL OTHER CHUNKS.
+
+*/
+
+/* ====================================================================== INCLUDES ==================================================================================== */
+
+#include <stdio.h>         // Std inbuilt functions
+#include <stdlib.h>        // malloc, calloc, free
+#include <string.h>        // Inbuilt string functions
+#include <pthread.h>       // Shard worker threads
+#include <fcntl.h>         // open
+#include <unistd.h>        // pread, pwrite, sysconf, ftruncate
+#include <time.h>          // Payload id fallback
+#include <sys/random.h>    // getrandom
+#include <sys/stat.h>      // stat
+#include "types.h"         // Status
+#include "common.h"        // MAGIC_STRING_EXT and MODE_* flags
+#include "encode.h"        // EncodeInfo and encoding steps
+#include "decode.h"        // DecodeInfo and decoding steps
+#include "ioengine.h"      // io_transform_range
+#include "lsbkernel.h"     // lsb_kernel_extract
+#include "shard.h"         // Prototypes
+
+/* ======================================================================= MACROS ===================================================================================== */
+
+// Carrier bits of a shard that are not chunk data: magic, mode word, id / count, payload id, total size, extension size, file size
+#define SHARD_HEADER_BITS (16 + 32 + 32 + 32 + 32 + 32 + 32)
+
+/* ======================================================================= STRUCTURE ================================================================================== */
+
+/* One shard to embed */
+typedef struct
+{
+    EncodeInfo enc;                 // Carrier, output and chunk of this shard
+    char stego_fname[4096];
+    uint id;
+    unsigned long long offset;      // Chunk position in the secret file (data shards)
+    int is_parity;
+    Status status;
+} ShardJob;
+
+/* One shard image found while joining */
+typedef struct
+{
+    char *fname;
+    int present;
+    uint len;                       // Chunk bytes
+    long data_offset;               // Carrier offset of the first chunk bit
+    unsigned long long out_offset;  // Chunk position in the output file
+    Status status;
+} ShardPiece;
+
+/* Shared state of a shard encode or join run */
+typedef struct _ShardSet
+{
+    // Encoding
+    ShardJob *jobs;
+    const char *secret_fname;
+    unsigned char *parity;          // XOR of all data chunks
+    uint mode;
+    uint payload_id;
+    uint total;
+
+    // Joining
+    ShardPiece *pieces;
+    int out_fd;
+    IoConfig io;
+
+    int count;                      // Jobs or pieces
+    int next;                       // Next job / piece handed to a worker
+    uint shard_count;
+    void (*work)(struct _ShardSet *, int);
+} ShardSet;
+
+/* Where extracted chunk bytes go: written to an output file, or XORed into a buffer */
+typedef struct
+{
+    int fd;
+    off_t pos;
+    unsigned char *xor_buf;
+    const LsbKernel *kernel;
+} ShardSink;
+
+/* ================================================================= FUNCTION DEFINITIONS ============================================================================= */
+
+/* Worker body: take the next job / piece index until all are done */
+static void *shard_worker(void *arg)
+{
+    ShardSet *set = arg;
+    int i;
+
+    while ((i = __atomic_fetch_add(&set->next, 1, __ATOMIC_RELAXED)) < set->count)
+    {
+        set->work(set, i);
+    }
+    return NULL;
+}
+
+/* Run work over every job / piece index on a pool of threads (one per CPU unless given) */
+static void run_shard_workers(ShardSet *set, void (*work)(ShardSet *, int), uint threads)
+{
+    if (threads == 0)
+    {
+        long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+        threads = cpus > 0 ? cpus : 1;
+    }
+    if (threads > (uint)set->count)
+    {
+        threads = set->count;
+    }
+
+    pthread_t tids[threads];
+    set->work = work;
+    set->next = 0;
+    uint started = 0;
+    while (started < threads && pthread_create(&tids[started], NULL, shard_worker, set) == 0)
+    {
+        started++;
+    }
+
+    // Fewer workers than asked for: this thread takes the indices they would have
+    if (started < threads)
+    {
+        shard_worker(set);
+    }
+    for (uint i = 0; i < started; i++)
+    {
+        pthread_join(tids[i], NULL);
+    }
+}
+
+/* Embed one shard: clone the carrier, shard header, then the usual payload fields for the chunk */
+static void encode_shard(ShardSet *set, int index)
+{
+    ShardJob *job = &set->jobs[index];
+    EncodeInfo *e = &job->enc;
+    job->status = e_failure;
+
+    // STEP 1 : Carrier, output image and the chunk source (secret file at the chunk offset, or the parity buffer)
+    e->fptr_src_image = fopen(e->src_image_fname, "r");
+    e->fptr_stego_image = fopen(e->stego_image_fname, "w");
+    if (job->is_parity)
+    {
+        e->fptr_secret = fmemopen(set->parity, e->size_secret_file, "r");
+    }
+    else
+    {
+        e->fptr_secret = fopen(set->secret_fname, "r");
+        if (e->fptr_secret != NULL && fseek(e->fptr_secret, job->offset, SEEK_SET) != 0)
+        {
+            fclose(e->fptr_secret);
+            e->fptr_secret = NULL;
+        }
+    }
+
+    // STEP 2 : Clone, extended header, shard fields, payload fields
+    if (e->fptr_src_image == NULL || e->fptr_stego_image == NULL || e->fptr_secret == NULL)
+    {
+        perror("fopen");
+        printf("Error: Unable to open files for shard %u.\n", job->id);
+    }
+    else if (clone_carrier_image(e) == e_failure ||
+             encode_magic_string(MAGIC_STRING_EXT, e) == e_failure ||
+             encode_mode_word(set->mode, e) == e_failure ||
+             encode_mode_word(job->id << 16 | set->shard_count, e) == e_failure ||
+             encode_mode_word(set->payload_id, e) == e_failure ||
+             encode_mode_word(set->total, e) == e_failure ||
+             encode_payload_fields(e) == e_failure ||
+             fflush(e->fptr_stego_image) != 0)
+    {
+        printf("Error: Failed to encode shard %u into %s.\n", job->id, e->stego_image_fname);
+    }
+    else
+    {
+        printf("Shard %u/%u: %ld bytes%s -> %s\n", job->id + 1, set->shard_count, e->size_secret_file,
+               job->is_parity ? " of parity" : "", e->stego_image_fname);
+        job->status = e_success;
+    }
+
+    // STEP 3 : Every shard owns its streams
+    if (e->fptr_src_image != NULL)
+    {
+        fclose(e->fptr_src_image);
+    }
+    if (e->fptr_stego_image != NULL && fclose(e->fptr_stego_image) != 0)
+    {
+        job->status = e_failure;
+    }
+    if (e->fptr_secret != NULL)
+    {
+        fclose(e->fptr_secret);
+    }
+}
+
+/* Chunk bytes a carrier can hold behind a shard header */
+static unsigned long long shard_capacity(const char *carrier, size_t extn_len)
+{
+    FILE *fp = fopen(carrier, "r");
+    if (fp == NULL)
+    {
+        perror(carrier);
+        return 0;
+    }
+    unsigned long long image_capacity = get_image_size_for_bmp(fp);
+    fclose(fp);
+
+    // check_capacity() wants strictly more carrier bytes than the payload needs
+    unsigned long long overhead = 54 + SHARD_HEADER_BITS + extn_len * 8;
+    return image_capacity > overhead ? (image_capacity - overhead - 1) / 8 : 0;
+}
+
+/* Split secret_fname over the carriers, writing <prefix>_<id>.bmp for every shard */
+Status do_shard_encoding(const char *secret_fname, const char *prefix, char *carriers[], int count, int parity, const EncodeInfo *base)
+{
+    ShardSet set;
+    struct stat st;
+    Status ret = e_success;
+
+    memset(&set, 0, sizeof(set));
+    if (base->fec_nsym != 0 || base->is_y4m || base->auto_fit)
+    {
+        printf("Error: Sharding works on plain BMP payloads only.\n");
+        return e_failure;
+    }
+    if (base->ckpt.interval != 0 || base->ckpt.progress_ms != 0 || base->cache.dir != NULL)
+    {
+        printf("Error: --checkpoint, --resume, --progress and --cache do not apply to sharding.\n");
+        return e_failure;
+    }
+    if (count < 1 + parity || count > SHARD_MAX)
+    {
+        printf("Error: Sharding needs 1 to %d carriers (2 or more with --parity).\n", SHARD_MAX);
+        return e_failure;
+    }
+
+    // STEP 1 : Secret size and extension
+    const char *extn = strrchr(secret_fname, '.');
+    if (stat(secret_fname, &st) != 0 || extn == NULL || strlen(extn + 1) >= MAX_FILE_SUFFIX || st.st_size > 0x7FFFFFFF)
+    {
+        printf("Error: Secret file must be an existing file with an extension of at most %d characters.\n", MAX_FILE_SUFFIX - 1);
+        return e_failure;
+    }
+    set.total = st.st_size;
+    size_t extn_len = strlen(extn + 1);
+
+    // STEP 2 : Plan the split, every data chunk as large as its carrier (and the parity carrier) allows
+    int data_carriers = count - parity;
+    unsigned long long limit = parity ? shard_capacity(carriers[count - 1], extn_len) : (unsigned long long)-1;
+    unsigned long long chunk[data_carriers], left = set.total, max_chunk = 0;
+    int used = 0;
+    for (int i = 0; i < data_carriers && left > 0; i++)
+    {
+        unsigned long long cap = shard_capacity(carriers[i], extn_len);
+        chunk[i] = cap < limit ? cap : limit;
+        chunk[i] = chunk[i] < left ? chunk[i] : left;
+        if (chunk[i] == 0)
+        {
+            continue;
+        }
+        left -= chunk[i];
+        max_chunk = chunk[i] > max_chunk ? chunk[i] : max_chunk;
+        used = i + 1;
+    }
+    if (left > 0 || set.total == 0)
+    {
+        printf("Error: Insufficient combined capacity, %llu of %u bytes do not fit.\n", left, set.total);
+        return e_failure;
+    }
+    for (int i = 0; i < used; i++)
+    {
+        if (chunk[i] == 0)
+        {
+            printf("Error: %s is too small to hold a shard.\n", carriers[i]);
+            return e_failure;
+        }
+    }
+    set.shard_count = used + parity;
+    set.mode = MODE_SHARD | (parity ? MODE_SHARD_PARITY : 0);
+    if (getrandom(&set.payload_id, sizeof(set.payload_id), 0) != sizeof(set.payload_id))
+    {
+        set.payload_id = (uint)time(NULL) ^ (uint)getpid() << 16;
+    }
+
+    // STEP 3 : Parity chunk = XOR of all data chunks, shorter chunks zero padded
+    if (parity)
+    {
+        unsigned char buf[64 * 1024];
+        FILE *fp = fopen(secret_fname, "r");
+        set.parity = calloc(max_chunk, 1);
+        if (fp == NULL || set.parity == NULL)
+        {
+            printf("Error: Unable to build the parity shard.\n");
+            ret = e_failure;
+        }
+        for (int i = 0; i < used && ret == e_success; i++)
+        {
+            for (unsigned long long done = 0; done < chunk[i];)
+            {
+                size_t want = chunk[i] - done < sizeof(buf) ? chunk[i] - done : sizeof(buf);
+                if (fread(buf, 1, want, fp) != want)
+                {
+                    ret = e_failure;
+                    break;
+                }
+                for (size_t k = 0; k < want; k++)
+                {
+                    set.parity[done + k] ^= buf[k];
+                }
+                done += want;
+            }
+        }
+        if (fp != NULL)
+        {
+            fclose(fp);
+        }
+    }
+
+    // STEP 4 : One job per shard, the options (I/O engine, pipeline) copied from the command line
+    set.jobs = calloc(set.shard_count, sizeof(*set.jobs));
+    set.secret_fname = secret_fname;
+    set.count = set.shard_count;
+    unsigned long long offset = 0;
+    for (uint id = 0; set.jobs != NULL && ret == e_success && id < set.shard_count; id++)
+    {
+        ShardJob *job = &set.jobs[id];
+        int is_parity = parity && id == set.shard_count - 1;
+        job->enc = *base;
+        job->enc.src_image_fname = carriers[is_parity ? count - 1 : (int)id];
+        snprintf(job->stego_fname, sizeof(job->stego_fname), "%s_%u.bmp", prefix, id);
+        job->enc.stego_image_fname = job->stego_fname;
+        strcpy(job->enc.extn_secret_file, extn + 1);
+        job->enc.size_secret_file = is_parity ? max_chunk : chunk[id];
+        job->id = id;
+        job->offset = offset;
+        job->is_parity = is_parity;
+        offset += is_parity ? 0 : chunk[id];
+    }
+    if (set.jobs == NULL)
+    {
+        ret = e_failure;
+    }
+
+    // STEP 5 : Embed all shards in parallel
+    if (ret == e_success)
+    {
+        printf("Payload %08x: %u bytes in %d data shard(s)%s.\n", set.payload_id, set.total, used, parity ? " + 1 parity shard" : "");
+        run_shard_workers(&set, encode_shard, base->threads);
+        for (int i = 0; i < set.count; i++)
+        {
+            if (set.jobs[i].status == e_failure)
+            {
+                ret = e_failure;
+            }
+        }
+    }
+
+    free(set.jobs);
+    free(set.parity);
+    return ret;
+}
+
+/* I/O engine callback: decode a block of chunk bytes and write (or XOR) them to the sink */
+static Status sink_shard_block(unsigned char *block, size_t len, void *ctx)
+{
+    ShardSink *sink = ctx;
+    size_t count = len / 8;
+
+    lsb_kernel_extract(sink->kernel, block, block, count);
+    if (sink->xor_buf != NULL)
+    {
+        for (size_t i = 0; i < count; i++)
+        {
+            sink->xor_buf[sink->pos + i] ^= block[i];
+        }
+    }
+    else if (pwrite(sink->fd, block, count, sink->pos) != (ssize_t)count)
+    {
+        perror("pwrite");
+        return e_failure;
+    }
+    sink->pos += count;
+    return e_success;
+}
+
+/* Stream the chunk of one shard image into a sink */
+static Status extract_chunk(const ShardPiece *piece, ShardSink *sink, IoConfig *io)
+{
+    const char *engine;
+    int fd = open(piece->fname, O_RDONLY);
+    if (fd < 0)
+    {
+        perror(piece->fname);
+        return e_failure;
+    }
+    Status ret = io_transform_range(fd, -1, piece->data_offset, (off_t)piece->len * 8, sink_shard_block, sink, io, &engine);
+    close(fd);
+    return ret;
+}
+
+/* Worker job: extract one data shard straight to its place in the output file */
+static void join_piece(ShardSet *set, int index)
+{
+    ShardPiece *piece = &set->pieces[index];
+    ShardSink sink = { set->out_fd, piece->out_offset, NULL, lsb_kernel_select(1, 3, LSB_MASK_BGR) };
+
+    piece->status = e_success;
+    if (piece->present && piece->len > 0 && index < (int)set->shard_count - (set->mode & MODE_SHARD_PARITY ? 1 : 0))
+    {
+        piece->status = extract_chunk(piece, &sink, &set->io);
+    }
+}
+
+/* Read the shard header of one image; fields that must agree across the set are returned through the pointers */
+static Status read_shard_header(char *fname, ShardPiece *piece, uint *id, uint *mode, uint *shard_count, uint *payload_id, uint *total, char *extn)
+{
+    DecodeInfo d;
+    Status ret = e_failure;
+
+    memset(&d, 0, sizeof(d));
+    d.fptr_stego_image = fopen(fname, "rb");
+    if (d.fptr_stego_image == NULL)
+    {
+        perror(fname);
+        return e_failure;
+    }
+
+    // STEP 1 : "#+" and a mode word with MODE_SHARD
+    if (fseek(d.fptr_stego_image, 54, SEEK_SET) == 0 && decode_magic_string(&d) == e_success && d.is_extended)
+    {
+        *mode = decode_size_from_lsb(d.fptr_stego_image);
+        if ((*mode & MODE_SHARD) && (*mode & ~(MODE_SHARD | MODE_SHARD_PARITY)) == 0)
+        {
+            // STEP 2 : Shard fields, then extension and chunk size; the chunk data starts right after
+            uint param = decode_size_from_lsb(d.fptr_stego_image);
+            *id = param >> 16;
+            *shard_count = param & 0xFFFF;
+            *payload_id = decode_size_from_lsb(d.fptr_stego_image);
+            *total = decode_size_from_lsb(d.fptr_stego_image);
+            if (decode_secret_file_extn(&d) == e_success)
+            {
+                int len = decode_size_from_lsb(d.fptr_stego_image);
+                if (len >= 0 && *id < *shard_count)
+                {
+                    strcpy(extn, d.extn_secret_file);
+                    piece->fname = fname;
+                    piece->len = len;
+                    piece->data_offset = ftell(d.fptr_stego_image);
+                    ret = e_success;
+                }
+            }
+        }
+    }
+    if (ret == e_failure)
+    {
+        printf("Error: %s is not a shard image.\n", fname);
+    }
+    fclose(d.fptr_stego_image);
+    return ret;
+}
+
+/* Rebuild the secret file from shard images given in any order */
+Status do_shard_decoding(const char *output_fname, char *images[], int count, const DecodeInfo *base)
+{
+    ShardSet set;
+    uint first_mode = 0, first_id = 0, first_total = 0;
+    char first_extn[MAX_FILE_SUFFIX] = "";
+    Status ret = e_success;
+
+    memset(&set, 0, sizeof(set));
+    if (base->ckpt.interval != 0 || base->ckpt.progress_ms != 0 || base->has_range)
+    {
+        printf("Error: --checkpoint, --resume, --progress and --range do not apply to joining.\n");
+        return e_failure;
+    }
+
+    // STEP 1 : Read every header, all must belong to one payload, no shard twice
+    for (int i = 0; i < count && ret == e_success; i++)
+    {
+        ShardPiece piece;
+        uint id, mode, shard_count, payload_id, total;
+        char extn[MAX_FILE_SUFFIX];
+
+        memset(&piece, 0, sizeof(piece));
+        if (read_shard_header(images[i], &piece, &id, &mode, &shard_count, &payload_id, &total, extn) == e_failure)
+        {
+            ret = e_failure;
+            break;
+        }
+        if (set.pieces == NULL)
+        {
+            set.shard_count = shard_count;
+            set.pieces = calloc(shard_count, sizeof(*set.pieces));
+            first_mode = mode;
+            first_id = payload_id;
+            first_total = total;
+            strcpy(first_extn, extn);
+            if (set.pieces == NULL)
+            {
+                ret = e_failure;
+                break;
+            }
+        }
+        if (payload_id != first_id || shard_count != set.shard_count || mode != first_mode || total != first_total)
+        {
+            printf("Error: %s belongs to a different payload (id %08x, expected %08x).\n", images[i], payload_id, first_id);
+            ret = e_failure;
+        }
+        else if (set.pieces[id].present)
+        {
+            printf("Error: %s and %s both hold shard %u.\n", set.pieces[id].fname, images[i], id);
+            ret = e_failure;
+        }
+        else
+        {
+            piece.present = 1;
+            set.pieces[id] = piece;
+        }
+    }
+
+    // STEP 2 : Completeness: every data shard, or all but one when the parity shard is there
+    int parity = (first_mode & MODE_SHARD_PARITY) != 0;
+    int data_shards = set.shard_count - parity;
+    int missing = -1;
+    unsigned long long known = 0;
+    for (int id = 0; ret == e_success && id < data_shards; id++)
+    {
+        if (set.pieces[id].present)
+        {
+            known += set.pieces[id].len;
+        }
+        else if (missing < 0 && parity && set.pieces[data_shards].present)
+        {
+            missing = id;
+        }
+        else
+        {
+            printf("Error: Shard %d of payload %08x is missing and cannot be rebuilt.\n", id, first_id);
+            ret = e_failure;
+        }
+    }
+    if (ret == e_success && (known > first_total || (missing < 0 && known != first_total) ||
+                             (missing >= 0 && first_total - known > set.pieces[data_shards].len)))
+    {
+        printf("Error: Shard sizes do not add up to the payload size %u.\n", first_total);
+        ret = e_failure;
+    }
+
+    // STEP 3 : Output offsets by shard id (the missing chunk is whatever the others leave)
+    unsigned long long offset = 0;
+    for (int id = 0; ret == e_success && id < data_shards; id++)
+    {
+        if (id == missing)
+        {
+            set.pieces[id].len = first_total - known;
+        }
+        set.pieces[id].out_offset = offset;
+        offset += set.pieces[id].len;
+    }
+
+    // STEP 4 : Extract the data shards in parallel, each straight to its offset
+    set.out_fd = -1;
+    if (ret == e_success)
+    {
+        printf("Payload %08x: %u bytes (.%s) from %d of %u shard(s).\n", first_id, first_total, first_extn, count, set.shard_count);
+        set.out_fd = open(output_fname, O_RDWR | O_CREAT | O_TRUNC, 0644);
+        if (set.out_fd < 0 || ftruncate(set.out_fd, first_total) != 0)
+        {
+            perror(output_fname);
+            ret = e_failure;
+        }
+    }
+    if (ret == e_success)
+    {
+        set.io = base->io;
+        set.mode = first_mode;
+        set.count = set.shard_count;
+        run_shard_workers(&set, join_piece, 0);
+        for (uint id = 0; id < set.shard_count; id++)
+        {
+            if (set.pieces[id].status == e_failure)
+            {
+                ret = e_failure;
+            }
+        }
+    }
+
+    // STEP 5 : Rebuild a missing chunk: parity XOR every other chunk (read back from the output)
+    if (ret == e_success && missing >= 0)
+    {
+        ShardPiece *p = &set.pieces[data_shards];
+        ShardSink sink = { -1, 0, calloc(p->len ? p->len : 1, 1), lsb_kernel_select(1, 3, LSB_MASK_BGR) };
+        unsigned char *other = malloc(p->len ? p->len : 1);
+        ret = sink.xor_buf != NULL && other != NULL ? extract_chunk(p, &sink, &set.io) : e_failure;
+        for (int id = 0; ret == e_success && id < data_shards; id++)
+        {
+            if (id == missing)
+            {
+                continue;
+            }
+            if (pread(set.out_fd, other, set.pieces[id].len, set.pieces[id].out_offset) != (ssize_t)set.pieces[id].len)
+            {
+                perror("pread");
+                ret = e_failure;
+                break;
+            }
+            for (uint k = 0; k < set.pieces[id].len; k++)
+            {
+                sink.xor_buf[k] ^= other[k];
+            }
+        }
+        if (ret == e_success &&
+            pwrite(set.out_fd, sink.xor_buf, set.pieces[missing].len, set.pieces[missing].out_offset) != (ssize_t)set.pieces[missing].len)
+        {
+            perror("pwrite");
+            ret = e_failure;
+        }
+        if (ret == e_success)
+        {
+            printf("Shard %d rebuilt from parity (%u bytes).\n", missing, set.pieces[missing].len);
+        }
+        free(sink.xor_buf);
+        free(other);
+    }
+
+    if (set.out_fd >= 0 && close(set.out_fd) != 0)
+    {
+        perror("close");
+        ret = e_failure;
+    }
+    free(set.pieces);
+    return ret;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/* ============================================================================= END OF CODE ===========================================================================*/
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
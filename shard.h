@@ -0,0 +1,43 @@
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// ============================================================== * * * * * shard.h * * * * * ========================================================================= //
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/*
+
+### USAGE OF shard.h FILE IN STEGANOGRAPHY PROJECT ?
+--> THIS HEADER FILE DECLARES THE SHARDED MODE. A SECRET FILE TOO LARGE FOR ONE CARRIER IS CUT INTO CHUNKS SIZED TO THE CAPACITY OF EACH GIVEN CARRIER, AND EVERY CHUNK
+    IS EMBEDDED INTO ITS OWN IMAGE BEHIND A SHARD HEADER (SHARD ID, SHARD COUNT, PAYLOAD ID, TOTAL SIZE). AN OPTIONAL XOR PARITY SHARD LETS ONE MISSING IMAGE BE
+    REBUILT. SHARDS ARE ENCODED AND EXTRACTED IN PARALLEL, AND THE JOIN STEP ACCEPTS THE IMAGES IN ANY ORDER.
+
+*/
+
+// ==================================================================================================================================================================== //
+
+#ifndef SHARD_H
+#define SHARD_H
+
+/* ====================================================================== INCLUDES ==================================================================================== */
+
+#include "types.h"
+#include "encode.h"
+#include "decode.h"
+
+/* ======================================================================= MACROS ===================================================================================== */
+
+#define SHARD_MAX 65535     // Shard id and count share one 32 bit parameter word
+
+/* ================================================================= FUNCTION PROTOTYPES ============================================================================== */
+
+/* Split secret_fname over carriers[0..count), writing <prefix>_<id>.bmp for every shard: -s <secret.txt> <prefix> <carrier.bmp>...
+ * base holds the parsed encode options; with parity the last carrier receives the XOR parity shard
+ */
+Status do_shard_encoding(const char *secret_fname, const char *prefix, char *carriers[], int count, int parity, const EncodeInfo *base);
+
+/* Rebuild the secret file from shard images given in any order: -j <output.txt> <shard.bmp>... */
+Status do_shard_decoding(const char *output_fname, char *images[], int count, const DecodeInfo *base);
+
+#endif
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/* ============================================================================= END OF CODE ===========================================================================*/
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
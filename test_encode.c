@@ -34,6 +34,14 @@ BMP or text file name. This tool demonstrates how information can be securely sh
 #include "types.h"   //Custom types like Status, OperationType
 #include "common.h"  //Common definitions like OperationType enum
 #include "decode.h"  //Function declarations and structures for decoding logic
+#include "y4m.h"     //Raw video (YUV4MPEG2) carrier
+#include "update.h"  //In-place payload update
+#include "index.h"   //Persistent carrier index
+#include "shard.h"   //Payload sharding over several carriers
+#include "daemon.h"  //Unix socket daemon and its client
+#include "analyze.h" //Chi-square / RS steganalysis
+#include "lsbkernel.h" //Specialised LSB kernels and their benchmark
+#include "sanitize.h" //LSB plane sanitizer
 
 /* ====================================================================== FUNCTION ==================================================================================== */
 
@@ -61,13 +69,92 @@ static OperationType check_operation_type(char *argv)
         // STEP 4: if yes, return e_decode
         return e_decode;
     }
+    // STEP 5: check if argv is "-u"
+    else if (strcmp(argv, "-u") == 0)
+    {
+        // STEP 6: if yes, return e_update
+        return e_update;
+    }
+    // STEP 7: check if argv is "-i" or "-p"
+    else if (strcmp(argv, "-i") == 0)
+    {
+        return e_index;
+    }
+    else if (strcmp(argv, "-p") == 0)
+    {
+        return e_pick;
+    }
+    // STEP 8: check if argv is "-s" or "-j"
+    else if (strcmp(argv, "-s") == 0)
+    {
+        return e_shard;
+    }
+    else if (strcmp(argv, "-j") == 0)
+    {
+        return e_join;
+    }
+    // STEP 9: check if argv is "-a"
+    else if (strcmp(argv, "-a") == 0)
+    {
+        return e_analyze;
+    }
+    // STEP 10: check if argv is "-D" or "-q"
+    else if (strcmp(argv, "-D") == 0)
+    {
+        return e_daemon;
+    }
+    else if (strcmp(argv, "-q") == 0)
+    {
+        return e_request;
+    }
+    // STEP 11: check if argv is "-b"
+    else if (strcmp(argv, "-b") == 0)
+    {
+        return e_bench;
+    }
+    // STEP 12: check if argv is "-z"
+    else if (strcmp(argv, "-z") == 0)
+    {
+        return e_sanitize;
+    }
     else
     {
-        // STEP 5: neither -e nor -d, return unsupported
+        // STEP 13: none of the above, return unsupported
         return e_unsupported;
     }
 }
 
+/*
+Separates long options (--name or --name=value) from the positional arguments
+
+Positional arguments are packed to the front of argv (still NULL terminated) so the
+argument validators keep reading argv[2], argv[3]... ; options are collected in opts
+
+return the new argc
+*/
+
+static int split_long_options(int argc, char *argv[], char *opts[], int *opt_count)
+{
+    int kept = 0;
+
+    *opt_count = 0;
+    for (int i = 0; i < argc; i++)
+    {
+        // STEP 1: anything after the operation that starts with "--" is an option
+        if (i > 1 && strncmp(argv[i], "--", 2) == 0)
+        {
+            opts[(*opt_count)++] = argv[i];
+        }
+        else
+        {
+            // STEP 2: keep positional arguments in their original order
+            argv[kept++] = argv[i];
+        }
+    }
+    argv[kept] = NULL;
+    return kept;
+}
+
 /* ====================================================================== INT MAIN() ================================================================================== */
 
 /*
@@ -82,12 +169,27 @@ return 0 for success, 1 for failure
 
 int main(int argc, char *argv[])
 {
-    // STEP 1: Validate argument count
+    // STEP 1: Separate --options, then validate argument count
+    char *opts[argc];
+    int opt_count;
+    argc = split_long_options(argc, argv, opts, &opt_count);
+
     if (argc < 3)
     {
         printf("Usage:\n");
         printf("Encoding: ./steganography -e <input.bmp> <secret.txt> [output.bmp]\n");
-        printf("Decoding: ./steganography -d <stego.bmp> [output.txt]\n");
+        printf("          ./steganography -e <input.y4m|-> <secret.txt> [output.y4m] [--planes=luma|all] [--threads=N]\n");
+        printf("Decoding: ./steganography -d <stego.bmp|stego.y4m|-> [output.txt] [original.bmp]\n");
+        printf("Updating: ./steganography -u <stego.bmp> <new_secret.txt> [--cache=DIR]\n");
+        printf("Indexing: ./steganography -i <carriers.idx> <carrier_dir>\n");
+        printf("Picking : ./steganography -p <carriers.idx> <secret.txt>\n");
+        printf("Sharding: ./steganography -s <secret.txt> <out_prefix> <carrier.bmp>... [--parity]\n");
+        printf("Joining : ./steganography -j <output.txt> <shard.bmp>...\n");
+        printf("Analysis: ./steganography -a <image.bmp|dir>... [--threads=N]\n");
+        printf("Daemon  : ./steganography -D <socket> [--threads=N] [--quiet]\n");
+        printf("Request : ./steganography -q <socket> encode|decode|scan|stats <files>... [--inline] [--repeat=N] [job options]\n");
+        printf("Bench   : ./steganography -b <MiB> [--repeat=N]\n");
+        printf("Sanitize: ./steganography -z <image.bmp|dir>... [--mode=random|zero] [--threads=N]\n");
         return 1;
     }
 
@@ -103,15 +205,18 @@ int main(int argc, char *argv[])
 
         // STEP 4: validate and store input arguments in encInfo struct 
         EncodeInfo encInfo;
+        memset(&encInfo, 0, sizeof(encInfo));
 
         // STEP 5: read and validate command-line arguments
 
-        if (read_and_validate_encode_args(argv, &encInfo) == e_success)
+        if (argc >= 4 && read_and_validate_encode_args(argv, &encInfo) == e_success &&
+            read_encode_options(opt_count, opts, &encInfo) == e_success)
         {
             printf("Reading and validation successful\n");
 
-            // STEP 6: call the main do_encoding func
-            if (do_encoding(&encInfo) == e_success)
+            // STEP 6: call the main do_encoding func (frame streams have their own pipeline)
+            Status ret = encInfo.is_y4m ? do_y4m_encoding(&encInfo) : do_encoding(&encInfo);
+            if (ret == e_success)
             {
                 printf("\033[0;32mEncoding completed successfully\033[0m\n");  // Green text
             }
@@ -133,12 +238,15 @@ int main(int argc, char *argv[])
         printf("\033[0;33mDECODING MODE SELECTED\033[0m\n");  // Yellow text
 
         DecodeInfo decInfo;
+        memset(&decInfo, 0, sizeof(decInfo));
 
-        if (read_and_validate_decode_args(argc, argv, &decInfo) == e_success)
+        if (read_and_validate_decode_args(argc, argv, &decInfo) == e_success &&
+            read_decode_options(opt_count, opts, &decInfo) == e_success)
         {
             printf("Arguments validated successfully for decoding\n");
 
-            if (do_decoding(&decInfo) == e_success)
+            Status ret = decInfo.is_y4m ? do_y4m_decoding(&decInfo) : do_decoding(&decInfo);
+            if (ret == e_success)
             {
                 printf("\033[0;32mDecoding completed successfully\033[0m\n");  // Green text
             }
@@ -153,10 +261,191 @@ int main(int argc, char *argv[])
         }
     }
 
+    /* ===================================================================== UPDATE MODE ============================================================================== */
+
+    else if (op_type == e_update)
+    {
+        printf("\033[0;33mUPDATE MODE SELECTED\033[0m\n");  // Yellow text
+
+        EncodeInfo encInfo;
+        memset(&encInfo, 0, sizeof(encInfo));
+
+        // Only --cache=DIR: a stego image that is one of its entries is copied before the update
+        Status opt_ret = e_success;
+        for (int i = 0; i < opt_count && opt_ret == e_success; i++)
+        {
+            if (strncmp(opts[i], "--cache=", 8) != 0)
+            {
+                printf("Error: Unknown update option %s\n", opts[i]);
+                opt_ret = e_failure;
+            }
+            else
+            {
+                opt_ret = read_cache_option(opts[i], &encInfo.cache);
+            }
+        }
+
+        if (opt_ret == e_success && read_and_validate_update_args(argc, argv, &encInfo) == e_success)
+        {
+            if (do_update(&encInfo) == e_success)
+            {
+                printf("\033[0;32mUpdate completed successfully\033[0m\n");  // Green text
+            }
+            else
+            {
+                printf("\033[0;31mUpdate failed\033[0m\n");  // Red text
+            }
+        }
+        else if (opt_ret == e_success)
+        {
+            printf("Validation of update arguments failed\n");
+        }
+    }
+
+    /* ================================================================== INDEX / PICK MODE =========================================================================== */
+
+    else if (op_type == e_index || op_type == e_pick)
+    {
+        if (opt_count > 0)
+        {
+            printf("Error: Unknown option %s\n", opts[0]);
+        }
+        else if (argc < 4)
+        {
+            printf("Usage: ./program %s carriers.idx %s\n", argv[1], op_type == e_index ? "carrier_dir" : "secret.txt");
+        }
+        else
+        {
+            // -i rescans the library (only new / changed headers are read), -p answers from the mapped index
+            Status ret = op_type == e_index ? do_index_update(argv[2], argv[3]) : do_index_pick(argv[2], argv[3]);
+            if (ret == e_failure)
+            {
+                printf("\033[0;31m%s failed\033[0m\n", op_type == e_index ? "Indexing" : "Pick");  // Red text
+                return 1;
+            }
+        }
+    }
+
+    /* ================================================================== SHARD / JOIN MODE =========================================================================== */
+
+    else if (op_type == e_shard)
+    {
+        printf("\033[0;33mSHARDING MODE SELECTED\033[0m\n");  // Yellow text
+
+        EncodeInfo encInfo;
+        memset(&encInfo, 0, sizeof(encInfo));
+
+        // --parity belongs to the shard layout, every other option is a normal encode option
+        int parity = 0, kept = 0;
+        for (int i = 0; i < opt_count; i++)
+        {
+            if (strcmp(opts[i], "--parity") == 0)
+            {
+                parity = 1;
+            }
+            else
+            {
+                opts[kept++] = opts[i];
+            }
+        }
+
+        if (argc < 5)
+        {
+            printf("Usage: ./program -s secret.txt out_prefix carrier.bmp... [--parity]\n");
+        }
+        else if (read_encode_options(kept, opts, &encInfo) == e_success &&
+                 do_shard_encoding(argv[2], argv[3], argv + 4, argc - 4, parity, &encInfo) == e_success)
+        {
+            printf("\033[0;32mSharding completed successfully\033[0m\n");  // Green text
+        }
+        else
+        {
+            printf("\033[0;31mSharding failed\033[0m\n");  // Red text
+            return 1;
+        }
+    }
+
+    else if (op_type == e_join)
+    {
+        printf("\033[0;33mJOINING MODE SELECTED\033[0m\n");  // Yellow text
+
+        DecodeInfo decInfo;
+        memset(&decInfo, 0, sizeof(decInfo));
+
+        if (argc < 4)
+        {
+            printf("Usage: ./program -j output.txt shard.bmp...\n");
+        }
+        else if (read_decode_options(opt_count, opts, &decInfo) == e_success &&
+                 do_shard_decoding(argv[2], argv + 3, argc - 3, &decInfo) == e_success)
+        {
+            printf("\033[0;32mJoining completed successfully\033[0m\n");  // Green text
+        }
+        else
+        {
+            printf("\033[0;31mJoining failed\033[0m\n");  // Red text
+            return 1;
+        }
+    }
+
+    /* ==================================================================== ANALYSIS MODE ============================================================================= */
+
+    else if (op_type == e_analyze)
+    {
+        if (do_analyze(argv + 2, argc - 2, opt_count, opts) == e_failure)
+        {
+            printf("\033[0;31mAnalysis failed\033[0m\n");  // Red text
+            return 1;
+        }
+    }
+
+    /* ================================================================= DAEMON / REQUEST MODE ======================================================================== */
+
+    else if (op_type == e_daemon)
+    {
+        // Runs until SIGINT / SIGTERM, the latency report is printed on the way out
+        if (do_daemon(argv[2], opt_count, opts) == e_failure)
+        {
+            printf("\033[0;31mDaemon failed\033[0m\n");  // Red text
+            return 1;
+        }
+    }
+
+    else if (op_type == e_request)
+    {
+        if (argc < 4 || do_daemon_request(argv[2], argc - 3, argv + 3, opt_count, opts) == e_failure)
+        {
+            printf("\033[0;31mRequest failed\033[0m\n");  // Red text
+            return 1;
+        }
+    }
+
+    /* =================================================================== BENCHMARK MODE ============================================================================= */
+
+    else if (op_type == e_bench)
+    {
+        if (do_kernel_bench(argv[2], opt_count, opts) == e_failure)
+        {
+            printf("\033[0;31mBenchmark failed\033[0m\n");  // Red text
+            return 1;
+        }
+    }
+
+    /* =================================================================== SANITIZE MODE ============================================================================== */
+
+    else if (op_type == e_sanitize)
+    {
+        if (do_sanitize(argv + 2, argc - 2, opt_count, opts) == e_failure)
+        {
+            printf("\033[0;31mSanitizing failed\033[0m\n");  // Red text
+            return 1;
+        }
+    }
+
     /* =================================================================== UNSUPPORTED MODE =========================================================================== */
     else
     {
-        printf("Invalid option '%s'. Use -e for encoding or -d for decoding.\n", argv[1]);
+        printf("Invalid option '%s'. Use -e for encoding, -d for decoding, -u for updating, -i for indexing, -p for picking, -s for sharding, -j for joining, -a for analysis, -D for the daemon, -q for a daemon request, -b for the kernel benchmark or -z for sanitizing.\n", argv[1]);
         return 1;
     }
     return 0;
@@ -30,9 +30,26 @@ typedef enum
 {
     e_encode,       //return 0 , Encoding operation ->> (-e)
     e_decode,       //return 1 , Decoding operation ->> (-d)
-    e_unsupported   //return 2 //Invalid operation (neither -e or -d)
+    e_update,       //return 2 , In-place payload update of a stego image ->> (-u)
+    e_index,        //return 3 , Create / refresh the carrier index of a directory ->> (-i)
+    e_pick,         //return 4 , Pick the best fitting unused carrier from the index ->> (-p)
+    e_shard,        //return 5 , Split a secret file over several carriers ->> (-s)
+    e_join,         //return 6 , Rebuild a secret file from its shard images ->> (-j)
+    e_analyze,      //return 7 , Chi-square / RS steganalysis of images or directories ->> (-a)
+    e_daemon,       //return 8 , Serve encode / decode jobs on a Unix domain socket ->> (-D)
+    e_request,      //return 9 , Send one job to a running daemon ->> (-q)
+    e_bench,        //return 10 , Benchmark of the LSB kernels against the generic loop ->> (-b)
+    e_sanitize,     //return 11 , Randomize / clear the pixel LSB plane of images or directories ->> (-z)
+    e_unsupported   //return 12 //Invalid operation (none of the above)
 } OperationType;
 
+//enum to represent which planes of a Y4M frame carry the payload
+typedef enum
+{
+    e_planes_luma,  //Only the Y plane of each frame ->> (--planes=luma)
+    e_planes_all    //Y, U and V planes of each frame ->> (--planes=all)
+} Y4mPlanes;
+
 #endif
 
 //////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -0,0 +1,295 @@
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// ============================================================= * * * * * update.c * * * * * ========================================================================= //
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/*
+
+### USAGE OF update.c FILE IN STEGANOGRAPHY PROJECT ?
+--> THIS FILE IMPLEMENTS THE IN-PLACE UPDATE OF A STEGO IMAGE. THE PLAIN PAYLOAD LAYOUT PUTS PAYLOAD BIT I IN CARRIER BYTE 54 + I, SO THE NEW PAYLOAD (MAGIC STRING,
+    EXTENSION SIZE, EXTENSION, FILE SIZE, DATA) IS WALKED CHUNK BY CHUNK NEXT TO THE MATCHING CARRIER BYTES. BYTES WHOSE LSB ALREADY HOLDS THE NEW BIT ARE LEFT ALONE,
+    THE REST ARE PATCHED AND WRITTEN BACK AS A FEW COALESCED RUNS. WHEN THE OLD PAYLOAD WAS LONGER, THE CARRIER BYTES UP TO ITS END GET RANDOM LSBS, SO NOTHING OF THE
+    OLD SECRET SURVIVES; THE IMAGE TAIL AFTER BOTH PAYLOADS IS NEVER READ OR WRITTEN.
+
+*/
+
+/* ====================================================================== INCLUDES ==================================================================================== */
+
+#include <stdio.h>       // Std inbuilt functions
+#include <string.h>      // Inbuilt string functions
+#include <fcntl.h>       // open
+#include <unistd.h>      // pread, pwrite, close, getpid
+#include <time.h>        // time
+#include <sys/stat.h>    // fstat
+#include <sys/random.h>  // getrandom
+#include "types.h"       // Status
+#include "common.h"      // MAGIC_STRING
+#include "encode.h"      // EncodeInfo
+#include "decode.h"      // decode_byte_from_lsb
+#include "sanitize.h"    // sanitize_lsbs
+#include "update.h"      // Prototypes
+
+/* ================================================================= FUNCTION DEFINITIONS ============================================================================= */
+
+/* Read and validate update args: -u <stego.bmp> <secret.txt> */
+Status read_and_validate_update_args(int argc, char *argv[], EncodeInfo *encInfo)
+{
+    if (argc < 4)
+    {
+        printf("Usage: ./program -u stego_image.bmp new_secret.txt\n");
+        return e_failure;
+    }
+
+    // STEP 1 : Stego image that is rewritten in place
+    if (strstr(argv[2], ".bmp") == NULL)
+    {
+        printf("Error: Stego image must be a .bmp file.\n");
+        return e_failure;
+    }
+    encInfo->src_image_fname = argv[2];
+    encInfo->stego_image_fname = argv[2];
+
+    // STEP 2 : New secret file and its extension
+    char *extn = strrchr(argv[3], '.');
+    if (strstr(argv[3], ".txt") == NULL || extn == NULL)
+    {
+        printf("Error: Secret file must be a .txt file.\n");
+        return e_failure;
+    }
+    encInfo->secret_fname = argv[3];
+    strcpy(encInfo->extn_secret_file, extn + 1);
+    return e_success;
+}
+
+/* Write the changed run [start, end) of a chunk, return e_failure on short writes */
+static Status flush_run(int fd, const unsigned char *carrier, size_t start, size_t end, off_t base, unsigned long *writes)
+{
+    if (pwrite(fd, carrier + start, end - start, base + start) != (ssize_t)(end - start))
+    {
+        perror("pwrite");
+        return e_failure;
+    }
+    (*writes)++;
+    return e_success;
+}
+
+/* Four payload bytes (MSB first) from the LSBs of the 32 carrier bytes at pos */
+static Status read_size_field(int fd, off_t pos, uint32_t *value)
+{
+    char bits[32];
+
+    if (pread(fd, bits, sizeof(bits), pos) != sizeof(bits))
+    {
+        return e_failure;
+    }
+    *value = 0;
+    for (int i = 0; i < 4; i++)
+    {
+        *value = (*value << 8) | (unsigned char)decode_byte_from_lsb(bits + 8 * i);
+    }
+    return e_success;
+}
+
+/* Carrier offset just after the payload already in the image (capped at the file size), 54 when its size fields make no sense */
+static off_t old_payload_end(int fd, off_t file_size)
+{
+    uint32_t extn_len, data_size;
+    off_t pos = 54 + 2 * 8;
+
+    if (read_size_field(fd, pos, &extn_len) == e_failure || extn_len == 0 || extn_len >= MAX_FILE_SUFFIX)
+    {
+        return 54;
+    }
+    pos += 32 + (off_t)extn_len * 8;
+    if (read_size_field(fd, pos, &data_size) == e_failure)
+    {
+        return 54;
+    }
+    pos += 32 + (off_t)data_size * 8;
+    return pos < file_size ? pos : file_size;
+}
+
+/* Replace the LSBs of carrier bytes [start, end) with random bits, so nothing of the old payload can be read there */
+static Status scrub_range(int fd, unsigned char *carrier, size_t size, off_t start, off_t end, unsigned long *writes)
+{
+    SanitizeRng rng;
+    uint64_t seed;
+
+    if (getrandom(&seed, sizeof(seed), 0) != sizeof(seed))
+    {
+        seed = (uint64_t)time(NULL) << 20 ^ (uint64_t)getpid();
+    }
+    sanitize_seed(&rng, seed);
+    for (off_t pos = start; pos < end;)
+    {
+        size_t len = end - pos < (off_t)size ? (size_t)(end - pos) : size;
+        if (pread(fd, carrier, len, pos) != (ssize_t)len)
+        {
+            perror("pread");
+            return e_failure;
+        }
+        sanitize_lsbs(carrier, len, e_sanitize_random, &rng);
+        if (flush_run(fd, carrier, 0, len, pos, writes) == e_failure)
+        {
+            return e_failure;
+        }
+        pos += len;
+    }
+    return e_success;
+}
+
+/* Rewrite the payload of a stego image in place, touching only changed bytes */
+Status do_update(EncodeInfo *encInfo)
+{
+    unsigned char payload[UPDATE_CHUNK];
+    unsigned char carrier[UPDATE_CHUNK * 8];
+    unsigned char prefix[16];
+    size_t prefix_len = 0, prefix_pos = 0;
+    unsigned long changed = 0, writes = 0;
+    unsigned long long read_bytes = 0;
+    Status ret = e_success;
+    struct stat st;
+
+    // STEP 1 : Open the stego image read-write and the new secret file (with --cache, a stego image linked with one of its entries gets its own copy first)
+    if (unshare_file(encInfo->stego_image_fname, encInfo->cache.dir, 1) == e_failure)
+    {
+        printf("Error: Unable to unshare %s\n", encInfo->stego_image_fname);
+        return e_failure;
+    }
+    int fd = open(encInfo->stego_image_fname, O_RDWR);
+    encInfo->fptr_secret = fopen(encInfo->secret_fname, "r");
+    if (fd < 0 || encInfo->fptr_secret == NULL || fstat(fd, &st) != 0)
+    {
+        perror("open");
+        printf("Error: Unable to open required files.\n");
+        if (fd >= 0)
+        {
+            close(fd);
+        }
+        if (encInfo->fptr_secret != NULL)
+        {
+            fclose(encInfo->fptr_secret);
+        }
+        return e_failure;
+    }
+
+    // STEP 2 : Only plain payloads can be patched bit for bit (FEC parity would go stale)
+    char magic[2 * 8];
+    if (pread(fd, magic, sizeof(magic), 54) != sizeof(magic) ||
+        decode_byte_from_lsb(magic) != MAGIC_STRING[0] || decode_byte_from_lsb(magic + 8) != MAGIC_STRING[1])
+    {
+        printf("Error: %s does not hold a plain stego payload, encode it with -e instead.\n", encInfo->stego_image_fname);
+        ret = e_failure;
+    }
+
+    // STEP 3 : End of the old payload, whatever of it lies past the new one is scrubbed afterwards
+    off_t old_end = ret == e_success ? old_payload_end(fd, st.st_size) : 54;
+
+    // STEP 4 : New payload prefix and capacity check against the pixel bytes after the header
+    size_t extn_len = strlen(encInfo->extn_secret_file);
+    encInfo->size_secret_file = get_file_size(encInfo->fptr_secret);
+    memcpy(prefix, MAGIC_STRING, 2);
+    prefix_len = 2;
+    for (int shift = 24; shift >= 0; shift -= 8)
+    {
+        prefix[prefix_len++] = extn_len >> shift;
+    }
+    memcpy(prefix + prefix_len, encInfo->extn_secret_file, extn_len);
+    prefix_len += extn_len;
+    for (int shift = 24; shift >= 0; shift -= 8)
+    {
+        prefix[prefix_len++] = encInfo->size_secret_file >> shift;
+    }
+    if (ret == e_success && (unsigned long long)(prefix_len + encInfo->size_secret_file) * 8 > (unsigned long long)st.st_size - 54)
+    {
+        printf("Error: Insufficient image capacity.\n");
+        ret = e_failure;
+    }
+
+    // STEP 5 : Chunk by chunk, compare wanted LSBs with stored ones and write back changed runs
+    off_t base = 54;
+    while (ret == e_success)
+    {
+        size_t n = 0;
+        while (n < UPDATE_CHUNK && prefix_pos < prefix_len)
+        {
+            payload[n++] = prefix[prefix_pos++];
+        }
+        n += fread(payload + n, 1, UPDATE_CHUNK - n, encInfo->fptr_secret);
+        if (n == 0)
+        {
+            break;
+        }
+
+        size_t len = n * 8;
+        if (pread(fd, carrier, len, base) != (ssize_t)len)
+        {
+            perror("pread");
+            ret = e_failure;
+            break;
+        }
+        read_bytes += len;
+
+        size_t run_start = 0, run_end = 0;
+        int in_run = 0;
+        for (size_t i = 0; i < len && ret == e_success; i++)
+        {
+            unsigned char want = (carrier[i] & 0xFE) | ((payload[i / 8] >> (7 - i % 8)) & 1);
+            if (want == carrier[i])
+            {
+                continue;
+            }
+            carrier[i] = want;
+            changed++;
+
+            // Extend the current run across small gaps, otherwise write it out and start anew
+            if (in_run && i - run_end <= UPDATE_MERGE_GAP)
+            {
+                run_end = i + 1;
+            }
+            else
+            {
+                if (in_run)
+                {
+                    ret = flush_run(fd, carrier, run_start, run_end, base, &writes);
+                }
+                run_start = i;
+                run_end = i + 1;
+                in_run = 1;
+            }
+        }
+        if (in_run && ret == e_success)
+        {
+            ret = flush_run(fd, carrier, run_start, run_end, base, &writes);
+        }
+        base += len;
+    }
+
+    // STEP 6 : A shorter payload leaves the tail of the old one behind, its LSBs are re-randomised
+    unsigned long long scrubbed = 0;
+    if (ret == e_success && old_end > base)
+    {
+        ret = scrub_range(fd, carrier, sizeof(carrier), base, old_end, &writes);
+        scrubbed = old_end - base;
+    }
+
+    // STEP 7 : Report the I/O the update cost
+    if (ret == e_success)
+    {
+        printf("Compared %llu carrier bytes, changed %lu bytes in %lu writes.\n", read_bytes, changed, writes);
+        if (scrubbed != 0)
+        {
+            printf("Scrubbed %llu carrier bytes left over from the previous, longer payload.\n", scrubbed);
+        }
+    }
+    fclose(encInfo->fptr_secret);
+    if (close(fd) != 0)
+    {
+        perror("close");
+        ret = e_failure;
+    }
+    return ret;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/* ============================================================================= END OF CODE ===========================================================================*/
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
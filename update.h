@@ -0,0 +1,40 @@
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// ============================================================= * * * * * update.h * * * * * ========================================================================= //
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/*
+
+### USAGE OF update.h FILE IN STEGANOGRAPHY PROJECT ?
+--> THIS HEADER FILE DECLARES THE IN-PLACE UPDATE MODE. INSTEAD OF RE-ENCODING FROM THE ORIGINAL CARRIER, AN EXISTING STEGO IMAGE IS OPENED READ-WRITE, THE NEW PAYLOAD
+    BITS ARE COMPARED WITH THE LSBS ALREADY STORED IN THE IMAGE, AND ONLY THE CARRIER BYTES WHOSE LSB MUST CHANGE ARE WRITTEN BACK WITH PWRITE.
+
+*/
+
+// ==================================================================================================================================================================== //
+
+#ifndef UPDATE_H
+#define UPDATE_H
+
+/* ====================================================================== INCLUDES ==================================================================================== */
+
+#include "types.h"
+#include "encode.h"
+
+/* ======================================================================= MACROS ===================================================================================== */
+
+#define UPDATE_CHUNK 8192       // Payload bytes compared per carrier read (64 KiB of carrier)
+#define UPDATE_MERGE_GAP 64     // Changed runs closer than this are written with one pwrite
+
+/* ================================================================= FUNCTION PROTOTYPES ============================================================================== */
+
+/* Read and validate update args: -u <stego.bmp> <secret.txt> */
+Status read_and_validate_update_args(int argc, char *argv[], EncodeInfo *encInfo);
+
+/* Rewrite the payload of a stego image in place, touching only changed bytes */
+Status do_update(EncodeInfo *encInfo);
+
+#endif
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/* ============================================================================= END OF CODE ===========================================================================*/
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -0,0 +1,682 @@
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// =============================================================== * * * * * y4m.c * * * * * ========================================================================== //
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/*
+
+### USAGE OF y4m.c FILE IN STEGANOGRAPHY PROJECT ?
+--> THIS FILE IMPLEMENTS THE YUV4MPEG2 VIDEO CARRIER. ENCODING RUNS AS A PIPELINE: A READER THREAD PULLS FRAMES (AND THE MATCHING SLICE OF PAYLOAD BYTES) INTO A RING OF
+    FRAME SLOTS, WORKER THREADS EMBED THE PAYLOAD BITS INTO ANY FRAME THAT IS READY, AND THE MAIN THREAD WRITES FRAMES BACK OUT IN ORDER. BECAUSE THE PAYLOAD BIT CARRIED
+    BY EVERY FRAME IS KNOWN WHEN THE FRAME IS READ, FRAMES CAN BE EMBEDDED OUT OF ORDER. DECODING READS FRAMES SEQUENTIALLY AND REBUILDS THE PAYLOAD BIT BY BIT.
+
+*/
+
+/* ====================================================================== INCLUDES ==================================================================================== */
+
+#include <stdio.h>     // Std inbuilt functions
+#include <stdlib.h>    // malloc, free, atoi
+#include <string.h>    // Inbuilt string functions
+#include <pthread.h>   // Reader / worker threads
+#include <unistd.h>    // sysconf
+#include "types.h"     // Status, Y4mPlanes
+#include "common.h"    // MAGIC_STRING_EXT and MODE_* flags
+#include "encode.h"    // EncodeInfo, encode_byte_to_lsb
+#include "decode.h"    // DecodeInfo
+#include "y4m.h"       // Y4mStream and prototypes
+
+/* ======================================================================= STRUCTURE ================================================================================== */
+
+/* States a frame slot moves through: reader -> worker -> writer -> reader */
+typedef enum
+{
+    e_slot_free,     // Slot can receive the next frame
+    e_slot_read,     // Frame and payload slice loaded, waiting for a worker
+    e_slot_busy,     // A worker is embedding into the frame
+    e_slot_embedded  // Ready to be written out
+} SlotState;
+
+/* One frame in flight */
+typedef struct
+{
+    unsigned char *frame;               // Frame pixel data
+    char frame_header[Y4M_MAX_LINE];    // "FRAME..." line, written back unchanged
+    unsigned char *payload;             // Payload bytes covering this frame's bit range
+    unsigned long long bit_offset;      // Payload bit stored in the first carrier byte
+    size_t payload_bits;                // Payload bits stored in this frame (0 = copied as is)
+    long seq;                           // Frame number
+    SlotState state;
+} Y4mSlot;
+
+/* Shared state of the encoding pipeline */
+typedef struct
+{
+    EncodeInfo *encInfo;
+    Y4mStream in;
+    size_t carrier_size;                // Bytes of each frame that carry payload bits
+
+    unsigned char prefix[32];           // Extended magic, mode word, extension size, extension, file size
+    size_t prefix_len;
+    unsigned long long payload_pos;     // Next payload byte handed to the reader
+    unsigned long long total_bits;      // Payload bits to embed
+    unsigned long long bits_queued;     // Payload bits already assigned to frames
+    unsigned char carry;                // Payload byte split across two frames
+    int has_carry;
+
+    Y4mSlot *slots;
+    uint nslots;
+    long frames_read;
+    int eof;
+    int failed;
+    pthread_mutex_t lock;
+    pthread_cond_t changed;
+} Y4mPipeline;
+
+/* Decoder progress through the payload byte stream */
+typedef struct
+{
+    DecodeInfo *decInfo;
+    unsigned char cur;                  // Byte being assembled from LSBs
+    int nbits;                          // Bits already in cur
+    uint index;                         // Bytes of magic string and mode word seen
+    PayloadParser parser;               // Extension size, extension, file size, data
+    int done;
+    int failed;
+} Y4mDecoder;
+
+/* ================================================================= FUNCTION DEFINITIONS ============================================================================= */
+
+/* Open a stream, "-" means stdin */
+static FILE *open_stream(const char *fname)
+{
+    if (strcmp(fname, "-") == 0)
+    {
+        return stdin;
+    }
+    return fopen(fname, "rb");
+}
+
+/* Store a 32 bit value MSB first, the same bit order encode_size_to_lsb() uses */
+static void put_be32(unsigned char *buf, uint value)
+{
+    buf[0] = value >> 24;
+    buf[1] = value >> 16;
+    buf[2] = value >> 8;
+    buf[3] = value;
+}
+
+/* Parse the stream header line and work out the frame size */
+Status y4m_read_stream_header(Y4mStream *stream)
+{
+    // STEP 1 : Read the header line
+    if (fgets(stream->header, Y4M_MAX_LINE, stream->fptr) == NULL ||
+        strncmp(stream->header, "YUV4MPEG2 ", 10) != 0 || strchr(stream->header, '\n') == NULL)
+    {
+        printf("ERROR! Not a YUV4MPEG2 stream\n");
+        return e_failure;
+    }
+
+    // STEP 2 : Walk the space separated tags, W / H / C are the ones that matter
+    char tags[Y4M_MAX_LINE];
+    const char *chroma = "420jpeg";
+    strcpy(tags, stream->header + 10);
+    stream->width = 0;
+    stream->height = 0;
+    for (char *tag = strtok(tags, " \n"); tag != NULL; tag = strtok(NULL, " \n"))
+    {
+        if (tag[0] == 'W')
+        {
+            stream->width = atoi(tag + 1);
+        }
+        else if (tag[0] == 'H')
+        {
+            stream->height = atoi(tag + 1);
+        }
+        else if (tag[0] == 'C')
+        {
+            chroma = tag + 1;
+        }
+    }
+    if (stream->width == 0 || stream->height == 0)
+    {
+        printf("ERROR! Y4M header has no frame size\n");
+        return e_failure;
+    }
+
+    // STEP 3 : Frame size from the chroma subsampling (8 bit samples only)
+    size_t w = stream->width, h = stream->height;
+    size_t cw = (w + 1) / 2, ch = (h + 1) / 2;
+    stream->luma_size = w * h;
+    const char *depth = strchr(chroma, 'p');
+    if ((depth != NULL && depth[1] >= '0' && depth[1] <= '9') || (strncmp(chroma, "mono", 4) == 0 && chroma[4] != '\0'))
+    {
+        printf("ERROR! High bit depth Y4M (C%s) is not supported\n", chroma);
+        return e_failure;
+    }
+    else if (strncmp(chroma, "420", 3) == 0)
+    {
+        stream->frame_size = w * h + 2 * cw * ch;
+    }
+    else if (strncmp(chroma, "422", 3) == 0)
+    {
+        stream->frame_size = w * h + 2 * cw * h;
+    }
+    else if (strcmp(chroma, "444alpha") == 0)
+    {
+        stream->frame_size = 4 * w * h;
+    }
+    else if (strncmp(chroma, "444", 3) == 0)
+    {
+        stream->frame_size = 3 * w * h;
+    }
+    else if (strncmp(chroma, "mono", 4) == 0)
+    {
+        stream->frame_size = w * h;
+    }
+    else
+    {
+        printf("ERROR! Unsupported Y4M colour space C%s\n", chroma);
+        return e_failure;
+    }
+    return e_success;
+}
+
+/* Read one "FRAME" line and the frame pixels, e_failure at end of stream */
+Status y4m_read_frame(Y4mStream *stream, char *frame_header, unsigned char *frame)
+{
+    if (fgets(frame_header, Y4M_MAX_LINE, stream->fptr) == NULL)
+    {
+        return e_failure;
+    }
+    if (strncmp(frame_header, "FRAME", 5) != 0)
+    {
+        printf("ERROR! Bad Y4M frame header\n");
+        return e_failure;
+    }
+    if (fread(frame, 1, stream->frame_size, stream->fptr) != stream->frame_size)
+    {
+        printf("ERROR! Truncated Y4M frame\n");
+        return e_failure;
+    }
+    return e_success;
+}
+
+/* Hand out the next n payload bytes: the prefix first, then the secret file */
+static size_t fetch_payload(Y4mPipeline *p, unsigned char *buf, size_t n)
+{
+    size_t done = 0;
+    while (done < n && p->payload_pos < p->prefix_len)
+    {
+        buf[done++] = p->prefix[p->payload_pos++];
+    }
+    size_t got = fread(buf + done, 1, n - done, p->encInfo->fptr_secret);
+    p->payload_pos += got;
+    return done + got;
+}
+
+/* Assign the next range of payload bits to a freshly read frame */
+static Status fill_slot_payload(Y4mPipeline *p, Y4mSlot *slot)
+{
+    unsigned long long left = p->total_bits - p->bits_queued;
+
+    slot->bit_offset = p->bits_queued;
+    slot->payload_bits = left < p->carrier_size ? left : p->carrier_size;
+    if (slot->payload_bits == 0)
+    {
+        return e_success;
+    }
+
+    // Bytes [first, last] of the payload hold the bits of this frame
+    unsigned long long first = slot->bit_offset / 8;
+    unsigned long long last = (slot->bit_offset + slot->payload_bits - 1) / 8;
+    size_t count = last - first + 1;
+    size_t have = 0;
+
+    // A byte shared with the previous frame was already fetched
+    if (p->has_carry)
+    {
+        slot->payload[have++] = p->carry;
+    }
+    if (fetch_payload(p, slot->payload + have, count - have) != count - have)
+    {
+        printf("ERROR! Secret file ended early\n");
+        return e_failure;
+    }
+
+    p->bits_queued += slot->payload_bits;
+    p->has_carry = (p->bits_queued % 8) != 0;
+    p->carry = slot->payload[count - 1];
+    return e_success;
+}
+
+/* Embed the payload slice of a slot into its frame */
+static void embed_frame_bits(Y4mSlot *slot)
+{
+    unsigned char *carrier = slot->frame;
+    unsigned long long first = slot->bit_offset / 8;
+    size_t n = slot->payload_bits;
+    size_t i = 0;
+
+    // Bits up to the next payload byte boundary
+    while (i < n && (slot->bit_offset + i) % 8 != 0)
+    {
+        unsigned long long g = slot->bit_offset + i;
+        carrier[i] = (carrier[i] & 0xFE) | ((slot->payload[g / 8 - first] >> (7 - g % 8)) & 1);
+        i++;
+    }
+
+    // Whole payload bytes, 8 carrier bytes each
+    while (i + 8 <= n)
+    {
+        encode_byte_to_lsb(slot->payload[(slot->bit_offset + i) / 8 - first], (char *)carrier + i);
+        i += 8;
+    }
+
+    // Remaining bits of a byte that continues in the next frame
+    while (i < n)
+    {
+        unsigned long long g = slot->bit_offset + i;
+        carrier[i] = (carrier[i] & 0xFE) | ((slot->payload[g / 8 - first] >> (7 - g % 8)) & 1);
+        i++;
+    }
+}
+
+/* Reader thread: frames and their payload slices into free slots */
+static void *reader_thread(void *arg)
+{
+    Y4mPipeline *p = arg;
+
+    for (long seq = 0; ; seq++)
+    {
+        Y4mSlot *slot = &p->slots[seq % p->nslots];
+
+        // Wait for the writer to release the slot
+        pthread_mutex_lock(&p->lock);
+        while (slot->state != e_slot_free && !p->failed)
+        {
+            pthread_cond_wait(&p->changed, &p->lock);
+        }
+        int failed = p->failed;
+        pthread_mutex_unlock(&p->lock);
+        if (failed || y4m_read_frame(&p->in, slot->frame_header, slot->frame) == e_failure)
+        {
+            break;
+        }
+
+        slot->seq = seq;
+        Status ret = fill_slot_payload(p, slot);
+
+        pthread_mutex_lock(&p->lock);
+        if (ret == e_failure)
+        {
+            p->failed = 1;
+        }
+        slot->state = e_slot_read;
+        p->frames_read = seq + 1;
+        pthread_cond_broadcast(&p->changed);
+        pthread_mutex_unlock(&p->lock);
+    }
+
+    pthread_mutex_lock(&p->lock);
+    p->eof = 1;
+    pthread_cond_broadcast(&p->changed);
+    pthread_mutex_unlock(&p->lock);
+    return NULL;
+}
+
+/* Worker thread: embeds into the oldest frame that is ready */
+static void *embed_worker(void *arg)
+{
+    Y4mPipeline *p = arg;
+
+    pthread_mutex_lock(&p->lock);
+    while (1)
+    {
+        Y4mSlot *slot = NULL;
+        for (uint i = 0; i < p->nslots; i++)
+        {
+            if (p->slots[i].state == e_slot_read && (slot == NULL || p->slots[i].seq < slot->seq))
+            {
+                slot = &p->slots[i];
+            }
+        }
+        if (slot == NULL)
+        {
+            if (p->eof || p->failed)
+            {
+                break;
+            }
+            pthread_cond_wait(&p->changed, &p->lock);
+            continue;
+        }
+
+        slot->state = e_slot_busy;
+        pthread_mutex_unlock(&p->lock);
+
+        if (slot->payload_bits != 0)
+        {
+            embed_frame_bits(slot);
+        }
+
+        pthread_mutex_lock(&p->lock);
+        slot->state = e_slot_embedded;
+        pthread_cond_broadcast(&p->changed);
+    }
+    pthread_mutex_unlock(&p->lock);
+    return NULL;
+}
+
+/* Writer (runs on the calling thread): frames go out in stream order */
+static void write_frames(Y4mPipeline *p)
+{
+    FILE *out = p->encInfo->fptr_stego_image;
+
+    for (long seq = 0; ; seq++)
+    {
+        Y4mSlot *slot = &p->slots[seq % p->nslots];
+
+        pthread_mutex_lock(&p->lock);
+        while (!(slot->state == e_slot_embedded && slot->seq == seq) && !(p->eof && seq >= p->frames_read) && !p->failed)
+        {
+            pthread_cond_wait(&p->changed, &p->lock);
+        }
+        int ready = slot->state == e_slot_embedded && slot->seq == seq && !p->failed;
+        pthread_mutex_unlock(&p->lock);
+        if (!ready)
+        {
+            break;
+        }
+
+        int ok = fputs(slot->frame_header, out) != EOF && fwrite(slot->frame, 1, p->in.frame_size, out) == p->in.frame_size;
+
+        pthread_mutex_lock(&p->lock);
+        if (!ok)
+        {
+            printf("ERROR! Cannot write frame %ld\n", seq);
+            p->failed = 1;
+        }
+        slot->state = e_slot_free;
+        pthread_cond_broadcast(&p->changed);
+        pthread_mutex_unlock(&p->lock);
+    }
+}
+
+/* Open carrier, secret and output, parse the header and build the payload prefix */
+static Status y4m_prepare(Y4mPipeline *p, EncodeInfo *encInfo)
+{
+    // STEP 1 : Open files
+    p->in.fptr = encInfo->fptr_src_image = open_stream(encInfo->src_image_fname);
+    encInfo->fptr_secret = fopen(encInfo->secret_fname, "rb");
+    encInfo->fptr_stego_image = fopen(encInfo->stego_image_fname, "wb");
+    if (encInfo->fptr_src_image == NULL || encInfo->fptr_secret == NULL || encInfo->fptr_stego_image == NULL)
+    {
+        perror("fopen");
+        printf("Error: Unable to open required files.\n");
+        return e_failure;
+    }
+
+    // STEP 2 : Frame geometry
+    if (y4m_read_stream_header(&p->in) == e_failure)
+    {
+        return e_failure;
+    }
+    p->carrier_size = encInfo->y4m_planes == e_planes_all ? p->in.frame_size : p->in.luma_size;
+    if (p->in.luma_size < 8 * 6)
+    {
+        printf("Error: Frames are too small to carry the stego header.\n");
+        return e_failure;
+    }
+    printf("width = %u\nheight = %u\n", p->in.width, p->in.height);
+
+    // STEP 3 : Payload prefix, same field order as the BMP encoder behind an extended magic
+    size_t extn_len = strlen(encInfo->extn_secret_file);
+    encInfo->size_secret_file = get_file_size(encInfo->fptr_secret);
+    memcpy(p->prefix, MAGIC_STRING_EXT, 2);
+    put_be32(p->prefix + 2, encInfo->y4m_planes == e_planes_all ? MODE_Y4M_ALL_PLANES : 0);
+    put_be32(p->prefix + 6, extn_len);
+    memcpy(p->prefix + 10, encInfo->extn_secret_file, extn_len);
+    put_be32(p->prefix + 10 + extn_len, encInfo->size_secret_file);
+    p->prefix_len = 14 + extn_len;
+    p->total_bits = (p->prefix_len + (unsigned long long)encInfo->size_secret_file) * 8;
+
+    // STEP 4 : Capacity check when the frame count can be known up front
+    if (p->in.fptr != stdin)
+    {
+        long pos = ftell(p->in.fptr);
+        fseek(p->in.fptr, 0, SEEK_END);
+        unsigned long long frames = (ftell(p->in.fptr) - pos) / (p->in.frame_size + 6);
+        fseek(p->in.fptr, pos, SEEK_SET);
+        if (frames * p->carrier_size < p->total_bits)
+        {
+            printf("Error: Insufficient carrier capacity (%llu frames).\n", frames);
+            return e_failure;
+        }
+        printf("Carrier has sufficient capacity (%llu frames).\n", frames);
+    }
+
+    // STEP 5 : Stream header goes out unchanged
+    if (fputs(p->in.header, encInfo->fptr_stego_image) == EOF)
+    {
+        printf("Error: Cannot write Y4M header.\n");
+        return e_failure;
+    }
+    return e_success;
+}
+
+/* Encode the secret file across the frames of a Y4M stream */
+Status do_y4m_encoding(EncodeInfo *encInfo)
+{
+    Y4mPipeline p;
+    Status ret = e_failure;
+    uint threads = encInfo->threads;
+
+    memset(&p, 0, sizeof(p));
+    p.encInfo = encInfo;
+    if (y4m_prepare(&p, encInfo) == e_success)
+    {
+        // STEP 1 : Ring of frame slots, a few per worker
+        if (threads == 0)
+        {
+            long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+            threads = cpus > 0 ? cpus : 1;
+        }
+        p.nslots = threads * Y4M_SLOTS_PER_THREAD + 2;
+        p.slots = calloc(p.nslots, sizeof(Y4mSlot));
+        int allocated = p.slots != NULL;
+        for (uint i = 0; allocated && i < p.nslots; i++)
+        {
+            p.slots[i].frame = malloc(p.in.frame_size);
+            p.slots[i].payload = malloc(p.carrier_size / 8 + 2);
+            allocated = p.slots[i].frame != NULL && p.slots[i].payload != NULL;
+        }
+
+        if (!allocated)
+        {
+            printf("Error: Out of memory for %u frames in flight.\n", p.nslots);
+        }
+        else
+        {
+            // STEP 2 : Reader and workers run while this thread writes
+            pthread_t reader, workers[threads];
+            uint started = 0;
+            pthread_mutex_init(&p.lock, NULL);
+            pthread_cond_init(&p.changed, NULL);
+            int reader_started = pthread_create(&reader, NULL, reader_thread, &p) == 0;
+            while (reader_started && started < threads && pthread_create(&workers[started], NULL, embed_worker, &p) == 0)
+            {
+                started++;
+            }
+
+            if (reader_started && started == threads)
+            {
+                write_frames(&p);
+            }
+            else
+            {
+                // A thread could not be started: stop the ones that were, then only join those
+                printf("Error: Cannot start the frame pipeline threads.\n");
+                pthread_mutex_lock(&p.lock);
+                p.failed = 1;
+                pthread_cond_broadcast(&p.changed);
+                pthread_mutex_unlock(&p.lock);
+            }
+
+            if (reader_started)
+            {
+                pthread_join(reader, NULL);
+            }
+            for (uint i = 0; i < started; i++)
+            {
+                pthread_join(workers[i], NULL);
+            }
+            pthread_cond_destroy(&p.changed);
+            pthread_mutex_destroy(&p.lock);
+
+            // STEP 3 : Every payload bit must have found a frame
+            if (p.failed)
+            {
+                printf("Error: Frame pipeline failed.\n");
+            }
+            else if (p.bits_queued < p.total_bits)
+            {
+                printf("Error: Insufficient carrier capacity, stream ended after %ld frames.\n", p.frames_read);
+            }
+            else
+            {
+                printf("Embedded %llu bits across %ld frames using %u threads.\n", p.total_bits, p.frames_read, threads);
+                ret = e_success;
+            }
+        }
+
+        for (uint i = 0; p.slots != NULL && i < p.nslots; i++)
+        {
+            free(p.slots[i].frame);
+            free(p.slots[i].payload);
+        }
+        free(p.slots);
+    }
+
+    // Close files
+    if (encInfo->fptr_src_image != NULL && encInfo->fptr_src_image != stdin)
+    {
+        fclose(encInfo->fptr_src_image);
+    }
+    if (encInfo->fptr_secret != NULL)
+    {
+        fclose(encInfo->fptr_secret);
+    }
+    if (encInfo->fptr_stego_image != NULL && fclose(encInfo->fptr_stego_image) != 0)
+    {
+        ret = e_failure;
+    }
+    return ret;
+}
+
+/* Feed one decoded payload byte through the extended header, then the payload parser */
+static void consume_byte(Y4mDecoder *d, unsigned char byte)
+{
+    if (d->index < 2)
+    {
+        // Extended magic string
+        if (byte != (unsigned char)MAGIC_STRING_EXT[d->index])
+        {
+            printf("ERROR! Magic string mismatch. Not a valid stego stream.\n");
+            d->failed = 1;
+        }
+        d->index++;
+    }
+    else if (d->index < 6)
+    {
+        // Mode word
+        d->decInfo->mode_word = (d->decInfo->mode_word << 8) | byte;
+        if (++d->index == 6 && (d->decInfo->mode_word & ~MODE_Y4M_ALL_PLANES) != 0)
+        {
+            printf("ERROR! Unsupported embedding mode 0x%08x\n", d->decInfo->mode_word);
+            d->failed = 1;
+        }
+    }
+    else
+    {
+        parse_payload_byte(d->decInfo, &d->parser, byte);
+        d->done = d->parser.done;
+        d->failed = d->parser.failed;
+    }
+}
+
+/* Pull payload bits out of a run of carrier bytes */
+static void take_bits(Y4mDecoder *d, const unsigned char *carrier, size_t n)
+{
+    for (size_t i = 0; i < n && !d->done && !d->failed; i++)
+    {
+        d->cur = (d->cur << 1) | (carrier[i] & 1);
+        if (++d->nbits == 8)
+        {
+            consume_byte(d, d->cur);
+            d->nbits = 0;
+        }
+    }
+}
+
+/* Decode the secret file from the frames of a Y4M stream */
+Status do_y4m_decoding(DecodeInfo *decInfo)
+{
+    Y4mStream in;
+    Y4mDecoder d;
+    char frame_header[Y4M_MAX_LINE];
+    unsigned char *frame = NULL;
+    long frames = 0;
+
+    printf("Starting decoding process...\n");
+    memset(&d, 0, sizeof(d));
+    d.decInfo = decInfo;
+    decInfo->mode_word = 0;
+
+    // STEP 1 : Open files and read the stream header
+    in.fptr = decInfo->fptr_stego_image = open_stream(decInfo->stego_image_fname);
+    decInfo->fptr_output = fopen(decInfo->output_fname, "w");
+    if (decInfo->fptr_stego_image == NULL || decInfo->fptr_output == NULL)
+    {
+        perror("fopen");
+        printf("ERROR! Failed to open files\n");
+        d.failed = 1;
+    }
+    else if (y4m_read_stream_header(&in) == e_failure || (frame = malloc(in.frame_size)) == NULL)
+    {
+        d.failed = 1;
+    }
+
+    // STEP 2 : Luma of every frame, then the chroma planes if the mode word says so
+    while (!d.done && !d.failed && y4m_read_frame(&in, frame_header, frame) == e_success)
+    {
+        take_bits(&d, frame, in.luma_size);
+        if (decInfo->mode_word & MODE_Y4M_ALL_PLANES)
+        {
+            take_bits(&d, frame + in.luma_size, in.frame_size - in.luma_size);
+        }
+        frames++;
+    }
+
+    free(frame);
+    if (decInfo->fptr_stego_image != NULL && decInfo->fptr_stego_image != stdin)
+    {
+        fclose(decInfo->fptr_stego_image);
+    }
+    if (decInfo->fptr_output != NULL)
+    {
+        fclose(decInfo->fptr_output);
+    }
+
+    if (!d.done)
+    {
+        if (!d.failed)
+        {
+            printf("ERROR! Stream ended after %ld frames before the payload was complete\n", frames);
+        }
+        return e_failure;
+    }
+    printf("Decoding completed successfully. Data written to: %s\n", decInfo->output_fname);
+    return e_success;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/* ============================================================================= END OF CODE ===========================================================================*/
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -0,0 +1,62 @@
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// =============================================================== * * * * * y4m.h * * * * * ========================================================================== //
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/*
+
+### USAGE OF y4m.h FILE IN STEGANOGRAPHY PROJECT ?
+--> THIS HEADER FILE DECLARES THE RAW VIDEO (YUV4MPEG2) CARRIER. A .Y4M FILE IS A TEXT HEADER LINE FOLLOWED BY UNCOMPRESSED FRAMES, EACH STARTING WITH A "FRAME" LINE.
+    THE PAYLOAD (EXTENDED MAGIC STRING, MODE WORD, EXTENSION SIZE, EXTENSION, FILE SIZE AND DATA) IS SPREAD OVER THE LSBS OF THE LUMA PLANE, OR OF ALL PLANES, OF
+    CONSECUTIVE FRAMES. FRAMES ARE STREAMED FROM A FILE OR STDIN AND SEVERAL FRAMES ARE KEPT IN FLIGHT BETWEEN A READER, EMBEDDING WORKERS AND A WRITER.
+
+*/
+
+// ==================================================================================================================================================================== //
+
+#ifndef Y4M_H
+#define Y4M_H
+
+/* ====================================================================== INCLUDES ==================================================================================== */
+
+#include <stdio.h>
+#include "types.h"
+#include "encode.h"
+#include "decode.h"
+
+/* ======================================================================= MACROS ===================================================================================== */
+
+#define Y4M_MAX_LINE 256        // Longest stream / frame header line accepted
+#define Y4M_SLOTS_PER_THREAD 2  // Frames in flight per embedding worker (plus one for reader and writer each)
+
+/* ======================================================================= STRUCTURE ================================================================================== */
+
+/* Geometry of a YUV4MPEG2 stream, parsed from its header line */
+typedef struct _Y4mStream
+{
+    FILE *fptr;                 // Stream being read or written
+    char header[Y4M_MAX_LINE];  // Stream header line, written back unchanged
+    uint width;                 // Frame width in pixels
+    uint height;                // Frame height in pixels
+    size_t frame_size;          // Bytes of pixel data in one frame (all planes)
+    size_t luma_size;           // Bytes of the Y plane (width * height)
+} Y4mStream;
+
+/* ================================================================= FUNCTION PROTOTYPES ============================================================================== */
+
+/* Parse the stream header line and work out the frame size */
+Status y4m_read_stream_header(Y4mStream *stream);
+
+/* Read one "FRAME" line and the frame pixels, e_failure at end of stream */
+Status y4m_read_frame(Y4mStream *stream, char *frame_header, unsigned char *frame);
+
+/* Encode the secret file across the frames of a Y4M stream */
+Status do_y4m_encoding(EncodeInfo *encInfo);
+
+/* Decode the secret file from the frames of a Y4M stream */
+Status do_y4m_decoding(DecodeInfo *decInfo);
+
+#endif
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/* ============================================================================= END OF CODE ===========================================================================*/
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////